@@ -7,6 +7,7 @@ from hypothesis import given
 
 from caffe2.python import core, workspace
 from caffe2.proto import caffe2_pb2
+from google.protobuf import text_format
 import caffe2.python.hypothesis_test_util as hu
 import hypothesis.strategies as st
 
@@ -518,3 +519,59 @@ class TestCaffe2Script(hu.HypothesisTestCase):
 
         output = workspace.FetchBlob('d')
         np.testing.assert_allclose(output, vector)
+
+    def test_optimize(self):
+        program = """
+            def decode(x, length) -> (y, step):
+                step = 0
+                y = x
+                while step < length:
+                    y = y * 2f + (1f - 0.5f) / 2f
+                    step += 1
+                    last = length - 1
+                    if step == last:
+                        y = -y
+            def compare(a, b) -> (c, d):
+                c = a + b * b
+                d = (a < b) or not (a > b)
+        """
+        inputs = dict(
+            x=np.array([1, 2, 3], dtype=np.float32),
+            length=np.array([5], dtype=np.int32),
+            a=np.array([1, 2, 3, 4], dtype=np.float32),
+            b=np.array([2, 2, 1, 0.5], dtype=np.float32))
+
+        def run(optimize):
+            workspace.ResetWorkspace()
+            feed_inputs(inputs)
+            CU = core.C.CompilationUnit(optimize=optimize)
+            CU.define(program)
+            results = {}
+            for function in ['decode', 'compare']:
+                CU.create_net(function).run()
+                proto = caffe2_pb2.NetDef()
+                text_format.Merge(CU.get_proto(function), proto)
+                results[function] = proto
+            for name in ['y', 'step', 'c', 'd']:
+                results[name] = workspace.FetchBlob(name)
+            return results
+
+        ref = run(optimize=False)
+        opt = run(optimize=True)
+        for name in ['y', 'step', 'c', 'd']:
+            np.testing.assert_array_equal(opt[name], ref[name])
+
+        # Each statement of compare is fused, and they are fused together.
+        self.assertEqual(
+            [op.type for op in opt['compare'].op], ['FusedElementwise'])
+        # The loop body is left with one fused op for its arithmetic and the
+        # If, the constants and (1f - 0.5f) / 2f being computed before.
+        # last = length - 1 stays in the body, as only ops of constants are
+        # hoisted.
+        loop = opt['decode'].op[-1]
+        self.assertEqual(loop.type, 'While')
+        for op in opt['decode'].op[:-1]:
+            self.assertNotIn('length', op.input)
+        body = [arg.n for arg in loop.arg if arg.name == 'loop_net'][0]
+        self.assertEqual(
+            [op.type for op in body.op], ['FusedElementwise', 'If'])
@@ -2,6 +2,7 @@
 #include "caffe2/utils/proto_utils.h"
 
 #include "compiler.h"
+#include "optimizer.h"
 #include "parser.h"
 
 namespace caffe2 {
@@ -723,6 +724,8 @@ struct DefCompiler {
 };
 
 struct CompilationUnitImpl {
+  explicit CompilationUnitImpl(bool optimize) : optimize(optimize) {}
+
   void defineFunction(const Def& def) {
     if (functions.count(def.name().name()) > 0) {
       throw ErrorReport(def) << def.name().name() << " already defined.";
@@ -744,8 +747,20 @@ struct CompilationUnitImpl {
   std::unique_ptr<NetBase> createNet(Workspace* ws, const std::string& str) {
     if (functions.count(str) == 0)
       throw ErrorReport() << "undefined function: " << str << "\n";
-    auto& def = functions.at(str);
-    return caffe2::CreateNet(*def.net_def, ws);
+    return caffe2::CreateNet(netDef(functions.at(str)), ws);
+  }
+
+  // the net to run for a function; functions keep their unoptimized
+  // NetDef so that they can still be inlined
+  NetDef netDef(const FunctionDefinition& def) const {
+    NetDef net_def = *def.net_def;
+    if (optimize && !def.isExtern()) {
+      std::unordered_set<std::string> params(
+          def.inputs.begin(), def.inputs.end());
+      params.insert(def.outputs.begin(), def.outputs.end());
+      optimizeFunction(&net_def, params);
+    }
+    return net_def;
   }
 
   void defineExtern(const std::string& name, std::unique_ptr<NetDef> net_def) {
@@ -757,15 +772,17 @@ struct CompilationUnitImpl {
   }
 
   std::string getProto(const std::string& functionName) {
-    return functions.at(functionName).net_def->DebugString();
+    return netDef(functions.at(functionName)).DebugString();
   }
 
  private:
   friend struct DefCompiler;
   SymbolTable functions;
+  bool optimize;
 };
 
-CompilationUnit::CompilationUnit() : pImpl(new CompilationUnitImpl()) {}
+CompilationUnit::CompilationUnit(bool optimize)
+    : pImpl(new CompilationUnitImpl(optimize)) {}
 
 void CompilationUnit::define(const std::string& str) {
   return pImpl->define(str);
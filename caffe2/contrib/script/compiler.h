@@ -8,7 +8,10 @@ namespace script {
 
 struct CompilationUnitImpl;
 struct CompilationUnit {
-  CompilationUnit();
+  // If optimize is true, the nets created from compiled functions hoist
+  // loop-invariant ops out of While bodies and fuse elementwise expressions
+  // into single operators, see optimizer.h.
+  explicit CompilationUnit(bool optimize = false);
   void define(const std::string& str);
   void defineExtern(const std::string& str, std::unique_ptr<NetDef> netdef);
   std::unique_ptr<NetBase> createNet(Workspace* ws, const std::string& name);
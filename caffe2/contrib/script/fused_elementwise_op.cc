@@ -0,0 +1,642 @@
+#include "fused_elementwise_op.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+bool IsFloating(TensorProto::DataType type) {
+  return type == TensorProto::FLOAT || type == TensorProto::DOUBLE;
+}
+
+bool IsNumeric(TensorProto::DataType type) {
+  return IsFloating(type) || type == TensorProto::INT32 ||
+      type == TensorProto::INT64;
+}
+
+struct Plus {
+  template <typename T>
+  T operator()(T x, T y) const {
+    return x + y;
+  }
+};
+
+struct Minus {
+  template <typename T>
+  T operator()(T x, T y) const {
+    return x - y;
+  }
+};
+
+struct Multiplies {
+  template <typename T>
+  T operator()(T x, T y) const {
+    return x * y;
+  }
+};
+
+struct Divides {
+  template <typename T>
+  T operator()(T x, T y) const {
+    return x / y;
+  }
+};
+
+struct Less {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x < y;
+  }
+};
+
+struct LessEqual {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x <= y;
+  }
+};
+
+struct Greater {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x > y;
+  }
+};
+
+struct GreaterEqual {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x >= y;
+  }
+};
+
+struct Equal {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x == y;
+  }
+};
+
+struct LogicalAnd {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x && y;
+  }
+};
+
+struct LogicalOr {
+  template <typename T>
+  bool operator()(T x, T y) const {
+    return x || y;
+  }
+};
+
+// Applies f to the n elements of x and y, or to those of x and the single
+// element of y.
+template <typename T, typename R, typename F>
+void Map(const T* x, const T* y, bool broadcast, int n, R* z, F f) {
+  if (broadcast) {
+    const T b = y[0];
+    for (int k = 0; k < n; ++k) {
+      z[k] = f(x[k], b);
+    }
+  } else {
+    for (int k = 0; k < n; ++k) {
+      z[k] = f(x[k], y[k]);
+    }
+  }
+}
+
+template <typename T, typename V>
+void LoadData(const TensorCPU& tensor, TIndex offset, int n, V* values) {
+  const T* data = tensor.data<T>() + offset;
+  for (int k = 0; k < n; ++k) {
+    values[k] = data[k];
+  }
+}
+
+template <typename T, typename V>
+void StoreData(const V* values, TIndex offset, int n, void* data) {
+  T* out = static_cast<T*>(data) + offset;
+  for (int k = 0; k < n; ++k) {
+    out[k] = static_cast<T>(values[k]);
+  }
+}
+
+// Rounds the results computed in double or int64_t to their actual type,
+// which gives the same results as computing in that type.
+void Round(TensorProto::DataType type, int n, double* f, int64_t* i) {
+  switch (type) {
+    case TensorProto::FLOAT:
+      for (int k = 0; k < n; ++k) {
+        f[k] = static_cast<float>(f[k]);
+      }
+      break;
+    case TensorProto::INT32:
+      for (int k = 0; k < n; ++k) {
+        i[k] = static_cast<int32_t>(i[k]);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+} // namespace
+
+constexpr int FusedElementwiseOp::kBlockSize;
+
+FusedElementwiseOp::FusedElementwiseOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws) {
+  CAFFE_ENFORCE(
+      HasSingleArgumentOfType<NetDef>("net"),
+      "net must be specified in FusedElementwise operator");
+  const auto net_def = GetSingleArgument<NetDef>("net", NetDef());
+  CAFFE_ENFORCE_EQ(net_def.external_input_size(), InputSize());
+  CAFFE_ENFORCE_EQ(net_def.external_output_size(), OutputSize());
+  fallback_.reset(new LazyNet(net_def, ws, /* lazy */ true));
+
+  static const std::unordered_map<std::string, Kind> kinds{
+      {"Add", Kind::Add},
+      {"Sub", Kind::Sub},
+      {"Mul", Kind::Mul},
+      {"Div", Kind::Div},
+      {"Negative", Kind::Negative},
+      {"LT", Kind::LT},
+      {"LE", Kind::LE},
+      {"GT", Kind::GT},
+      {"GE", Kind::GE},
+      {"EQ", Kind::EQ},
+      {"And", Kind::And},
+      {"Or", Kind::Or},
+      {"Not", Kind::Not},
+      {"Cast", Kind::Cast},
+      {"ConstantFill", Kind::Constant},
+  };
+  // The register holding the current value of each blob.
+  std::unordered_map<std::string, int> registers;
+  for (int i = 0; i < InputSize(); ++i) {
+    registers[net_def.external_input(i)] = i;
+  }
+  int next_register = InputSize();
+  for (const auto& op : net_def.op()) {
+    auto it = kinds.find(op.type());
+    CAFFE_ENFORCE(
+        it != kinds.end(), "Cannot fuse operator ", ProtoDebugString(op));
+    CAFFE_ENFORCE_EQ(op.output_size(), 1);
+    Instruction instruction;
+    instruction.kind = it->second;
+    for (const auto& input : op.input()) {
+      auto r = registers.find(input);
+      CAFFE_ENFORCE(r != registers.end(), "Undefined fused input ", input);
+      instruction.inputs.push_back(r->second);
+    }
+    ArgumentHelper helper(op);
+    int num_inputs = 2;
+    switch (instruction.kind) {
+      case Kind::Negative:
+      case Kind::Not:
+        num_inputs = 1;
+        break;
+      case Kind::Cast:
+        num_inputs = 1;
+        CAFFE_ENFORCE(helper.HasSingleArgumentOfType<int>("to"));
+        instruction.type = static_cast<TensorProto::DataType>(
+            helper.GetSingleArgument<int>("to", TensorProto::FLOAT));
+        break;
+      case Kind::Constant:
+        num_inputs = 0;
+        CAFFE_ENFORCE(
+            helper.GetRepeatedArgument<int64_t>("shape") ==
+                std::vector<int64_t>{1},
+            "Only single element constants can be fused");
+        instruction.type = static_cast<TensorProto::DataType>(
+            helper.GetSingleArgument<int>("dtype", TensorProto::FLOAT));
+        if (!helper.HasArgument("dtype") &&
+            helper.HasSingleArgumentOfType<int64_t>("value")) {
+          instruction.type = TensorProto::INT64;
+        }
+        switch (instruction.type) {
+          case TensorProto::FLOAT:
+            instruction.f = helper.GetSingleArgument<float>("value", 0);
+            break;
+          case TensorProto::DOUBLE:
+            instruction.f = helper.GetSingleArgument<double>("value", 0);
+            break;
+          case TensorProto::INT32:
+            instruction.i = helper.GetSingleArgument<int>("value", 0);
+            break;
+          case TensorProto::INT64:
+            instruction.i = helper.GetSingleArgument<int64_t>("value", 0);
+            break;
+          case TensorProto::BOOL:
+            instruction.i = helper.GetSingleArgument<bool>("value", false);
+            break;
+          default:
+            CAFFE_THROW("Cannot fuse constants of type ", instruction.type);
+        }
+        break;
+      default:
+        instruction.broadcast = helper.GetSingleArgument<int>("broadcast", 0);
+        break;
+    }
+    CAFFE_ENFORCE_EQ(instruction.inputs.size(), num_inputs);
+    instruction.output = next_register++;
+    registers[op.output(0)] = instruction.output;
+    instructions_.push_back(instruction);
+  }
+  for (const auto& output : net_def.external_output()) {
+    auto r = registers.find(output);
+    CAFFE_ENFORCE(r != registers.end(), "Undefined fused output ", output);
+    outputs_.push_back(r->second);
+  }
+  registers_.resize(next_register);
+}
+
+bool FusedElementwiseOp::RunOnDevice() {
+  if (!Infer()) {
+    VLOG(1) << "Running fused ops one by one on unsupported inputs";
+    return fallback_->Run();
+  }
+  for (int i = 0; i < InputSize(); ++i) {
+    if (registers_[i].scalar) {
+      Load(i, 0, 1);
+    }
+  }
+  for (const auto& instruction : instructions_) {
+    if (registers_[instruction.output].scalar) {
+      Execute(instruction, 1);
+    }
+  }
+
+  // An output that is also an input is written in place when it keeps its
+  // type and shape, the blocks being read before they are written. Otherwise
+  // it is written aside, so that the input is not freed or resized while it
+  // is read.
+  std::vector<TensorCPU> aside(OutputSize());
+  std::vector<TensorCPU*> targets(OutputSize());
+  std::vector<void*> data(OutputSize());
+  for (int k = 0; k < OutputSize(); ++k) {
+    const auto& value = registers_[outputs_[k]];
+    const auto& meta = DataTypeToTypeMeta(value.type);
+    targets[k] = Output(k);
+    for (int i = 0; i < InputSize(); ++i) {
+      if (&Input(i) == targets[k] &&
+          (targets[k]->meta() != meta || targets[k]->dims() != value.dims)) {
+        targets[k] = &aside[k];
+      }
+    }
+    targets[k]->Resize(value.dims);
+    data[k] = targets[k]->raw_mutable_data(meta);
+  }
+  for (TIndex offset = 0; offset < size_; offset += kBlockSize) {
+    const int n = std::min<TIndex>(kBlockSize, size_ - offset);
+    for (int i = 0; i < InputSize(); ++i) {
+      if (!registers_[i].scalar) {
+        Load(i, offset, n);
+      }
+    }
+    for (const auto& instruction : instructions_) {
+      if (!registers_[instruction.output].scalar) {
+        Execute(instruction, n);
+      }
+    }
+    for (int k = 0; k < OutputSize(); ++k) {
+      if (!registers_[outputs_[k]].scalar) {
+        Store(registers_[outputs_[k]], offset, n, data[k]);
+      }
+    }
+  }
+  for (int k = 0; k < OutputSize(); ++k) {
+    if (registers_[outputs_[k]].scalar) {
+      Store(registers_[outputs_[k]], 0, 1, data[k]);
+    }
+    if (targets[k] == &aside[k]) {
+      Output(k)->swap(aside[k]);
+    }
+  }
+  return true;
+}
+
+bool FusedElementwiseOp::Infer() {
+  for (int i = 0; i < InputSize(); ++i) {
+    if (!InputIsType<TensorCPU>(i)) {
+      return false;
+    }
+    const auto& tensor = Input(i);
+    auto* value = &registers_[i];
+    value->type = TypeMetaToDataType(tensor.meta());
+    if (value->type != TensorProto::FLOAT &&
+        value->type != TensorProto::DOUBLE &&
+        value->type != TensorProto::INT32 &&
+        value->type != TensorProto::INT64 &&
+        value->type != TensorProto::BOOL) {
+      return false;
+    }
+    value->dims = tensor.dims();
+  }
+  for (const auto& instruction : instructions_) {
+    if (!Infer(instruction)) {
+      return false;
+    }
+  }
+  size_ = -1;
+  for (auto& value : registers_) {
+    const TIndex size = size_from_dim_(0, value.dims);
+    value.scalar = size == 1;
+    if (!value.scalar) {
+      if (size_ >= 0 && size != size_) {
+        return false;
+      }
+      size_ = size;
+    }
+  }
+  size_ = std::max<TIndex>(size_, 0);
+  for (auto& value : registers_) {
+    const size_t capacity =
+        value.scalar ? 1 : std::min<TIndex>(size_, kBlockSize);
+    if (IsFloating(value.type)) {
+      value.f.resize(capacity);
+    } else {
+      value.i.resize(capacity);
+    }
+  }
+  return true;
+}
+
+bool FusedElementwiseOp::Infer(const Instruction& instruction) {
+  auto* out = &registers_[instruction.output];
+  switch (instruction.kind) {
+    case Kind::Constant:
+      out->type = instruction.type;
+      out->dims = {1};
+      return true;
+    case Kind::Cast: {
+      const auto& a = registers_[instruction.inputs[0]];
+      out->type = instruction.type;
+      out->dims = a.dims;
+      return instruction.type == TensorProto::BOOL ||
+          IsNumeric(instruction.type);
+    }
+    case Kind::Negative:
+    case Kind::Not: {
+      const auto& a = registers_[instruction.inputs[0]];
+      out->type = a.type;
+      out->dims = a.dims;
+      return instruction.kind == Kind::Negative
+          ? IsNumeric(a.type)
+          : a.type == TensorProto::BOOL;
+    }
+    default:
+      break;
+  }
+
+  // Binary ops, with the shapes accepted by BinaryElementwiseOp without axis.
+  const auto& a = registers_[instruction.inputs[0]];
+  const auto& b = registers_[instruction.inputs[1]];
+  if (a.type != b.type) {
+    return false;
+  }
+  if (a.dims != b.dims &&
+      (!instruction.broadcast || size_from_dim_(0, b.dims) != 1)) {
+    return false;
+  }
+  out->dims = a.dims;
+  switch (instruction.kind) {
+    case Kind::Add:
+    case Kind::Sub:
+    case Kind::Mul:
+    case Kind::Div:
+      out->type = a.type;
+      return IsNumeric(a.type);
+    case Kind::LT:
+    case Kind::LE:
+    case Kind::GT:
+    case Kind::GE:
+      out->type = TensorProto::BOOL;
+      return IsNumeric(a.type);
+    case Kind::EQ:
+      out->type = TensorProto::BOOL;
+      return !IsFloating(a.type);
+    case Kind::And:
+    case Kind::Or:
+      out->type = TensorProto::BOOL;
+      return a.type == TensorProto::BOOL;
+    default:
+      CAFFE_THROW("Unexpected fused instruction");
+  }
+}
+
+void FusedElementwiseOp::Load(int input, TIndex offset, int n) {
+  const auto& tensor = Input(input);
+  auto* value = &registers_[input];
+  switch (value->type) {
+    case TensorProto::FLOAT:
+      LoadData<float>(tensor, offset, n, value->f.data());
+      break;
+    case TensorProto::DOUBLE:
+      LoadData<double>(tensor, offset, n, value->f.data());
+      break;
+    case TensorProto::INT32:
+      LoadData<int>(tensor, offset, n, value->i.data());
+      break;
+    case TensorProto::INT64:
+      LoadData<int64_t>(tensor, offset, n, value->i.data());
+      break;
+    case TensorProto::BOOL:
+      LoadData<bool>(tensor, offset, n, value->i.data());
+      break;
+    default:
+      CAFFE_THROW("Unexpected fused value type ", value->type);
+  }
+}
+
+void FusedElementwiseOp::Store(
+    const Register& value,
+    TIndex offset,
+    int n,
+    void* data) {
+  switch (value.type) {
+    case TensorProto::FLOAT:
+      StoreData<float>(value.f.data(), offset, n, data);
+      break;
+    case TensorProto::DOUBLE:
+      StoreData<double>(value.f.data(), offset, n, data);
+      break;
+    case TensorProto::INT32:
+      StoreData<int>(value.i.data(), offset, n, data);
+      break;
+    case TensorProto::INT64:
+      StoreData<int64_t>(value.i.data(), offset, n, data);
+      break;
+    case TensorProto::BOOL:
+      StoreData<bool>(value.i.data(), offset, n, data);
+      break;
+    default:
+      CAFFE_THROW("Unexpected fused value type ", value.type);
+  }
+}
+
+template <typename F>
+void FusedElementwiseOp::Arithmetic(
+    const Register& a,
+    const Register& b,
+    int n,
+    Register* out,
+    F f) {
+  if (IsFloating(a.type)) {
+    Map(a.f.data(), b.f.data(), b.scalar, n, out->f.data(), f);
+  } else {
+    Map(a.i.data(), b.i.data(), b.scalar, n, out->i.data(), f);
+  }
+  Round(out->type, n, out->f.data(), out->i.data());
+}
+
+template <typename F>
+void FusedElementwiseOp::Compare(
+    const Register& a,
+    const Register& b,
+    int n,
+    Register* out,
+    F f) {
+  if (IsFloating(a.type)) {
+    Map(a.f.data(), b.f.data(), b.scalar, n, out->i.data(), f);
+  } else {
+    Map(a.i.data(), b.i.data(), b.scalar, n, out->i.data(), f);
+  }
+}
+
+void FusedElementwiseOp::Cast(const Register& a, int n, Register* out) {
+  const bool floating = IsFloating(a.type);
+  switch (out->type) {
+    case TensorProto::FLOAT:
+      // Converts directly, as int64_t -> double -> float may round twice.
+      for (int k = 0; k < n; ++k) {
+        out->f[k] = floating ? static_cast<float>(a.f[k])
+                             : static_cast<float>(a.i[k]);
+      }
+      break;
+    case TensorProto::DOUBLE:
+      for (int k = 0; k < n; ++k) {
+        out->f[k] = floating ? a.f[k] : static_cast<double>(a.i[k]);
+      }
+      break;
+    case TensorProto::BOOL:
+      for (int k = 0; k < n; ++k) {
+        out->i[k] = floating ? a.f[k] != 0 : a.i[k] != 0;
+      }
+      break;
+    default:
+      for (int k = 0; k < n; ++k) {
+        out->i[k] = floating ? static_cast<int64_t>(a.f[k]) : a.i[k];
+      }
+      Round(out->type, n, out->f.data(), out->i.data());
+      break;
+  }
+}
+
+void FusedElementwiseOp::Execute(const Instruction& instruction, int n) {
+  auto* out = &registers_[instruction.output];
+  switch (instruction.kind) {
+    case Kind::Constant:
+      if (IsFloating(instruction.type)) {
+        out->f[0] = instruction.f;
+      } else {
+        out->i[0] = instruction.i;
+      }
+      return;
+    case Kind::Cast:
+      Cast(registers_[instruction.inputs[0]], n, out);
+      return;
+    case Kind::Negative: {
+      const auto& a = registers_[instruction.inputs[0]];
+      if (IsFloating(a.type)) {
+        for (int k = 0; k < n; ++k) {
+          out->f[k] = -a.f[k];
+        }
+      } else {
+        for (int k = 0; k < n; ++k) {
+          out->i[k] = -a.i[k];
+        }
+      }
+      Round(out->type, n, out->f.data(), out->i.data());
+      return;
+    }
+    case Kind::Not: {
+      const auto& a = registers_[instruction.inputs[0]];
+      for (int k = 0; k < n; ++k) {
+        out->i[k] = !a.i[k];
+      }
+      return;
+    }
+    default:
+      break;
+  }
+
+  const auto& a = registers_[instruction.inputs[0]];
+  const auto& b = registers_[instruction.inputs[1]];
+  switch (instruction.kind) {
+    case Kind::Add:
+      Arithmetic(a, b, n, out, Plus());
+      break;
+    case Kind::Sub:
+      Arithmetic(a, b, n, out, Minus());
+      break;
+    case Kind::Mul:
+      Arithmetic(a, b, n, out, Multiplies());
+      break;
+    case Kind::Div:
+      Arithmetic(a, b, n, out, Divides());
+      break;
+    case Kind::LT:
+      Compare(a, b, n, out, Less());
+      break;
+    case Kind::LE:
+      Compare(a, b, n, out, LessEqual());
+      break;
+    case Kind::GT:
+      Compare(a, b, n, out, Greater());
+      break;
+    case Kind::GE:
+      Compare(a, b, n, out, GreaterEqual());
+      break;
+    case Kind::EQ:
+      Compare(a, b, n, out, Equal());
+      break;
+    case Kind::And:
+      Compare(a, b, n, out, LogicalAnd());
+      break;
+    case Kind::Or:
+      Compare(a, b, n, out, LogicalOr());
+      break;
+    default:
+      CAFFE_THROW("Unexpected fused instruction");
+  }
+}
+
+REGISTER_CPU_OPERATOR(FusedElementwise, FusedElementwiseOp);
+
+OPERATOR_SCHEMA(FusedElementwise)
+    .NumInputs(0, INT_MAX)
+    .NumOutputs(0, INT_MAX)
+    .SetDoc(R"DOC(
+Runs the elementwise ops of 'net' as a single operator. The inputs and outputs
+of the operator are bound to the external inputs and outputs of 'net'. The ops
+may be Add, Sub, Mul, Div, LT, LE, GT, GE, EQ, And, Or, Not, Negative, Cast and
+single element ConstantFill, and are evaluated in the operator when their
+inputs have the same shape or, when broadcasting, when their second input has
+a single element. Otherwise 'net' runs as a regular net in the workspace of the
+operator. Produced by the caffe2 script compiler in optimized mode.
+    )DOC")
+    .Arg("net", "Net of the fused elementwise ops")
+    .AllowInplace([](int in, int out) -> bool { return true; });
+
+SHOULD_NOT_DO_GRADIENT(FusedElementwise);
+
+} // namespace caffe2
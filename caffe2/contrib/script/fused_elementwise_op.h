@@ -0,0 +1,111 @@
+#ifndef CAFFE2_CONTRIB_SCRIPT_FUSED_ELEMENTWISE_OP_H_
+#define CAFFE2_CONTRIB_SCRIPT_FUSED_ELEMENTWISE_OP_H_
+
+#include <memory>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/lazy_net.h"
+
+namespace caffe2 {
+
+/**
+ * Runs a chain of elementwise ops as a single operator.
+ *
+ * The 'net' argument holds the fused ops, reading the inputs of the operator
+ * under the names of its external inputs and writing its outputs under the
+ * names of its external outputs. The ops are interpreted in the operator, on
+ * values that never leave it, so the whole chain costs one dispatch. This is
+ * meant for the scalar arithmetic of compiled scripts.
+ *
+ * The chain runs on one block of elements at a time, which goes through every
+ * op before the next block is loaded, so the intermediate values of a block
+ * stay in cache. Values with a single element, like the constants, are
+ * computed once.
+ *
+ * Binary ops must see two tensors of the same shape, or a second tensor with
+ * a single element when broadcasting, and the values with more than one
+ * element must all have the same size. For other shapes or types the net runs
+ * as is, so the results and errors are those of the unfused ops.
+ */
+class FusedElementwiseOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  FusedElementwiseOp(const OperatorDef& operator_def, Workspace* ws);
+
+  bool RunOnDevice() override;
+
+ private:
+  enum class Kind {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Negative,
+    LT,
+    LE,
+    GT,
+    GE,
+    EQ,
+    And,
+    Or,
+    Not,
+    Cast,
+    Constant,
+  };
+
+  // Number of elements each instruction computes at once.
+  static constexpr int kBlockSize = 256;
+
+  struct Instruction {
+    Kind kind;
+    std::vector<int> inputs;
+    int output;
+    bool broadcast = false;
+    // Type of the result of Cast and Constant.
+    TensorProto::DataType type = TensorProto::UNDEFINED;
+    // Value of Constant, depending on its type.
+    double f = 0;
+    int64_t i = 0;
+  };
+
+  // Holds the elements of the current block of a value, or its only element
+  // for a scalar. FLOAT and DOUBLE values are stored in f, the other types in
+  // i.
+  struct Register {
+    TensorProto::DataType type;
+    std::vector<TIndex> dims;
+    bool scalar;
+    std::vector<double> f;
+    std::vector<int64_t> i;
+  };
+
+  // Sets the types and shapes of the registers from the inputs. Returns false
+  // when they are not supported.
+  bool Infer();
+  bool Infer(const Instruction& instruction);
+  void Execute(const Instruction& instruction, int n);
+  void Load(int input, TIndex offset, int n);
+  static void Store(const Register& value, TIndex offset, int n, void* data);
+  template <typename F>
+  static void
+  Arithmetic(const Register& a, const Register& b, int n, Register* out, F f);
+  template <typename F>
+  static void
+  Compare(const Register& a, const Register& b, int n, Register* out, F f);
+  static void Cast(const Register& a, int n, Register* out);
+
+  std::vector<Instruction> instructions_;
+  // Register of each output.
+  std::vector<int> outputs_;
+  // One register per input and per instruction.
+  std::vector<Register> registers_;
+  // Number of elements of the registers that are not scalars.
+  TIndex size_ = 0;
+  std::unique_ptr<LazyNet> fallback_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_SCRIPT_FUSED_ELEMENTWISE_OP_H_
@@ -0,0 +1,364 @@
+#include "optimizer.h"
+
+#include <unordered_map>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+namespace script {
+
+namespace {
+
+// Ops evaluated by FusedElementwise, see fused_elementwise_op.h.
+static std::unordered_set<std::string> binary_elementwise_ops = {
+    "Add", "Sub", "Mul", "Div", "LT", "LE", "GT", "GE", "EQ", "And", "Or",
+};
+
+static std::unordered_set<int> fused_constant_types = {
+    TensorProto::FLOAT,
+    TensorProto::DOUBLE,
+    TensorProto::INT32,
+    TensorProto::INT64,
+    TensorProto::BOOL,
+};
+
+bool isFloating(int type) {
+  return type == TensorProto::FLOAT || type == TensorProto::DOUBLE;
+}
+
+bool isNumeric(int type) {
+  return type != TensorProto::BOOL && fused_constant_types.count(type) > 0;
+}
+
+// Subnets that run in the blob namespace of the op, which the passes look
+// into.
+std::vector<NetDef*> controlFlowSubnets(OperatorDef* op) {
+  std::vector<NetDef*> subnets;
+  if (op->type() == "If" || op->type() == "While") {
+    for (auto& arg : *op->mutable_arg()) {
+      if (arg.has_n()) {
+        subnets.push_back(arg.mutable_n());
+      }
+    }
+  }
+  return subnets;
+}
+
+NetDef* findSubnet(OperatorDef* op, const std::string& name) {
+  for (auto& arg : *op->mutable_arg()) {
+    if (arg.name() == name && arg.has_n()) {
+      return arg.mutable_n();
+    }
+  }
+  return nullptr;
+}
+
+// Names created by DefCompiler::fresh, possibly prefixed by the inlined
+// function that used them.
+bool isTemporary(const std::string& name) {
+  auto p = name.rfind('/');
+  return name.compare(p == std::string::npos ? 0 : p + 1, 2, "$t") == 0;
+}
+
+// Number of reads and writes of each blob, including in subnets.
+struct Usage {
+  void add(const OperatorDef& op) {
+    for (const auto& input : op.input()) {
+      reads[input]++;
+    }
+    for (const auto& output : op.output()) {
+      writes[output]++;
+    }
+    for (const auto& arg : op.arg()) {
+      if (arg.has_n()) {
+        add(arg.n());
+      }
+      for (const auto& net : arg.nets()) {
+        add(net);
+      }
+    }
+  }
+  void add(const NetDef& net) {
+    for (const auto& op : net.op()) {
+      add(op);
+    }
+  }
+  int numReads(const std::string& name) const {
+    auto it = reads.find(name);
+    return it == reads.end() ? 0 : it->second;
+  }
+  int numWrites(const std::string& name) const {
+    auto it = writes.find(name);
+    return it == writes.end() ? 0 : it->second;
+  }
+  std::unordered_map<std::string, int> reads;
+  std::unordered_map<std::string, int> writes;
+};
+
+struct Optimizer {
+  Optimizer(NetDef* net, const std::unordered_set<std::string>& params)
+      : net(net), params(params) {
+    usage.add(*net);
+  }
+
+  void run() {
+    hoistLoopInvariants(net);
+    fuseElementwise(net);
+  }
+
+  void hoistLoopInvariants(NetDef* net) {
+    google::protobuf::RepeatedPtrField<OperatorDef> ops;
+    ops.Swap(net->mutable_op());
+    for (auto& op : ops) {
+      // inner loops first, so what they hoist can leave the outer loops too
+      for (auto* subnet : controlFlowSubnets(&op)) {
+        hoistLoopInvariants(subnet);
+      }
+      if (op.type() == "While") {
+        hoistFromLoop(&op, net);
+      }
+      net->add_op()->Swap(&op);
+    }
+  }
+
+  // Moves the invariant ops of the body of 'loop' to the end of 'net'.
+  void hoistFromLoop(OperatorDef* loop, NetDef* net) {
+    NetDef* body = findSubnet(loop, "loop_net");
+    NetDef* cond = findSubnet(loop, "cond_net");
+    if (!body) {
+      return;
+    }
+    Usage in_loop;
+    in_loop.add(*body);
+    Usage in_cond;
+    if (cond) {
+      in_cond.add(*cond);
+      in_loop.add(*cond);
+    }
+    // blobs read by the body before the current op
+    Usage before;
+    // types of the scalars computed by the ops hoisted so far
+    std::unordered_map<std::string, int> constants;
+    google::protobuf::RepeatedPtrField<OperatorDef> kept;
+    for (auto& op : *body->mutable_op()) {
+      int type = hoistedType(op, constants);
+      bool invariant = type != TensorProto::UNDEFINED;
+      for (const auto& input : op.input()) {
+        invariant &= in_loop.numWrites(input) == 0;
+      }
+      // The outputs must keep their value everywhere they are read: they are
+      // only written by this op, and only read after it in the body.
+      for (const auto& output : op.output()) {
+        invariant &= params.count(output) == 0 &&
+            usage.numWrites(output) == 1 &&
+            usage.numReads(output) == in_loop.numReads(output) &&
+            in_cond.numReads(output) == 0 && before.numReads(output) == 0;
+      }
+      if (invariant) {
+        constants[op.output(0)] = type;
+        in_loop.writes[op.output(0)]--;
+        net->add_op()->Swap(&op);
+      } else {
+        before.add(op);
+        kept.Add()->Swap(&op);
+      }
+    }
+    if (kept.size() < body->op_size()) {
+      VLOG(1) << "Hoisted " << body->op_size() - kept.size()
+              << " loop invariant ops";
+    }
+    body->mutable_op()->Swap(&kept);
+  }
+
+  // The body may not run at all, and the condition guards what it computes,
+  // e.g. the Gather of a list element by an index checked against its size.
+  // Only ops that cannot throw are thus hoisted: scalar constants and the
+  // elementwise ops of scalars hoisted before them, except integer division.
+  // Returns the type of the scalar 'op' computes, or UNDEFINED when it may
+  // not be hoisted.
+  int hoistedType(
+      const OperatorDef& op,
+      const std::unordered_map<std::string, int>& constants) {
+    if (!isFusable(op)) {
+      return TensorProto::UNDEFINED;
+    }
+    std::vector<int> types;
+    for (const auto& input : op.input()) {
+      auto it = constants.find(input);
+      if (it == constants.end()) {
+        return TensorProto::UNDEFINED;
+      }
+      types.push_back(it->second);
+    }
+    ArgumentHelper args(op);
+    const auto& name = op.type();
+    if (name == "ConstantFill") {
+      // the op infers the type from the value when there is no dtype
+      const Argument* value = nullptr;
+      for (const auto& arg : op.arg()) {
+        if (arg.name() == "value") {
+          value = &arg;
+        }
+      }
+      int type = value && value->has_i() ? TensorProto::INT64
+                                         : TensorProto::FLOAT;
+      type = args.GetSingleArgument<int>("dtype", type);
+      // the value is read from the field of the type, losslessly
+      if (!value) {
+        return type;
+      }
+      if (isFloating(type)) {
+        return value->has_f() ? type : TensorProto::UNDEFINED;
+      }
+      bool fits = value->has_i() &&
+          (type != TensorProto::INT32 ||
+           value->i() == static_cast<int32_t>(value->i()));
+      return fits ? type : TensorProto::UNDEFINED;
+    }
+    if (types.size() == 1 && name == "Cast") {
+      int to = args.GetSingleArgument<int>("to", TensorProto::UNDEFINED);
+      return fused_constant_types.count(to) ? to : TensorProto::UNDEFINED;
+    }
+    if (types.size() == 1 && name == "Negative" && isNumeric(types[0])) {
+      return types[0];
+    }
+    if (types.size() == 1 && name == "Not" && types[0] == TensorProto::BOOL) {
+      return TensorProto::BOOL;
+    }
+    if (types.size() != 2 || types[0] != types[1]) {
+      return TensorProto::UNDEFINED;
+    }
+    int type = types[0];
+    if ((name == "Add" || name == "Sub" || name == "Mul") && isNumeric(type)) {
+      return type;
+    }
+    if (name == "Div" && isFloating(type)) {
+      return type;
+    }
+    if ((name == "LT" || name == "LE" || name == "GT" || name == "GE" ||
+         name == "EQ") &&
+        isNumeric(type)) {
+      return TensorProto::BOOL;
+    }
+    if ((name == "And" || name == "Or") && type == TensorProto::BOOL) {
+      return TensorProto::BOOL;
+    }
+    return TensorProto::UNDEFINED;
+  }
+
+  bool isFusable(const OperatorDef& op) {
+    if (op.output_size() != 1 || !op.engine().empty() ||
+        op.has_device_option()) {
+      return false;
+    }
+    const auto& type = op.type();
+    bool binary = binary_elementwise_ops.count(type) > 0;
+    if (!binary && type != "Negative" && type != "Not" && type != "Cast" &&
+        type != "ConstantFill") {
+      return false;
+    }
+    for (const auto& arg : op.arg()) {
+      const auto& name = arg.name();
+      // broadcast is set on every op emitted for an expression
+      bool known = name == "broadcast" && arg.has_i();
+      if (type == "Cast") {
+        known |= name == "to" && arg.has_i();
+      } else if (type == "ConstantFill") {
+        known |= name == "value" ||
+            (name == "dtype" && fused_constant_types.count(arg.i())) ||
+            (name == "shape" && arg.ints_size() == 1 && arg.ints(0) == 1);
+      }
+      if (!known) {
+        return false;
+      }
+    }
+    if (type == "Cast") {
+      return ArgumentHelper::HasArgument(op, "to");
+    }
+    if (type == "ConstantFill") {
+      return op.input_size() == 0 && ArgumentHelper::HasArgument(op, "shape");
+    }
+    return true;
+  }
+
+  void fuseElementwise(NetDef* net) {
+    google::protobuf::RepeatedPtrField<OperatorDef> ops;
+    ops.Swap(net->mutable_op());
+    int i = 0;
+    while (i < ops.size()) {
+      int end = i;
+      while (end < ops.size() && isFusable(ops.Get(end))) {
+        end++;
+      }
+      if (end - i >= 2) {
+        fuse(ops, i, end, net->add_op());
+        i = end;
+        continue;
+      }
+      auto& op = *ops.Mutable(i);
+      for (auto* subnet : controlFlowSubnets(&op)) {
+        fuseElementwise(subnet);
+      }
+      net->add_op()->Swap(&op);
+      i++;
+    }
+  }
+
+  void fuse(
+      const google::protobuf::RepeatedPtrField<OperatorDef>& ops,
+      int begin,
+      int end,
+      OperatorDef* fused) {
+    fused->set_type("FusedElementwise");
+    auto* arg = fused->add_arg();
+    arg->set_name("net");
+    auto* body = arg->mutable_n();
+    Usage in_run;
+    std::unordered_set<std::string> written;
+    std::unordered_set<std::string> read_before_write;
+    std::vector<std::string> outputs;
+    for (int i = begin; i < end; i++) {
+      const auto& op = ops.Get(i);
+      for (const auto& input : op.input()) {
+        if (!written.count(input) &&
+            read_before_write.insert(input).second) {
+          body->add_external_input(input);
+          fused->add_input(input);
+        }
+      }
+      for (const auto& output : op.output()) {
+        if (written.insert(output).second) {
+          outputs.push_back(output);
+        }
+      }
+      in_run.add(op);
+      body->add_op()->CopyFrom(op);
+    }
+    for (const auto& output : outputs) {
+      bool internal = isTemporary(output) && params.count(output) == 0 &&
+          usage.numWrites(output) == 1 && !read_before_write.count(output) &&
+          usage.numReads(output) == in_run.numReads(output);
+      if (!internal) {
+        body->add_external_output(output);
+        fused->add_output(output);
+      }
+    }
+  }
+
+  NetDef* net;
+  const std::unordered_set<std::string>& params;
+  // usage in the whole function, which hoisting does not change
+  Usage usage;
+};
+
+} // namespace
+
+void optimizeFunction(
+    NetDef* net,
+    const std::unordered_set<std::string>& params) {
+  Optimizer(net, params).run();
+}
+
+} // namespace script
+} // namespace caffe2
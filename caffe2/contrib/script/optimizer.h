@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+namespace script {
+
+// Rewrites the NetDef of a compiled function so that it dispatches fewer
+// operators:
+//  - scalar constants of While bodies, and the elementwise ops computing
+//    scalars from them, are moved before the While op. They then run once,
+//    even when the loop does not iterate, so only ops that cannot throw are
+//    moved;
+//  - runs of consecutive elementwise ops on scalars or small tensors, which
+//    the compiler emits for arithmetic and comparisons, are fused into single
+//    FusedElementwise ops. Temporaries only used inside a run are no longer
+//    written to the workspace.
+// 'params' are the inputs and outputs of the function; they are never
+// written by hoisted ops and always written by fused ops.
+void optimizeFunction(
+    NetDef* net,
+    const std::unordered_set<std::string>& params);
+
+} // namespace script
+} // namespace caffe2
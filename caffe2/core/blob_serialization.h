@@ -393,6 +393,14 @@ void TensorSerializer<Context>::Serialize(
           &this->context_);
     }
   } break;
+  case TensorProto_DataType_BFLOAT16:
+    detail::CopyToProtoWithCast(
+        chunkSize,
+        reinterpret_cast<const uint16_t*>(input.template data<bfloat16>()) +
+            chunkBegin,
+        proto.mutable_int32_data(),
+        &this->context_);
+    break;
   case TensorProto_DataType_DOUBLE:
     detail::CopyToProtoAsIs(
         chunkSize,
@@ -555,6 +563,15 @@ void TensorDeserializer<Context>::Deserialize(
             &context);
       }
       break;
+    case TensorProto_DataType_BFLOAT16:
+      detail::CopyFromProtoWithCast(
+          chunkSize,
+          proto.int32_data(),
+          reinterpret_cast<uint16_t*>(
+              tensor->template mutable_data<bfloat16>()) +
+              chunkBegin,
+          &context);
+      break;
     case TensorProto_DataType_DOUBLE:
       detail::CopyFromProtoAsIs(
           chunkSize,
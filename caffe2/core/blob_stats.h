@@ -10,6 +10,9 @@ namespace caffe2 {
 
 struct BlobStatGetter {
   virtual size_t sizeBytes(const Blob& blob) const = 0;
+  virtual size_t allocations(const Blob& /* unused */) const {
+    return 0;
+  }
   virtual ~BlobStatGetter() {}
 };
 
@@ -42,5 +45,12 @@ namespace BlobStat {
  * If not available, return 0.
  */
 size_t sizeBytes(const Blob& blob);
+
+/**
+ * Return the number of times the blob's storage was allocated, if available
+ * for a blob of given type. A count above one means the blob reallocated,
+ * e.g. because it kept growing across runs. If not available, return 0.
+ */
+size_t allocations(const Blob& blob);
 }
 }
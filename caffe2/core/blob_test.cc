@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 #include "caffe2/core/blob.h"
 #include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/blob_stats.h"
 #include "caffe2/core/common.h"
 #include "caffe2/core/context.h"
 #include "caffe2/core/db.h"
@@ -478,6 +479,86 @@ TYPED_TEST(TensorCPUTest, MaxKeepOnShrink) {
   FLAGS_caffe2_max_keep_on_shrink_memory = LLONG_MAX;
 }
 
+TYPED_TEST(TensorCPUTest, GrowthPolicyHighWaterMark) {
+  FLAGS_caffe2_keep_on_shrink = false;
+
+  TensorCPU tensor(vector<int>{4, 8});
+  TensorGrowthPolicy policy;
+  policy.keep_high_water_mark = true;
+  tensor.SetGrowthPolicy(policy);
+  TypeParam* ptr = tensor.mutable_data<TypeParam>();
+  // Shrinking keeps the storage even though keep_on_shrink is off.
+  tensor.Resize(1, 8);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  tensor.Resize(4, 8);
+  EXPECT_EQ(ptr, tensor.mutable_data<TypeParam>());
+  EXPECT_EQ(tensor.allocation_count(), 1);
+
+  FLAGS_caffe2_keep_on_shrink = true;
+}
+
+TYPED_TEST(TensorCPUTest, GrowthPolicyGeometric) {
+  TensorCPU tensor(vector<int>{10, 16});
+  TensorGrowthPolicy policy;
+  policy.growth_pct = 100;
+  tensor.SetGrowthPolicy(policy);
+  tensor.mutable_data<TypeParam>();
+  // The first allocation is exact.
+  EXPECT_EQ(tensor.capacity_nbytes(), 10 * 16 * sizeof(TypeParam));
+  // Growing by one row doubles the capacity...
+  tensor.Resize(11, 16);
+  tensor.mutable_data<TypeParam>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 20 * 16 * sizeof(TypeParam));
+  // ... so that the following growth steps reuse the storage.
+  for (int rows = 12; rows <= 20; ++rows) {
+    tensor.Resize(rows, 16);
+    tensor.mutable_data<TypeParam>();
+  }
+  EXPECT_EQ(tensor.allocation_count(), 2);
+}
+
+TEST(TensorTest, GrowthPolicySizeClass) {
+  EXPECT_EQ(TensorGrowthPolicy::RoundToSizeClass(1), 64);
+  EXPECT_EQ(TensorGrowthPolicy::RoundToSizeClass(64), 64);
+  EXPECT_EQ(TensorGrowthPolicy::RoundToSizeClass(65), 80);
+  EXPECT_EQ(TensorGrowthPolicy::RoundToSizeClass(1000), 1024);
+  EXPECT_EQ(TensorGrowthPolicy::RoundToSizeClass(1025), 1280);
+
+  TensorCPU tensor(vector<int>{250});
+  TensorGrowthPolicy policy;
+  policy.round_to_size_class = true;
+  tensor.SetGrowthPolicy(policy);
+  float* ptr = tensor.mutable_data<float>();
+  EXPECT_EQ(tensor.capacity_nbytes(), 1024);
+  // Growing within the size class does not reallocate.
+  tensor.Resize(256);
+  EXPECT_EQ(ptr, tensor.mutable_data<float>());
+  EXPECT_EQ(tensor.allocation_count(), 1);
+}
+
+TEST(TensorTest, GrowthPolicyFromNetArguments) {
+  Workspace ws;
+  NetDef net_def;
+  net_def.set_name("growth_policy_net");
+  auto* op_def = net_def.add_op();
+  op_def->set_type("ConstantFill");
+  op_def->add_output("out");
+  AddArgument<vector<int>>("shape", vector<int>{10}, op_def);
+  net_def.add_arg()->CopyFrom(MakeArgument<float>("tensor_growth_pct", 50));
+  net_def.add_arg()->CopyFrom(
+      MakeArgument<int>("tensor_keep_high_water_mark", 1));
+
+  auto* net = ws.CreateNet(net_def);
+  ASSERT_TRUE(net != nullptr);
+  ASSERT_TRUE(net->Run());
+  const auto& policy =
+      ws.GetBlob("out")->Get<TensorCPU>().growth_policy();
+  EXPECT_FLOAT_EQ(policy.growth_pct, 50);
+  EXPECT_TRUE(policy.keep_high_water_mark);
+  EXPECT_FALSE(policy.round_to_size_class);
+  EXPECT_EQ(BlobStat::allocations(*ws.GetBlob("out")), 1);
+}
+
 TYPED_TEST(TensorCPUDeathTest, CannotAccessRawDataWhenEmpty) {
   TensorCPU tensor;
   EXPECT_EQ(tensor.ndim(), 0);
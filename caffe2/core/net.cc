@@ -100,6 +100,40 @@ void AddGlobalNetObserverCreator(NetObserverCreator creator) {
   VLOG(1) << "Have set a custom GlobalNetObserverCreator";
 }
 
+void ApplyNetArgumentsToOperators(const NetDef& net_def, NetBase* net) {
+  // Net-level growth policy applies to every operator that does not set
+  // its own.
+  ArgumentHelper net_args(net_def);
+  TensorGrowthPolicy policy;
+  if (GetTensorGrowthPolicyFromArguments(net_args, &policy)) {
+    for (auto* op : net->GetOperators()) {
+      if (!op->has_tensor_growth_policy()) {
+        op->set_tensor_growth_policy(policy);
+      }
+    }
+  }
+  // Likewise for blob pointer caching, unless the operator says otherwise.
+  if (net_args.HasArgument("cache_blob_pointers")) {
+    const bool cache =
+        net_args.GetSingleArgument<bool>("cache_blob_pointers", false);
+    for (auto* op : net->GetOperators()) {
+      if (!op->HasArgument("cache_blob_pointers")) {
+        op->set_cache_blob_pointers(cache);
+      }
+    }
+  }
+  // And for scratch arenas.
+  if (net_args.HasArgument("use_scratch_arena")) {
+    const bool use_arena =
+        net_args.GetSingleArgument<bool>("use_scratch_arena", false);
+    for (auto* op : net->GetOperators()) {
+      if (!op->HasArgument("use_scratch_arena")) {
+        op->set_use_scratch_arena(use_arena);
+      }
+    }
+  }
+}
+
 unique_ptr<NetBase> CreateNet(const NetDef& net_def, Workspace* ws) {
   std::shared_ptr<NetDef> tmp_net_def(new NetDef(net_def));
   return CreateNet(tmp_net_def, ws);
@@ -116,6 +150,9 @@ unique_ptr<NetBase> CreateNet(
   } else {
     net = NetRegistry()->Create(net_def->type(), net_def, ws);
   }
+  if (net) {
+    ApplyNetArgumentsToOperators(*net_def, net.get());
+  }
   VLOG(1) << "Adding a global observer to a net";
   if (net) {
     auto* observer_creators = GetNetObserverCreators();
@@ -147,6 +147,13 @@ unique_ptr<NetBase> CreateNet(
 
 void AddGlobalNetObserverCreator(NetObserverCreator creator);
 
+/**
+ * @brief Applies the net-level operator arguments of net_def (tensor growth
+ * policy, blob pointer caching and scratch arenas) to the operators of net
+ * that do not set them. CreateNet calls it on every net it creates.
+ */
+void ApplyNetArgumentsToOperators(const NetDef& net_def, NetBase* net);
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_NET_H_
@@ -0,0 +1,85 @@
+#include "caffe2/core/net_shape_specialized.h"
+
+#include "caffe2/core/net_simple.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+ShapeSpecializedNet::ShapeSpecializedNet(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws)
+    : NetBase(net_def, ws), ws_(ws), last_plan_(nullptr) {
+  VLOG(1) << "Constructing ShapeSpecializedNet " << net_def->name();
+  ArgumentHelper net_args(*net_def);
+  const int max_plans =
+      net_args.GetSingleArgument<int>("max_shape_plans", 8);
+  CAFFE_ENFORCE_GE(max_plans, 0, "max_shape_plans must be non-negative");
+  max_plans_ = max_plans;
+  // Outputs are created in the parent workspace so that they outlive the
+  // plans and can be fetched from it.
+  for (const auto& output : external_output_) {
+    ws->CreateBlob(output);
+  }
+  fallback_plan_ = CreatePlan();
+  last_plan_ = fallback_plan_.get();
+}
+
+std::unique_ptr<ShapeSpecializedNet::Plan> ShapeSpecializedNet::CreatePlan()
+    const {
+  std::unique_ptr<Plan> plan(new Plan());
+  plan->ws.reset(new Workspace(ws_));
+  plan->net.reset(new SimpleNet(net_def_, plan->ws.get()));
+  ApplyNetArgumentsToOperators(*net_def_, plan->net.get());
+  return plan;
+}
+
+void ShapeSpecializedNet::ComputeShapeKey(vector<TIndex>* key) const {
+  key->clear();
+  for (const auto& input : external_input_) {
+    const Blob* blob = ws_->GetBlob(input);
+    if (!blob) {
+      key->push_back(-1);
+      continue;
+    }
+    key->push_back(static_cast<TIndex>(blob->meta().id()));
+    auto info = GetTensorInfoFunction(blob->meta().id());
+    if (!info) {
+      key->push_back(-1);
+      continue;
+    }
+    bool shares_data = false;
+    size_t capacity;
+    DeviceOption device;
+    const auto dims = info(blob->GetRaw(), &shares_data, &capacity, &device);
+    key->push_back(dims.size());
+    key->insert(key->end(), dims.begin(), dims.end());
+  }
+}
+
+bool ShapeSpecializedNet::Run() {
+  StartAllObservers();
+  ComputeShapeKey(&key_);
+  if (key_ != last_key_) {
+    auto it = plans_.find(key_);
+    if (it != plans_.end()) {
+      last_plan_ = it->second.get();
+    } else if (plans_.size() < max_plans_) {
+      VLOG(1) << "Creating plan " << plans_.size() << " of net " << name_;
+      auto plan = CreatePlan();
+      last_plan_ = plan.get();
+      plans_.emplace(key_, std::move(plan));
+    } else {
+      last_plan_ = fallback_plan_.get();
+    }
+    last_key_.swap(key_);
+  }
+  if (!last_plan_->net->Run()) {
+    return false;
+  }
+  StopAllObservers();
+  return true;
+}
+
+REGISTER_NET(shape_specialized, ShapeSpecializedNet);
+
+} // namespace caffe2
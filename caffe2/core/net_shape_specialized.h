@@ -0,0 +1,80 @@
+#ifndef CAFFE2_CORE_NET_SHAPE_SPECIALIZED_H_
+#define CAFFE2_CORE_NET_SHAPE_SPECIALIZED_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+// A net that keeps one instance of its operators per tuple of input shapes.
+//
+// Every run looks up the types and shapes of the external inputs. The first
+// run with a given tuple instantiates the operators in a child workspace of
+// its own, and later runs with the same tuple reuse them, so intermediate
+// blobs and the state operators keep across runs (bias multipliers, scratch
+// buffers, cached blob pointers) are already sized for those shapes. Inputs
+// and external outputs live in the parent workspace.
+//
+// At most max_shape_plans (default 8) tuples get a plan of their own; runs
+// with other shapes share a fallback plan, which behaves like a SimpleNet.
+// Each plan holds its own intermediate blobs, so memory grows with the
+// number of plans.
+class ShapeSpecializedNet : public NetBase {
+ public:
+  ShapeSpecializedNet(
+      const std::shared_ptr<const NetDef>& net_def,
+      Workspace* ws);
+
+  bool SupportsAsync() override {
+    return false;
+  }
+
+  bool Run() override;
+
+  // Returns the operators of the plan of the last run, or of the fallback
+  // plan before the first run.
+  vector<OperatorBase*> GetOperators() const override {
+    return last_plan_->net->GetOperators();
+  }
+
+  // The number of shape tuples with a plan of their own.
+  size_t num_plans() const {
+    return plans_.size();
+  }
+
+ protected:
+  bool RunAsync() override {
+    return Run();
+  }
+
+ private:
+  struct Plan {
+    std::unique_ptr<Workspace> ws;
+    std::unique_ptr<NetBase> net;
+  };
+
+  std::unique_ptr<Plan> CreatePlan() const;
+  // Fills key with the type and shape of every external input.
+  void ComputeShapeKey(vector<TIndex>* key) const;
+
+  Workspace* ws_;
+  size_t max_plans_;
+  std::map<vector<TIndex>, std::unique_ptr<Plan>> plans_;
+  std::unique_ptr<Plan> fallback_plan_;
+  Plan* last_plan_;
+  vector<TIndex> last_key_;
+  vector<TIndex> key_;
+
+  DISABLE_COPY_AND_ASSIGN(ShapeSpecializedNet);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NET_SHAPE_SPECIALIZED_H_
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "caffe2/core/net.h"
 #include "caffe2/core/net_dag.h"
+#include "caffe2/core/net_shape_specialized.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/scope_guard.h"
 
@@ -580,4 +581,99 @@ TEST(NetTest, FailingOperator) {
   }
 }
 
+namespace {
+
+const char* kShapeSpecializedSpec = R"DOC(
+        name: "example"
+        type: "shape_specialized"
+        external_input: "X"
+        external_input: "W"
+        external_input: "b"
+        external_output: "Y"
+        op {
+          input: "X"
+          input: "W"
+          input: "b"
+          output: "hidden"
+          type: "FC"
+        }
+        op {
+          input: "hidden"
+          output: "Y"
+          type: "Relu"
+        }
+)DOC";
+
+void FillTensor(Workspace* ws, const string& name, vector<TIndex> dims) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  auto* data = tensor->mutable_data<float>();
+  for (int i = 0; i < tensor->size(); ++i) {
+    data[i] = (i % 7) - 3.0f;
+  }
+}
+
+// Runs net_def with X of the given batch sizes, and checks the outputs
+// against a simple net.
+void CheckShapeSpecializedNet(
+    const NetDef& net_def,
+    const vector<int>& batch_sizes) {
+  Workspace ws;
+  FillTensor(&ws, "W", {4, 3});
+  FillTensor(&ws, "b", {4});
+  FillTensor(&ws, "X", {1, 3});
+  NetDef simple_def(net_def);
+  simple_def.clear_type();
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  ASSERT_TRUE(net);
+  Workspace ref_ws;
+  for (const auto& name : {"W", "b"}) {
+    ref_ws.CreateBlob(name)->GetMutable<TensorCPU>()->CopyFrom(
+        ws.GetBlob(name)->Get<TensorCPU>());
+  }
+  for (int batch_size : batch_sizes) {
+    FillTensor(&ws, "X", {batch_size, 3});
+    FillTensor(&ref_ws, "X", {batch_size, 3});
+    ASSERT_TRUE(net->Run());
+    ASSERT_TRUE(ref_ws.RunNetOnce(simple_def));
+    const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+    const auto& expected = ref_ws.GetBlob("Y")->Get<TensorCPU>();
+    ASSERT_EQ(Y.dims(), expected.dims());
+    for (int i = 0; i < Y.size(); ++i) {
+      EXPECT_EQ(Y.data<float>()[i], expected.data<float>()[i]);
+    }
+  }
+  // Intermediate blobs are kept by the plans.
+  EXPECT_FALSE(ws.HasBlob("hidden"));
+}
+
+} // namespace
+
+TEST(NetTest, ShapeSpecializedNetCachesPlans) {
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kShapeSpecializedSpec, &net_def));
+  CheckShapeSpecializedNet(net_def, {2, 5, 2, 2, 5});
+
+  Workspace ws;
+  FillTensor(&ws, "W", {4, 3});
+  FillTensor(&ws, "b", {4});
+  FillTensor(&ws, "X", {2, 3});
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  auto* specialized = dynamic_cast<ShapeSpecializedNet*>(net.get());
+  ASSERT_TRUE(specialized);
+  EXPECT_EQ(specialized->num_plans(), 0);
+  for (int batch_size : {2, 5, 2, 5}) {
+    FillTensor(&ws, "X", {batch_size, 3});
+    ASSERT_TRUE(net->Run());
+  }
+  EXPECT_EQ(specialized->num_plans(), 2);
+}
+
+TEST(NetTest, ShapeSpecializedNetFallback) {
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kShapeSpecializedSpec, &net_def));
+  net_def.add_arg()->CopyFrom(MakeArgument<int>("max_shape_plans", 1));
+  CheckShapeSpecializedNet(net_def, {2, 5, 3, 2, 5});
+}
+
 } // namespace caffe2
@@ -0,0 +1,835 @@
+#include "nomnigraph/Transformations/Caffe2Rewrites.h"
+#include "nomnigraph/Converters/Caffe2.h"
+
+#include "nomnigraph/Support/Casting.h"
+#include "nomnigraph/Support/Pointer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <unordered_set>
+
+namespace nom {
+namespace transformations {
+
+using namespace repr;
+
+namespace {
+
+using NodeRef = NNGraph::NodeRef;
+using ContextPtr = std::shared_ptr<Caffe2RewriteContext>;
+
+caffe2::OperatorDef *getOperatorDef(NodeRef node) {
+  auto *annotation = nn::get<NeuralNetOperator>(node)->getMutableAnnotation();
+  assert(annotation && annotation->getSaved() &&
+         "Operator was not converted from a Caffe2 net.");
+  return reinterpret_cast<caffe2::OperatorDef *>(annotation->getSaved());
+}
+
+caffe2::Argument *getArgument(caffe2::OperatorDef *op,
+                              const std::string &name) {
+  for (auto &arg : *op->mutable_arg()) {
+    if (arg.name() == name) {
+      return &arg;
+    }
+  }
+  return nullptr;
+}
+
+int64_t getIntArgument(caffe2::OperatorDef *op, const std::string &name,
+                       int64_t defaultValue) {
+  auto *arg = getArgument(op, name);
+  return arg && arg->has_i() ? arg->i() : defaultValue;
+}
+
+std::vector<int64_t> getIntsArgument(caffe2::OperatorDef *op,
+                                     const std::string &name) {
+  auto *arg = getArgument(op, name);
+  return arg ? std::vector<int64_t>(arg->ints().begin(), arg->ints().end())
+             : std::vector<int64_t>();
+}
+
+/// \brief Concat and Split take their axis either as an argument or from a
+/// storage order.
+bool getConcatAxis(caffe2::OperatorDef *op, int64_t *axis, int64_t *addAxis) {
+  if (getArgument(op, "axis")) {
+    *axis = getIntArgument(op, "axis", -1);
+    *addAxis = getIntArgument(op, "add_axis", 0);
+    return true;
+  }
+  auto *order = getArgument(op, "order");
+  *addAxis = 0;
+  if (!order || order->s() == "NCHW") {
+    *axis = 1;
+  } else if (order->s() == "NHWC") {
+    *axis = 3;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool sameConcatAxis(NodeRef a, NodeRef b) {
+  int64_t axisA, addAxisA, axisB, addAxisB;
+  return getConcatAxis(getOperatorDef(a), &axisA, &addAxisA) &&
+         getConcatAxis(getOperatorDef(b), &axisB, &addAxisB) &&
+         axisA == axisB && addAxisA == addAxisB;
+}
+
+const std::string getName(NodeRef tensor) {
+  return nn::get<NeuralNetData>(tensor)->getName();
+}
+
+bool isExternalOutput(const Caffe2RewriteContext &context, NodeRef tensor) {
+  return context.ExternalOutputs.count(getName(tensor));
+}
+
+bool isUnused(const Caffe2RewriteContext &context, NodeRef tensor) {
+  return tensor->getOutEdges().size() == 0 && !isExternalOutput(context, tensor);
+}
+
+bool hasSingleUse(NodeRef tensor, NodeRef consumer) {
+  return tensor->getOutEdges().size() == 1 &&
+         tensor->getOutEdges().front()->head() == consumer;
+}
+
+/// \brief Caffe2 nets refer to blobs by name, so the consumers of \p from
+/// may only read \p to instead when no other operator writes that name in
+/// between.  This is conservatively checked by requiring that the only
+/// versions of the name of \p to are \p to, \p from and the tensors
+/// \p removed by the rewrite.
+bool canForward(NNGraph *g, NodeRef to, NodeRef from,
+                const std::vector<NodeRef> &removed = {}) {
+  const auto name = getName(to);
+  for (auto node : g->getMutableNodes()) {
+    if (node == to || node == from || !nn::is<NeuralNetData>(node) ||
+        getName(node) != name) {
+      continue;
+    }
+    // Leftovers of earlier rewrites, neither produced nor consumed.
+    if (node->getInEdges().size() == 0 && node->getOutEdges().size() == 0) {
+      continue;
+    }
+    if (std::find(removed.begin(), removed.end(), node) == removed.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \brief Whether a consumer of \p tensor writes its name in place, as
+/// ScatterWeightedSum(Y, ...) -> Y does.  Such a consumer must keep reading
+/// a blob of that name.
+bool isUpdatedInPlace(NodeRef tensor) {
+  const auto name = getName(tensor);
+  for (auto edge : tensor->getOutEdges()) {
+    for (auto output : nn::getOutputs(edge->head())) {
+      if (getName(output) == name) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+RewriteRule removeIdentity(const std::string &type, ContextPtr context) {
+  return RewriteRule(
+      "Remove" + type, {type},
+      [type, context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto op = ops[0];
+        if (type == "Dropout" &&
+            !getIntArgument(getOperatorDef(op), "is_test", 0)) {
+          return false;
+        }
+        auto inputs = nn::getInputs(op);
+        auto outputs = nn::getOutputs(op);
+        if (inputs.size() != 1 || outputs.size() < 1) {
+          return false;
+        }
+        for (size_t i = 1; i < outputs.size(); ++i) {
+          if (!isUnused(*context, outputs[i])) {
+            return false;
+          }
+        }
+        auto X = inputs[0];
+        auto Y = outputs[0];
+        // An external output is still produced, and in-place consumers still
+        // update the blob they read, only if the op ran in place.
+        if (getName(X) != getName(Y) &&
+            (isExternalOutput(*context, Y) || isUpdatedInPlace(Y))) {
+          return false;
+        }
+        if (!canForward(&m->dataFlow, X, Y)) {
+          return false;
+        }
+        rewrite::replaceAllUsesWith(&m->dataFlow, Y, X);
+        rewrite::deleteOperator(&m->dataFlow, op);
+        return true;
+      });
+}
+
+/// Reshape(Reshape(X)) -> Reshape(X), when the second shape is explicit.
+RewriteRule collapseReshapes(ContextPtr context) {
+  return RewriteRule(
+      "CollapseReshapes", {"Reshape", "Reshape"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto first = ops[0];
+        auto second = ops[1];
+        auto firstOutputs = nn::getOutputs(first);
+        auto secondInputs = nn::getInputs(second);
+        auto secondOutputs = nn::getOutputs(second);
+        // The second shape must not be given as an input, nor copy
+        // dimensions (0) of the intermediate shape.
+        auto shape = getIntsArgument(getOperatorDef(second), "shape");
+        if (secondInputs.size() != 1 || shape.empty() ||
+            std::find(shape.begin(), shape.end(), 0) != shape.end()) {
+          return false;
+        }
+        auto T = secondInputs[0];
+        if (firstOutputs[0] != T || !hasSingleUse(T, second) ||
+            isExternalOutput(*context, T)) {
+          return false;
+        }
+        // The old shape outputs would change or disappear.
+        for (size_t i = 1; i < firstOutputs.size(); ++i) {
+          if (!isUnused(*context, firstOutputs[i])) {
+            return false;
+          }
+        }
+        for (size_t i = 1; i < secondOutputs.size(); ++i) {
+          if (!isUnused(*context, secondOutputs[i])) {
+            return false;
+          }
+        }
+        auto X = nn::getInputs(first)[0];
+        if (!canForward(&m->dataFlow, X, T)) {
+          return false;
+        }
+        rewrite::replaceAllUsesWith(&m->dataFlow, T, X);
+        rewrite::deleteOperator(&m->dataFlow, first);
+        return true;
+      });
+}
+
+/// Transpose(Transpose(X, a), b) -> Transpose(X, c) with c[i] = a[b[i]],
+/// or X when c is the identity.
+RewriteRule mergeTransposes(ContextPtr context) {
+  return RewriteRule(
+      "MergeTransposes", {"Transpose", "Transpose"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto first = ops[0];
+        auto second = ops[1];
+        auto a = getIntsArgument(getOperatorDef(first), "axes");
+        auto b = getIntsArgument(getOperatorDef(second), "axes");
+        // The default axes reverse the dimensions, which needs the rank.
+        if (a.empty() || a.size() != b.size()) {
+          return false;
+        }
+        const int64_t ndim = a.size();
+        std::vector<int64_t> c(ndim);
+        bool identity = true;
+        for (int64_t i = 0; i < ndim; ++i) {
+          if (b[i] < 0 || b[i] >= ndim) {
+            return false;
+          }
+          c[i] = a[b[i]];
+          identity &= c[i] == i;
+        }
+
+        auto X = nn::getInputs(first)[0];
+        auto T = nn::getOutputs(first)[0];
+        auto Y = nn::getOutputs(second)[0];
+        if (nn::getInputs(second)[0] != T || !hasSingleUse(T, second) ||
+            isExternalOutput(*context, T)) {
+          return false;
+        }
+        auto *g = &m->dataFlow;
+        if (identity && !isExternalOutput(*context, Y) &&
+            canForward(g, X, Y, {T})) {
+          rewrite::replaceAllUsesWith(g, Y, X);
+          rewrite::deleteOperator(g, second);
+          rewrite::deleteOperator(g, first);
+          return true;
+        }
+        // An external output keeps its name, so the producer of X writes
+        // it instead.
+        if (identity && isExternalOutput(*context, Y) && nn::hasProducer(X) &&
+            nn::getOutputs(nn::getProducer(X)).size() == 1 &&
+            hasSingleUse(X, first) && !isExternalOutput(*context, X) &&
+            canForward(g, Y, X, {T})) {
+          auto producer = nn::getProducer(X);
+          g->deleteNode(second);
+          g->deleteNode(first);
+          g->deleteNode(T);
+          g->deleteNode(X);
+          g->createEdge(producer, Y);
+          return true;
+        }
+        if (!canForward(g, X, T)) {
+          return false;
+        }
+        auto *axes = getArgument(getOperatorDef(second), "axes");
+        axes->clear_ints();
+        for (auto axis : c) {
+          axes->add_ints(axis);
+        }
+        rewrite::replaceAllUsesWith(g, T, X);
+        rewrite::deleteOperator(g, first);
+        return true;
+      });
+}
+
+/// Concat(Split(X)) -> X, when the Concat takes every output of the Split
+/// in order.
+RewriteRule eliminateSplitConcat(ContextPtr context) {
+  return RewriteRule(
+      "EliminateSplitConcat", {"Split", "Concat"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto split = ops[0];
+        auto concat = ops[1];
+        if (!sameConcatAxis(split, concat)) {
+          return false;
+        }
+        auto parts = nn::getOutputs(split);
+        if (parts != nn::getInputs(concat)) {
+          return false;
+        }
+        for (auto part : parts) {
+          if (!hasSingleUse(part, concat) || isExternalOutput(*context, part)) {
+            return false;
+          }
+        }
+        auto concatOutputs = nn::getOutputs(concat);
+        for (size_t i = 1; i < concatOutputs.size(); ++i) {
+          if (!isUnused(*context, concatOutputs[i])) {
+            return false;
+          }
+        }
+        auto X = nn::getInputs(split)[0];
+        auto Y = concatOutputs[0];
+        if (isExternalOutput(*context, Y) ||
+            !canForward(&m->dataFlow, X, Y, parts)) {
+          return false;
+        }
+        rewrite::replaceAllUsesWith(&m->dataFlow, Y, X);
+        rewrite::deleteOperator(&m->dataFlow, concat);
+        rewrite::deleteOperator(&m->dataFlow, split);
+        return true;
+      });
+}
+
+/// Split(Concat(A, B, ...), split_info) -> A, B, ... when the Split uses the
+/// split information output by the Concat.
+RewriteRule eliminateConcatSplit(ContextPtr context) {
+  return RewriteRule(
+      "EliminateConcatSplit", {"Concat", "Split"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto concat = ops[0];
+        auto split = ops[1];
+        if (!sameConcatAxis(concat, split)) {
+          return false;
+        }
+        auto concatOutputs = nn::getOutputs(concat);
+        if (concatOutputs.size() != 2 ||
+            nn::getInputs(split) != concatOutputs) {
+          return false;
+        }
+        auto parts = nn::getInputs(concat);
+        auto outputs = nn::getOutputs(split);
+        if (parts.size() != outputs.size()) {
+          return false;
+        }
+        auto *g = &m->dataFlow;
+        for (size_t i = 0; i < parts.size(); ++i) {
+          if (isExternalOutput(*context, outputs[i]) ||
+              !canForward(g, parts[i], outputs[i], concatOutputs)) {
+            return false;
+          }
+        }
+        for (size_t i = 0; i < parts.size(); ++i) {
+          rewrite::replaceAllUsesWith(g, outputs[i], parts[i]);
+        }
+        rewrite::deleteOperator(g, split);
+        if (isUnused(*context, concatOutputs[0]) &&
+            isUnused(*context, concatOutputs[1])) {
+          rewrite::deleteOperator(g, concat);
+        }
+        return true;
+      });
+}
+
+/// \brief Finds the GivenTensorFill of the init net producing a blob, if
+/// that is how the blob is produced.
+caffe2::OperatorDef *findGivenTensorFill(caffe2::NetDef *initNet,
+                                         const std::string &name) {
+  for (int i = initNet->op_size() - 1; i >= 0; --i) {
+    auto *op = initNet->mutable_op(i);
+    if (std::find(op->output().begin(), op->output().end(), name) ==
+        op->output().end()) {
+      continue;
+    }
+    if (op->type() != "GivenTensorFill" || op->output_size() != 1 ||
+        !getArgument(op, "values")) {
+      return nullptr;
+    }
+    return op;
+  }
+  return nullptr;
+}
+
+caffe2::Argument *findGivenTensorValues(caffe2::NetDef *initNet,
+                                        const std::string &name) {
+  auto *fill = findGivenTensorFill(initNet, name);
+  return fill ? getArgument(fill, "values") : nullptr;
+}
+
+/// \brief Finds the fill of a weight that only \p op reads, so that it can
+/// be rewritten in the init net.
+caffe2::OperatorDef *findOwnedWeight(NNGraph *g,
+                                     const Caffe2RewriteContext &context,
+                                     NodeRef weight, NodeRef op) {
+  if (!context.InitNet || nn::hasProducer(weight) ||
+      !hasSingleUse(weight, op) || isExternalOutput(context, weight) ||
+      !canForward(g, weight, weight)) {
+    return nullptr;
+  }
+  return findGivenTensorFill(context.InitNet, getName(weight));
+}
+
+int64_t numElements(const std::vector<int64_t> &shape) {
+  int64_t size = 1;
+  for (auto dim : shape) {
+    size *= dim;
+  }
+  return size;
+}
+
+/// \brief Makes \p node the operator \p def, keeping its place in the net
+/// and its edges.
+void resetOperator(NodeRef node, const caffe2::OperatorDef &def) {
+  auto *saved = getOperatorDef(node);
+  *saved = def;
+  auto op = util::make_unique<GenericOperator>(def.type());
+  op->setAnnotation(util::make_unique<Annotation>());
+  op->getMutableAnnotation()->setSaved(saved);
+  node->resetData(std::unique_ptr<Value>(std::move(op)));
+}
+
+/// Add(MatMul(X, W), b) -> FC(X, W, b), or FCTransposed when W is not
+/// transposed, for a 1-D bias b filled by the init net.
+RewriteRule fuseMatMulAdd(ContextPtr context) {
+  return RewriteRule(
+      "FuseMatMulAdd", {"MatMul", "Add"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        if (!context->InitNet) {
+          return false;
+        }
+        auto matmul = ops[0];
+        auto add = ops[1];
+        auto *matmulDef = getOperatorDef(matmul);
+        auto *addDef = getOperatorDef(add);
+        // FC flattens its inputs the way MatMul does by default.
+        if (getIntArgument(matmulDef, "trans_a", 0) ||
+            getIntArgument(matmulDef, "axis_a", 1) != 1 ||
+            getIntArgument(matmulDef, "axis_b", 1) != 1 ||
+            !getIntArgument(addDef, "broadcast", 0) ||
+            getArgument(addDef, "axis")) {
+          return false;
+        }
+        auto matmulOutputs = nn::getOutputs(matmul);
+        auto addInputs = nn::getInputs(add);
+        auto addOutputs = nn::getOutputs(add);
+        if (nn::getInputs(matmul).size() != 2 || matmulOutputs.size() != 1 ||
+            addInputs.size() != 2 || addOutputs.size() != 1) {
+          return false;
+        }
+        auto W = nn::getInputs(matmul)[1];
+        auto T = matmulOutputs[0];
+        auto b = addInputs[1];
+        auto Y = addOutputs[0];
+        auto *g = &m->dataFlow;
+        if (addInputs[0] != T || !hasSingleUse(T, add) ||
+            (isExternalOutput(*context, T) && getName(T) != getName(Y)) ||
+            !canForward(g, Y, T)) {
+          return false;
+        }
+        // The bias of FC is broadcast along the last dimension only.
+        if (nn::hasProducer(b) || !canForward(g, b, b)) {
+          return false;
+        }
+        auto *fill = findGivenTensorFill(context->InitNet, getName(b));
+        if (!fill || getIntsArgument(fill, "shape").size() != 1) {
+          return false;
+        }
+        // It has one value per output, that is per row of W for FC and per
+        // column of the flattened W for FCTransposed. Add would broadcast a
+        // bias of size 1 that FC does not accept.
+        auto *wFill = nn::hasProducer(W)
+                          ? nullptr
+                          : findGivenTensorFill(context->InitNet, getName(W));
+        if (!wFill) {
+          return false;
+        }
+        auto wShape = getIntsArgument(wFill, "shape");
+        if (wShape.size() < 2) {
+          return false;
+        }
+        int64_t N = wShape[0];
+        if (!getIntArgument(matmulDef, "trans_b", 0)) {
+          N = std::accumulate(wShape.begin() + 1, wShape.end(), int64_t(1),
+                              std::multiplies<int64_t>());
+        }
+        if (getIntsArgument(fill, "shape")[0] != N) {
+          return false;
+        }
+
+        caffe2::OperatorDef fc;
+        fc.set_type(getIntArgument(matmulDef, "trans_b", 0) ? "FC"
+                                                             : "FCTransposed");
+        fc.set_name(matmulDef->name());
+        if (matmulDef->has_device_option()) {
+          fc.mutable_device_option()->CopyFrom(matmulDef->device_option());
+        }
+        resetOperator(matmul, fc);
+        g->deleteNode(add);
+        g->deleteNode(T);
+        g->createEdge(b, matmul);
+        g->createEdge(matmul, Y);
+        return true;
+      });
+}
+
+/// SpatialBN(Conv(X, W[, b]), scale, bias, mean, var) -> Conv(X, W', b') in
+/// test mode, with all the weights from the init net.
+RewriteRule foldBatchNormIntoConv(ContextPtr context) {
+  return RewriteRule(
+      "FoldBatchNormIntoConv", {"Conv", "SpatialBN"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto conv = ops[0];
+        auto bn = ops[1];
+        auto *bnDef = getOperatorDef(bn);
+        if (!context->InitNet || !getIntArgument(bnDef, "is_test", 0)) {
+          return false;
+        }
+        auto convInputs = nn::getInputs(conv);
+        auto convOutputs = nn::getOutputs(conv);
+        auto bnInputs = nn::getInputs(bn);
+        auto bnOutputs = nn::getOutputs(bn);
+        if (convInputs.size() < 2 || convInputs.size() > 3 ||
+            convOutputs.size() != 1 || bnInputs.size() != 5 ||
+            bnOutputs.size() != 1) {
+          return false;
+        }
+        auto T = convOutputs[0];
+        auto Y = bnOutputs[0];
+        auto *g = &m->dataFlow;
+        if (bnInputs[0] != T || !hasSingleUse(T, bn) ||
+            (isExternalOutput(*context, T) && getName(T) != getName(Y)) ||
+            !canForward(g, Y, T)) {
+          return false;
+        }
+
+        // W[, b], then scale, bias, mean and var.
+        std::vector<caffe2::OperatorDef *> fills;
+        for (size_t i = 1; i < convInputs.size(); ++i) {
+          fills.push_back(findOwnedWeight(g, *context, convInputs[i], conv));
+        }
+        for (size_t i = 1; i < bnInputs.size(); ++i) {
+          fills.push_back(findOwnedWeight(g, *context, bnInputs[i], bn));
+        }
+        if (std::find(fills.begin(), fills.end(), nullptr) != fills.end() ||
+            std::unordered_set<caffe2::OperatorDef *>(fills.begin(),
+                                                      fills.end())
+                    .size() != fills.size()) {
+          return false;
+        }
+        const bool hasBias = convInputs.size() == 3;
+        auto shape = getIntsArgument(fills[0], "shape");
+        if (shape.empty()) {
+          return false;
+        }
+        const int64_t M = shape[0];
+        auto *W = getArgument(fills[0], "values");
+        if (W->floats_size() != numElements(shape)) {
+          return false;
+        }
+        std::vector<caffe2::Argument *> values;
+        for (size_t i = 1; i < fills.size(); ++i) {
+          values.push_back(getArgument(fills[i], "values"));
+          if (values.back()->floats_size() != M) {
+            return false;
+          }
+        }
+        auto *b = hasBias ? values[0] : nullptr;
+        auto *bnScale = values[hasBias + 0];
+        auto *bnBias = values[hasBias + 1];
+        auto *mean = values[hasBias + 2];
+        auto *var = values[hasBias + 3];
+        auto *epsilonArg = getArgument(bnDef, "epsilon");
+        const float epsilon = epsilonArg ? epsilonArg->f() : 1e-5f;
+
+        // The bias of the Conv, or the one of the batch norm if there is
+        // none, becomes the folded bias.
+        auto *foldedBias = hasBias ? b : bnBias;
+        const int64_t filterSize = W->floats_size() / std::max<int64_t>(M, 1);
+        for (int64_t c = 0; c < M; ++c) {
+          const float s =
+              bnScale->floats(c) / std::sqrt(var->floats(c) + epsilon);
+          for (int64_t i = c * filterSize; i < (c + 1) * filterSize; ++i) {
+            W->set_floats(i, W->floats(i) * s);
+          }
+          const float bias = hasBias ? b->floats(c) : 0.0f;
+          foldedBias->set_floats(
+              c, (bias - mean->floats(c)) * s + bnBias->floats(c));
+        }
+
+        g->deleteNode(bn);
+        g->deleteNode(T);
+        if (!hasBias) {
+          g->createEdge(bnInputs[2], conv);
+        }
+        g->createEdge(conv, Y);
+        return true;
+      });
+}
+
+/// Op(Transpose(X)) -> Transpose(Op(X)) for elementwise Op, so that
+/// transposes move towards each other and cancel out.
+RewriteRule sinkTranspose(const std::string &type, ContextPtr context) {
+  return RewriteRule(
+      "SinkTransposeThrough" + type, {"Transpose", type},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto transpose = ops[0];
+        auto op = ops[1];
+        auto transposeInputs = nn::getInputs(transpose);
+        auto opInputs = nn::getInputs(op);
+        auto opOutputs = nn::getOutputs(op);
+        if (transposeInputs.size() != 1 || opInputs.size() != 1 ||
+            opOutputs.size() != 1) {
+          return false;
+        }
+        auto T = nn::getOutputs(transpose)[0];
+        auto Y = opOutputs[0];
+        // T now holds the untransposed result of Op.
+        if (opInputs[0] != T || !hasSingleUse(T, op) ||
+            isExternalOutput(*context, T) || getName(T) == getName(Y)) {
+          return false;
+        }
+        auto transposeDef = *getOperatorDef(transpose);
+        auto opDef = *getOperatorDef(op);
+        resetOperator(transpose, opDef);
+        resetOperator(op, transposeDef);
+        return true;
+      });
+}
+
+/// Conv(Transpose(X, {0, 3, 1, 2})) -> Transpose(Conv'(X), {0, 3, 1, 2}),
+/// where Conv' runs in NHWC order on the filter rearranged in the init net.
+/// The Transpose then sinks and may cancel out with the next one.
+RewriteRule convToNHWC(ContextPtr context) {
+  return RewriteRule(
+      "ConvToNHWC", {"Transpose", "Conv"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        auto transpose = ops[0];
+        auto conv = ops[1];
+        auto *convDef = getOperatorDef(conv);
+        auto *order = getArgument(convDef, "order");
+        // Caffe2 only has 2-D, ungrouped NHWC convolutions on the default
+        // engine.
+        if (getIntsArgument(getOperatorDef(transpose), "axes") !=
+                std::vector<int64_t>({0, 3, 1, 2}) ||
+            (order && order->s() != "NCHW") || !convDef->engine().empty() ||
+            getIntArgument(convDef, "group", 1) != 1) {
+          return false;
+        }
+        auto convInputs = nn::getInputs(conv);
+        if (convInputs.size() < 2 || nn::getOutputs(conv).size() != 1) {
+          return false;
+        }
+        auto T = nn::getOutputs(transpose)[0];
+        auto *g = &m->dataFlow;
+        if (convInputs[0] != T || !hasSingleUse(T, conv) ||
+            isExternalOutput(*context, T)) {
+          return false;
+        }
+        auto *fill = findOwnedWeight(g, *context, convInputs[1], conv);
+        if (!fill) {
+          return false;
+        }
+        auto shape = getIntsArgument(fill, "shape");
+        auto *W = getArgument(fill, "values");
+        if (shape.size() != 4 || W->floats_size() != numElements(shape)) {
+          return false;
+        }
+
+        // MCHW -> MHWC.
+        const int64_t M = shape[0], C = shape[1];
+        const int64_t kernelSize = shape[2] * shape[3];
+        std::vector<float> mchw(W->floats().begin(), W->floats().end());
+        for (int64_t j = 0; j < M; ++j) {
+          for (int64_t c = 0; c < C; ++c) {
+            for (int64_t k = 0; k < kernelSize; ++k) {
+              W->set_floats((j * kernelSize + k) * C + c,
+                            mchw[(j * C + c) * kernelSize + k]);
+            }
+          }
+        }
+        auto *shapeArg = getArgument(fill, "shape");
+        shapeArg->clear_ints();
+        for (auto dim : {M, shape[2], shape[3], C}) {
+          shapeArg->add_ints(dim);
+        }
+
+        auto transposeDef = *getOperatorDef(transpose);
+        auto nhwcDef = *convDef;
+        if (order) {
+          getArgument(&nhwcDef, "order")->set_s("NHWC");
+        } else {
+          auto *arg = nhwcDef.add_arg();
+          arg->set_name("order");
+          arg->set_s("NHWC");
+        }
+        resetOperator(transpose, nhwcDef);
+        resetOperator(conv, transposeDef);
+        for (size_t i = 1; i < convInputs.size(); ++i) {
+          g->deleteEdge(g->getEdge(convInputs[i], conv));
+          g->createEdge(convInputs[i], transpose);
+        }
+        return true;
+      });
+}
+
+/// Scale(FC(X, W, b), s) -> FC(X, s * W, s * b), with W and b from the
+/// init net.
+RewriteRule foldScaleIntoFC(ContextPtr context) {
+  return RewriteRule(
+      "FoldScaleIntoFC", {"FC", "Scale"},
+      [context](NNModule *m, const std::vector<NodeRef> &ops) {
+        if (!context->InitNet) {
+          return false;
+        }
+        auto fc = ops[0];
+        auto scale = ops[1];
+        auto fcInputs = nn::getInputs(fc);
+        auto fcOutputs = nn::getOutputs(fc);
+        auto scaleInputs = nn::getInputs(scale);
+        if (fcInputs.size() != 3 || fcOutputs.size() != 1 ||
+            scaleInputs.size() != 1) {
+          return false;
+        }
+        auto T = fcOutputs[0];
+        auto Y = nn::getOutputs(scale)[0];
+        auto *g = &m->dataFlow;
+        // FC writes Y earlier than the Scale did.  When the Scale runs in
+        // place, the external output is the name of Y, which is kept.
+        if (!hasSingleUse(T, scale) ||
+            (isExternalOutput(*context, T) && getName(T) != getName(Y)) ||
+            !canForward(g, Y, T)) {
+          return false;
+        }
+
+        std::vector<caffe2::Argument *> values;
+        for (auto weight : {fcInputs[1], fcInputs[2]}) {
+          if (nn::hasProducer(weight) || !hasSingleUse(weight, fc) ||
+              isExternalOutput(*context, weight) ||
+              !canForward(g, weight, weight)) {
+            return false;
+          }
+          auto *arg = findGivenTensorValues(context->InitNet, getName(weight));
+          if (!arg) {
+            return false;
+          }
+          values.emplace_back(arg);
+        }
+        if (values[0] == values[1]) {
+          return false;
+        }
+
+        const float s = getArgument(getOperatorDef(scale), "scale")
+                            ? getArgument(getOperatorDef(scale), "scale")->f()
+                            : 1.0f;
+        for (auto *arg : values) {
+          for (int i = 0; i < arg->floats_size(); ++i) {
+            arg->set_floats(i, arg->floats(i) * s);
+          }
+        }
+        g->deleteNode(scale);
+        g->deleteNode(T);
+        g->createEdge(fc, Y);
+        return true;
+      });
+}
+
+bool hasSubnets(const caffe2::OperatorDef &op) {
+  if (op.type() == "While") {
+    return true;
+  }
+  for (const auto &arg : op.arg()) {
+    if (arg.has_n() || arg.nets_size()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+void addCaffe2Passes(PassManager *pm, ContextPtr context) {
+  pm->addPass("RemoveIdentities",
+              {removeIdentity("Copy", context),
+               removeIdentity("Alias", context),
+               removeIdentity("StopGradient", context),
+               removeIdentity("Dropout", context),
+               collapseReshapes(context)});
+  pm->addPass("FuseGemm", {fuseMatMulAdd(context)});
+  pm->addPass("FoldBatchNorm", {foldBatchNormIntoConv(context)});
+  std::vector<RewriteRule> layoutRules{convToNHWC(context)};
+  for (const auto &type : {"Relu", "Sigmoid", "Tanh", "Exp", "Log", "Abs",
+                           "Negative", "Sqrt", "Sqr", "Softsign", "Elu",
+                           "LeakyRelu", "Clip", "Scale"}) {
+    layoutRules.emplace_back(sinkTranspose(type, context));
+  }
+  pm->addPass("OptimizeLayout", layoutRules);
+  pm->addPass("MergeTransposes", {mergeTransposes(context)});
+  pm->addPass("EliminateConcatSplit", {eliminateSplitConcat(context),
+                                       eliminateConcatSplit(context)});
+  pm->addPass("FoldScale", {foldScaleIntoFC(context)});
+}
+
+caffe2::NetDef rewriteCaffe2Net(const caffe2::NetDef &net,
+                                caffe2::NetDef *initNet,
+                                std::vector<PassStats> *stats) {
+  // Blobs read by subnets are not inputs of the op holding them, so they
+  // are invisible to the graph.
+  for (const auto &op : net.op()) {
+    if (hasSubnets(op)) {
+      return net;
+    }
+  }
+
+  // The graph refers to the operators of the net it was converted from,
+  // which the rules modify.
+  caffe2::NetDef ops = net;
+  auto nn = converters::convertFromCaffe2Proto(ops);
+
+  auto context = std::make_shared<Caffe2RewriteContext>();
+  context->ExternalOutputs.insert(net.external_output().begin(),
+                                  net.external_output().end());
+  context->InitNet = initNet;
+
+  PassManager pm;
+  addCaffe2Passes(&pm, context);
+  pm.run(&nn);
+  if (stats) {
+    *stats = pm.getStats();
+  }
+
+  caffe2::NetDef rewritten = net;
+  rewritten.clear_op();
+  rewritten.mutable_op()->MergeFrom(converters::convertToCaffe2Proto(nn).op());
+  return rewritten;
+}
+
+} // namespace transformations
+} // namespace nom
@@ -0,0 +1,193 @@
+#include "nomnigraph/Transformations/Rewriter.h"
+#include "nomnigraph/Transformations/Match.h"
+
+#include "nomnigraph/Support/Casting.h"
+#include "nomnigraph/Support/Pointer.h"
+
+#include <chrono>
+#include <sstream>
+#include <unordered_set>
+
+namespace nom {
+namespace transformations {
+
+using namespace repr;
+
+namespace {
+
+/// \brief Matches pattern operators by name and pattern tensors with any
+/// tensor.
+struct OperatorNameEquality {
+  static bool equal(const NNGraph::NodeRef &pattern,
+                    const NNGraph::NodeRef &node) {
+    if (nn::is<NeuralNetData>(pattern)) {
+      return nn::is<NeuralNetData>(node);
+    }
+    return nn::is<NeuralNetOperator>(node) &&
+           nn::get<NeuralNetOperator>(node)->getName() ==
+               nn::get<NeuralNetOperator>(pattern)->getName();
+  }
+};
+
+std::unique_ptr<NNGraph> buildPattern(const std::vector<std::string> &ops) {
+  auto pattern = util::make_unique<NNGraph>();
+  NNGraph::NodeRef previous = nullptr;
+  for (const auto &op : ops) {
+    auto opNode =
+        pattern->createNode(util::make_unique<GenericOperator>(op));
+    if (previous) {
+      auto tensorNode = pattern->createNode(util::make_unique<Tensor>(""));
+      pattern->createEdge(previous, tensorNode);
+      pattern->createEdge(tensorNode, opNode);
+    }
+    previous = opNode;
+  }
+  return pattern;
+}
+
+/// \brief Recovers the order of the operators of a matched chain, which
+/// subgraphs do not keep.
+std::vector<NNGraph::NodeRef>
+orderedOperators(const Subgraph<NNGraph::NodeType, NNGraph::EdgeType> &sg) {
+  NNGraph::NodeRef op = nullptr;
+  for (auto node : sg.getNodes()) {
+    if (!nn::is<NeuralNetOperator>(node)) {
+      continue;
+    }
+    bool isFirst = true;
+    for (auto input : nn::getInputs(node)) {
+      isFirst &= !sg.hasNode(input);
+    }
+    if (isFirst) {
+      op = node;
+      break;
+    }
+  }
+
+  std::vector<NNGraph::NodeRef> ops;
+  while (op) {
+    ops.emplace_back(op);
+    NNGraph::NodeRef next = nullptr;
+    for (auto output : nn::getOutputs(op)) {
+      if (!sg.hasNode(output)) {
+        continue;
+      }
+      for (auto consumer : nn::getConsumers(output)) {
+        if (sg.hasNode(consumer)) {
+          next = consumer;
+        }
+      }
+    }
+    op = next;
+  }
+  return ops;
+}
+
+} // namespace
+
+Pass::Pass(std::string name, std::vector<RewriteRule> rules)
+    : Name(name), Rules(std::move(rules)) {
+  for (const auto &rule : Rules) {
+    assert(rule.Pattern.size() > 0 && "Rewrite rule has an empty pattern.");
+    Patterns.emplace_back(buildPattern(rule.Pattern));
+  }
+}
+
+bool Pass::applyOnce(NNModule *m, size_t ruleIndex) {
+  Match<NNGraph, OperatorNameEquality> matcher(*Patterns[ruleIndex]);
+  for (const auto &subgraph : matcher.match(m->dataFlow)) {
+    auto ops = orderedOperators(subgraph);
+    if (ops.size() != Rules[ruleIndex].Pattern.size()) {
+      continue;
+    }
+    // A successful rewrite invalidates the remaining matches.
+    if (Rules[ruleIndex].Rewrite(m, ops)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int Pass::run(NNModule *m, PassStats *stats) {
+  auto start = std::chrono::steady_clock::now();
+  int rewrites = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < Rules.size(); ++i) {
+      while (applyOnce(m, i)) {
+        stats->RuleRewrites[Rules[i].Name]++;
+        ++rewrites;
+        changed = true;
+      }
+    }
+  }
+  stats->Runs++;
+  stats->Rewrites += rewrites;
+  stats->Seconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  return rewrites;
+}
+
+void PassManager::addPass(std::string name, std::vector<RewriteRule> rules) {
+  Passes.emplace_back(name, std::move(rules));
+  Stats.emplace_back();
+  Stats.back().Name = name;
+}
+
+int PassManager::run(NNModule *m, int maxIterations) {
+  int total = 0;
+  for (int iter = 0; iter < maxIterations; ++iter) {
+    int rewrites = 0;
+    for (size_t i = 0; i < Passes.size(); ++i) {
+      rewrites += Passes[i].run(m, &Stats[i]);
+    }
+    total += rewrites;
+    // A later pass may have exposed new matches to an earlier one.
+    if (!rewrites) {
+      break;
+    }
+  }
+  return total;
+}
+
+std::string PassManager::getStatsString() const {
+  std::stringstream ss;
+  for (const auto &stats : Stats) {
+    ss << stats.Name << ": " << stats.Rewrites << " rewrites in " << stats.Runs
+       << " runs, " << stats.Seconds * 1000 << " ms";
+    const char *separator = " (";
+    for (const auto &rule : stats.RuleRewrites) {
+      ss << separator << rule.first << ": " << rule.second;
+      separator = ", ";
+    }
+    ss << (stats.RuleRewrites.empty() ? "" : ")") << "\n";
+  }
+  return ss.str();
+}
+
+namespace rewrite {
+
+void replaceAllUsesWith(NNGraph *g, NNGraph::NodeRef from,
+                        NNGraph::NodeRef to) {
+  const auto outEdges = from->getOutEdges();
+  for (auto edge : outEdges) {
+    g->setEdgeTail(edge, to);
+  }
+}
+
+void deleteOperator(NNGraph *g, NNGraph::NodeRef op) {
+  auto outputs = nn::getOutputs(op);
+  g->deleteNode(op);
+  for (auto output : outputs) {
+    if (output->getOutEdges().size() == 0) {
+      g->deleteNode(output);
+    }
+  }
+}
+
+} // namespace rewrite
+
+} // namespace transformations
+} // namespace nom
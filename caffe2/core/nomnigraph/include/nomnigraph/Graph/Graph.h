@@ -245,6 +245,17 @@ public:
     return e;
   }
 
+  /// \brief Moves the tail of an edge to another node.  The edge keeps its
+  /// position among the in-edges of its head, which matters when that
+  /// order is meaningful (e.g. operator inputs).
+  /// \p e A reference to the edge.
+  /// \p newTail The node that will have this edge as an out-edge.
+  void setEdgeTail(EdgeRef e, NodeRef newTail) {
+    e->Tail->removeOutEdge(e);
+    e->Tail = newTail;
+    newTail->addOutEdge(e);
+  }
+
   /// \brief Get a reference to the edge between two nodes if it exists.
   /// note: will fail assertion if the edge does not exist.
   EdgeRef getEdge(NodeRef tail, NodeRef head) {
@@ -263,10 +274,13 @@ public:
   /// related to the node.
   void deleteNode(NodeRef n, bool deleteEdges = true) {
     if (deleteEdges) {
-      for (auto &edge : n->inEdges) {
+      // Copy the edge lists, deleteEdge removes entries from them.
+      const auto inEdges = n->inEdges;
+      for (auto &edge : inEdges) {
         deleteEdge(edge);
       }
-      for (auto &edge : n->outEdges) {
+      const auto outEdges = n->outEdges;
+      for (auto &edge : outEdges) {
         deleteEdge(edge);
       }
     }
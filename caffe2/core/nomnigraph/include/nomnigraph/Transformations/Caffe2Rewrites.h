@@ -0,0 +1,64 @@
+//=== nomnigraph/Transformations/Caffe2Rewrites.h - Caffe2 rules -*- C++ -*-===//
+//
+// TODO Licensing.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a library of rewrite rules for graphs converted from
+// Caffe2 nets, mostly removing the overhead ops left by net builders.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NOM_TRANSFORMATIONS_CAFFE2REWRITES_H
+#define NOM_TRANSFORMATIONS_CAFFE2REWRITES_H
+
+#include "nomnigraph/Representations/NeuralNet.h"
+#include "nomnigraph/Transformations/Rewriter.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace nom {
+namespace transformations {
+
+/// \brief State shared by the Caffe2 rules.
+struct Caffe2RewriteContext {
+  /// Blobs that must still be produced under their name after rewriting.
+  std::unordered_set<std::string> ExternalOutputs;
+  /// Optional init net producing the weights of the net.  Rules that fold
+  /// constants into weights only apply when it is set, and assume that the
+  /// weights are not shared with another net.
+  caffe2::NetDef *InitNet = nullptr;
+};
+
+/// \brief Adds the Caffe2 rule library to \p pm as the passes
+///   RemoveIdentities: drops Copy, Alias, StopGradient and test mode
+///     Dropout, and collapses chains of Reshape;
+///   FuseGemm: fuses MatMul and the broadcast Add of a bias into FC;
+///   FoldBatchNorm: folds test mode SpatialBN into the preceding Conv;
+///   OptimizeLayout: runs Conv in NHWC order when its input is transposed
+///     from NHWC, and moves Transposes past elementwise ops;
+///   MergeTransposes: composes consecutive Transposes into one, or none;
+///   EliminateConcatSplit: removes a Split undoing a Concat and the
+///     other way round;
+///   FoldScale: folds a Scale of the output of FC into its weights.
+/// The rules rewriting weights, in every pass but RemoveIdentities,
+/// MergeTransposes and EliminateConcatSplit, need the init net.
+void addCaffe2Passes(PassManager *pm,
+                     std::shared_ptr<Caffe2RewriteContext> context);
+
+/// \brief Applies the Caffe2 rule library to \p net to a fixpoint.  Weights
+/// produced by \p initNet (optional) may be rewritten in place.  Nets with
+/// control flow or subnets are returned unchanged.
+/// \param stats [optional][output] The statistics of every pass.
+caffe2::NetDef rewriteCaffe2Net(const caffe2::NetDef &net,
+                                caffe2::NetDef *initNet = nullptr,
+                                std::vector<PassStats> *stats = nullptr);
+
+} // namespace transformations
+} // namespace nom
+
+#endif // NOM_TRANSFORMATIONS_CAFFE2REWRITES_H
@@ -0,0 +1,120 @@
+//=== nomnigraph/Transformations/Rewriter.h - Pattern rewriting -*- C++ -*-===//
+//
+// TODO Licensing.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a rewrite engine that applies declarative pattern rules
+// to a neural network graph until a fixpoint is reached.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NOM_TRANSFORMATIONS_REWRITER_H
+#define NOM_TRANSFORMATIONS_REWRITER_H
+
+#include "nomnigraph/Graph/Graph.h"
+#include "nomnigraph/Representations/NeuralNet.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nom {
+namespace transformations {
+
+/// \brief A declarative rewrite rule.
+///
+/// The pattern is a chain of operator names, each operator consuming an
+/// output of the previous one (e.g. {"Transpose", "Transpose"}).  At every
+/// match the rewrite is called with the matched operator nodes in pattern
+/// order.  It checks the preconditions the pattern cannot express and
+/// returns false, leaving the graph untouched, when they do not hold.
+struct RewriteRule {
+  using RewriteFunction = std::function<bool(
+      repr::NNModule *, const std::vector<repr::NNGraph::NodeRef> &)>;
+
+  RewriteRule(std::string name, std::vector<std::string> pattern,
+              RewriteFunction rewrite)
+      : Name(name), Pattern(pattern), Rewrite(rewrite) {}
+
+  std::string Name;
+  std::vector<std::string> Pattern;
+  RewriteFunction Rewrite;
+};
+
+/// \brief Statistics gathered by the PassManager for a single pass.
+struct PassStats {
+  std::string Name;
+  /// Number of times the pass was run.
+  int Runs = 0;
+  /// Total number of rewrites made by the pass, and per rule.
+  int Rewrites = 0;
+  std::map<std::string, int> RuleRewrites;
+  double Seconds = 0;
+};
+
+/// \brief A named group of rules that are applied together until none of
+/// them matches anymore.
+class Pass {
+public:
+  Pass(std::string name, std::vector<RewriteRule> rules);
+  Pass(Pass &&) = default;
+
+  const std::string &getName() const { return Name; }
+
+  /// \brief Runs the pass to a fixpoint.
+  /// \return The number of rewrites made, which are added to \p stats.
+  int run(repr::NNModule *m, PassStats *stats);
+
+private:
+  // Applies the first match of the rule whose rewrite succeeds.
+  bool applyOnce(repr::NNModule *m, size_t ruleIndex);
+
+  std::string Name;
+  std::vector<RewriteRule> Rules;
+  // Match keeps a reference to the pattern graph, so patterns are
+  // allocated on the heap to keep them in place when a Pass is moved.
+  std::vector<std::unique_ptr<repr::NNGraph>> Patterns;
+};
+
+/// \brief Runs a sequence of passes, repeating the whole sequence until no
+/// pass changes the graph, and keeps statistics for every pass.
+class PassManager {
+public:
+  void addPass(std::string name, std::vector<RewriteRule> rules);
+
+  /// \brief Runs the passes to a fixpoint, or at most \p maxIterations
+  /// times over.
+  /// \return The total number of rewrites made.
+  int run(repr::NNModule *m, int maxIterations = 16);
+
+  const std::vector<PassStats> &getStats() const { return Stats; }
+
+  /// \brief Human readable summary of the statistics, one line per pass.
+  std::string getStatsString() const;
+
+private:
+  std::vector<Pass> Passes;
+  std::vector<PassStats> Stats;
+};
+
+/// Helpers to write rewrites on NNGraph.
+namespace rewrite {
+
+/// \brief Makes the consumers of \p from read \p to instead, keeping the
+/// position of the input for each consumer.
+void replaceAllUsesWith(repr::NNGraph *g, repr::NNGraph::NodeRef from,
+                        repr::NNGraph::NodeRef to);
+
+/// \brief Deletes an operator along with the output tensors it produces
+/// that have no consumers.
+void deleteOperator(repr::NNGraph *g, repr::NNGraph::NodeRef op);
+
+} // namespace rewrite
+
+} // namespace transformations
+} // namespace nom
+
+#endif // NOM_TRANSFORMATIONS_REWRITER_H
@@ -0,0 +1,366 @@
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/proto_utils.h"
+#include "nomnigraph/Converters/Caffe2.h"
+#include "nomnigraph/Transformations/Caffe2Rewrites.h"
+
+namespace caffe2 {
+
+namespace {
+
+using nom::transformations::PassStats;
+using nom::transformations::rewriteCaffe2Net;
+
+OperatorDef* AddOp(
+    NetDef* net,
+    const string& type,
+    const vector<string>& inputs,
+    const vector<string>& outputs) {
+  auto* op = net->add_op();
+  *op = CreateOperatorDef(type, "", inputs, outputs);
+  return op;
+}
+
+vector<string> OpTypes(const NetDef& net) {
+  vector<string> types;
+  for (const auto& op : net.op()) {
+    types.push_back(op.type());
+  }
+  return types;
+}
+
+int Rewrites(const vector<PassStats>& stats, const string& rule) {
+  int rewrites = 0;
+  for (const auto& pass : stats) {
+    auto it = pass.RuleRewrites.find(rule);
+    rewrites += it == pass.RuleRewrites.end() ? 0 : it->second;
+  }
+  return rewrites;
+}
+
+OperatorDef* AddFill(
+    NetDef* net,
+    const string& name,
+    const vector<int>& shape,
+    float offset = 0) {
+  auto* fill = AddOp(net, "GivenTensorFill", {}, {name});
+  fill->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", shape));
+  int size = 1;
+  for (auto dim : shape) {
+    size *= dim;
+  }
+  vector<float> values(size);
+  for (int i = 0; i < size; ++i) {
+    values[i] = offset + (i % 5) * 0.25f;
+  }
+  fill->add_arg()->CopyFrom(MakeArgument<vector<float>>("values", values));
+  return fill;
+}
+
+void FillInput(Workspace* ws, const string& name, vector<TIndex> dims) {
+  auto* X = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  X->Resize(dims);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = (i % 7) - 3;
+  }
+}
+
+// Checks that the rewritten nets compute the same output Y.
+void ExpectSameOutput(
+    const NetDef& init,
+    const NetDef& net,
+    const NetDef& rewrittenInit,
+    const NetDef& rewritten,
+    const string& input,
+    vector<TIndex> dims) {
+  Workspace ws;
+  FillInput(&ws, input, dims);
+  ASSERT_TRUE(ws.RunNetOnce(init));
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  TensorCPU expected(ws.GetBlob("Y")->Get<TensorCPU>());
+  Workspace rewrittenWs;
+  FillInput(&rewrittenWs, input, dims);
+  ASSERT_TRUE(rewrittenWs.RunNetOnce(rewrittenInit));
+  ASSERT_TRUE(rewrittenWs.RunNetOnce(rewritten));
+  const auto& Y = rewrittenWs.GetBlob("Y")->Get<TensorCPU>();
+  ASSERT_EQ(Y.dims(), expected.dims());
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i], expected.data<float>()[i], 1e-4);
+  }
+}
+
+} // namespace
+
+TEST(NomnigraphRewriterTest, RemoveIdentities) {
+  NetDef net;
+  AddOp(&net, "Relu", {"X"}, {"A"});
+  AddOp(&net, "Copy", {"A"}, {"B"});
+  AddOp(&net, "StopGradient", {"B"}, {"B"});
+  auto* reshape = AddOp(&net, "Reshape", {"B"}, {"C", "C_shape"});
+  reshape->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", {-1}));
+  reshape = AddOp(&net, "Reshape", {"C"}, {"D", "D_shape"});
+  reshape->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", {2, -1}));
+  AddOp(&net, "Sigmoid", {"D"}, {"Y"});
+  // The output of the last Copy must keep being produced.
+  AddOp(&net, "Copy", {"Y"}, {"Z"});
+  net.add_external_input("X");
+  net.add_external_output("Z");
+
+  vector<PassStats> stats;
+  auto rewritten = rewriteCaffe2Net(net, nullptr, &stats);
+  EXPECT_EQ(
+      OpTypes(rewritten),
+      vector<string>({"Relu", "Reshape", "Sigmoid", "Copy"}));
+  EXPECT_EQ(rewritten.op(1).input(0), "A");
+  EXPECT_EQ(rewritten.op(1).output(0), "D");
+  EXPECT_EQ(Rewrites(stats, "RemoveCopy"), 1);
+  EXPECT_EQ(Rewrites(stats, "RemoveStopGradient"), 1);
+  EXPECT_EQ(Rewrites(stats, "CollapseReshapes"), 1);
+  EXPECT_EQ(rewritten.external_output(0), "Z");
+}
+
+TEST(NomnigraphRewriterTest, KeepsOverwrittenBlobs) {
+  // A is overwritten between the Copy and the consumer of its output, so
+  // the consumer cannot read A instead.
+  NetDef net;
+  AddOp(&net, "Copy", {"A"}, {"B"});
+  AddOp(&net, "Relu", {"X"}, {"A"});
+  AddOp(&net, "Sum", {"A", "B"}, {"Y"});
+  net.add_external_output("Y");
+  EXPECT_EQ(OpTypes(rewriteCaffe2Net(net)), OpTypes(net));
+}
+
+TEST(NomnigraphRewriterTest, KeepsCopiesUpdatedInPlace) {
+  // ScatterWeightedSum updates the copy W in place. Without the Copy it
+  // would update V, or read V and write W, which it does not support.
+  NetDef net;
+  AddOp(&net, "Copy", {"V"}, {"W"});
+  AddOp(
+      &net,
+      "ScatterWeightedSum",
+      {"W", "w0", "indices", "grad", "w1"},
+      {"W"});
+  AddOp(&net, "Sum", {"V", "W"}, {"Y"});
+  net.add_external_output("Y");
+  vector<PassStats> stats;
+  EXPECT_EQ(OpTypes(rewriteCaffe2Net(net, nullptr, &stats)), OpTypes(net));
+  EXPECT_EQ(Rewrites(stats, "RemoveCopy"), 0);
+}
+
+TEST(NomnigraphRewriterTest, MergeTransposes) {
+  NetDef net;
+  auto* t = AddOp(&net, "Transpose", {"X"}, {"A"});
+  t->add_arg()->CopyFrom(MakeArgument<vector<int>>("axes", {0, 2, 3, 1}));
+  t = AddOp(&net, "Transpose", {"A"}, {"B"});
+  t->add_arg()->CopyFrom(MakeArgument<vector<int>>("axes", {0, 3, 1, 2}));
+  t = AddOp(&net, "Transpose", {"B"}, {"C"});
+  t->add_arg()->CopyFrom(MakeArgument<vector<int>>("axes", {1, 0, 2, 3}));
+  t = AddOp(&net, "Transpose", {"C"}, {"Y"});
+  t->add_arg()->CopyFrom(MakeArgument<vector<int>>("axes", {0, 2, 1, 3}));
+  net.add_external_input("X");
+  net.add_external_output("Y");
+
+  Workspace ws;
+  auto* X = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(2, 3, 4, 5);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = i;
+  }
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  TensorCPU expected(ws.GetBlob("Y")->Get<TensorCPU>());
+
+  auto rewritten = rewriteCaffe2Net(net);
+  ASSERT_EQ(OpTypes(rewritten), vector<string>({"Transpose"}));
+  EXPECT_EQ(rewritten.op(0).input(0), "X");
+  EXPECT_EQ(rewritten.op(0).output(0), "Y");
+  ASSERT_TRUE(ws.RunNetOnce(rewritten));
+  const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+  ASSERT_EQ(Y.dims(), expected.dims());
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_EQ(Y.data<float>()[i], expected.data<float>()[i]);
+  }
+}
+
+TEST(NomnigraphRewriterTest, EliminateConcatSplit) {
+  NetDef net;
+  AddOp(&net, "Concat", {"A", "B"}, {"AB", "AB_info"});
+  AddOp(&net, "Split", {"AB", "AB_info"}, {"A2", "B2"});
+  AddOp(&net, "Sum", {"A2", "B2"}, {"S"});
+  AddOp(&net, "Split", {"S"}, {"S1", "S2"});
+  AddOp(&net, "Concat", {"S1", "S2"}, {"S3", "S3_info"});
+  AddOp(&net, "Relu", {"S3"}, {"Y"});
+  net.add_external_output("Y");
+
+  vector<PassStats> stats;
+  auto rewritten = rewriteCaffe2Net(net, nullptr, &stats);
+  ASSERT_EQ(OpTypes(rewritten), vector<string>({"Sum", "Relu"}));
+  EXPECT_EQ(rewritten.op(0).input(0), "A");
+  EXPECT_EQ(rewritten.op(0).input(1), "B");
+  EXPECT_EQ(rewritten.op(1).input(0), "S");
+  EXPECT_EQ(Rewrites(stats, "EliminateConcatSplit"), 1);
+  EXPECT_EQ(Rewrites(stats, "EliminateSplitConcat"), 1);
+
+  // Concatenating along another axis is not undone.
+  net.mutable_op(4)->add_arg()->CopyFrom(MakeArgument<int>("axis", 0));
+  EXPECT_EQ(OpTypes(rewriteCaffe2Net(net)).size(), 4);
+}
+
+TEST(NomnigraphRewriterTest, FoldScaleIntoFC) {
+  NetDef init;
+  auto* fill = AddOp(&init, "GivenTensorFill", {}, {"W"});
+  fill->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", {2, 3}));
+  fill->add_arg()->CopyFrom(
+      MakeArgument<vector<float>>("values", {1, 2, 3, 4, 5, 6}));
+  fill = AddOp(&init, "GivenTensorFill", {}, {"b"});
+  fill->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", {2}));
+  fill->add_arg()->CopyFrom(MakeArgument<vector<float>>("values", {1, -1}));
+
+  NetDef net;
+  AddOp(&net, "FC", {"X", "W", "b"}, {"Y"});
+  AddOp(&net, "Scale", {"Y"}, {"Y"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<float>("scale", 0.5));
+  for (const auto& input : {"X", "W", "b"}) {
+    net.add_external_input(input);
+  }
+  net.add_external_output("Y");
+
+  // Without an init net the weights are unknown.
+  EXPECT_EQ(OpTypes(rewriteCaffe2Net(net)), vector<string>({"FC", "Scale"}));
+
+  Workspace ws;
+  ASSERT_TRUE(ws.RunNetOnce(init));
+  auto* X = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(4, 3);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = i - 5;
+  }
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  TensorCPU expected(ws.GetBlob("Y")->Get<TensorCPU>());
+
+  auto rewritten = rewriteCaffe2Net(net, &init);
+  ASSERT_EQ(OpTypes(rewritten), vector<string>({"FC"}));
+  EXPECT_EQ(rewritten.op(0).output(0), "Y");
+  ASSERT_TRUE(ws.RunNetOnce(init));
+  ASSERT_TRUE(ws.RunNetOnce(rewritten));
+  const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_FLOAT_EQ(Y.data<float>()[i], expected.data<float>()[i]);
+  }
+}
+
+TEST(NomnigraphRewriterTest, FuseMatMulAdd) {
+  for (int transB : {0, 1}) {
+    NetDef init;
+    AddFill(&init, "W", transB ? vector<int>{4, 3} : vector<int>{3, 4});
+    AddFill(&init, "b", {4}, -0.5);
+    NetDef net;
+    AddOp(&net, "MatMul", {"X", "W"}, {"XW"})
+        ->add_arg()
+        ->CopyFrom(MakeArgument<int>("trans_b", transB));
+    AddOp(&net, "Add", {"XW", "b"}, {"Y"})
+        ->add_arg()
+        ->CopyFrom(MakeArgument<int>("broadcast", 1));
+    for (const auto& input : {"X", "W", "b"}) {
+      net.add_external_input(input);
+    }
+    net.add_external_output("Y");
+
+    auto rewrittenInit = init;
+    auto rewritten = rewriteCaffe2Net(net, &rewrittenInit);
+    ASSERT_EQ(
+        OpTypes(rewritten),
+        vector<string>({transB ? "FC" : "FCTransposed"}));
+    ExpectSameOutput(init, net, rewrittenInit, rewritten, "X", {2, 3});
+  }
+
+  // A bias of another shape is not broadcast the way FC does, and neither
+  // are biases of size 1 nor weights whose shape is not known.
+  for (const auto& shapes : vector<std::pair<vector<int>, vector<int>>>{
+           {{4, 3}, {2, 4}}, {{4, 3}, {1}}, {{}, {4}}}) {
+    NetDef init;
+    if (!shapes.first.empty()) {
+      AddFill(&init, "W", shapes.first);
+    }
+    AddFill(&init, "b", shapes.second);
+    NetDef net;
+    AddOp(&net, "MatMul", {"X", "W"}, {"XW"})
+        ->add_arg()
+        ->CopyFrom(MakeArgument<int>("trans_b", 1));
+    AddOp(&net, "Add", {"XW", "b"}, {"Y"})
+        ->add_arg()
+        ->CopyFrom(MakeArgument<int>("broadcast", 1));
+    net.add_external_output("Y");
+    EXPECT_EQ(OpTypes(rewriteCaffe2Net(net, &init)).size(), 2);
+  }
+}
+
+TEST(NomnigraphRewriterTest, FoldBatchNormIntoConv) {
+  for (bool convBias : {false, true}) {
+    NetDef init;
+    AddFill(&init, "W", {4, 2, 3, 3}, -0.5);
+    AddFill(&init, "scale", {4}, 0.5);
+    AddFill(&init, "bias", {4}, -0.25);
+    AddFill(&init, "mean", {4}, 0.1);
+    AddFill(&init, "var", {4}, 1);
+    NetDef net;
+    vector<string> convInputs{"X", "W"};
+    if (convBias) {
+      AddFill(&init, "b", {4}, 0.3);
+      convInputs.push_back("b");
+    }
+    AddOp(&net, "Conv", convInputs, {"T"})
+        ->add_arg()
+        ->CopyFrom(MakeArgument<int>("kernel", 3));
+    auto* bn =
+        AddOp(&net, "SpatialBN", {"T", "scale", "bias", "mean", "var"}, {"Y"});
+    bn->add_arg()->CopyFrom(MakeArgument<int>("is_test", 1));
+    bn->add_arg()->CopyFrom(MakeArgument<float>("epsilon", 1e-3));
+    net.add_external_output("Y");
+
+    auto rewrittenInit = init;
+    vector<PassStats> stats;
+    auto rewritten = rewriteCaffe2Net(net, &rewrittenInit, &stats);
+    ASSERT_EQ(OpTypes(rewritten), vector<string>({"Conv"}));
+    EXPECT_EQ(rewritten.op(0).input_size(), 3);
+    EXPECT_EQ(rewritten.op(0).output(0), "Y");
+    EXPECT_EQ(Rewrites(stats, "FoldBatchNormIntoConv"), 1);
+    ExpectSameOutput(init, net, rewrittenInit, rewritten, "X", {1, 2, 5, 5});
+  }
+}
+
+TEST(NomnigraphRewriterTest, ConvToNHWC) {
+  NetDef init;
+  AddFill(&init, "W", {4, 2, 3, 3}, -0.5);
+  AddFill(&init, "b", {4}, 0.5);
+  NetDef net;
+  AddOp(&net, "Transpose", {"X"}, {"X_nchw"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<vector<int>>("axes", {0, 3, 1, 2}));
+  auto* conv = AddOp(&net, "Conv", {"X_nchw", "W", "b"}, {"C"});
+  conv->add_arg()->CopyFrom(MakeArgument<int>("kernel", 3));
+  conv->add_arg()->CopyFrom(MakeArgument<int>("pad", 1));
+  AddOp(&net, "Relu", {"C"}, {"R"});
+  AddOp(&net, "Transpose", {"R"}, {"Y"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<vector<int>>("axes", {0, 2, 3, 1}));
+  for (const auto& input : {"X", "W", "b"}) {
+    net.add_external_input(input);
+  }
+  net.add_external_output("Y");
+
+  auto rewrittenInit = init;
+  auto rewritten = rewriteCaffe2Net(net, &rewrittenInit);
+  ASSERT_EQ(OpTypes(rewritten), vector<string>({"Conv", "Relu"}));
+  EXPECT_EQ(rewritten.op(0).input(0), "X");
+  EXPECT_EQ(rewritten.op(1).output(0), "Y");
+  ExpectSameOutput(init, net, rewrittenInit, rewritten, "X", {2, 5, 6, 2});
+
+  // Grouped convolutions have no NHWC implementation.
+  net.mutable_op(1)->add_arg()->CopyFrom(MakeArgument<int>("group", 2));
+  EXPECT_EQ(OpTypes(rewriteCaffe2Net(net, &init)).size(), 4);
+}
+
+} // namespace caffe2
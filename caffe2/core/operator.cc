@@ -22,6 +22,19 @@ CAFFE2_DEFINE_bool(
     false,
     "If set, disable implicit engine preferences. This is useful for unit "
     "testing and debugging cases.");
+CAFFE2_DEFINE_bool(
+    caffe2_operator_cache_blob_pointers,
+    false,
+    "If set, operators cache the typed objects of their input and output "
+    "blobs after the first checked access. Can be overridden per operator or "
+    "per net with the cache_blob_pointers argument.");
+CAFFE2_DEFINE_bool(
+    caffe2_use_scratch_arena,
+    false,
+    "If set, operators that support it take their temporary buffers from "
+    "the per-thread and per-stream scratch arenas of the workspace instead "
+    "of keeping them as members. Can be overridden per operator or per net with the "
+    "use_scratch_arena argument.");
 
 namespace caffe2 {
 
@@ -48,6 +61,22 @@ OperatorBase::OperatorBase(const OperatorDef& operator_def, Workspace* ws)
   for (const string& output_str : operator_def.output()) {
     outputs_.push_back(CHECK_NOTNULL(ws->CreateBlob(output_str)));
   }
+
+  TensorGrowthPolicy policy;
+  if (GetTensorGrowthPolicyFromArguments(
+          ArgumentHelper(operator_def), &policy)) {
+    set_tensor_growth_policy(policy);
+  }
+  if (ArgumentHelper::GetSingleArgument<OperatorDef, bool>(
+          operator_def,
+          "cache_blob_pointers",
+          FLAGS_caffe2_operator_cache_blob_pointers)) {
+    set_cache_blob_pointers(true);
+  }
+  if (ArgumentHelper::GetSingleArgument<OperatorDef, bool>(
+          operator_def, "use_scratch_arena", FLAGS_caffe2_use_scratch_arena)) {
+    set_use_scratch_arena(true);
+  }
 }
 
 vector<TensorShape> OperatorBase::InputTensorShapes() {
@@ -280,6 +309,28 @@ unique_ptr<OperatorBase> CreateOperator(
   }
 }
 
+bool GetTensorGrowthPolicyFromArguments(
+    const ArgumentHelper& helper,
+    TensorGrowthPolicy* policy) {
+  bool found = false;
+  if (helper.HasArgument("tensor_growth_pct")) {
+    policy->growth_pct = helper.GetSingleArgument<float>("tensor_growth_pct", 0);
+    CAFFE_ENFORCE_GE(policy->growth_pct, 0, "tensor_growth_pct is negative");
+    found = true;
+  }
+  if (helper.HasArgument("tensor_keep_high_water_mark")) {
+    policy->keep_high_water_mark =
+        helper.GetSingleArgument<bool>("tensor_keep_high_water_mark", false);
+    found = true;
+  }
+  if (helper.HasArgument("tensor_round_to_size_class")) {
+    policy->round_to_size_class =
+        helper.GetSingleArgument<bool>("tensor_round_to_size_class", false);
+    found = true;
+  }
+  return found;
+}
+
 std::map<int32_t, OperatorRegistry*>* gDeviceTypeRegistry() {
   static std::map<int32_t, OperatorRegistry*> g_device_type_registry;
   return &g_device_type_registry;
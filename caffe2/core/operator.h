@@ -16,6 +16,7 @@
 #include "caffe2/core/operator_gradient.h"
 #include "caffe2/core/operator_schema.h"
 #include "caffe2/core/registry.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/types.h"
 #include "caffe2/core/workspace.h"
@@ -267,6 +268,48 @@ class OperatorBase : public Observable<OperatorBase> {
     return engine_;
   }
 
+  // The growth policy applied to the output tensors of this operator. It is
+  // set either from the operator's own arguments or, failing that, from the
+  // arguments of the net that owns it.
+  void set_tensor_growth_policy(const TensorGrowthPolicy& policy) {
+    tensor_growth_policy_.reset(new TensorGrowthPolicy(policy));
+  }
+
+  bool has_tensor_growth_policy() const {
+    return tensor_growth_policy_ != nullptr;
+  }
+
+  // Enables caching of the typed objects held by the input and output blobs.
+  // Once an input or output has been accessed through the checked path, later
+  // accesses reuse the cached pointer as long as the blob still holds the
+  // same object, skipping the TypeMeta lookup and enforce. This is meant for
+  // nets made of many tiny operators where that overhead shows up.
+  void set_cache_blob_pointers(bool enable) {
+    if (enable) {
+      cached_inputs_.assign(inputs_.size(), nullptr);
+      cached_outputs_.assign(outputs_.size(), nullptr);
+    } else {
+      cached_inputs_.clear();
+      cached_outputs_.clear();
+    }
+  }
+
+  bool cache_blob_pointers() const {
+    return !cached_inputs_.empty() || !cached_outputs_.empty();
+  }
+
+  // Makes operators that support it borrow their temporaries from the
+  // scratch arenas of the workspace for the duration of a run, instead of
+  // keeping them as members. Not thread-safe, must be called while the net
+  // is being created.
+  void set_use_scratch_arena(bool enable) {
+    scratch_arenas_ = enable ? operator_ws_->GetScratchArenas() : nullptr;
+  }
+
+  bool use_scratch_arena() const {
+    return scratch_arenas_ != nullptr;
+  }
+
  public:
   static constexpr int kNoNetPositionSet = -1;
 
@@ -288,6 +331,30 @@ class OperatorBase : public Observable<OperatorBase> {
   // An event used by asynchronous execution.
   std::unique_ptr<Event> event_;
 
+  // Null unless a non-default growth policy has been requested.
+  std::unique_ptr<TensorGrowthPolicy> tensor_growth_policy_;
+
+  // Objects last seen in inputs_ and outputs_, when blob pointer caching is
+  // enabled. Empty otherwise. A cached pointer is only trusted after checking
+  // that the blob still holds it with the expected type, so blobs that get
+  // reset or replaced between runs simply go through the checked path again.
+  vector<const void*> cached_inputs_;
+  vector<void*> cached_outputs_;
+
+  // Returns the scratch arena of the calling thread for this operator's
+  // device and the stream of the current run, or nullptr if the operator does
+  // not use scratch arenas. Meant to be passed to a ScratchArena::Lease in
+  // RunOnDevice.
+  std::shared_ptr<ScratchArena> scratch_arena() {
+    return scratch_arenas_
+        ? scratch_arenas_->ForCurrentThread(device_option_, stream_id_)
+        : nullptr;
+  }
+
+  ScratchArenas* scratch_arenas_ = nullptr;
+  // The stream of the current Run or RunAsync.
+  int stream_id_ = 0;
+
   DISABLE_COPY_AND_ASSIGN(OperatorBase);
 };
 
@@ -325,7 +392,9 @@ template <class Context>
 class Operator : public OperatorBase {
  public:
   explicit Operator(const OperatorDef& operator_def, Workspace* ws)
-      : OperatorBase(operator_def, ws), context_(operator_def.device_option()) {
+      : OperatorBase(operator_def, ws),
+        context_(operator_def.device_option()),
+        tensor_type_id_(TypeMeta::Id<Tensor<Context>>()) {
     // In the constructor, we switch to the device so that the child class
     // constructors will run on that device.
     context_.SwitchToDevice(0);
@@ -333,10 +402,36 @@ class Operator : public OperatorBase {
   ~Operator() noexcept override {}
 
   inline const Tensor<Context>& Input(int idx) {
+    if (!cached_inputs_.empty()) {
+      DCHECK_LT(idx, cached_inputs_.size());
+      const Blob* blob = Inputs()[idx];
+      if (blob->GetRaw() == cached_inputs_[idx] &&
+          blob->meta().id() == tensor_type_id_) {
+        return *static_cast<const Tensor<Context>*>(cached_inputs_[idx]);
+      }
+      const auto& input = OperatorBase::template Input<Tensor<Context>>(idx);
+      cached_inputs_[idx] = &input;
+      return input;
+    }
     return OperatorBase::template Input<Tensor<Context>>(idx);
   }
   inline Tensor<Context>* Output(int idx) {
-    return OperatorBase::template Output<Tensor<Context>>(idx);
+    if (!cached_outputs_.empty()) {
+      DCHECK_LT(idx, cached_outputs_.size());
+      Blob* blob = Outputs()[idx];
+      if (blob->GetRaw() == cached_outputs_[idx] &&
+          blob->meta().id() == tensor_type_id_) {
+        return static_cast<Tensor<Context>*>(cached_outputs_[idx]);
+      }
+    }
+    auto* output = OperatorBase::template Output<Tensor<Context>>(idx);
+    if (tensor_growth_policy_) {
+      output->SetGrowthPolicy(*tensor_growth_policy_);
+    }
+    if (!cached_outputs_.empty()) {
+      cached_outputs_[idx] = output;
+    }
+    return output;
   }
 
   void WaitEvent(const Event& ev, int stream_id = -1) final {
@@ -365,6 +460,7 @@ class Operator : public OperatorBase {
     try {
       StartAllObservers();
 
+      stream_id_ = stream_id;
       context_.SwitchToDevice(stream_id);
       bool result = RunOnDevice();
       if (!result) {
@@ -391,6 +487,7 @@ class Operator : public OperatorBase {
 
   bool RunAsync(int stream_id = 0) final {
     try {
+      stream_id_ = stream_id;
       context_.SwitchToDevice(stream_id);
       auto result = RunOnDevice();
       if (result) {
@@ -480,6 +577,10 @@ class Operator : public OperatorBase {
   }
 
   Context context_;
+
+ private:
+  // Looked up once, since TypeMeta::Id is not inlined.
+  const CaffeTypeId tensor_type_id_;
 };
 
 #define USE_OPERATOR_BASE_FUNCTIONS                                 \
@@ -814,6 +915,13 @@ void SetOpEnginePref(
 
 TensorShape GetTensorShapeOfBlob(const Blob* b);
 
+// Reads the tensor growth policy arguments (tensor_growth_pct,
+// tensor_keep_high_water_mark and tensor_round_to_size_class) from an
+// operator or net definition. Returns false if none of them is present.
+bool GetTensorGrowthPolicyFromArguments(
+    const ArgumentHelper& helper,
+    TensorGrowthPolicy* policy);
+
 TensorShapes InferBlobShapesAndTypesFromWorkspace(
     Workspace* ws,
     const vector<std::unique_ptr<NetDef>>& nets);
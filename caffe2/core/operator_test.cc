@@ -606,4 +606,66 @@ TEST(IsTestArg, non_standard) {
       "JustTestWithNonStandardIsTestArg");
 }
 
+// Copies the first element of its input into its output, reading both twice
+// per run so that cached accesses are exercised.
+class JustTestCopyFirst : public Operator<CPUContext> {
+ public:
+  using Operator<CPUContext>::Operator;
+  bool RunOnDevice() override {
+    Output(0)->ResizeLike(Input(0));
+    Output(0)->mutable_data<float>()[0] = Input(0).data<float>()[0];
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(JustTestCopyFirst, JustTestCopyFirst);
+OPERATOR_SCHEMA(JustTestCopyFirst).NumInputs(1).NumOutputs(1);
+
+TEST(OperatorTest, CacheBlobPointers) {
+  Workspace ws;
+  auto* in = ws.CreateBlob("in")->GetMutable<TensorCPU>();
+  in->Resize(1);
+  in->mutable_data<float>()[0] = 1;
+
+  OperatorDef op_def;
+  op_def.set_type("JustTestCopyFirst");
+  op_def.add_input("in");
+  op_def.add_output("out");
+  AddArgument<int>("cache_blob_pointers", 1, &op_def);
+  auto op = CreateOperator(op_def, &ws);
+  EXPECT_TRUE(op->cache_blob_pointers());
+  EXPECT_TRUE(op->Run());
+  EXPECT_EQ(ws.GetBlob("out")->Get<TensorCPU>().data<float>()[0], 1);
+
+  // Replacing the contents of the blobs invalidates the cached pointers.
+  auto* new_in = new TensorCPU(vector<TIndex>{1});
+  new_in->mutable_data<float>()[0] = 2;
+  ws.GetBlob("in")->Reset(new_in);
+  ws.GetBlob("out")->Reset();
+  EXPECT_TRUE(op->Run());
+  EXPECT_EQ(ws.GetBlob("out")->Get<TensorCPU>().data<float>()[0], 2);
+
+  // A blob of the wrong type still fails the type check.
+  ws.GetBlob("in")->GetMutable<int>();
+  EXPECT_THROW(op->Run(), EnforceNotMet);
+}
+
+TEST(OperatorTest, CacheBlobPointersFromNet) {
+  Workspace ws;
+  ws.CreateBlob("in")->GetMutable<TensorCPU>()->Resize(1);
+  ws.GetBlob("in")->GetMutable<TensorCPU>()->mutable_data<float>();
+
+  NetDef net_def;
+  auto* op_def = net_def.add_op();
+  op_def->set_type("JustTestCopyFirst");
+  op_def->add_input("in");
+  op_def->add_output("out");
+  net_def.add_arg()->CopyFrom(MakeArgument<int>("cache_blob_pointers", 1));
+  unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  for (auto* op : net->GetOperators()) {
+    EXPECT_TRUE(op->cache_blob_pointers());
+  }
+  EXPECT_TRUE(net->Run());
+}
+
 }  // namespace caffe2
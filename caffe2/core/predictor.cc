@@ -2,6 +2,9 @@
 
 #include <unordered_set>
 
+#include "caffe2/transforms/constant_folding_transform.h"
+#include "caffe2/transforms/dead_op_elimination_transform.h"
+
 namespace caffe2 {
 
 namespace {
@@ -53,38 +56,58 @@ const ::google::protobuf::RepeatedPtrField<::std::string>& getBlobs(
 }
 } // namespace
 
-Predictor::Predictor(const MetaNetDef& def, Workspace* parent)
-    : Predictor(
-          getNet(
-              def,
-              PredictorConsts::default_instance().global_init_net_type()),
-          getNet(def, PredictorConsts::default_instance().predict_net_type()),
-          parent) {
+Predictor::Predictor(
+    const MetaNetDef& def,
+    Workspace* parent,
+    bool fold_constants)
+    : run_net_(
+          getNet(def, PredictorConsts::default_instance().predict_net_type())),
+      ws_(parent) {
   const auto& inputs =
       getBlobs(def, PredictorConsts::default_instance().inputs_blob_type());
   for (const auto& input : inputs) {
     inputNames_.insert(input);
   }
+  initialize(
+      getNet(def, PredictorConsts::default_instance().global_init_net_type()),
+      fold_constants);
 }
 
 Predictor::Predictor(
     const NetDef& init_net,
     const NetDef& run_net,
-    Workspace* parent)
+    Workspace* parent,
+    bool fold_constants)
     : run_net_(run_net), ws_(parent) {
+  initialize(init_net, fold_constants);
+}
+
+void Predictor::initialize(const NetDef& init_net, bool fold_constants) {
   CAFFE_ENFORCE(ws_.RunNetOnce(init_net));
 
+  if (fold_constants) {
+    std::unordered_set<std::string> constants;
+    for (const auto& op : init_net.op()) {
+      for (const auto& output : op.output()) {
+        if (!inputNames_.count(output)) {
+          constants.insert(output);
+        }
+      }
+    }
+    run_net_ = FoldConstants(run_net_, constants, &ws_);
+  }
+
   // real model inputs can be fed later in run* functions
   const auto& initialized_vec = ws_.Blobs();
   const std::unordered_set<std::string> initialized{initialized_vec.begin(),
                                                     initialized_vec.end()};
-  for (const auto& name : run_net.external_input()) {
+  for (const auto& name : run_net_.external_input()) {
     if (!initialized.count(name)) {
       auto* blob = ws_.CreateBlob(name);
       blob->template GetMutable<TensorCPU>();
     }
   }
-  CAFFE_ENFORCE(ws_.CreateNet(run_net));
+  CAFFE_ENFORCE(ws_.CreateNet(run_net_));
 }
 
 Predictor::~Predictor() {}
@@ -106,7 +129,7 @@ bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   return true;
 }
 
-bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
+void Predictor::shareInputs(const TensorMap& inputs) {
   if (!inputNames_.empty()) {
     CAFFE_ENFORCE_EQ(inputs.size(), inputNames_.size());
   }
@@ -116,6 +139,10 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
     }
     shareInputTensor(&ws_, input.first, input.second);
   }
+}
+
+bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
+  shareInputs(inputs);
 
   if (!ws_.RunNet(run_net_.name())) {
     return false;
@@ -127,4 +154,40 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
   }
   return true;
 }
+
+const std::string& Predictor::outputsNet(
+    const std::vector<std::string>& output_names) {
+  auto it = outputsNets_.find(output_names);
+  if (it != outputsNets_.end()) {
+    return it->second;
+  }
+  const std::unordered_set<std::string> run_net_outputs{
+      run_net_.external_output().begin(), run_net_.external_output().end()};
+  for (const auto& name : output_names) {
+    CAFFE_ENFORCE(
+        run_net_outputs.count(name), "Not an output of run_net: ", name);
+  }
+  auto net = PruneUnusedOps(run_net_, output_names);
+  net.set_name(
+      run_net_.name() + "_outputs_" + caffe2::to_string(outputsNets_.size()));
+  CAFFE_ENFORCE(ws_.CreateNet(net));
+  return outputsNets_.emplace(output_names, net.name()).first->second;
+}
+
+bool Predictor::run_map_outputs(
+    const TensorMap& inputs,
+    const std::vector<std::string>& output_names,
+    TensorVector* outputs) {
+  shareInputs(inputs);
+
+  if (!ws_.RunNet(outputsNet(output_names))) {
+    return false;
+  }
+
+  outputs->resize(output_names.size());
+  for (auto i = 0; i < outputs->size(); ++i) {
+    (*outputs)[i] = extractOutputTensor(&ws_, output_names[i]);
+  }
+  return true;
+}
 } // namespace caffe2
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <unordered_set>
 #include "caffe2/core/net.h"
 #include "caffe2/core/tensor.h"
@@ -15,14 +16,22 @@ class Predictor {
 
   // MetaNetDef contains 'init_net', 'run_net', and meta-info
   // The meta-info is used to verify inputs are correctly passed
-  Predictor(const MetaNetDef& net, Workspace* parent = nullptr);
+  Predictor(
+      const MetaNetDef& net,
+      Workspace* parent = nullptr,
+      bool fold_constants = false);
 
   // Runs the `init_net` once, then saves the `run_net` to be executed
   // in `::run`
+  // With `fold_constants`, the ops of `run_net` that only depend on blobs
+  // created by `init_net` are run once here instead of at every `::run`.
+  // Blobs that `init_net` creates for the model inputs must then be listed
+  // as inputs of a MetaNetDef, or they would be treated as constants.
   Predictor(
       const NetDef& init_net,
       const NetDef& run_net,
-      Workspace* parent = nullptr);
+      Workspace* parent = nullptr,
+      bool fold_constants = false);
   ~Predictor();
 
   // Executes `run_net` on the inputs.
@@ -41,6 +50,14 @@ class Predictor {
   // Similar to run, but consumes a map of name to tensor as input
   bool run_map(const TensorMap& inputs, TensorVector* outputs);
 
+  // Similar to run_map, but only computes the outputs of run_net named in
+  // `output_names`, returned in that order. The ops that only the other
+  // outputs need are skipped.
+  bool run_map_outputs(
+      const TensorMap& inputs,
+      const std::vector<std::string>& output_names,
+      TensorVector* outputs);
+
   const NetDef& def() const {
     return run_net_;
   };
@@ -50,8 +67,15 @@ class Predictor {
   };
 
  private:
+  void initialize(const NetDef& init_net, bool fold_constants);
+  void shareInputs(const TensorMap& inputs);
+  // Returns the name of the net computing `output_names`, creating it on
+  // first use.
+  const std::string& outputsNet(const std::vector<std::string>& output_names);
+
   NetDef run_net_;
   Workspace ws_;
   std::unordered_set<std::string> inputNames_;
+  std::map<std::vector<std::string>, std::string> outputsNets_;
 };
 }
@@ -197,6 +197,29 @@ TEST_F(PredictorTest, SimpleBatchSizedMapInput) {
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
 
+TEST_F(PredictorTest, RunSubsetOfOutputs) {
+  auto run = parseNetDef(predictSpec);
+  *run.add_op() = CreateOperatorDef("Relu", "", {"y"}, {"z"});
+  run.add_external_output("z");
+  Predictor p(parseNetDef(initSpec), run);
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorMap input{
+      {"data", inputData->template GetMutable<TensorCPU>()}};
+  Predictor::TensorVector output;
+  ASSERT_TRUE(p.run_map_outputs(input, {"y"}, &output));
+  EXPECT_EQ(output.size(), 1);
+  EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
+  // The Relu was not run.
+  EXPECT_FALSE(p.ws()->GetBlob("z")->IsType<TensorCPU>());
+
+  ASSERT_TRUE(p.run_map_outputs(input, {"z", "y"}, &output));
+  EXPECT_EQ(output.size(), 2);
+  EXPECT_EQ(output[0]->dim(1), 10);
+  EXPECT_NEAR(output[0]->data<float>()[4], 0.1209, 1E-4);
+  EXPECT_EQ(output[1]->dim(1), 10);
+  EXPECT_THROW(p.run_map_outputs(input, {"W"}, &output), EnforceNotMet);
+}
+
 class PredictorMetaNetDefTest : public testing::Test {
  public:
   void SetUp() override {
@@ -222,4 +245,17 @@ TEST_F(PredictorMetaNetDefTest, SimpleMetaNetDefInitializer) {
   EXPECT_TRUE(output.front()->dim(1) == 10);
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
+
+TEST_F(PredictorMetaNetDefTest, FoldConstantsKeepsInputs) {
+  // The init net fills "data", which must not be folded as it is an input.
+  Predictor p(parseMetaNetDef(metaSpec), nullptr, true);
+  EXPECT_EQ(p.def().op_size(), 1);
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorMap input{
+      {"data", inputData->template GetMutable<TensorCPU>()}};
+  Predictor::TensorVector output;
+  p.run_map(input, &output);
+  EXPECT_EQ(output.size(), 1);
+  EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
+}
 } // namespace caffe2
@@ -0,0 +1,69 @@
+#include "caffe2/core/scratch_arena.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_max_scratch_arenas,
+    64,
+    "Number of scratch arenas a workspace keeps before evicting the least "
+    "recently used ones that are not in use.");
+
+namespace caffe2 {
+
+Blob* ScratchArena::Acquire() {
+  if (in_use_ == blobs_.size()) {
+    blobs_.emplace_back(new Blob());
+  }
+  return blobs_[in_use_++].get();
+}
+
+std::shared_ptr<ScratchArena> ScratchArenas::ForCurrentThread(
+    const DeviceOption& option,
+    int stream_id) {
+  const Key key(
+      std::this_thread::get_id(),
+      option.device_type(),
+      option.cuda_gpu_id(),
+      stream_id);
+  std::lock_guard<std::mutex> g(mutex_);
+  auto it = arenas_.find(key);
+  if (it == arenas_.end()) {
+    if (arenas_.size() >=
+        static_cast<size_t>(FLAGS_caffe2_max_scratch_arenas)) {
+      EvictOne();
+    }
+    it = arenas_.emplace(key, Entry{std::make_shared<ScratchArena>(), 0})
+             .first;
+  }
+  it->second.last_use = ++clock_;
+  return it->second.arena;
+}
+
+void ScratchArenas::EvictOne() {
+  auto victim = arenas_.end();
+  for (auto it = arenas_.begin(); it != arenas_.end(); ++it) {
+    // Leases hold a reference to their arena.
+    if (it->second.arena.use_count() == 1 &&
+        (victim == arenas_.end() ||
+         it->second.last_use < victim->second.last_use)) {
+      victim = it;
+    }
+  }
+  if (victim != arenas_.end()) {
+    arenas_.erase(victim);
+  }
+}
+
+size_t ScratchArenas::num_arenas() {
+  std::lock_guard<std::mutex> g(mutex_);
+  return arenas_.size();
+}
+
+size_t ScratchArenas::size() {
+  std::lock_guard<std::mutex> g(mutex_);
+  size_t total = 0;
+  for (const auto& kv : arenas_) {
+    total += kv.second.arena->size();
+  }
+  return total;
+}
+
+} // namespace caffe2
@@ -0,0 +1,144 @@
+#ifndef CAFFE2_CORE_SCRATCH_ARENA_H_
+#define CAFFE2_CORE_SCRATCH_ARENA_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "caffe2/core/blob.h"
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * A stack of scratch blobs that operators borrow temporaries from while they
+ * run, instead of keeping them as members. The blobs keep their memory
+ * between runs, so all operators executing on the same thread and stream
+ * share one set of buffers sized for the largest of them.
+ *
+ * An arena is only ever used by a single thread. Buffers are handed out
+ * through a Lease and go back to the arena when the lease is destroyed;
+ * leases on the same arena must be nested, which is naturally the case for
+ * operators that run other nets from their RunOnDevice.
+ */
+class ScratchArena {
+ public:
+  class Lease {
+   public:
+    // A lease on a null arena hands out the fallbacks passed to Get().
+    explicit Lease(ScratchArena* arena)
+        : arena_(arena), begin_(arena ? arena->in_use_ : 0) {}
+
+    // Keeps the arena alive for the duration of the lease, even if its owner
+    // evicts it meanwhile.
+    explicit Lease(std::shared_ptr<ScratchArena> arena)
+        : Lease(arena.get()) {
+      owner_ = std::move(arena);
+    }
+
+    ~Lease() {
+      if (arena_) {
+        arena_->in_use_ = begin_;
+      }
+    }
+
+    // Returns a scratch object of type T, valid until the lease is destroyed.
+    // Its content is left over from an earlier user. If the lease has no
+    // arena, returns fallback instead.
+    template <class T>
+    T* Get(T* fallback) {
+      if (!arena_) {
+        return fallback;
+      }
+      return arena_->Acquire()->template GetMutable<T>();
+    }
+
+   private:
+    std::shared_ptr<ScratchArena> owner_;
+    ScratchArena* arena_;
+    size_t begin_;
+
+    DISABLE_COPY_AND_ASSIGN(Lease);
+  };
+
+  ScratchArena() {}
+
+  // Number of scratch blobs the arena has allocated so far.
+  size_t size() const {
+    return blobs_.size();
+  }
+
+  // Number of scratch blobs currently leased.
+  size_t in_use() const {
+    return in_use_;
+  }
+
+  const Blob& blob(size_t i) const {
+    CAFFE_ENFORCE_LT(i, blobs_.size());
+    return *blobs_[i];
+  }
+
+ private:
+  Blob* Acquire();
+
+  std::vector<std::unique_ptr<Blob>> blobs_;
+  size_t in_use_ = 0;
+
+  DISABLE_COPY_AND_ASSIGN(ScratchArena);
+};
+
+/**
+ * The scratch arenas of a workspace, one per thread, device and stream.
+ *
+ * Work queued by an operator on a device stream may still read its scratch
+ * buffers after the lease is released, so the buffers are only reused by
+ * later operators on the same stream, which run after it. The CUDA streams
+ * of a stream id are distinct for each thread, so the thread, the device and
+ * the stream id together designate one stream.
+ *
+ * At most --caffe2_max_scratch_arenas arenas are kept: past that, creating
+ * an arena evicts the least recently used one that is not leased, e.g. the
+ * arena of a thread that has exited.
+ */
+class ScratchArenas {
+ public:
+  ScratchArenas() {}
+
+  // Thread-safe. Returns the arena of the calling thread for the device
+  // described by option and the given stream, creating it if needed.
+  std::shared_ptr<ScratchArena> ForCurrentThread(
+      const DeviceOption& option,
+      int stream_id);
+
+  // Number of arenas.
+  size_t num_arenas();
+
+  // Total number of scratch blobs across all arenas.
+  size_t size();
+
+ private:
+  using Key = std::tuple<std::thread::id, int, int, int>;
+  struct Entry {
+    std::shared_ptr<ScratchArena> arena;
+    uint64_t last_use;
+  };
+
+  // Removes the least recently used arena that is not leased, if any.
+  void EvictOne();
+
+  std::mutex mutex_;
+  std::map<Key, Entry> arenas_;
+  uint64_t clock_ = 0;
+
+  DISABLE_COPY_AND_ASSIGN(ScratchArenas);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_SCRATCH_ARENA_H_
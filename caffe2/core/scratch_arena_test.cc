@@ -0,0 +1,181 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/scratch_arena.h"
+
+CAFFE2_DECLARE_int(caffe2_max_scratch_arenas);
+
+namespace caffe2 {
+
+namespace {
+
+// Sums its input through a scratch tensor of the same size.
+class ScratchArenaTestOp final : public Operator<CPUContext> {
+ public:
+  ScratchArenaTestOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Output(0);
+    ScratchArena::Lease scratch(scratch_arena());
+    auto* buffer = scratch.Get(&buffer_);
+    buffer->ResizeLike(X);
+    context_.Copy<float, CPUContext, CPUContext>(
+        X.size(), X.data<float>(), buffer->mutable_data<float>());
+    Y->Resize(vector<TIndex>());
+    float sum = 0;
+    for (int i = 0; i < buffer->size(); ++i) {
+      sum += buffer->data<float>()[i];
+    }
+    *Y->mutable_data<float>() = sum;
+    return true;
+  }
+
+  const TensorCPU& buffer() const {
+    return buffer_;
+  }
+
+ private:
+  TensorCPU buffer_;
+};
+
+REGISTER_CPU_OPERATOR(ScratchArenaTest, ScratchArenaTestOp);
+OPERATOR_SCHEMA(ScratchArenaTest).NumInputs(1).NumOutputs(1);
+
+void FillInput(Workspace* ws, const string& name, int size) {
+  auto* X = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  X->Resize(size);
+  for (int i = 0; i < size; ++i) {
+    X->mutable_data<float>()[i] = 1;
+  }
+}
+
+} // namespace
+
+TEST(ScratchArenaTest, NestedLeases) {
+  ScratchArena arena;
+  {
+    ScratchArena::Lease outer(&arena);
+    auto* a = outer.Get<TensorCPU>(nullptr);
+    {
+      ScratchArena::Lease inner(&arena);
+      auto* b = inner.Get<TensorCPU>(nullptr);
+      EXPECT_NE(a, b);
+      EXPECT_EQ(arena.in_use(), 2);
+    }
+    EXPECT_EQ(arena.in_use(), 1);
+    // The buffer released by the inner lease is handed out again.
+    auto* c = outer.Get<TensorCPU>(nullptr);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(arena.size(), 2);
+  }
+  EXPECT_EQ(arena.in_use(), 0);
+  EXPECT_EQ(arena.size(), 2);
+}
+
+TEST(ScratchArenaTest, NullArenaReturnsFallback) {
+  TensorCPU fallback;
+  ScratchArena::Lease lease(nullptr);
+  EXPECT_EQ(lease.Get(&fallback), &fallback);
+}
+
+TEST(ScratchArenaTest, OnePerStream) {
+  ScratchArenas arenas;
+  DeviceOption cpu;
+  DeviceOption gpu;
+  gpu.set_device_type(CUDA);
+  gpu.set_cuda_gpu_id(1);
+  auto arena = arenas.ForCurrentThread(cpu, 0);
+  EXPECT_EQ(arena, arenas.ForCurrentThread(cpu, 0));
+  // Work queued on another stream may still use the buffers of this one.
+  EXPECT_NE(arena, arenas.ForCurrentThread(cpu, 1));
+  EXPECT_NE(arena, arenas.ForCurrentThread(gpu, 0));
+  std::shared_ptr<ScratchArena> other;
+  std::thread([&] { other = arenas.ForCurrentThread(cpu, 0); }).join();
+  EXPECT_NE(arena, other);
+  EXPECT_EQ(arenas.num_arenas(), 4);
+}
+
+TEST(ScratchArenaTest, EvictsIdleArenas) {
+  const int max_arenas = FLAGS_caffe2_max_scratch_arenas;
+  FLAGS_caffe2_max_scratch_arenas = 2;
+  ScratchArenas arenas;
+  DeviceOption option;
+  std::shared_ptr<ScratchArena> arena;
+  // The arena of a thread that has exited goes once there are too many.
+  std::thread([&] { arena = arenas.ForCurrentThread(option, 0); }).join();
+  arena.reset();
+  {
+    ScratchArena::Lease lease(arenas.ForCurrentThread(option, 0));
+    lease.Get<TensorCPU>(nullptr);
+    EXPECT_EQ(arenas.num_arenas(), 2);
+    EXPECT_EQ(arenas.size(), 1);
+    arenas.ForCurrentThread(option, 1);
+    EXPECT_EQ(arenas.num_arenas(), 2);
+    // The least recently used arena is leased, so stream 1 goes instead.
+    arenas.ForCurrentThread(option, 2);
+    EXPECT_EQ(arenas.num_arenas(), 2);
+    EXPECT_EQ(arenas.size(), 1);
+  }
+  arenas.ForCurrentThread(option, 2);
+  arenas.ForCurrentThread(option, 3);
+  EXPECT_EQ(arenas.num_arenas(), 2);
+  EXPECT_EQ(arenas.size(), 0);
+  FLAGS_caffe2_max_scratch_arenas = max_arenas;
+}
+
+TEST(ScratchArenaTest, SharedAcrossOperators) {
+  Workspace ws;
+  FillInput(&ws, "X1", 10);
+  FillInput(&ws, "X2", 100);
+  NetDef net_def;
+  net_def.set_name("scratch");
+  net_def.set_type("simple");
+  net_def.add_arg()->CopyFrom(MakeArgument<bool>("use_scratch_arena", true));
+  net_def.add_op()->CopyFrom(
+      CreateOperatorDef("ScratchArenaTest", "", {"X1"}, {"Y1"}));
+  net_def.add_op()->CopyFrom(
+      CreateOperatorDef("ScratchArenaTest", "", {"X2"}, {"Y2"}));
+  auto* net = ws.CreateNet(net_def);
+  ASSERT_TRUE(net != nullptr);
+  for (auto* op : net->GetOperators()) {
+    EXPECT_TRUE(op->use_scratch_arena());
+  }
+  EXPECT_TRUE(ws.RunNet("scratch"));
+  EXPECT_EQ(ws.GetBlob("Y1")->Get<TensorCPU>().data<float>()[0], 10);
+  EXPECT_EQ(ws.GetBlob("Y2")->Get<TensorCPU>().data<float>()[0], 100);
+  // The arenas are not blobs of the workspace.
+  EXPECT_EQ(ws.Blobs().size(), 4);
+
+  // Both operators ran on this thread and used the same scratch tensor.
+  EXPECT_EQ(ws.GetScratchArenas()->num_arenas(), 1);
+  EXPECT_EQ(ws.GetScratchArenas()->size(), 1);
+  for (auto* op : net->GetOperators()) {
+    EXPECT_EQ(
+        static_cast<ScratchArenaTestOp*>(op)->buffer().capacity_nbytes(), 0);
+  }
+}
+
+TEST(ScratchArenaTest, DisabledByDefault) {
+  Workspace ws;
+  FillInput(&ws, "X", 10);
+  NetDef net_def;
+  net_def.set_name("no_scratch");
+  net_def.set_type("simple");
+  net_def.add_op()->CopyFrom(
+      CreateOperatorDef("ScratchArenaTest", "", {"X"}, {"Y"}));
+  auto* net = ws.CreateNet(net_def);
+  ASSERT_TRUE(net != nullptr);
+  EXPECT_TRUE(ws.RunNet("no_scratch"));
+  EXPECT_EQ(ws.GetScratchArenas()->num_arenas(), 0);
+  auto* op = static_cast<ScratchArenaTestOp*>(net->GetOperators()[0]);
+  EXPECT_FALSE(op->use_scratch_arena());
+  EXPECT_EQ(op->buffer().size(), 10);
+}
+
+} // namespace caffe2
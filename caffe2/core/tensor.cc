@@ -90,6 +90,10 @@ struct TensorCPUStatGetter : BlobStatGetter {
     }
     return nbytes;
   }
+
+  size_t allocations(const Blob& blob) const override {
+    return blob.Get<TensorCPU>().allocation_count();
+  }
 };
 REGISTER_BLOB_STAT_GETTER(TensorCPU, TensorCPUStatGetter);
 }
@@ -1,6 +1,7 @@
 #ifndef CAFFE2_CORE_TENSOR_H_
 #define CAFFE2_CORE_TENSOR_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
@@ -80,6 +81,65 @@ inline int canonical_axis_index_(int axis_index, int ndims) {
   return axis_index;
 }
 
+/**
+ * @brief Controls how a Tensor sizes and retains its storage across Resize()
+ * calls.
+ *
+ * The default policy allocates exactly the requested number of bytes and
+ * follows the global caffe2_keep_on_shrink flags, which is the historical
+ * behavior. Blobs that see variable-sized inputs (e.g. variable batch sizes)
+ * can use a more aggressive policy to avoid reallocating on every run.
+ */
+struct TensorGrowthPolicy {
+  // When a tensor outgrows its storage, allocate at least this many percent
+  // more than the storage it had before. This gives amortized O(1)
+  // reallocations for steadily growing tensors, similar to Extend().
+  float growth_pct = 0;
+  // If set, storage is never released on shrink, independently of the
+  // caffe2_keep_on_shrink and caffe2_max_keep_on_shrink_memory flags.
+  bool keep_high_water_mark = false;
+  // If set, allocation sizes are rounded up to a size class. Size classes are
+  // spaced at a quarter of the enclosing power of two, which bounds the waste
+  // to 25% while letting nearby sizes share an allocation.
+  bool round_to_size_class = false;
+
+  bool IsDefault() const {
+    return growth_pct <= 0 && !keep_high_water_mark && !round_to_size_class;
+  }
+
+  /**
+   * Returns the number of bytes to allocate for a request of nbytes, given
+   * that the previous storage of the tensor held previous_nbytes.
+   */
+  size_t AllocationBytes(size_t nbytes, size_t previous_nbytes) const {
+    size_t bytes = nbytes;
+    if (growth_pct > 0 && previous_nbytes > 0) {
+      bytes = std::max(
+          bytes,
+          static_cast<size_t>(previous_nbytes * (growth_pct + 100) / 100));
+    }
+    if (round_to_size_class) {
+      bytes = RoundToSizeClass(bytes);
+    }
+    return bytes;
+  }
+
+  static size_t RoundToSizeClass(size_t nbytes) {
+    // Small allocations are rounded to a cache line.
+    constexpr size_t kMinSizeClass = 64;
+    if (nbytes <= kMinSizeClass) {
+      return kMinSizeClass;
+    }
+    size_t power = kMinSizeClass;
+    while (power * 2 < nbytes) {
+      power <<= 1;
+    }
+    // nbytes now lies in (power, 2 * power]; round to a quarter of power.
+    const size_t step = power / 4;
+    return (nbytes + step - 1) / step * step;
+  }
+};
+
 /**
  * @brief Tensor is the basic class in Caffe2 that stores a contiguous memory
  * with its shape information.
@@ -292,7 +352,7 @@ class Tensor {
       // will create the data storage.
       int64_t new_size = size_ * meta_.itemsize();
       bool reset_tensor = false;
-      if (reserved_) {
+      if (reserved_ || growth_policy_.keep_high_water_mark) {
         // If tensor is reserved then don't claim its memeory unless capacity_
         // is smaller than new size
         reset_tensor = capacity_ < new_size;
@@ -302,7 +362,11 @@ class Tensor {
       }
 
       if (reset_tensor) {
+        // Remember the storage we outgrew so that the growth policy can
+        // over-allocate relative to it.
+        size_t outgrown_capacity = capacity_ < new_size ? capacity_ : 0;
         FreeMemory();
+        previous_capacity_ = outgrown_capacity;
       }
     }
   }
@@ -353,6 +417,7 @@ class Tensor {
   inline void FreeMemory() {
     data_.reset();
     capacity_ = 0;
+    previous_capacity_ = 0;
     // If reserved is true and we changed tensor memory then it is fine
     // to switch it to false, if Resize is called from Reserve and it triggers
     // FreeMemory() then reserved_ will be set to true at end of Reserve()
@@ -465,6 +530,28 @@ class Tensor {
     return shares_data_;
   }
 
+  /**
+   * @brief Sets the policy used to size future allocations of this tensor.
+   *
+   * The policy and the allocation statistics belong to the tensor object
+   * itself: they are not exchanged by swap() nor propagated by ShareData().
+   */
+  void SetGrowthPolicy(const TensorGrowthPolicy& policy) {
+    growth_policy_ = policy;
+  }
+
+  const TensorGrowthPolicy& growth_policy() const {
+    return growth_policy_;
+  }
+
+  /**
+   * Returns the number of times this tensor allocated new storage. Any count
+   * above one means that the tensor had to reallocate.
+   */
+  size_t allocation_count() const {
+    return allocation_count_;
+  }
+
   /**
    * Returns a const raw void* pointer of the underlying storage. mutable_data()
    * or raw_mutable_data() must have been called prior to this function call.
@@ -531,6 +618,8 @@ class Tensor {
         // For types that need placement new, we will call it, as well as
         // making sure that when the data is freed, it calls the right
         // destruction procedure.
+        // Over-allocation is not applied here: only the first size_ items are
+        // constructed, so the capacity must match them exactly.
         auto size = size_;
         auto dtor = meta_.dtor();
         auto ptr_and_deleter = Context::New(size_ * meta_.itemsize());
@@ -541,12 +630,16 @@ class Tensor {
               deleter(ptr);
             });
         meta_.ctor()(data_.get(), size_);
+        capacity_ = size_ * meta_.itemsize();
       } else {
         // For fundamental type, new and delete is easier.
-        auto ptr_and_deleter = Context::New(size_ * meta_.itemsize());
+        capacity_ = growth_policy_.AllocationBytes(
+            size_ * meta_.itemsize(), previous_capacity_);
+        auto ptr_and_deleter = Context::New(capacity_);
         data_.reset(ptr_and_deleter.first, ptr_and_deleter.second);
       }
-      capacity_ = size_ * meta_.itemsize();
+      previous_capacity_ = 0;
+      ++allocation_count_;
       return data_.get();
     }
   }
@@ -684,6 +777,11 @@ class Tensor {
   bool shares_data_ = false;
   size_t capacity_ = 0;
   bool reserved_ = false;
+  TensorGrowthPolicy growth_policy_;
+  // Capacity of the storage released by the last growing Resize(), used by
+  // the growth policy. Zero if there is nothing to grow from.
+  size_t previous_capacity_ = 0;
+  size_t allocation_count_ = 0;
   // In case of chunk load we store how much data was already loaded
 
  private:
@@ -0,0 +1,5 @@
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+CAFFE_KNOWN_TYPE(int8::Int8TensorCPU);
+}
@@ -0,0 +1,39 @@
+#ifndef CAFFE2_CORE_TENSOR_INT8_H_
+#define CAFFE2_CORE_TENSOR_INT8_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/context.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/typeid.h"
+
+namespace caffe2 {
+namespace int8 {
+
+/**
+ * @brief An 8-bit linearly quantized CPU tensor.
+ *
+ * Element q of t stands for the real value scale * (q - zero_point).
+ * Activations are stored as uint8_t with an arbitrary zero point. Weights
+ * are stored as int8_t with a zero point of 0, and may carry one scale per
+ * slice along their first (output channel) dimension in channel_scales,
+ * which then takes precedence over scale.
+ */
+struct Int8TensorCPU {
+  float scale{1.0};
+  int32_t zero_point{0};
+  std::vector<float> channel_scales;
+  TensorCPU t;
+
+  // The scale of the given slice along the first dimension.
+  float channel_scale(int i) const {
+    return channel_scales.empty() ? scale : channel_scales[i];
+  }
+};
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_TENSOR_INT8_H_
@@ -18,6 +18,7 @@ CAFFE_KNOWN_TYPE(uint16_t);
 CAFFE_KNOWN_TYPE(int16_t);
 CAFFE_KNOWN_TYPE(int64_t);
 CAFFE_KNOWN_TYPE(float16);
+CAFFE_KNOWN_TYPE(bfloat16);
 CAFFE_KNOWN_TYPE(double);
 CAFFE_KNOWN_TYPE(char);
 CAFFE_KNOWN_TYPE(std::unique_ptr<std::mutex>);
@@ -51,6 +52,7 @@ TensorProto::DataType TypeMetaToDataType(const TypeMeta& meta) {
     {TypeMeta::Id<int16_t>(), TensorProto_DataType_INT16},
     {TypeMeta::Id<int64_t>(), TensorProto_DataType_INT64},
     {TypeMeta::Id<float16>(), TensorProto_DataType_FLOAT16},
+    {TypeMeta::Id<bfloat16>(), TensorProto_DataType_BFLOAT16},
     {TypeMeta::Id<double>(), TensorProto_DataType_DOUBLE},
   };
   const auto it = data_type_map.find(meta.id());
@@ -70,6 +72,7 @@ const TypeMeta& DataTypeToTypeMeta(const TensorProto::DataType& dt) {
       {TensorProto_DataType_INT16, TypeMeta::Make<int16_t>()},
       {TensorProto_DataType_INT64, TypeMeta::Make<int64_t>()},
       {TensorProto_DataType_FLOAT16, TypeMeta::Make<float16>()},
+      {TensorProto_DataType_BFLOAT16, TypeMeta::Make<bfloat16>()},
       {TensorProto_DataType_DOUBLE, TypeMeta::Make<double>()},
   };
   const auto it = type_meta_map.find(dt);
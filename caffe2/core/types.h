@@ -52,6 +52,11 @@ static_assert(sizeof(unsigned short) == 2,
 namespace caffe2 {
 typedef struct CAFFE2_ALIGNED(2) __f16 { uint16_t x; } float16;
 
+// Brain floating point: the upper 16 bits of an IEEE float, i.e. the same
+// exponent range as float with an 8 bit mantissa. It is only used as a storage
+// format on CPU; computation happens in float.
+typedef struct CAFFE2_ALIGNED(2) __bf16 { uint16_t x; } bfloat16;
+
 // Helpers to avoid using typeinfo with -rtti
 template <typename T>
 inline bool fp16_type();
@@ -68,11 +73,14 @@ inline bool fp16_type() {
 
 }  // namespace caffe2
 
-// Make __f16 a fundamental type.
+// Make __f16 and __bf16 fundamental types.
 namespace std {
 template<>
 struct is_fundamental<caffe2::__f16> : std::integral_constant<bool, true> {
 };
+template<>
+struct is_fundamental<caffe2::__bf16> : std::integral_constant<bool, true> {
+};
 }  // namespace std
 
 #endif  // CAFFE2_CORE_TYPES_H_
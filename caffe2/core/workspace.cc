@@ -305,11 +305,24 @@ bool Workspace::RunPlan(const PlanDef& plan, ShouldContinue shouldContinue) {
 }
 
 ThreadPool* Workspace::GetThreadPool() {
+  ThreadPool* pool = thread_pool_ptr_.load(std::memory_order_acquire);
+  if (pool) {
+    return pool;
+  }
   std::lock_guard<std::mutex> guard(thread_pool_creation_mutex_);
   if (!thread_pool_) {
     thread_pool_ = ThreadPool::defaultThreadPool();
+    thread_pool_ptr_.store(thread_pool_.get(), std::memory_order_release);
   }
   return thread_pool_.get();
 }
 
+ScratchArenas* Workspace::GetScratchArenas() {
+  std::lock_guard<std::mutex> guard(scratch_arenas_creation_mutex_);
+  if (!scratch_arenas_) {
+    scratch_arenas_.reset(new ScratchArenas());
+  }
+  return scratch_arenas_.get();
+}
+
 } // namespace caffe2
@@ -4,6 +4,7 @@
 #include "caffe2/core/common.h"
 #include "caffe2/core/observer.h"
 
+#include <atomic>
 #include <climits>
 #include <cstddef>
 #include <mutex>
@@ -14,6 +15,7 @@
 #include "caffe2/core/blob.h"
 #include "caffe2/core/registry.h"
 #include "caffe2/core/net.h"
+#include "caffe2/core/scratch_arena.h"
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/signal_handler.h"
 #include "caffe2/utils/threadpool/ThreadPool.h"
@@ -276,6 +278,13 @@ class Workspace {
    */
   ThreadPool* GetThreadPool();
 
+  /*
+   * Returns the scratch arenas that the operators of this workspace borrow
+   * their temporary buffers from when they use scratch arenas. They are
+   * created lazily.
+   */
+  ScratchArenas* GetScratchArenas();
+
   // RunOperatorOnce and RunNetOnce runs an operator or net once. The difference
   // between RunNet and RunNetOnce lies in the fact that RunNet allows you to
   // have a persistent net object, while RunNetOnce creates a net and discards
@@ -295,7 +304,11 @@ class Workspace {
   std::unordered_map<string, std::pair<const Workspace*, string>>
       forwarded_blobs_;
   std::unique_ptr<ThreadPool> thread_pool_;
+  // thread_pool_ once created, read without taking the mutex.
+  std::atomic<ThreadPool*> thread_pool_ptr_{nullptr};
   std::mutex thread_pool_creation_mutex_;
+  std::unique_ptr<ScratchArenas> scratch_arenas_;
+  std::mutex scratch_arenas_creation_mutex_;
 
   DISABLE_COPY_AND_ASSIGN(Workspace);
 };
@@ -115,4 +115,17 @@ TEST(WorkspaceTest, BlobMapping) {
   }
 }
 
+TEST(WorkspaceTest, ThreadPool) {
+  Workspace parent;
+  Workspace shared(&parent);
+  Workspace forwarded(&shared, std::unordered_map<string, string>());
+  // Each workspace has a threadpool of its own, created once.
+  ThreadPool* pool = parent.GetThreadPool();
+  EXPECT_TRUE(pool);
+  EXPECT_EQ(pool, parent.GetThreadPool());
+  EXPECT_NE(pool, shared.GetThreadPool());
+  EXPECT_NE(pool, forwarded.GetThreadPool());
+  EXPECT_NE(shared.GetThreadPool(), forwarded.GetThreadPool());
+}
+
 }  // namespace caffe2
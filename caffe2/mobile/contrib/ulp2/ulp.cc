@@ -1,5 +1,7 @@
 #include "ulp.h"
 #include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/utils/cpuid.h"
+#include "ulp_avx2.h"
 #include "ulp_neon.h"
 
 namespace caffe2 {
@@ -115,7 +117,7 @@ void qpad_zero(const ConvArgs& args, const TensorCPU& X, TensorCPU* Y) {
             X.dim32(2) + args.pad_l + args.pad_r,
             X.dim32(3));
   auto* Ydata = Y->mutable_data<uint8_t>();
-  ::memset(Ydata, Y->nbytes(), 0);
+  ::memset(Ydata, 0, Y->nbytes());
   const auto C = Y->dim32(3);
   const auto XrowSize = X.dim32(3) * X.dim32(2);
   const auto YrowSize = Y->dim32(3) * Y->dim32(2);
@@ -296,6 +298,11 @@ void run2b1bConvGeneric(QConvState* state, const ConvArgs& args, const TensorCPU
   if (run2b1bConvNeon(state, args, X, Y)) {
     return;
   }
+#endif
+#ifdef CAFFE2_PERF_WITH_AVX2
+  if (GetCpuId().avx2() && run2b1bConvAVX2(state, args, X, Y)) {
+    return;
+  }
 #endif
   uniformQuantize2b1b(X, state->XQs, 0.5, 1.0);
   for (auto i = 0; i < k2b1bXBits; ++i) {
@@ -0,0 +1,211 @@
+#include "ulp_avx2.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+#ifdef __AVX2__
+
+// Number of output pixels handed to each parallelFor task.
+constexpr size_t kAVX2RowsPerBlock = 16;
+
+// Applies 2-bit uniform quantization to 8 floats at a time. Each comparison
+// mask has one bit per channel, so movemask directly gives the packed byte.
+void uniformQuantize2b1bAVX2(QConvState* state,
+                             const TensorCPU& X,
+                             const std::vector<std::unique_ptr<TensorCPU>>& XQ,
+                             float offset,
+                             float inter_center_distance) {
+  CAFFE_ENFORCE_GT(X.ndim(), 1);
+  const size_t C = X.dim32(X.ndim() - 1);
+  const size_t N = X.size() / C;
+  const size_t QC = divRoundUp(C, 8);
+  auto XQs = X.dims();
+  XQs[X.ndim() - 1] = QC;
+  CAFFE_ENFORCE_EQ(XQ.size(), k2b1bXBits);
+  for (auto i = 0; i < k2b1bXBits; ++i) {
+    XQ[i]->Resize(XQs);
+  }
+  const float* Xdata = X.data<float>();
+  std::array<uint8_t*, k2b1bXBits> XQdata;
+  for (size_t i = 0; i < k2b1bXBits; ++i) {
+    XQdata[i] = XQ[i]->mutable_data<uint8_t>();
+  }
+  const __m256 offset_ = _mm256_set1_ps(offset);
+  const __m256 offset_plus_inter_center_distance = _mm256_set1_ps(offset + inter_center_distance);
+  const __m256 offset_plus_2_inter_center_distance =
+      _mm256_set1_ps(offset + 2 * inter_center_distance);
+  const size_t QCUnroll = C / 8;
+  state->parallelFor(divRoundUp(N, kAVX2RowsPerBlock), [&](size_t nb) {
+    for (size_t n = nb * kAVX2RowsPerBlock;
+         n < std::min<size_t>(nb * kAVX2RowsPerBlock + kAVX2RowsPerBlock, N);
+         ++n) {
+      for (size_t qc = 0; qc < QCUnroll; ++qc) {
+        const __m256 x = _mm256_loadu_ps(&Xdata[qc * 8 + C * n]);
+        const int ge0 = _mm256_movemask_ps(_mm256_cmp_ps(x, offset_, _CMP_GE_OQ));
+        const int ge1 =
+            _mm256_movemask_ps(_mm256_cmp_ps(x, offset_plus_inter_center_distance, _CMP_GE_OQ));
+        const int ge2 =
+            _mm256_movemask_ps(_mm256_cmp_ps(x, offset_plus_2_inter_center_distance, _CMP_GE_OQ));
+        XQdata[0][qc + QC * n] = (ge0 & ~ge1) | ge2;
+        XQdata[1][qc + QC * n] = ge1;
+      }
+      for (size_t qc = QCUnroll; qc < QC; ++qc) {
+        std::array<uint8_t, k2b1bXBits> p = {{0, 0}};
+        for (size_t b = 0; b < 8; ++b) {
+          const size_t c = qc * 8 + b;
+          if (c < C) {
+            float v = Xdata[c + C * n];
+            if (v < offset) {
+              // zero'd already.
+            } else if (v < offset + inter_center_distance) {
+              p[0] |= 1 << b;
+            } else if (v < offset + 2 * inter_center_distance) {
+              p[1] |= 1 << b;
+            } else {
+              p[0] |= 1 << b;
+              p[1] |= 1 << b;
+            }
+          }
+        }
+        for (auto i = 0; i < k2b1bXBits; ++i) {
+          XQdata[i][qc + QC * n] = p[i];
+        }
+      }
+    }
+  });
+}
+
+// Per-byte popcount through a nibble lookup table.
+inline __m256i popcnt8(__m256i v) {
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_and_si256(v, low_mask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  return _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+}
+
+inline uint32_t hsum64(__m256i v) {
+  const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+// Computes popcount(X0 ^ W[f]) and popcount(X1 ^ W[f]) over QK bytes for
+// kUnrollF consecutive filters, so each filter row is loaded once for both
+// bit planes of the input.
+template <size_t kUnrollF>
+inline void qxor_popcount(const uint8_t* __restrict__ X0,
+                          const uint8_t* __restrict__ X1,
+                          const uint8_t* __restrict__ W,
+                          size_t QK,
+                          uint32_t* acc0,
+                          uint32_t* acc1) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i vacc0[kUnrollF];
+  __m256i vacc1[kUnrollF];
+  for (size_t f = 0; f < kUnrollF; ++f) {
+    vacc0[f] = zero;
+    vacc1[f] = zero;
+  }
+  size_t qk = 0;
+  for (; qk + 32 <= QK; qk += 32) {
+    const __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(X0 + qk));
+    const __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(X1 + qk));
+    for (size_t f = 0; f < kUnrollF; ++f) {
+      const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(W + f * QK + qk));
+      vacc0[f] = _mm256_add_epi64(vacc0[f],
+                                  _mm256_sad_epu8(popcnt8(_mm256_xor_si256(x0, w)), zero));
+      vacc1[f] = _mm256_add_epi64(vacc1[f],
+                                  _mm256_sad_epu8(popcnt8(_mm256_xor_si256(x1, w)), zero));
+    }
+  }
+  for (size_t f = 0; f < kUnrollF; ++f) {
+    acc0[f] = hsum64(vacc0[f]);
+    acc1[f] = hsum64(vacc1[f]);
+    for (size_t k = qk; k < QK; ++k) {
+      acc0[f] += __builtin_popcount(X0[k] ^ W[f * QK + k]);
+      acc1[f] += __builtin_popcount(X1[k] ^ W[f * QK + k]);
+    }
+  }
+}
+
+// Computes Y = 3/2 WQN + 1/2 YQ0 + YQ1 + bias, where YQi is the -1/1 product
+// of the i-th input bit plane (M x QK bytes) with the filters (F x QK bytes),
+// without materializing YQ0 and YQ1.
+void qgemm_nt_2b1b_avx2(QConvState* state,
+                        size_t M,
+                        size_t F,
+                        size_t QK,
+                        const uint8_t* X0,
+                        const uint8_t* X1,
+                        const uint8_t* W,
+                        const float* WQN,
+                        const float* bias,
+                        float* Y) {
+  constexpr size_t kUnrollF = 4;
+  const float K = QK * 8;
+  state->parallelFor(divRoundUp(M, kAVX2RowsPerBlock), [&](size_t mb) {
+    for (size_t m = mb * kAVX2RowsPerBlock;
+         m < std::min<size_t>(mb * kAVX2RowsPerBlock + kAVX2RowsPerBlock, M);
+         ++m) {
+      const uint8_t* X0row = X0 + m * QK;
+      const uint8_t* X1row = X1 + m * QK;
+      float* Yrow = Y + m * F;
+      uint32_t acc0[kUnrollF];
+      uint32_t acc1[kUnrollF];
+      size_t f = 0;
+      for (; f + kUnrollF <= F; f += kUnrollF) {
+        qxor_popcount<kUnrollF>(X0row, X1row, W + f * QK, QK, acc0, acc1);
+        for (size_t ff = 0; ff < kUnrollF; ++ff) {
+          Yrow[f + ff] = 1.5f * WQN[f + ff] + 0.5f * (K - 2.0f * acc0[ff]) +
+              (K - 2.0f * acc1[ff]) + (bias ? bias[f + ff] : 0.0f);
+        }
+      }
+      for (; f < F; ++f) {
+        qxor_popcount<1>(X0row, X1row, W + f * QK, QK, acc0, acc1);
+        Yrow[f] = 1.5f * WQN[f] + 0.5f * (K - 2.0f * acc0[0]) + (K - 2.0f * acc1[0]) +
+            (bias ? bias[f] : 0.0f);
+      }
+    }
+  });
+}
+
+bool run2b1bConvAVX2(QConvState* state, const ConvArgs& args, const TensorCPU& X, TensorCPU* Y) {
+  CAFFE_ENFORCE_EQ(X.ndim(), 4);
+  const size_t KH = state->WQ->dim32(1);
+  const size_t KW = state->WQ->dim32(2);
+  const size_t OH = (X.dim32(1) - KH + args.pad_t + args.pad_b) / args.stride_h + 1;
+  const size_t OW = (X.dim32(2) - KW + args.pad_l + args.pad_r) / args.stride_w + 1;
+  const size_t OC = state->WQ->dim32(0);
+  const size_t QK = state->WQ->size() / OC;
+  CAFFE_ENFORCE_EQ(QK, KH * KW * divRoundUp(X.dim32(3), 8));
+  Y->Resize(X.dim32(0), OH, OW, OC);
+
+  uniformQuantize2b1bAVX2(state, X, state->XQs, 0.5, 1.0);
+  const bool is_1x1 = KH == 1 && KW == 1 && args.pad_l == 0 && args.pad_r == 0 && args.pad_b == 0 &&
+                      args.pad_t == 0 && args.stride_h == 1 && args.stride_w == 1;
+  const TensorCPU* XQcols[k2b1bXBits] = {state->XQs[0].get(), state->XQs[1].get()};
+  if (!is_1x1) {
+    // The column buffers of both bit planes are needed at once.
+    qim2col(args, *(state->XQs[0]), *(state->WQ), state->scratchColBuffer.get());
+    qim2col(args, *(state->XQs[1]), *(state->WQ), state->scratch.get());
+    XQcols[0] = state->scratchColBuffer.get();
+    XQcols[1] = state->scratch.get();
+  }
+  qgemm_nt_2b1b_avx2(state,
+                     X.dim32(0) * OH * OW,
+                     OC,
+                     QK,
+                     XQcols[0]->data<uint8_t>(),
+                     XQcols[1]->data<uint8_t>(),
+                     state->WQ->data<uint8_t>(),
+                     state->WQN->data<float>(),
+                     state->bias ? state->bias->data<float>() : nullptr,
+                     Y->mutable_data<float>());
+  return true;
+}
+
+#endif
+
+} // namespace caffe2
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "ulp.h"
+
+namespace caffe2 {
+
+// Runs the 2b1b convolution with AVX2 kernels. Only call this on CPUs that
+// support AVX2; the translation unit is compiled with -mavx2.
+bool run2b1bConvAVX2(QConvState* state, const ConvArgs& args, const TensorCPU& X, TensorCPU* Y);
+}
@@ -1,4 +1,6 @@
 #include "ulp.h"
+#include "caffe2/utils/cpuid.h"
+#include "ulp_avx2.h"
 #include "ulp_neon.h"
 #include "gtest/gtest.h"
 
@@ -368,6 +370,33 @@ TEST(QConv, 2b1bInputPackingTest) {
   ConvTest2b1b(2, 2, 2, 3, 3, 1, 1, ca());
 }
 
+#ifdef CAFFE2_PERF_WITH_AVX2
+TEST(QConv, 2b1bConvAVX2Test) {
+  if (!GetCpuId().avx2()) {
+    return;
+  }
+  // Channel counts that are not multiples of 8, and rows that are not
+  // multiples of the 32 byte vector width.
+  for (const auto& shape : std::vector<std::array<int, 4>>{
+           {{3, 3, 3, 5}}, {{40, 1, 1, 7}}, {{264, 3, 3, 9}}, {{512, 1, 1, 4}}}) {
+    const auto IC = shape[0], KH = shape[1], KW = shape[2], OC = shape[3];
+    const auto args = ca(KH / 2, 1);
+    auto X = genTensor0123({2, 7, 6, IC});
+    auto W = genTensor11({OC, KH, KW, IC});
+    auto bias = genTensorUniform11({OC});
+    TensorCPU Y, YAVX2;
+    conv(args, X, W, &bias, &Y);
+    Workspace ws;
+    auto state = create2b1bConvState(&ws, W, &bias);
+    ASSERT_TRUE(run2b1bConvAVX2(state.get(), args, X, &YAVX2));
+    ASSERT_TRUE(Y.dims() == YAVX2.dims());
+    for (auto i = 0; i < Y.size(); ++i) {
+      EXPECT_NEAR(Y.data<float>()[i], YAVX2.data<float>()[i], 1e-3);
+    }
+  }
+}
+#endif
+
 TEST(QConv, 2b1bConvTestRandomized) {
   auto rca = []() {
     ConvArgs r;
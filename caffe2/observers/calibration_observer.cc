@@ -0,0 +1,64 @@
+#include "caffe2/observers/calibration_observer.h"
+
+namespace caffe2 {
+
+void CalibrationOperatorObserver::Start() {
+  const auto& def = subject_->debug_def();
+  const auto& inputs = subject_->Inputs();
+  for (int i = 0; i < inputs.size(); ++i) {
+    net_observer_->Record(def.input(i), *inputs[i]);
+  }
+}
+
+void CalibrationOperatorObserver::Stop() {
+  const auto& def = subject_->debug_def();
+  const auto& outputs = subject_->Outputs();
+  for (int i = 0; i < outputs.size(); ++i) {
+    net_observer_->Record(def.output(i), *outputs[i]);
+  }
+}
+
+void CalibrationNetObserver::Start() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  recorded_this_run_.clear();
+}
+
+void CalibrationNetObserver::Record(const std::string& name, const Blob& blob) {
+  if (!blob.IsType<TensorCPU>()) {
+    return;
+  }
+  const auto& tensor = blob.Get<TensorCPU>();
+  if (!tensor.IsType<float>() || tensor.size() == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!recorded_this_run_.insert(name).second) {
+    return;
+  }
+  auto it = histograms_.find(name);
+  if (it == histograms_.end()) {
+    it = histograms_.emplace(name, int8::Histogram(nbins_)).first;
+  }
+  it->second.Add(tensor.data<float>(), tensor.size());
+}
+
+std::unordered_map<std::string, int8::Histogram>
+CalibrationNetObserver::GetHistograms() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return histograms_;
+}
+
+std::unordered_map<std::string, int8::QuantizationParams>
+CalibrationNetObserver::GetQuantizationParams(
+    int8::CalibrationMethod method,
+    float percentile) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::unordered_map<std::string, int8::QuantizationParams> params;
+  for (const auto& it : histograms_) {
+    params[it.first] =
+        int8::ChooseQuantizationParams(it.second, method, percentile);
+  }
+  return params;
+}
+
+} // namespace caffe2
@@ -0,0 +1,74 @@
+#ifndef CAFFE2_OBSERVERS_CALIBRATION_OBSERVER_H_
+#define CAFFE2_OBSERVERS_CALIBRATION_OBSERVER_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/transforms/int8_quantization_transform.h"
+
+namespace caffe2 {
+
+class CalibrationNetObserver;
+
+class CalibrationOperatorObserver final : public ObserverBase<OperatorBase> {
+ public:
+  CalibrationOperatorObserver(
+      OperatorBase* subject,
+      CalibrationNetObserver* net_observer)
+      : ObserverBase<OperatorBase>(subject), net_observer_(net_observer) {}
+
+ private:
+  // Inputs are recorded before the operator runs, since in-place operators
+  // overwrite them; outputs after.
+  void Start() override;
+  void Stop() override;
+
+  CalibrationNetObserver* net_observer_;
+};
+
+/**
+ * Collects histograms of the float CPU tensors read and written by the
+ * operators of a net, to calibrate post-training quantization. Run the net
+ * on representative inputs with the observer attached, then pass the result
+ * of GetQuantizationParams to int8::QuantizeNet. Each blob is recorded once
+ * per run of the net, the first time it is seen.
+ */
+class CalibrationNetObserver final
+    : public OperatorAttachingNetObserver<
+          CalibrationOperatorObserver,
+          CalibrationNetObserver> {
+ public:
+  explicit CalibrationNetObserver(NetBase* subject, int nbins = 2048)
+      : OperatorAttachingNetObserver<
+            CalibrationOperatorObserver,
+            CalibrationNetObserver>(subject, this),
+        nbins_(nbins) {}
+
+  void Record(const std::string& name, const Blob& blob);
+
+  std::unordered_map<std::string, int8::Histogram> GetHistograms() const;
+
+  std::unordered_map<std::string, int8::QuantizationParams>
+  GetQuantizationParams(
+      int8::CalibrationMethod method,
+      float percentile = 99.99) const;
+
+ private:
+  void Start() override;
+
+  const int nbins_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, int8::Histogram> histograms_;
+  std::unordered_set<std::string> recorded_this_run_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OBSERVERS_CALIBRATION_OBSERVER_H_
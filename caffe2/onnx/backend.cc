@@ -3,6 +3,7 @@
 #include "caffe2/onnx/backend.h"
 #include "caffe2/onnx/device.h"
 #include "caffe2/onnx/helper.h"
+#include "caffe2/transforms/constant_folding_transform.h"
 #include "caffe2/utils/map_utils.h"
 #include "caffe2/utils/proto_utils.h"
 
@@ -11,6 +12,8 @@
 #include "onnx/optimizer/optimize.h"
 #endif
 
+#include "nomnigraph/Transformations/Caffe2Rewrites.h"
+
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
@@ -85,6 +88,14 @@ ModelProto OptimizeOnnx(const ModelProto& input, bool init) {
 }
 #endif
 
+// The nets converted node by node from ONNX miss fusions (Gemm into FC,
+// BatchNormalization into Conv), keep the transposes of the original layout
+// and compute constant subgraphs at every run. This cleans them up.
+void OptimizeNets(caffe2::NetDef* init_net, caffe2::NetDef* pred_net) {
+  *pred_net = FoldConstantsIntoInitNet(*pred_net, init_net);
+  *pred_net = nom::transformations::rewriteCaffe2Net(*pred_net, init_net);
+}
+
 template <class T, class U>
 U LookUpWithDefault(
     const std::unordered_map<T, U>& map,
@@ -994,7 +1005,8 @@ void Caffe2Backend::OnnxToCaffe2(
 Caffe2BackendRep* Caffe2Backend::Prepare(
     const std::string& onnx_model_str,
     const std::string& device,
-    const std::vector<Caffe2Ops>& extras) {
+    const std::vector<Caffe2Ops>& extras,
+    bool optimize) {
   Caffe2BackendRep* rep = new Caffe2BackendRep();
   ModelProto onnx_model;
   ParseProtoFromLargeString(onnx_model_str, &onnx_model);
@@ -1040,6 +1052,9 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
       opset_version,
       true,
       extras);
+  if (optimize) {
+    OptimizeNets(&rep->init_net(), &rep->pred_net());
+  }
 
   // Get a list of uninitialized inputs to help with the inference setup
   auto& uninitialized_inputs = rep->uninitialized_inputs();
@@ -104,10 +104,15 @@ struct OnnxNode {
 
 class Caffe2Backend {
  public:
+  // With `optimize` (off by default), the converted nets go through constant
+  // folding and the Caffe2 rewrite rules (see
+  // nomnigraph/Transformations/Caffe2Rewrites.h), which may rewrite the
+  // initializers of the model.
   Caffe2BackendRep* Prepare(
       const std::string& onnx_model_str,
       const std::string& device,
-      const std::vector<Caffe2Ops>& extras);
+      const std::vector<Caffe2Ops>& extras,
+      bool optimize = false);
 
   bool SupportOp(const std::string tyep) const;
 
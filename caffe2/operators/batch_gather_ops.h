@@ -11,7 +11,8 @@ template <class Context>
 class BatchGatherOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(BatchGatherOp)
+  BatchGatherOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
 
   bool RunOnDevice() override {
     return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
@@ -36,32 +37,97 @@ class BatchGatherOp final : public Operator<Context> {
     auto block_bytesize = block_size * data.meta().itemsize();
     auto N = indices.size();
     auto data_batch_bytesize = data.size_from_dim(1) * data.meta().itemsize();
-    auto gathered_batch_bytesize =
-        N * data.size_from_dim(2) * data.meta().itemsize();
     const TInd* idxs = indices.template data<TInd>();
     auto src_base = static_cast<const char*>(data.raw_data());
     auto out = static_cast<char*>(output->raw_mutable_data(data.meta()));
 
-    for (auto batch = 0; batch < data.dim(0); ++batch) {
+    for (auto i = 0; i < N; ++i) {
+      auto idx = idxs[i];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < data.dim(1),
+          "INDICES element is out of DATA bounds, id=",
+          idx,
+          " data_dim=",
+          data.dim(1));
+    }
+    GatherRows(
+        data.dim(0),
+        N,
+        block_size,
+        block_bytesize,
+        idxs,
+        src_base,
+        data_batch_bytesize,
+        out,
+        data.meta(),
+        &context_);
+    return true;
+  }
+
+  INPUT_TAGS(DATA, INDICES);
+
+ private:
+  template <typename TInd>
+  void GatherRows(
+      int batch_size,
+      int N,
+      int block_size,
+      size_t block_bytesize,
+      const TInd* idxs,
+      const char* src_base,
+      size_t data_batch_bytesize,
+      char* out,
+      const TypeMeta& meta,
+      CPUContext* context) {
+    if (meta.copy()) {
+      GatherRows<TInd, CPUContext>(
+          batch_size,
+          N,
+          block_size,
+          block_bytesize,
+          idxs,
+          src_base,
+          data_batch_bytesize,
+          out,
+          meta,
+          context);
+      return;
+    }
+    math::GatherRowsCPU(
+        batch_size,
+        N,
+        block_bytesize,
+        idxs,
+        src_base,
+        data_batch_bytesize,
+        out,
+        ws_->GetThreadPool());
+  }
+
+  template <typename TInd, class OtherContext>
+  void GatherRows(
+      int batch_size,
+      int N,
+      int block_size,
+      size_t block_bytesize,
+      const TInd* idxs,
+      const char* src_base,
+      size_t data_batch_bytesize,
+      char* out,
+      const TypeMeta& meta,
+      OtherContext* context) {
+    for (auto batch = 0; batch < batch_size; ++batch) {
       for (auto i = 0; i < N; ++i) {
-        auto idx = idxs[i];
-        CAFFE_ENFORCE(
-            0 <= idx && idx < data.dim(1),
-            "INDICES element is out of DATA bounds, id=",
-            idx,
-            " data_dim=",
-            data.dim(1));
         auto src =
-            src_base + idx * block_bytesize + batch * data_batch_bytesize;
-        auto dst = out + i * block_bytesize + batch * gathered_batch_bytesize;
-        context_.template CopyItems<Context, Context>(
-            data.meta(), block_size, src, dst);
+            src_base + idxs[i] * block_bytesize + batch * data_batch_bytesize;
+        auto dst = out + (batch * N + i) * block_bytesize;
+        context->template CopyItems<Context, Context>(
+            meta, block_size, src, dst);
       }
     }
-    return true;
   }
 
-  INPUT_TAGS(DATA, INDICES);
+  Workspace* ws_;
 };
 
 template <class Context>
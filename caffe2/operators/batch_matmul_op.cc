@@ -66,11 +66,14 @@ vector<TensorShape> TensorInferenceForBatchMatMul(
       N = dims_B[ndims_B - 1];
     }
 
-    std::vector<TIndex> new_dims;
-    if (ndims_A >= ndims_B) {
-      new_dims.assign(dims_A.begin(), dims_A.end() - 2);
-    } else {
-      new_dims.assign(dims_B.begin(), dims_B.end() - 2);
+    // The batch dimensions are broadcasted as numpy does.
+    const int num_batch_dims = std::max(ndims_A, ndims_B) - 2;
+    std::vector<TIndex> new_dims(num_batch_dims);
+    for (int i = 0; i < num_batch_dims; ++i) {
+      const int i_A = i - num_batch_dims + ndims_A - 2;
+      const int i_B = i - num_batch_dims + ndims_B - 2;
+      const TIndex dim_A = i_A >= 0 ? dims_A[i_A] : 1;
+      new_dims[i] = dim_A == 1 && i_B >= 0 ? dims_B[i_B] : dim_A;
     }
     if (!A_broadcasted) {
       new_dims.push_back(M);
@@ -18,7 +18,8 @@ class BatchMatMulOp final : public Operator<Context> {
         trans_a_(OperatorBase::GetSingleArgument<int>("trans_a", 0)),
         trans_b_(OperatorBase::GetSingleArgument<int>("trans_b", 0)),
         broadcast_(OperatorBase::GetSingleArgument<int>("broadcast", 0)),
-        use_scratch_(OperatorBase::GetSingleArgument<int>("use_scratch", 0)) {
+        use_scratch_(OperatorBase::GetSingleArgument<int>("use_scratch", 0)),
+        ws_(ws) {
     if (use_scratch_) {
       scratch_ = std::make_shared<Tensor<Context>>();
     }
@@ -111,29 +112,6 @@ class BatchMatMulOp final : public Operator<Context> {
       // In the event that A or B are one-dimensional, the trailing or leading
       // 1 is not added to the output tensor's size.
 
-      // First step: partition the tensors into inner and outer blocks.
-      // Ignoring the last two dimensions of A and B, ensure that one of the
-      // tensors' dimensions is a suffix of the other. For example,
-      // [4, x, x] is a suffix of [2, 3, 4, x, x]. In this example, the
-      // dimensions of size 2 and 3 will be broadcasted, so we partition into
-      // 2*3=6 individual instances of batched GEMM with A and B \in [4, x, x].
-      size_t num_inner_dims = std::min(ndims_A, ndims_B);
-      for (size_t i = 2; i < num_inner_dims; ++i) {
-        auto first_r_itr = dims_A.rbegin();
-        auto second_r_itr = dims_B.rbegin();
-        CAFFE_ENFORCE_EQ(
-            *(first_r_itr + i),
-            *(second_r_itr + i),
-            dimMismatchErrorString(
-                ndims_A - i - 1,
-                *(first_r_itr + i),
-                ndims_B - i - 1,
-                *(second_r_itr + i),
-                trans_a_,
-                trans_b_));
-      }
-      size_t num_outer_dims = std::max(ndims_A, ndims_B) - num_inner_dims;
-
       // Standard M, N, and K parameters respecting GEMM API and transpose
       // flags
       size_t M, N, K, K_dim;
@@ -172,14 +150,48 @@ class BatchMatMulOp final : public Operator<Context> {
                 trans_b_));
       }
 
-      // Calculate output tensor shapes [B..., (M), (N)]
-      // Batch dimensions will be broadcasted out to those of the longer tensor
-      // A or B. Either M or N are optional if A or B, respectively are 1-D.
-      std::vector<TIndex> new_dims;
-      if (ndims_A >= ndims_B) {
-        new_dims.assign(dims_A.begin(), dims_A.end() - 2);
-      } else {
-        new_dims.assign(dims_B.begin(), dims_B.end() - 2);
+      // Broadcast the batch dimensions, all but the last two, as numpy does:
+      // they are aligned to the right, and the missing ones, or those of
+      // size 1 when broadcasting, take the size of the other tensor. For
+      // example, [4, M, K] * [2, 3, 4, K, N] = [2, 3, 4, M, N] is 2 * 3 * 4
+      // matrix products, reusing each matrix of A for the 2 * 3 outer
+      // batches. Broadcasted matrices are read in place, not copied.
+      const int num_batch_dims = std::max(ndims_A, ndims_B) - 2;
+      std::vector<TIndex> new_dims(num_batch_dims);
+      // How far to move the A and B pointers along each batch dimension, 0
+      // along the dimensions they are broadcasted.
+      std::vector<size_t> A_strides(num_batch_dims);
+      std::vector<size_t> B_strides(num_batch_dims);
+      // The trailing batch dimensions of the same size in A and B are those of
+      // the "inner batches", which are evenly spaced in A, B and Y. The
+      // others are those of the "outer batches", whose offsets are computed.
+      size_t num_sub_batches = 1;
+      int num_outer_dims = 0;
+      size_t A_stride = M * K;
+      size_t B_stride = K * N;
+      for (int i = num_batch_dims - 1; i >= 0; --i) {
+        const int i_A = i - num_batch_dims + ndims_A - 2;
+        const int i_B = i - num_batch_dims + ndims_B - 2;
+        const TIndex dim_A = i_A >= 0 ? dims_A[i_A] : 1;
+        const TIndex dim_B = i_B >= 0 ? dims_B[i_B] : 1;
+        CAFFE_ENFORCE(
+            dim_A == dim_B || (broadcast_ && (dim_A == 1 || dim_B == 1)),
+            dimMismatchErrorString(
+                i_A, dim_A, i_B, dim_B, trans_a_, trans_b_));
+        new_dims[i] = dim_A == 1 ? dim_B : dim_A;
+        A_strides[i] = dim_A == 1 ? 0 : A_stride;
+        B_strides[i] = dim_B == 1 ? 0 : B_stride;
+        A_stride *= dim_A;
+        B_stride *= dim_B;
+        if (num_outer_dims == 0 && dim_A == dim_B) {
+          num_sub_batches *= new_dims[i];
+        } else if (num_outer_dims == 0) {
+          num_outer_dims = i + 1;
+        }
+      }
+      size_t num_outer_batches = 1;
+      for (int i = 0; i < num_outer_dims; ++i) {
+        num_outer_batches *= new_dims[i];
       }
       if (!A_broadcasted) {
         new_dims.push_back(M);
@@ -192,50 +204,6 @@ class BatchMatMulOp final : public Operator<Context> {
         new_dims.push_back(1);
       }
 
-      // Calculate strides. Continuing our example above,
-      //   [4, M, K] * [2, 3, 4, K, N] = [2, 3, 4, M, N]
-      // We calculate this as follows:
-      //   1) Treat the outer batch dimensions as flattened, i.e. view the B
-      //      tensor here as [6, 4, K, N] and Y as [6, 4, M, N]. The same rea-
-      //      soning is analogous for the case where # dims A >= # dims B.
-      //   2) Perform this operation:
-      //        for i in range(6):
-      //          Y[i, :, :, :] = BatchMatMul(A, B[i, :, :, :])
-      size_t A_stride = 1; // How far to increment A pointer each itr
-      size_t B_stride = 1; // How far to increment B pointer each itr
-      size_t Y_stride = 1; // How far to increment Y pointer each itr
-      // How many "inner batches" we have. That is, the product of sizes for
-      // the slices excluding M, K, and N, for their respective matrices.
-      size_t num_sub_batches = 1;
-      if (ndims_A >= ndims_B) {
-        auto first_r_itr = dims_A.rbegin();
-        auto output_r_itr = new_dims.rbegin();
-        for (size_t i = 0; i < num_inner_dims; ++i) {
-          A_stride *= *(first_r_itr + i);
-          Y_stride *= *(output_r_itr + i);
-          if (i >= 2) {
-            num_sub_batches *= *(first_r_itr + i);
-          }
-        }
-        B_stride = 0;
-      } else {
-        A_stride = 0;
-        auto second_r_itr = dims_B.rbegin();
-        auto output_r_itr = new_dims.rbegin();
-        for (size_t i = 0; i < num_inner_dims; ++i) {
-          B_stride *= *(second_r_itr + i);
-          Y_stride *= *(output_r_itr + i);
-          if (i >= 2) {
-            num_sub_batches *= *(second_r_itr + i);
-          }
-        }
-      }
-
-      size_t num_outer_batches = 1;
-      for (size_t i = 0; i < num_outer_dims; ++i) {
-        num_outer_batches *= new_dims[i];
-      }
-
       // Mutually exclusive since otherwise we would've taken the vector-vector
       // path above
       if (A_broadcasted) {
@@ -253,34 +221,113 @@ class BatchMatMulOp final : public Operator<Context> {
         return true;
       }
 
-      // TODO(T23893772): doing this in a loop is likely going to be slow on GPU
+      A_offsets_.resize(num_outer_batches);
+      B_offsets_.resize(num_outer_batches);
       for (size_t p = 0; p < num_outer_batches; ++p) {
-        math::GemmBatched<T, Context, Engine>(
-            trans_a_ ? CblasTrans : CblasNoTrans,
-            trans_b_ ? CblasTrans : CblasNoTrans,
-            num_sub_batches,
-            M,
-            N,
-            K,
-            1.0f,
-            data_A + p * A_stride,
-            data_B + p * B_stride,
-            0.0f,
-            Y_data + p * Y_stride,
-            &context_,
-            use_scratch_ ? scratch_.get() : nullptr);
+        size_t A_offset = 0, B_offset = 0;
+        size_t q = p;
+        for (int i = num_outer_dims - 1; i >= 0; --i) {
+          A_offset += q % new_dims[i] * A_strides[i];
+          B_offset += q % new_dims[i] * B_strides[i];
+          q /= new_dims[i];
+        }
+        A_offsets_[p] = A_offset;
+        B_offsets_[p] = B_offset;
       }
+      BatchGemm(
+          M,
+          N,
+          K,
+          num_sub_batches,
+          data_A,
+          data_B,
+          Y_data,
+          &context_);
     }
     return true;
   }
 
  protected:
+  // Computes the num_sub_batches products of each outer batch p, whose
+  // matrices start at A + A_offsets_[p], B + B_offsets_[p], and at
+  // Y + p * num_sub_batches * M * N for the results.
+  template <typename T>
+  void BatchGemm(
+      size_t M,
+      size_t N,
+      size_t K,
+      size_t num_sub_batches,
+      const T* A,
+      const T* B,
+      T* Y,
+      CPUContext* /* context */) {
+    const size_t batch_size = A_offsets_.size() * num_sub_batches;
+    A_pointers_.resize(batch_size);
+    B_pointers_.resize(batch_size);
+    Y_pointers_.resize(batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+      const size_t p = i / num_sub_batches;
+      const size_t q = i % num_sub_batches;
+      A_pointers_[i] = A + A_offsets_[p] + q * M * K;
+      B_pointers_[i] = B + B_offsets_[p] + q * K * N;
+      Y_pointers_[i] = Y + i * M * N;
+    }
+    math::GemmBatchedCPU(
+        trans_a_ ? CblasTrans : CblasNoTrans,
+        trans_b_ ? CblasTrans : CblasNoTrans,
+        batch_size,
+        M,
+        N,
+        K,
+        1.0f,
+        A_pointers_.data(),
+        B_pointers_.data(),
+        0.0f,
+        Y_pointers_.data(),
+        ws_->GetThreadPool());
+  }
+
+  template <typename T, class OtherContext>
+  void BatchGemm(
+      size_t M,
+      size_t N,
+      size_t K,
+      size_t num_sub_batches,
+      const T* A,
+      const T* B,
+      T* Y,
+      OtherContext* context) {
+    // TODO(T23893772): doing this in a loop is likely going to be slow on GPU
+    for (size_t p = 0; p < A_offsets_.size(); ++p) {
+      math::GemmBatched<T, Context, Engine>(
+          trans_a_ ? CblasTrans : CblasNoTrans,
+          trans_b_ ? CblasTrans : CblasNoTrans,
+          num_sub_batches,
+          M,
+          N,
+          K,
+          1.0f,
+          A + A_offsets_[p],
+          B + B_offsets_[p],
+          0.0f,
+          Y + p * num_sub_batches * M * N,
+          context,
+          use_scratch_ ? scratch_.get() : nullptr);
+    }
+  }
+
   bool trans_a_;
   bool trans_b_;
   bool broadcast_;
 
   bool use_scratch_;
   std::shared_ptr<Tensor<Context>> scratch_;
+  Workspace* ws_;
+  std::vector<size_t> A_offsets_;
+  std::vector<size_t> B_offsets_;
+  std::vector<const float*> A_pointers_;
+  std::vector<const float*> B_pointers_;
+  std::vector<float*> Y_pointers_;
 };
 
 } // namespace caffe2
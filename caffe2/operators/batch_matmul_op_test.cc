@@ -74,5 +74,28 @@ TEST_F(BatchMatMulOpTest, BatchMatMulOpBroadcastTest) {
   VerifyOutput(std::vector<TIndex>{2, 3, 5, 6}, 10.0f);
 }
 
+TEST_F(BatchMatMulOpTest, BatchMatMulOpBroadcastOnesTest) {
+  auto* arg = def_.add_arg();
+  arg->set_name("broadcast");
+  arg->set_i(1);
+  AddConstInput(std::vector<TIndex>{2, 1, 4, 5, 10}, 1.0f, "A");
+  AddConstInput(std::vector<TIndex>{3, 1, 10, 6}, 1.0f, "B");
+  std::unique_ptr<OperatorBase> op(CreateOperator(def_, &ws_));
+  ASSERT_NE(nullptr, op);
+  ASSERT_TRUE(op->Run());
+  VerifyOutput(std::vector<TIndex>{2, 3, 4, 5, 6}, 10.0f);
+}
+
+TEST_F(BatchMatMulOpTest, BatchMatMulOpBroadcastMismatchTest) {
+  auto* arg = def_.add_arg();
+  arg->set_name("broadcast");
+  arg->set_i(1);
+  AddConstInput(std::vector<TIndex>{2, 5, 10}, 1.0f, "A");
+  AddConstInput(std::vector<TIndex>{3, 10, 6}, 1.0f, "B");
+  std::unique_ptr<OperatorBase> op(CreateOperator(def_, &ws_));
+  ASSERT_NE(nullptr, op);
+  EXPECT_THROW(op->Run(), EnforceNotMet);
+}
+
 } // namespace
 } // namespace caffe2
@@ -1,6 +1,7 @@
 #include "caffe2/operators/boolean_mask_ops.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/utils/math.h"
 
 namespace caffe2 {
 namespace {
@@ -80,9 +81,32 @@ bool BooleanMaskOp<CPUContext>::RunOnDevice() {
   }
   const auto innerSize = data.size_from_dim(1);
   const auto innerSizeBytes = innerSize * data.meta().itemsize();
+  const auto* inPtr = (char*)data.raw_data();
+
+  if (!data.meta().copy()) {
+    indices_.clear();
+    indices_.reserve(numOutputs);
+    for (int i = 0; i < outerSize; ++i) {
+      if (maskPtr[i]) {
+        indices_.push_back(i);
+      }
+    }
+    if (OutputSize() == 2) {
+      std::copy(indices_.begin(), indices_.end(), out_vec);
+    }
+    math::GatherRowsCPU(
+        1,
+        numOutputs,
+        innerSizeBytes,
+        indices_.data(),
+        inPtr,
+        0,
+        outPtr,
+        ws_->GetThreadPool());
+    return true;
+  }
 
   TIndex lastStart = -1;
-  const auto* inPtr = (char*)data.raw_data();
   TIndex outStart = 0;
 
   for (TIndex i = 0;; ++i) {
@@ -13,9 +13,14 @@ class BooleanMaskOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   BooleanMaskOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws) {}
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
 
   bool RunOnDevice() override;
+
+ private:
+  Workspace* ws_;
+  // Positions of the true values of the mask.
+  vector<int64_t> indices_;
 };
 
 template <class Context>
@@ -1,7 +1,10 @@
 #include "box_with_nms_limit_op.h"
 #include "caffe2/utils/eigen_utils.h"
+#include "caffe2/utils/math.h"
 #include "generate_proposals_op_util_nms.h"
 
+#include <limits>
+
 #ifdef CAFFE2_USE_MKL
 #include "caffe2/mkl/operators/operator_fallback_mkl.h"
 #endif // CAFFE2_USE_MKL
@@ -84,6 +87,75 @@ bool BoxWithNMSLimitOp<CPUContext>::RunOnDevice() {
     out_keeps_size->Resize(batch_size, num_classes);
   }
 
+  vector<int> offsets(batch_size + 1, 0);
+  for (int b = 0; b < batch_size; ++b) {
+    CAFFE_ENFORCE_GE(batch_splits(b), 0);
+    offsets[b + 1] = offsets[b] + batch_splits(b);
+  }
+
+  // To store updated scores if SoftNMS is used
+  vector<ERArrXXf> soft_nms_scores(batch_size);
+  if (soft_nms_enabled_) {
+    for (int b = 0; b < batch_size; ++b) {
+      soft_nms_scores[b].resize(offsets[b + 1] - offsets[b], num_classes);
+    }
+  }
+  vector<vector<vector<int>>> all_keeps(
+      batch_size, vector<vector<int>>(num_classes));
+
+  // Perform nms to each class of each image, in parallel, by (image, class)
+  // pair. The overlaps of the boxes of an image grow with their square, which
+  // is taken as the cost of a pair.
+  // skip j = 0, because it's the background class
+  const int num_fg_classes = std::max(num_classes - 1, 0);
+  const TIndex image_boxes = N / std::max(batch_size, 1) + 1;
+  math::ParallelFor(
+      batch_size * num_fg_classes,
+      std::min<TIndex>(
+          image_boxes * image_boxes, std::numeric_limits<int>::max()),
+      ws_->GetThreadPool(),
+      [&](int begin, int end) {
+        for (int task = begin; task < end; ++task) {
+          const int b = task / num_fg_classes;
+          const int j = task % num_fg_classes + 1;
+          const int num_boxes = offsets[b + 1] - offsets[b];
+          Eigen::Map<const ERArrXXf> scores(
+              tscores.data<float>() + offsets[b] * tscores.dim(1),
+              num_boxes,
+              tscores.dim(1));
+          Eigen::Map<const ERArrXXf> boxes(
+              tboxes.data<float>() + offsets[b] * tboxes.dim(1),
+              num_boxes,
+              tboxes.dim(1));
+
+          auto cur_scores = scores.col(j);
+          auto inds = utils::GetArrayIndices(cur_scores > score_thres_);
+          auto cur_boxes = boxes.block(0, j * 4, boxes.rows(), 4);
+
+          if (soft_nms_enabled_) {
+            auto cur_soft_nms_scores = soft_nms_scores[b].col(j);
+            all_keeps[b][j] = utils::soft_nms_cpu(
+                &cur_soft_nms_scores,
+                cur_boxes,
+                cur_scores,
+                inds,
+                soft_nms_sigma_,
+                nms_thres_,
+                soft_nms_min_score_thres_,
+                soft_nms_method_);
+          } else {
+            std::sort(
+                inds.data(),
+                inds.data() + inds.size(),
+                [&cur_scores](int lhs, int rhs) {
+                  return cur_scores(lhs) > cur_scores(rhs);
+                });
+            all_keeps[b][j] =
+                utils::nms_cpu(cur_boxes, cur_scores, inds, nms_thres_);
+          }
+        }
+      });
+
   vector<int> total_keep_per_batch(batch_size);
   int offset = 0;
   for (int b = 0; b < batch_splits.size(); ++b) {
@@ -97,47 +169,18 @@ bool BoxWithNMSLimitOp<CPUContext>::RunOnDevice() {
         num_boxes,
         tboxes.dim(1));
 
-    // To store updated scores if SoftNMS is used
-    ERArrXXf soft_nms_scores(num_boxes, tscores.dim(1));
-    vector<vector<int>> keeps(num_classes);
-
-    // Perform nms to each class
-    // skip j = 0, because it's the background class
+    auto& keeps = all_keeps[b];
     int total_keep_count = 0;
     for (int j = 1; j < num_classes; j++) {
-      auto cur_scores = scores.col(j);
-      auto inds = utils::GetArrayIndices(cur_scores > score_thres_);
-      auto cur_boxes = boxes.block(0, j * 4, boxes.rows(), 4);
-
-      if (soft_nms_enabled_) {
-        auto cur_soft_nms_scores = soft_nms_scores.col(j);
-        keeps[j] = utils::soft_nms_cpu(
-            &cur_soft_nms_scores,
-            cur_boxes,
-            cur_scores,
-            inds,
-            soft_nms_sigma_,
-            nms_thres_,
-            soft_nms_min_score_thres_,
-            soft_nms_method_);
-      } else {
-        std::sort(
-            inds.data(),
-            inds.data() + inds.size(),
-            [&cur_scores](int lhs, int rhs) {
-              return cur_scores(lhs) > cur_scores(rhs);
-            });
-        keeps[j] = utils::nms_cpu(cur_boxes, cur_scores, inds, nms_thres_);
-      }
       total_keep_count += keeps[j].size();
     }
 
     if (soft_nms_enabled_) {
       // Re-map scores to the updated SoftNMS scores
       new (&scores) Eigen::Map<const ERArrXXf>(
-          soft_nms_scores.data(),
-          soft_nms_scores.rows(),
-          soft_nms_scores.cols());
+          soft_nms_scores[b].data(),
+          soft_nms_scores[b].rows(),
+          soft_nms_scores[b].cols());
     }
 
     // Limit to max_per_image detections *over all classes*
@@ -0,0 +1,89 @@
+#include "caffe2/operators/box_with_nms_limit_op.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include "caffe2/core/flags.h"
+#include "caffe2/utils/proto_utils.h"
+
+CAFFE2_DECLARE_bool(caffe2_intra_op_parallelism);
+CAFFE2_DECLARE_int(caffe2_intra_op_min_work_size);
+
+namespace caffe2 {
+
+namespace {
+
+void AddInput(
+    const vector<TIndex>& shape,
+    const vector<float>& values,
+    const string& name,
+    Workspace* ws) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  std::copy(values.begin(), values.end(), tensor->mutable_data<float>());
+}
+
+} // namespace
+
+TEST(BoxWithNMSLimitTest, TestThreadPool) {
+  // The (image, class) pairs are processed on the threads of the workspace,
+  // and the results have to be those of the serial run.
+  const vector<float> batch_splits{40, 25, 35};
+  const int num_boxes = 100;
+  const int num_classes = 5;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  vector<float> scores(num_boxes * num_classes);
+  vector<float> boxes(num_boxes * num_classes * 4);
+  for (auto& v : scores) {
+    v = dist(gen);
+  }
+  for (int i = 0; i < num_boxes * num_classes; ++i) {
+    boxes[4 * i] = 100 * dist(gen);
+    boxes[4 * i + 1] = 100 * dist(gen);
+    boxes[4 * i + 2] = boxes[4 * i] + 50 * dist(gen);
+    boxes[4 * i + 3] = boxes[4 * i + 1] + 50 * dist(gen);
+  }
+
+  for (const bool soft_nms : {false, true}) {
+    vector<vector<float>> outputs[2];
+    // Inline, and split between the threads however small the work is.
+    FLAGS_caffe2_intra_op_min_work_size = 0;
+    for (const bool parallel : {false, true}) {
+      FLAGS_caffe2_intra_op_parallelism = parallel;
+      Workspace ws;
+      AddInput(vector<TIndex>{num_boxes, num_classes}, scores, "scores", &ws);
+      AddInput(
+          vector<TIndex>{num_boxes, num_classes * 4}, boxes, "boxes", &ws);
+      AddInput(
+          vector<TIndex>{TIndex(batch_splits.size())},
+          batch_splits,
+          "batch_splits",
+          &ws);
+      OperatorDef def = CreateOperatorDef(
+          "BoxWithNMSLimit",
+          "",
+          vector<string>{"scores", "boxes", "batch_splits"},
+          vector<string>{"out_scores",
+                         "out_boxes",
+                         "out_classes",
+                         "out_batch_splits"},
+          vector<Argument>{MakeArgument("score_thresh", 0.2f),
+                           MakeArgument("nms", 0.5f),
+                           MakeArgument("detections_per_im", 20),
+                           MakeArgument("soft_nms_enabled", soft_nms)});
+      EXPECT_TRUE(ws.RunOperatorOnce(def));
+      for (const string name :
+           {"out_scores", "out_boxes", "out_classes", "out_batch_splits"}) {
+        const auto& tensor = ws.GetBlob(name)->Get<TensorCPU>();
+        outputs[parallel].emplace_back(
+            tensor.data<float>(), tensor.data<float>() + tensor.size());
+      }
+    }
+    FLAGS_caffe2_intra_op_parallelism = false;
+    FLAGS_caffe2_intra_op_min_work_size = 65536;
+    EXPECT_GT(outputs[0][0].size(), batch_splits.size());
+    EXPECT_EQ(outputs[0], outputs[1]);
+  }
+}
+
+} // namespace caffe2
@@ -1,6 +1,90 @@
 #include "caffe2/operators/concat_split_op.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "caffe2/perfkernels/nontemporal_copy.h"
+
 namespace caffe2 {
+
+void ConcatSplitCopy(
+    bool split,
+    int rows,
+    const vector<size_t>& slice_bytes,
+    const vector<char*>& slices,
+    char* whole,
+    const TypeMeta& meta,
+    CPUContext* context,
+    Workspace* ws) {
+  if (meta.copy()) {
+    ConcatSplitCopy<CPUContext>(
+        split, rows, slice_bytes, slices, whole, meta, context, ws);
+    return;
+  }
+  // Offsets of the slices in a row of whole.
+  const int num_slices = slices.size();
+  vector<size_t> offsets(num_slices + 1, 0);
+  for (int i = 0; i < num_slices; ++i) {
+    offsets[i + 1] = offsets[i] + slice_bytes[i];
+  }
+  const size_t row_bytes = offsets[num_slices];
+  const size_t total_bytes = row_bytes * rows;
+  if (total_bytes == 0) {
+    return;
+  }
+  // A slice of a single row may share its buffer with whole.
+  vector<char> in_place(num_slices, false);
+  if (rows == 1) {
+    for (int i = 0; i < num_slices; ++i) {
+      in_place[i] = slices[i] == whole + offsets[i];
+    }
+  }
+  // Beyond this size whole does not fit in the cache anyway. Smaller pieces
+  // are still copied normally, as the aligned streaming stores only pay off
+  // over a few KB.
+  constexpr size_t kNonTemporalBytes = 16 << 20;
+  constexpr size_t kNonTemporalPieceBytes = 4 << 10;
+  const bool non_temporal = total_bytes >= kNonTemporalBytes;
+  // The bytes of whole are divided in chunks, so that the work is balanced
+  // whether there are many small slices or few large ones.
+  constexpr size_t kChunkBytes = 16 << 10;
+  const int num_chunks = (total_bytes + kChunkBytes - 1) / kChunkBytes;
+  math::ParallelFor(
+      num_chunks,
+      kChunkBytes,
+      ws->GetThreadPool(),
+      [&](int begin, int end) {
+        size_t pos = begin * kChunkBytes;
+        const size_t end_pos = std::min(total_bytes, end * kChunkBytes);
+        bool streamed = false;
+        while (pos < end_pos) {
+          const size_t row = pos / row_bytes;
+          const size_t col = pos % row_bytes;
+          // The slice holding col, skipping the empty ones.
+          const int i = std::upper_bound(
+                            offsets.begin() + 1, offsets.end(), col) -
+              offsets.begin() - 1;
+          const size_t n = std::min(end_pos - pos, offsets[i + 1] - col);
+          if (!in_place[i]) {
+            char* slice =
+                slices[i] + row * slice_bytes[i] + (col - offsets[i]);
+            char* dst = split ? slice : whole + pos;
+            const char* src = split ? whole + pos : slice;
+            if (non_temporal && n >= kNonTemporalPieceBytes) {
+              NonTemporalCopy(dst, src, n);
+              streamed = true;
+            } else {
+              std::memcpy(dst, src, n);
+            }
+          }
+          pos += n;
+        }
+        if (streamed) {
+          NonTemporalFence();
+        }
+      });
+}
+
 namespace {
 std::pair<std::vector<DeviceOption>, std::vector<DeviceOption>> splitOpDevInfer(
     const OperatorDef& def) {
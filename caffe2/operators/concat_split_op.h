@@ -23,6 +23,68 @@ inline int GetDimFromOrderString(const string& str) {
 }
 } // namespace
 
+// Copies between the rows x row_bytes matrix whole and the slices it is the
+// concatenation of: row r of whole is made of the rows r of slices[0],
+// slices[1]..., of slice_bytes[i] bytes each. The slices are copied into whole
+// when split is false, and whole into the slices when it is true.
+template <class Context>
+void ConcatSplitCopy(
+    bool split,
+    int rows,
+    const vector<size_t>& slice_bytes,
+    const vector<char*>& slices,
+    char* whole,
+    const TypeMeta& meta,
+    Context* context,
+    Workspace* /* ws */) {
+  const size_t itemsize = meta.itemsize();
+  const int row_items =
+      std::accumulate(slice_bytes.begin(), slice_bytes.end(), size_t(0)) /
+      itemsize;
+  size_t offset = 0;
+  for (size_t i = 0; i < slices.size(); ++i) {
+    const int cols = slice_bytes[i] / itemsize;
+    if (split) {
+      math::CopyMatrix<Context>(
+          itemsize,
+          rows,
+          cols,
+          whole + offset,
+          row_items,
+          slices[i],
+          cols,
+          context,
+          meta.copy());
+    } else {
+      math::CopyMatrix<Context>(
+          itemsize,
+          rows,
+          cols,
+          slices[i],
+          cols,
+          whole + offset,
+          row_items,
+          context,
+          meta.copy());
+    }
+    offset += slice_bytes[i];
+  }
+}
+
+// On the CPU, the types copied with memcpy are copied in chunks of the same
+// size on the threads of the workspace, and with non-temporal stores when
+// whole is very large. Slices that already are in place in whole, as when
+// they were produced into its buffer, are not copied.
+void ConcatSplitCopy(
+    bool split,
+    int rows,
+    const vector<size_t>& slice_bytes,
+    const vector<char*>& slices,
+    char* whole,
+    const TypeMeta& meta,
+    CPUContext* context,
+    Workspace* ws);
+
 template <class Context>
 class SplitOp final : public Operator<Context> {
  public:
@@ -31,7 +93,8 @@ class SplitOp final : public Operator<Context> {
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   SplitOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        split_(OperatorBase::GetRepeatedArgument<int>("split")) {
+        split_(OperatorBase::GetRepeatedArgument<int>("split")),
+        ws_(ws) {
     CAFFE_ENFORCE(
         !(OperatorBase::HasArgument("axis") &&
           OperatorBase::HasArgument("order")),
@@ -54,6 +117,9 @@ class SplitOp final : public Operator<Context> {
   int axis_;
   int add_axis_;
   vector<int> split_;
+  Workspace* ws_;
+  vector<size_t> slice_bytes_;
+  vector<char*> slices_;
   // Input: X, optionally split
   // The split tensor is stored in CPU.
 };
@@ -63,7 +129,7 @@ class ConcatOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   ConcatOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws) {
+      : Operator<Context>(operator_def, ws), ws_(ws) {
     CAFFE_ENFORCE(
         !(OperatorBase::HasArgument("axis") &&
           OperatorBase::HasArgument("order")),
@@ -84,6 +150,9 @@ class ConcatOp final : public Operator<Context> {
  protected:
   int axis_;
   int add_axis_;
+  Workspace* ws_;
+  vector<size_t> slice_bytes_;
+  vector<char*> slices_;
   // Input: a number of tensors. Output: Y, split
   // The split are stored in CPU.
 };
@@ -143,7 +212,8 @@ bool SplitOp<Context>::RunOnDevice() {
   if (add_axis_) {
     output_dims.erase(output_dims.begin() + canonical_axis);
   }
-  size_t input_offset = 0;
+  slice_bytes_.resize(OutputSize());
+  slices_.resize(OutputSize());
   for (int i = 0; i < OutputSize(); ++i) {
     auto* output = Output(i);
     auto axis_dim = add_axis_ ? 1 : axis_data[i];
@@ -151,18 +221,18 @@ bool SplitOp<Context>::RunOnDevice() {
       output_dims[canonical_axis] = axis_data[i];
     }
     output->Resize(output_dims);
-    math::CopyMatrix<Context>(
-        input.itemsize(),
-        before,
-        axis_dim * after,
-        static_cast<const char*>(input.raw_data()) + input_offset,
-        input.dim32(canonical_axis) * after,
-        output->raw_mutable_data(input.meta()),
-        axis_dim * after,
-        &context_,
-        input.meta().copy());
-    input_offset += axis_dim * after * input.itemsize();
+    slice_bytes_[i] = axis_dim * after * input.itemsize();
+    slices_[i] = static_cast<char*>(output->raw_mutable_data(input.meta()));
   }
+  ConcatSplitCopy(
+      true,
+      before,
+      slice_bytes_,
+      slices_,
+      static_cast<char*>(const_cast<void*>(input.raw_data())),
+      input.meta(),
+      &context_,
+      ws_);
   return true;
 }
 
@@ -234,23 +304,22 @@ bool ConcatOp<Context>::RunOnDevice() {
     output_dims[canonical_axis] = output_channels;
   }
   output->Resize(output_dims);
-  size_t output_offset = 0;
+  slice_bytes_.resize(InputSize());
+  slices_.resize(InputSize());
   for (int i = 0; i < InputSize(); ++i) {
     auto& input = Input(i);
-    auto axis_dim = add_axis_ ? 1 : input.dim32(canonical_axis);
-    math::CopyMatrix<Context>(
-        input.itemsize(),
-        before,
-        axis_dim * after,
-        input.raw_data(),
-        axis_dim * after,
-        static_cast<char*>(output->raw_mutable_data(input_zero.meta())) +
-            output_offset,
-        output_channels * after,
-        &context_,
-        input_zero.meta().copy());
-    output_offset += axis_dim * after * input.itemsize();
+    slice_bytes_[i] = axis_data[i] * after * input.itemsize();
+    slices_[i] = static_cast<char*>(const_cast<void*>(input.raw_data()));
   }
+  ConcatSplitCopy(
+      false,
+      before,
+      slice_bytes_,
+      slices_,
+      static_cast<char*>(output->raw_mutable_data(input_zero.meta())),
+      input_zero.meta(),
+      &context_,
+      ws_);
   return true;
 }
 
@@ -159,7 +159,8 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
     runWithSharedBuffer<Context>(ws_, f);
   } else {
-    f(&col_buffer_);
+    ScratchArena::Lease scratch(OperatorBase::scratch_arena());
+    f(scratch.Get(&col_buffer_));
   }
   return true;
 }
@@ -305,7 +306,8 @@ bool ConvOp<T, Context>::RunOnDeviceWithOrderNHWC() {
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
       runWithSharedBuffer<Context>(ws_, f);
     } else {
-      f(&col_buffer_);
+      ScratchArena::Lease scratch(OperatorBase::scratch_arena());
+      f(scratch.Get(&col_buffer_));
     }
   }
   return true;
@@ -355,7 +357,9 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   col_buffer_shape.push_back(C / group_ * kernel_dims_size);
   col_buffer_shape.insert(
       col_buffer_shape.end(), output_dims.begin(), output_dims.end());
-  col_buffer_.Resize(col_buffer_shape);
+  ScratchArena::Lease scratch(OperatorBase::scratch_arena());
+  auto* col_buffer = scratch.Get(&col_buffer_);
+  col_buffer->Resize(col_buffer_shape);
 
   if (kernel_.size() != 2) {
     SetDeviceTensor(img_shape, &img_shape_device_);
@@ -367,7 +371,7 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   const T* Xdata = X.template data<T>();
   const T* filter_data = filter.template data<T>();
   const T* dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
 
   // Pre-setting the gradients to zero.
@@ -545,12 +549,14 @@ bool ConvGradientOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   const int output_image_size = dY.dim32(1) * dY.dim32(2);
   // The col buffer is stored in CHW order as well - kernel_dim, and the height
   // and width.
-  col_buffer_.Resize(output_image_size, kernel_dim);
+  ScratchArena::Lease scratch(OperatorBase::scratch_arena());
+  auto* col_buffer = scratch.Get(&col_buffer_);
+  col_buffer->Resize(output_image_size, kernel_dim);
 
   const T* Xdata = X.template data<T>();
   const T* const filter_data = filter.template data<T>();
   const T* const dYdata = dY.template data<T>();
-  T* col_buffer_data = col_buffer_.template mutable_data<T>();
+  T* col_buffer_data = col_buffer->template mutable_data<T>();
   T* dfilter_data = dfilter->template mutable_data<T>();
 
   // Pre-setting the gradients to zero.
@@ -1,9 +1,205 @@
 #include <functional>
 
 #include "caffe2/operators/fully_connected_op.h"
+#include "caffe2/core/scratch_arena.h"
+#include "caffe2/perfkernels/float16_convert.h"
 
 namespace caffe2 {
 
+namespace {
+
+// Number of floats in a converted weight panel; small enough for the panel to
+// stay in L2 while the GEMM reads it once per row of X.
+constexpr int kFCWeightPanelSize = 16384;
+
+template <typename T>
+const float* FloatData(const TensorCPU& X, TensorCPU* buffer) {
+  buffer->ResizeLike(X);
+  ConvertToFloat(
+      X.size(), X.template data<T>(), buffer->template mutable_data<float>());
+  return buffer->template data<float>();
+}
+
+template <>
+const float* FloatData<float>(const TensorCPU& X, TensorCPU* /* unused */) {
+  return X.data<float>();
+}
+
+template <typename T>
+const float* WeightPanel(const T* W, int size, TensorCPU* panel) {
+  panel->Resize(size);
+  ConvertToFloat(size, W, panel->template mutable_data<float>());
+  return panel->template data<float>();
+}
+
+const float* WeightPanel(const float* W, int /* size */, TensorCPU* /* unused */) {
+  return W;
+}
+
+template <typename T>
+float* FloatOutput(TensorCPU* Y, TensorCPU* buffer) {
+  buffer->ResizeLike(*Y);
+  return buffer->template mutable_data<float>();
+}
+
+template <>
+float* FloatOutput<float>(TensorCPU* Y, TensorCPU* /* unused */) {
+  return Y->mutable_data<float>();
+}
+
+template <typename T>
+void StoreOutput(const TensorCPU& buffer, TensorCPU* Y) {
+  ConvertFromFloat(
+      Y->size(), buffer.data<float>(), Y->template mutable_data<T>());
+}
+
+template <>
+void StoreOutput<float>(const TensorCPU& /* unused */, TensorCPU* /* unused */) {}
+
+template <class FullyConnectedOp, typename T_X>
+bool RunFullyConnectedOpWithWeightType(FullyConnectedOp* op) {
+  const auto& W = op->Input(1);
+  if (W.template IsType<float>()) {
+    return op->template DoRunWithStorageType<T_X, float>();
+  } else if (W.template IsType<float16>()) {
+    return op->template DoRunWithStorageType<T_X, float16>();
+  } else if (W.template IsType<bfloat16>()) {
+    return op->template DoRunWithStorageType<T_X, bfloat16>();
+  }
+  CAFFE_THROW("Unsupported weight type for FC: ", W.meta().name());
+}
+
+template <class FullyConnectedOp>
+bool RunFullyConnectedOpOnCPUDevice(FullyConnectedOp* op) {
+  const auto& X = op->Input(0);
+  if (X.template IsType<float>() && op->Input(1).template IsType<float>() &&
+      op->Input(2).template IsType<float>()) {
+    return op->template DoRunWithType<
+        float, // X
+        float, // W
+        float, // B
+        float, // Y
+        float>(); // Math
+  } else if (X.template IsType<float>()) {
+    return RunFullyConnectedOpWithWeightType<FullyConnectedOp, float>(op);
+  } else if (X.template IsType<float16>()) {
+    return RunFullyConnectedOpWithWeightType<FullyConnectedOp, float16>(op);
+  } else if (X.template IsType<bfloat16>()) {
+    return RunFullyConnectedOpWithWeightType<FullyConnectedOp, bfloat16>(op);
+  }
+  CAFFE_THROW("Unsupported input type for FC: ", X.meta().name());
+}
+
+} // namespace
+
+template <class Context, class Engine, bool TransposeWeight>
+template <typename T_X, typename T_W>
+bool FullyConnectedOp<Context, Engine, TransposeWeight>::DoRunWithStorageType() {
+  const auto& X = Input(0);
+  const auto& W = Input(1);
+  const auto& b = Input(2);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE(b.ndim() == 1, b.ndim());
+  const auto canonical_axis = X.canonical_axis_index(axis_);
+  const int M = X.size_to_dim(canonical_axis);
+  const int K = X.size_from_dim(canonical_axis);
+  const auto canonical_axis_w = W.canonical_axis_index(axis_w_);
+  const int N = TransposeWeight ? W.size_to_dim(canonical_axis_w)
+                                : W.size_from_dim(canonical_axis_w);
+  CAFFE_ENFORCE_EQ(M * K, X.size(), "Dimension mismatch between X and W");
+  CAFFE_ENFORCE_EQ(K * N, W.size(), "Dimension mismatch between X and W");
+  CAFFE_ENFORCE_EQ(N, b.size(), "Dimension mismatch between W and b");
+
+  Y_shape_cache_ = X.dims();
+  Y_shape_cache_.resize(canonical_axis + 1);
+  Y_shape_cache_[canonical_axis] = N;
+  Y->Resize(Y_shape_cache_);
+  if (X.size() == 0) {
+    Y->template mutable_data<T_X>();
+    return true;
+  }
+
+  ScratchArena::Lease scratch(OperatorBase::scratch_arena());
+  auto* X_float = scratch.Get(&X_float_);
+  auto* W_panel = scratch.Get(&W_panel_);
+  auto* Y_float = scratch.Get(&Y_float_);
+  const float* Xdata = FloatData<T_X>(X, X_float);
+  const T_W* Wdata = W.template data<T_W>();
+  float* Ydata = FloatOutput<T_X>(Y, Y_float);
+
+  // Unconverted float weights are used as a single panel.
+  const bool whole = std::is_same<T_W, float>::value;
+  if (TransposeWeight) {
+    // W is N x K: each panel is a block of output channels.
+    const int rows = whole ? N : std::max(1, kFCWeightPanelSize / K);
+    for (int n = 0; n < N; n += rows) {
+      const int panel_rows = std::min(rows, N - n);
+      math::GemmEx<float, Context>(
+          CblasNoTrans,
+          CblasTrans,
+          M,
+          panel_rows,
+          K,
+          1,
+          Xdata,
+          K,
+          WeightPanel(Wdata + n * K, panel_rows * K, W_panel),
+          K,
+          0,
+          Ydata + n,
+          N,
+          &context_);
+    }
+  } else {
+    // W is K x N: each panel is a block of the reduction dimension.
+    const int rows = whole ? K : std::max(1, kFCWeightPanelSize / N);
+    for (int k = 0; k < K; k += rows) {
+      const int panel_rows = std::min(rows, K - k);
+      math::GemmEx<float, Context>(
+          CblasNoTrans,
+          CblasNoTrans,
+          M,
+          N,
+          panel_rows,
+          1,
+          Xdata + k,
+          K,
+          WeightPanel(Wdata + k * N, panel_rows * N, W_panel),
+          N,
+          k == 0 ? 0 : 1,
+          Ydata,
+          N,
+          &context_);
+    }
+  }
+
+  const float* bdata = nullptr;
+  if (b.template IsType<float>()) {
+    bdata = b.template data<float>();
+  } else if (b.template IsType<T_W>()) {
+    bdata = FloatData<T_W>(b, W_panel);
+  } else {
+    CAFFE_THROW("The bias of FC must be float or have the type of W");
+  }
+  EigenMatrixMap<float>(Ydata, N, M).colwise() +=
+      ConstEigenVectorMap<float>(bdata, N);
+  StoreOutput<T_X>(*Y_float, Y);
+  return true;
+}
+
+template <>
+bool FullyConnectedOp<CPUContext>::RunOnDevice() {
+  return RunFullyConnectedOpOnCPUDevice(this);
+}
+
+template <>
+bool FullyConnectedOp<
+    CPUContext,
+    DefaultEngine,
+    false /* don't transpose weight */>::RunOnDevice() {
+  return RunFullyConnectedOpOnCPUDevice(this);
+}
+
 REGISTER_CPU_OPERATOR(FC, FullyConnectedOp<CPUContext>);
 REGISTER_CPU_OPERATOR(FCGradient, FullyConnectedGradientOp<CPUContext>);
 
@@ -183,6 +379,9 @@ Lastly, even though b is a 1D vector of size N, it is copied/resized to
 be size (M x N) implicitly and added to each vector in the batch.
 Each of these dimensions must be matched correctly, or else the operator
 will throw errors.
+
+On CPU, X, W and b may also be stored as float16 or bfloat16; computation
+always happens in float, and Y is stored in the type of X.
 )DOC")
     .Arg(
         "axis",
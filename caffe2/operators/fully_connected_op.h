@@ -138,6 +138,12 @@ class FullyConnectedOp final : public Operator<Context> {
         float>(); // Math
   }
 
+  // CPU only: runs with X and/or W stored as float16 or bfloat16, computing
+  // in float. W is converted one cache-sized panel at a time, so it is only
+  // read from memory in 16 bits. Y has the storage type of X.
+  template <typename T_X, typename T_W>
+  bool DoRunWithStorageType();
+
  protected:
   size_t axis_{1};
   size_t axis_w_{1};
@@ -145,6 +151,10 @@ class FullyConnectedOp final : public Operator<Context> {
   // a vector object every time we run Run().
   vector<TIndex> Y_shape_cache_;
   Tensor<Context> bias_multiplier_;
+  // Float copies of 16 bit inputs and outputs.
+  Tensor<Context> X_float_;
+  Tensor<Context> W_panel_;
+  Tensor<Context> Y_float_;
 
   bool float16_compute_;
 };
@@ -20,7 +20,8 @@ class GatherRangesToDenseOp final : public Operator<Context> {
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   GatherRangesToDenseOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        lengths_(OperatorBase::GetRepeatedArgument<int>("lengths")) {
+        lengths_(OperatorBase::GetRepeatedArgument<int>("lengths")),
+        ws_(ws) {
     CAFFE_ENFORCE_GT(lengths_.size(), 0, "There has to be at least one length");
     for (auto length : lengths_) {
       CAFFE_ENFORCE_GT(length, 0, "Each length should be positive");
@@ -72,6 +73,9 @@ class GatherRangesToDenseOp final : public Operator<Context> {
       outputRawData.push_back(ptr);
     }
 
+    srcs_.clear();
+    dsts_.clear();
+    range_bytes_.clear();
     for (int i = 0; i < batchSize; ++i) {
       for (int j = 0; j < OutputSize(); ++j) {
         auto rangeStart = rangesData[rangesDataOffset++];
@@ -85,13 +89,20 @@ class GatherRangesToDenseOp final : public Operator<Context> {
             lengths_[j],
             "Range lengths missmatch for output #",
             j);
+        CAFFE_ENFORCE(
+            0 <= rangeStart && rangeStart + rangeLength <= data.size(),
+            "Range [",
+            rangeStart,
+            ", ",
+            rangeStart + rangeLength,
+            ") is out of the data bounds ",
+            data.size());
 
         if (InputSize() == 2) {
-          context_.template CopyItems<Context, Context>(
-              data.meta(),
-              rangeLength,
-              rawData + rangeStart * itemsize,
-              outputRawData[j] + i * itemsize * lengths_[j]);
+          // Copied once all the ranges are checked.
+          srcs_.push_back(rawData + rangeStart * itemsize);
+          dsts_.push_back(outputRawData[j] + i * itemsize * lengths_[j]);
+          range_bytes_.push_back(rangeLength * itemsize);
         } else {
           auto& key = Input(KEY);
           auto* key_data = key.template data<int64_t>();
@@ -120,6 +131,19 @@ class GatherRangesToDenseOp final : public Operator<Context> {
     }
     CAFFE_ENFORCE_EQ(rangesDataOffset, ranges.size());
 
+    if (!data.meta().copy()) {
+      math::CopyRangesCPU(
+          srcs_.size(),
+          srcs_.data(),
+          dsts_.data(),
+          range_bytes_.data(),
+          ws_->GetThreadPool());
+    } else {
+      for (size_t i = 0; i < srcs_.size(); ++i) {
+        context_.template CopyItems<Context, Context>(
+            data.meta(), range_bytes_[i] / itemsize, srcs_[i], dsts_[i]);
+      }
+    }
     return true;
   }
 
@@ -127,6 +151,11 @@ class GatherRangesToDenseOp final : public Operator<Context> {
 
  private:
   vector<int> lengths_;
+  Workspace* ws_;
+  // Ranges of bytes copied to the outputs when there are no keys
+  vector<const char*> srcs_;
+  vector<char*> dsts_;
+  vector<size_t> range_bytes_;
 };
 
 } // namespace caffe2
@@ -2,6 +2,8 @@
 #include "caffe2/operators/generate_proposals_op_util_boxes.h"
 #include "generate_proposals_op_util_nms.h"
 
+#include <limits>
+
 #ifdef CAFFE2_USE_MKL
 #include "caffe2/mkl/operators/operator_fallback_mkl.h"
 #endif // CAFFE2_USE_MKL
@@ -224,22 +226,30 @@ bool GenerateProposalsOp<CPUContext>::RunOnDevice() {
   out_rois->Resize(0, roi_col_count);
   out_rois_probs->Resize(0);
 
-  // Use openmp for acceleration?
-  for (int i = 0; i < num_images; i++) {
-    auto cur_im_info = im_info.row(i);
-    auto cur_bbox_deltas = GetSubTensorView<float>(bbox_deltas, i);
-    auto cur_scores = GetSubTensorView<float>(scores, i);
-
-    ERArrXXf im_i_boxes;
-    EArrXf im_i_probs;
-    ProposalsForOneImage(
-        cur_im_info,
-        all_anchors,
-        cur_bbox_deltas,
-        cur_scores,
-        &im_i_boxes,
-        &im_i_probs);
+  // The images are processed in parallel, and written in order.
+  vector<ERArrXXf> im_boxes(num_images);
+  vector<EArrXf> im_probs(num_images);
+  // Each image reads a score and four deltas per anchor and pixel.
+  const int cost = std::min<TIndex>(5 * A * K, std::numeric_limits<int>::max());
+  math::ParallelFor(
+      num_images, cost, ws_->GetThreadPool(), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+          auto cur_im_info = im_info.row(i);
+          auto cur_bbox_deltas = GetSubTensorView<float>(bbox_deltas, i);
+          auto cur_scores = GetSubTensorView<float>(scores, i);
+          ProposalsForOneImage(
+              cur_im_info,
+              all_anchors,
+              cur_bbox_deltas,
+              cur_scores,
+              &im_boxes[i],
+              &im_probs[i]);
+        }
+      });
 
+  for (int i = 0; i < num_images; i++) {
+    const auto& im_i_boxes = im_boxes[i];
+    const auto& im_i_probs = im_probs[i];
     int csz = im_i_boxes.rows();
     int cur_start_idx = out_rois->dim(0);
 
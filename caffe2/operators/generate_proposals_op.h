@@ -78,7 +78,8 @@ class GenerateProposalsOp final : public Operator<Context> {
         rpn_min_size_(OperatorBase::GetSingleArgument<float>("min_size", 16)),
         correct_transform_coords_(OperatorBase::GetSingleArgument<bool>(
             "correct_transform_coords",
-            false)) {}
+            false)),
+        ws_(ws) {}
 
   ~GenerateProposalsOp() {}
 
@@ -116,6 +117,7 @@ class GenerateProposalsOp final : public Operator<Context> {
   // Set to true to match the detectron code, set to false for backward
   // compatibility
   bool correct_transform_coords_{false};
+  Workspace* ws_;
 };
 
 } // namespace caffe2
@@ -1,7 +1,12 @@
 #include "caffe2/operators/generate_proposals_op.h"
 
 #include <gtest/gtest.h>
+#include <random>
 #include "caffe2/core/flags.h"
+#include "caffe2/utils/proto_utils.h"
+
+CAFFE2_DECLARE_bool(caffe2_intra_op_parallelism);
+CAFFE2_DECLARE_int(caffe2_intra_op_min_work_size);
 
 namespace caffe2 {
 
@@ -250,4 +255,59 @@ TEST(GenerateProposalsTest, TestRealDownSampled) {
       1e-4);
 }
 
+TEST(GenerateProposalsTest, TestThreadPool) {
+  // The images are processed on the threads of the workspace, and the
+  // results have to be those of the serial run.
+  const int img_count = 6;
+  const int A = 3;
+  const int H = 12;
+  const int W = 10;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  vector<float> scores(img_count * A * H * W);
+  vector<float> bbx(img_count * 4 * A * H * W);
+  for (auto& v : scores) {
+    v = dist(gen);
+  }
+  for (auto& v : bbx) {
+    v = dist(gen) - 0.5f;
+  }
+  vector<float> im_info;
+  for (int i = 0; i < img_count; ++i) {
+    im_info.insert(im_info.end(), {160, 200, 1.0f});
+  }
+  vector<float> anchors{-8, -8, 23, 23, -24, -8, 39, 23, -8, -24, 23, 39};
+
+  vector<vector<float>> outputs[2];
+  // Inline, and split between the threads however small the work is.
+  FLAGS_caffe2_intra_op_min_work_size = 0;
+  for (const bool parallel : {false, true}) {
+    FLAGS_caffe2_intra_op_parallelism = parallel;
+    Workspace ws;
+    AddInput(vector<TIndex>{img_count, A, H, W}, scores, "scores", &ws);
+    AddInput(vector<TIndex>{img_count, 4 * A, H, W}, bbx, "bbox_deltas", &ws);
+    AddInput(vector<TIndex>{img_count, 3}, im_info, "im_info", &ws);
+    AddInput(vector<TIndex>{A, 4}, anchors, "anchors", &ws);
+    OperatorDef def = CreateOperatorDef(
+        "GenerateProposals",
+        "",
+        vector<string>{"scores", "bbox_deltas", "im_info", "anchors"},
+        vector<string>{"rois", "rois_probs"},
+        vector<Argument>{MakeArgument("spatial_scale", 1.0f / 16.0f),
+                         MakeArgument("post_nms_topN", 50),
+                         MakeArgument("nms_thresh", 0.7f),
+                         MakeArgument("min_size", 4.0f)});
+    EXPECT_TRUE(ws.RunOperatorOnce(def));
+    for (const string name : {"rois", "rois_probs"}) {
+      const auto& tensor = ws.GetBlob(name)->Get<TensorCPU>();
+      outputs[parallel].emplace_back(
+          tensor.data<float>(), tensor.data<float>() + tensor.size());
+    }
+  }
+  FLAGS_caffe2_intra_op_parallelism = false;
+  FLAGS_caffe2_intra_op_min_work_size = 65536;
+  EXPECT_GT(outputs[0][1].size(), img_count);
+  EXPECT_EQ(outputs[0], outputs[1]);
+}
+
 } // namespace caffe2
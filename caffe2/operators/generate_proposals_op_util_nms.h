@@ -12,6 +12,27 @@
 namespace caffe2 {
 namespace utils {
 
+// Overlaps (IoU) of the boxes 1 to count of the arrays with the box 0, in
+// ovr[0] to ovr[count - 1].
+template <typename T>
+void ComputeOverlaps(
+    const EArrXt<T>& x1,
+    const EArrXt<T>& y1,
+    const EArrXt<T>& x2,
+    const EArrXt<T>& y2,
+    const EArrXt<T>& areas,
+    int count,
+    EArrXt<T>* ovr) {
+  auto inter = ovr->head(count);
+  inter = (x2.segment(1, count).cwiseMin(x2[0]) -
+           x1.segment(1, count).cwiseMax(x1[0]) + 1.0)
+              .cwiseMax(0.0) *
+      (y2.segment(1, count).cwiseMin(y2[0]) -
+       y1.segment(1, count).cwiseMax(y1[0]) + 1.0)
+          .cwiseMax(0.0);
+  inter = inter / (areas[0] + areas.segment(1, count) - inter);
+}
+
 // Greedy non-maximum suppression for proposed bounding boxes
 // Reject a bounding box if its region has an intersection-overunion (IoU)
 //    overlap with a higher scoring selected bounding box larger than a
@@ -36,39 +57,45 @@ std::vector<int> nms_cpu(
 
   using EArrX = EArrXt<typename Derived1::Scalar>;
 
-  auto x1 = proposals.col(0);
-  auto y1 = proposals.col(1);
-  auto x2 = proposals.col(2);
-  auto y2 = proposals.col(3);
-
+  // The candidates are copied in score order and compacted after each kept
+  // box, so the overlaps are computed on contiguous arrays.
+  const int num_boxes = sorted_indices.size();
+  EArrXi order = AsEArrXt(sorted_indices);
+  EArrX x1(num_boxes), y1(num_boxes), x2(num_boxes), y2(num_boxes);
+  for (int k = 0; k < num_boxes; ++k) {
+    const int i = order[k];
+    x1[k] = proposals(i, 0);
+    y1[k] = proposals(i, 1);
+    x2[k] = proposals(i, 2);
+    y2[k] = proposals(i, 3);
+  }
   EArrX areas = (x2 - x1 + 1.0) * (y2 - y1 + 1.0);
 
-  EArrXi order = AsEArrXt(sorted_indices);
+  EArrX ovr(num_boxes);
   std::vector<int> keep;
-  int ci = 0;
-  while (order.size() > 0) {
+  int count = num_boxes;
+  while (count > 0) {
     // exit if already enough proposals
     if (topN >= 0 && keep.size() >= topN) {
       break;
     }
 
-    int i = order[0];
-    keep.push_back(i);
-    ConstEigenVectorArrayMap<int> rest_indices(
-        order.data() + 1, order.size() - 1);
-    EArrX xx1 = GetSubArray(x1, rest_indices).cwiseMax(x1[i]);
-    EArrX yy1 = GetSubArray(y1, rest_indices).cwiseMax(y1[i]);
-    EArrX xx2 = GetSubArray(x2, rest_indices).cwiseMin(x2[i]);
-    EArrX yy2 = GetSubArray(y2, rest_indices).cwiseMin(y2[i]);
-
-    EArrX w = (xx2 - xx1 + 1.0).cwiseMax(0.0);
-    EArrX h = (yy2 - yy1 + 1.0).cwiseMax(0.0);
-    EArrX inter = w * h;
-    EArrX ovr = inter / (areas[i] + GetSubArray(areas, rest_indices) - inter);
-
-    // indices for sub array order[1:n]
-    auto inds = GetArrayIndices(ovr <= thresh);
-    order = GetSubArray(order, AsEArrXt(inds) + 1);
+    keep.push_back(order[0]);
+    const int rest = count - 1;
+    ComputeOverlaps(x1, y1, x2, y2, areas, rest, &ovr);
+
+    count = 0;
+    for (int j = 0; j < rest; ++j) {
+      if (ovr[j] <= thresh) {
+        order[count] = order[j + 1];
+        x1[count] = x1[j + 1];
+        y1[count] = y1[j + 1];
+        x2[count] = x2[j + 1];
+        y2[count] = y2[j + 1];
+        areas[count] = areas[j + 1];
+        ++count;
+      }
+    }
   }
 
   return keep;
@@ -129,21 +156,32 @@ std::vector<int> soft_nms_cpu(
   CAFFE_ENFORCE_EQ(scores.cols(), 1);
 
   using EArrX = EArrXt<typename Derived1::Scalar>;
-
-  const auto& x1 = proposals.col(0);
-  const auto& y1 = proposals.col(1);
-  const auto& x2 = proposals.col(2);
-  const auto& y2 = proposals.col(3);
-
-  EArrX areas = (x2 - x1 + 1.0) * (y2 - y1 + 1.0);
+  using Scalar = typename Derived2::Scalar;
 
   // Initialize out_scores with original scores. Will be iteratively updated
   // as Soft-NMS is applied.
   *out_scores = scores;
 
-  std::vector<int> keep;
+  // The pending proposals and their updated scores are kept in contiguous
+  // arrays, compacted after each kept box.
+  const int num_boxes = indices.size();
   EArrXi pending = AsEArrXt(indices);
-  while (pending.size() > 0) {
+  EArrX x1(num_boxes), y1(num_boxes), x2(num_boxes), y2(num_boxes);
+  EArrXt<Scalar> pending_scores(num_boxes);
+  for (int k = 0; k < num_boxes; ++k) {
+    const int i = pending[k];
+    x1[k] = proposals(i, 0);
+    y1[k] = proposals(i, 1);
+    x2[k] = proposals(i, 2);
+    y2[k] = proposals(i, 3);
+    pending_scores[k] = scores(i);
+  }
+  EArrX areas = (x2 - x1 + 1.0) * (y2 - y1 + 1.0);
+
+  EArrX ovr(num_boxes);
+  std::vector<int> keep;
+  int count = num_boxes;
+  while (count > 0) {
     // Exit if already enough proposals
     if (topN >= 0 && keep.size() >= topN) {
       break;
@@ -151,44 +189,48 @@ std::vector<int> soft_nms_cpu(
 
     // Find proposal with max score among remaining proposals
     int max_pos;
-    auto max_score = GetSubArray(*out_scores, pending).maxCoeff(&max_pos);
-    int i = pending[max_pos];
-    keep.push_back(i);
+    pending_scores.head(count).maxCoeff(&max_pos);
+    keep.push_back(pending[max_pos]);
 
     // Compute IoU of the remaining boxes with the identified max box
-    std::swap(pending(0), pending(max_pos));
-    const auto& rest_indices = pending.tail(pending.size() - 1);
-    EArrX xx1 = GetSubArray(x1, rest_indices).cwiseMax(x1[i]);
-    EArrX yy1 = GetSubArray(y1, rest_indices).cwiseMax(y1[i]);
-    EArrX xx2 = GetSubArray(x2, rest_indices).cwiseMin(x2[i]);
-    EArrX yy2 = GetSubArray(y2, rest_indices).cwiseMin(y2[i]);
-
-    EArrX w = (xx2 - xx1 + 1.0).cwiseMax(0.0);
-    EArrX h = (yy2 - yy1 + 1.0).cwiseMax(0.0);
-    EArrX inter = w * h;
-    EArrX ovr = inter / (areas[i] + GetSubArray(areas, rest_indices) - inter);
-
-    // Update scores based on computed IoU, overlap threshold and NMS method
-    for (int j = 0; j < rest_indices.size(); ++j) {
-      typename Derived2::Scalar weight;
+    std::swap(pending[0], pending[max_pos]);
+    std::swap(x1[0], x1[max_pos]);
+    std::swap(y1[0], y1[max_pos]);
+    std::swap(x2[0], x2[max_pos]);
+    std::swap(y2[0], y2[max_pos]);
+    std::swap(areas[0], areas[max_pos]);
+    std::swap(pending_scores[0], pending_scores[max_pos]);
+    const int rest = count - 1;
+    ComputeOverlaps(x1, y1, x2, y2, areas, rest, &ovr);
+
+    // Update scores based on computed IoU, overlap threshold and NMS method,
+    // and discard boxes with new scores below min threshold
+    count = 0;
+    for (int j = 0; j < rest; ++j) {
+      Scalar weight;
       switch (method) {
         case 1: // Linear
-          weight = (ovr(j) > overlap_thresh) ? (1.0 - ovr(j)) : 1.0;
+          weight = (ovr[j] > overlap_thresh) ? (1.0 - ovr[j]) : 1.0;
           break;
         case 2: // Gaussian
-          weight = std::exp(-1.0 * ovr(j) * ovr(j) / sigma);
+          weight = std::exp(-1.0 * ovr[j] * ovr[j] / sigma);
           break;
         default: // Original NMS
-          weight = (ovr(j) > overlap_thresh) ? 0.0 : 1.0;
+          weight = (ovr[j] > overlap_thresh) ? 0.0 : 1.0;
+      }
+      const Scalar score = pending_scores[j + 1] * weight;
+      (*out_scores)(pending[j + 1]) = score;
+      if (score >= score_thresh) {
+        pending[count] = pending[j + 1];
+        x1[count] = x1[j + 1];
+        y1[count] = y1[j + 1];
+        x2[count] = x2[j + 1];
+        y2[count] = y2[j + 1];
+        areas[count] = areas[j + 1];
+        pending_scores[count] = score;
+        ++count;
       }
-      (*out_scores)(rest_indices[j]) *= weight;
     }
-
-    // Discard boxes with new scores below min threshold and update pending
-    // indices
-    const auto& rest_scores = GetSubArray(*out_scores, rest_indices);
-    const auto& inds = GetArrayIndices(rest_scores >= score_thresh);
-    pending = GetSubArray(rest_indices, AsEArrXt(inds));
   }
 
   return keep;
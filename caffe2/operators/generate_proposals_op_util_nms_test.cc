@@ -44,6 +44,57 @@ TEST(UtilsNMSTest, TestNMS) {
   }
 }
 
+TEST(UtilsNMSTest, TestNMSManyBoxes) {
+  // Overlapping boxes, compared with a direct implementation of greedy NMS
+  const int num_boxes = 500;
+  Eigen::ArrayXXf proposals(num_boxes, 4);
+  Eigen::ArrayXf scores(num_boxes);
+  for (int i = 0; i < num_boxes; ++i) {
+    const float x = (i * 37) % 200;
+    const float y = (i * 53) % 150;
+    proposals.row(i) << x, y, x + 10 + i % 40, y + 10 + (i * 7) % 30;
+    scores[i] = ((i * 101) % num_boxes) / float(num_boxes);
+  }
+  std::vector<int> indices(num_boxes);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::sort(indices.begin(), indices.end(), [&scores](int lhs, int rhs) {
+    return scores(lhs) > scores(rhs);
+  });
+
+  for (float thresh : {0.1f, 0.3f, 0.7f}) {
+    std::vector<int> expected;
+    std::vector<bool> suppressed(num_boxes, false);
+    for (int i : indices) {
+      if (suppressed[i]) {
+        continue;
+      }
+      expected.push_back(i);
+      for (int j : indices) {
+        const float w = std::max(
+            std::min(proposals(i, 2), proposals(j, 2)) -
+                std::max(proposals(i, 0), proposals(j, 0)) + 1,
+            0.0f);
+        const float h = std::max(
+            std::min(proposals(i, 3), proposals(j, 3)) -
+                std::max(proposals(i, 1), proposals(j, 1)) + 1,
+            0.0f);
+        const float area_i = (proposals(i, 2) - proposals(i, 0) + 1) *
+            (proposals(i, 3) - proposals(i, 1) + 1);
+        const float area_j = (proposals(j, 2) - proposals(j, 0) + 1) *
+            (proposals(j, 3) - proposals(j, 1) + 1);
+        if (w * h / (area_i + area_j - w * h) > thresh) {
+          suppressed[j] = true;
+        }
+      }
+    }
+    EXPECT_LT(expected.size(), num_boxes);
+    EXPECT_EQ(expected, utils::nms_cpu(proposals, scores, indices, thresh));
+
+    expected.resize(10);
+    EXPECT_EQ(expected, utils::nms_cpu(proposals, scores, indices, thresh, 10));
+  }
+}
+
 TEST(UtilsNMSTest, TestSoftNMS) {
   Eigen::ArrayXXf input(5, 5);
   input.row(0) << 5.18349426e+02, 1.77783920e+02, 9.06085266e+02,
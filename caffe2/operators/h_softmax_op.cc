@@ -1,5 +1,6 @@
 #include "caffe2/operators/h_softmax_op.h"
 
+#include <limits>
 #include <queue>
 #include <stack>
 
@@ -65,6 +66,64 @@ float HSoftmaxOp<float, CPUContext>::RunForwardSingle(const float* X,
   return -log(std::max(softmax_output_data[target], kLOG_THRESHOLD()));
 }
 
+template <>
+void HSoftmaxOp<float, CPUContext>::RunForwardBatch(
+    const NodeBatch& batch,
+    const float* X,
+    const float* W,
+    const float* b,
+    int K,
+    float* int_output,
+    float* losses,
+    std::vector<float>* inputs,
+    std::vector<float>* fc_outputs,
+    CPUContext* context) {
+  const int m = batch.entries.size();
+  const int dim_out = batch.w_length;
+  const float* batch_X = getBatchInputs(batch, X, K, inputs);
+  fc_outputs->resize(m * dim_out);
+  float* fc_output_data = fc_outputs->data();
+
+  // W * x for all the examples
+  math::Gemm<float, CPUContext>(
+      CblasNoTrans,
+      CblasTrans,
+      m,
+      dim_out,
+      K,
+      1,
+      batch_X,
+      W + batch.w_offset * K,
+      0,
+      fc_output_data,
+      context);
+
+  const float* bias = b + batch.w_offset;
+  for (int i = 0; i < m; ++i) {
+    const auto& entry = batch.entries[i];
+    const float* fc_row = fc_output_data + i * dim_out;
+    float* fc_out = int_output + entry.int_output_offset;
+    float* softmax_out = fc_out + dim_out;
+    float max_value = fc_row[0] + bias[0];
+    for (int j = 0; j < dim_out; ++j) {
+      fc_out[j] = fc_row[j] + bias[j];
+      max_value = std::max(max_value, fc_out[j]);
+    }
+    // Softmax
+    float sum = 0;
+    for (int j = 0; j < dim_out; ++j) {
+      softmax_out[j] = std::exp(fc_out[j] - max_value);
+      sum += softmax_out[j];
+    }
+    for (int j = 0; j < dim_out; ++j) {
+      softmax_out[j] /= sum;
+    }
+    // Cross entropy loss
+    losses[entry.index] =
+        -log(std::max(softmax_out[entry.target], kLOG_THRESHOLD()));
+  }
+}
+
 // Implementation for the CPU context.
 template <>
 bool HSoftmaxOp<float, CPUContext>::RunOnDevice() {
@@ -85,106 +144,125 @@ bool HSoftmaxOp<float, CPUContext>::RunOnDevice() {
   // Sum of output dimensions of all hierarchy nodes
   int N = W.dim32(0);
   CAFFE_ENFORCE_EQ(N, b.dim32(0));
+  CAFFE_ENFORCE_EQ(label.size(), M);
   Y->Resize(M);
   auto* Ydata = Y->mutable_data<float>();
-  math::Set<float, CPUContext>(M, 0.f, Ydata, &context_);
   const auto* labeldata = label.data<int>();
 
-  auto hierarchy = getHierarchyForLabels(M, labeldata, hierarchy_all_map_);
-  int int_output_size = getIntermediateOutputSize(labeldata, M, hierarchy);
-  intermediate_output->Resize(int_output_size);
-  float * int_output_data = intermediate_output->mutable_data<float>();
-  int int_output_offset = 0;
-
-  if (bias_multiplier_.size() != M) {
-    bias_multiplier_.Resize(M);
-    math::Set<float, CPUContext>(M, static_cast<float>(1),
-        bias_multiplier_.mutable_data<float>(), &context_);
+  std::vector<NodeBatch> batches;
+  std::vector<int> path_begins;
+  int int_output_size = getNodeBatches(M, labeldata, &batches, &path_begins);
+  TIndex flops = 0;
+  for (const auto& batch : batches) {
+    CAFFE_ENFORCE(
+        0 <= batch.w_offset && batch.w_offset + batch.w_length <= N,
+        "Node ",
+        batch.w_offset,
+        " is out of the ",
+        N,
+        " rows of W");
+    flops += TIndex(batch.entries.size()) * batch.w_length * K;
   }
+  intermediate_output->Resize(int_output_size);
+  float* int_output_data = intermediate_output->mutable_data<float>();
+
+  // The examples that go through a node are evaluated together, and the
+  // nodes in parallel.
+  std::vector<float> losses(path_begins[M]);
+  const TIndex cost = batches.empty()
+      ? 1
+      : std::min<TIndex>(
+          flops / batches.size() + 1, std::numeric_limits<int>::max());
+  math::ParallelFor(
+      batches.size(), cost, ws_->GetThreadPool(), [&](int begin, int end) {
+        CPUContext context;
+        std::vector<float> inputs;
+        std::vector<float> fc_outputs;
+        for (int i = begin; i < end; ++i) {
+          RunForwardBatch(
+              batches[i],
+              X.data<float>(),
+              W.data<float>(),
+              b.data<float>(),
+              K,
+              int_output_data,
+              losses.data(),
+              &inputs,
+              &fc_outputs,
+              &context);
+        }
+      });
 
   for (int sample = 0; sample < M; ++sample) {
-    int word_id = labeldata[sample];
-    const PathProto& path = hierarchy[word_id];
-    for (const PathNodeProto& node : path.path_nodes()) {
-      //Offset of node's weight matrix in W
-      int w_offset = node.index();
-      //Number of output dimensions in node's weight matrix
-      int w_length = node.length();
-      int target = node.target();
-      //Adding log probabilities
-      Ydata[sample] += RunForwardSingle(X.data<float>() + sample*K,
-        W.data<float>() + w_offset*K, b.data<float>() + w_offset, target,
-        int_output_data, bias_multiplier_.data<float>()+sample, w_length, K,
-        int_output_offset);
+    //Adding log probabilities
+    Ydata[sample] = 0;
+    for (int i = path_begins[sample]; i < path_begins[sample + 1]; ++i) {
+      Ydata[sample] += losses[i];
     }
   }
   return true;
 }
 
 template <>
-void HSoftmaxGradientOp<float, CPUContext>::RunBackwardSingle(const float* X,
-  const float* dY, const float* W, int target,
-  const float* int_output, float* dX, float* dW, float* db, float* dint_output,
-  int dim_in, int dim_out, int& int_output_offset) {
-
-  //Cross entropy
-  // dX_entropy is the dX for the cross entropy layer
-  float* dX_entropy = dint_output + int_output_offset - dim_out;
-  // X_entropy is the X for the cross entropy layer and Y for the softmax layer
-  const float* X_entropy = int_output + int_output_offset - dim_out;
-
-  math::Set<float, CPUContext>(dim_out, 0.f, dX_entropy, &context_);
-  dX_entropy[target] = - (*dY) / std::max(X_entropy[target], kLOG_THRESHOLD());
-
-  int_output_offset -= dim_out;
-
-  //Softmax
-  if (scale_.size() != 1) {
-    scale_.Resize(1);
-  }
-  float* scaledata = scale_.mutable_data<float>();
+void HSoftmaxGradientOp<float, CPUContext>::RunBackwardBatch(
+    const NodeBatch& batch,
+    const float* X,
+    const float* dY,
+    const float* int_output,
+    float* dW,
+    float* db,
+    float* dint_output,
+    int K,
+    std::vector<float>* inputs,
+    std::vector<float>* fc_gradients,
+    CPUContext* context) {
+  const int m = batch.entries.size();
+  const int dim_out = batch.w_length;
+  const float* batch_X = getBatchInputs(batch, X, K, inputs);
+  fc_gradients->resize(m * dim_out);
+  float* dX_fc = fc_gradients->data();
+
+  for (int i = 0; i < m; ++i) {
+    const auto& entry = batch.entries[i];
+    // X_entropy is the X for the cross entropy layer and Y for the softmax
+    // layer
+    const float* X_entropy =
+        int_output + entry.int_output_offset + dim_out;
+    float* dX_softmax = dint_output + entry.int_output_offset;
+    float* dX_entropy = dX_softmax + dim_out;
+
+    //Cross entropy
+    std::fill(dX_entropy, dX_entropy + dim_out, 0.f);
+    dX_entropy[entry.target] = -dY[entry.sample] /
+        std::max(X_entropy[entry.target], kLOG_THRESHOLD());
+
+    //Softmax
+    const float scale = X_entropy[entry.target] * dX_entropy[entry.target];
+    for (int j = 0; j < dim_out; ++j) {
+      dX_softmax[j] = (dX_entropy[j] - scale) * X_entropy[j];
+    }
+    std::copy(dX_softmax, dX_softmax + dim_out, dX_fc + i * dim_out);
 
-  if (sum_multiplier_.size() != dim_out) {
-    sum_multiplier_.Resize(dim_out);
-    math::Set<float, CPUContext>(dim_out, 1.f,
-      sum_multiplier_.mutable_data<float>(), &context_);
+    // db = db + dX_softmax
+    for (int j = 0; j < dim_out; ++j) {
+      db[batch.w_offset + j] += dX_softmax[j];
+    }
   }
 
-  float* dX_softmax = dint_output + int_output_offset - dim_out;
-  context_.Copy<float, CPUContext, CPUContext>(dim_out, dX_entropy, dX_softmax);
-
-  math::Dot<float, CPUContext>(dim_out, X_entropy, dX_entropy, scaledata,
-    &context_);
-  math::Gemv<float, CPUContext>(CblasTrans, 1, dim_out, -1,
-    sum_multiplier_.data<float>(), scaledata , 1, dX_softmax, &context_);
-  math::Mul<float, CPUContext>(dim_out, dX_softmax, X_entropy, dX_softmax,
-    &context_);
-
-  int_output_offset -= dim_out;
-
   //FC
-  if (bias_multiplier_.size() != 1) {
-    // If the helper bias multiplier has not been created, reshape and fill
-    // it with 1
-    bias_multiplier_.Resize(1);
-    math::Set<float, CPUContext>(1, static_cast<float>(1),
-        bias_multiplier_.template mutable_data<float>(), &context_);
-  }
-
-  // Compute dW and add incrementally
-  // dW = dW + dX_softmax'*X
-  math::Gemm<float, CPUContext>(CblasTrans, CblasNoTrans, dim_out, dim_in, 1, 1,
-    dX_softmax, X, 1, dW, &context_);
-
-  // Compute dB and add incrementally
-  // db = db + dX_softmax*bias_multiplier_
-  math::Gemv<float, CPUContext>(CblasTrans, 1, dim_out, 1, dX_softmax,
-    bias_multiplier_.template data<float>(), 1, db, &context_);
-
-  // Compute dX and add incrementally
-  // dX = dX + W'dX_softmax
-  math::Gemv<float, CPUContext>(CblasTrans, dim_out, dim_in,
-    1, W, dX_softmax, 1, dX, &context_);
+  // dW = dW + dX_fc'*X
+  math::Gemm<float, CPUContext>(
+      CblasTrans,
+      CblasNoTrans,
+      dim_out,
+      K,
+      m,
+      1,
+      dX_fc,
+      batch_X,
+      1,
+      dW + batch.w_offset * K,
+      context);
 }
 
 // Implementation for the CPU context.
@@ -210,37 +288,106 @@ bool HSoftmaxGradientOp<float, CPUContext>::RunOnDevice() {
   float* db_data = db->mutable_data<float>();
   float* dOutput_data = dX_intermediate_output->mutable_data<float>();
 
-  math::Set<float, CPUContext>(X.size(), 0.f, dX_data, &context_);
   math::Set<float, CPUContext>(W.size(), 0.f, dW_data, &context_);
   math::Set<float, CPUContext>(b.size(), 0.f, db_data, &context_);
-  math::Set<float, CPUContext>(intermediate_output.size(), 0.f, dOutput_data,
-                               &context_);
 
   // Batch size
   int M = X.ndim() > 1 ? X.dim32(0) : 1;
   // Input feature dimension
   int K = X.size() / M;
+  int N = W.dim32(0);
+  CAFFE_ENFORCE_EQ(label.size(), M);
+  CAFFE_ENFORCE_EQ(dY.size(), M);
   const auto* labeldata = label.data<int>();
 
-  auto hierarchy = getHierarchyForLabels(M, labeldata, hierarchy_all_map_);
-  int output_offset = getIntermediateOutputSize(labeldata, M, hierarchy);
-
-  //Traverse backward to access intermediate_output generated by HSoftmaxOp
-  // sequentially in reverse order
-  for (int sample = M-1; sample >= 0; sample--) {
-    int word_id = labeldata[sample];
-    PathProto path = hierarchy[word_id];
-    for (auto node = path.path_nodes().rbegin();
-      node != path.path_nodes().rend(); node++) {
-      int w_offset = node->index();
-      int w_length = node->length();
-      int target = node->target();
-      RunBackwardSingle(X.data<float>() + sample*K, dY.data<float>() + sample,
-        W.data<float>() + w_offset*K, target, intermediate_output.data<float>(),
-        dX_data + sample*K, dW_data + w_offset*K, db_data + w_offset,
-        dOutput_data, K, w_length, output_offset);
+  std::vector<NodeBatch> batches;
+  std::vector<int> path_begins;
+  int int_output_size = getNodeBatches(M, labeldata, &batches, &path_begins);
+  CAFFE_ENFORCE_EQ(
+      intermediate_output.size(),
+      int_output_size,
+      "The intermediate output does not match the labels");
+  // The nodes write to their rows of dW and db in parallel, which must not
+  // overlap.
+  std::vector<std::pair<int, int>> rows;
+  TIndex flops = 0;
+  for (const auto& batch : batches) {
+    rows.emplace_back(batch.w_offset, batch.w_offset + batch.w_length);
+    flops += TIndex(batch.entries.size()) * batch.w_length * K;
+  }
+  std::sort(rows.begin(), rows.end());
+  for (int i = 0; i < rows.size(); ++i) {
+    CAFFE_ENFORCE(
+        0 <= rows[i].first && rows[i].second <= N &&
+            (i == 0 || rows[i - 1].second <= rows[i].first),
+        "Node ",
+        rows[i].first,
+        " is out of the ",
+        N,
+        " rows of W or overlaps another node");
+  }
+
+  const TIndex cost = batches.empty()
+      ? 1
+      : std::min<TIndex>(
+          flops / batches.size() + 1, std::numeric_limits<int>::max());
+  math::ParallelFor(
+      batches.size(), cost, ws_->GetThreadPool(), [&](int begin, int end) {
+        CPUContext context;
+        std::vector<float> inputs;
+        std::vector<float> fc_gradients;
+        for (int i = begin; i < end; ++i) {
+          RunBackwardBatch(
+              batches[i],
+              X.data<float>(),
+              dY.data<float>(),
+              intermediate_output.data<float>(),
+              dW_data,
+              db_data,
+              dOutput_data,
+              K,
+              &inputs,
+              &fc_gradients,
+              &context);
+        }
+      });
+
+  // The node and the softmax gradients of each entry of the paths.
+  std::vector<std::pair<const NodeBatch*, const float*>> path_entries(
+      path_begins[M]);
+  for (const auto& batch : batches) {
+    for (const auto& entry : batch.entries) {
+      path_entries[entry.index] = {&batch,
+                                   dOutput_data + entry.int_output_offset};
     }
   }
+  // dX = dX + W'dX_softmax, over the path of each example
+  math::ParallelFor(
+      M,
+      std::min<TIndex>(
+          flops / std::max(M, 1) + 1, std::numeric_limits<int>::max()),
+      ws_->GetThreadPool(),
+      [&](int begin, int end) {
+        CPUContext context;
+        for (int sample = begin; sample < end; ++sample) {
+          float* dX_row = dX_data + sample * K;
+          std::fill(dX_row, dX_row + K, 0.f);
+          for (int i = path_begins[sample + 1] - 1; i >= path_begins[sample];
+               --i) {
+            const auto* node = path_entries[i].first;
+            math::Gemv<float, CPUContext>(
+                CblasTrans,
+                node->w_length,
+                K,
+                1,
+                W.data<float>() + node->w_offset * K,
+                path_entries[i].second,
+                1,
+                dX_row,
+                &context);
+          }
+        }
+      });
   return true;
 }
 
@@ -561,6 +708,9 @@ The operator returns a 1-D tensor holding the computed log probability of the
 target class and a 2-D tensor of intermediate outputs (from the weight matrix
 and softmax from each step in the path from root to target class) which will be
 used by the gradient operator to compute gradients for all samples in the batch.
+
+The samples of the batch that go through the same node of the hierarchy are
+evaluated together with one matrix multiplication, and the nodes in parallel.
 )DOC")
   .Arg("hierarchy", "Serialized HierarchyProto string containing list of "
   "vocabulary words and their paths from root of hierarchy to the leaf")
@@ -14,7 +14,7 @@ class HSoftmaxOpBase : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   HSoftmaxOpBase(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws) {
+      : Operator<Context>(operator_def, ws), ws_(ws) {
     HierarchyProto hierarchy;
     CAFFE_ENFORCE(hierarchy.ParseFromString(
         OperatorBase::GetSingleArgument<string>("hierarchy", "")));
@@ -24,45 +24,103 @@ class HSoftmaxOpBase : public Operator<Context> {
   }
 
  protected:
+  // A node in the path of an example. index numbers the nodes of all the
+  // paths, one example after the other, and the FC and softmax outputs of the
+  // node are stored at int_output_offset in the intermediate output.
+  struct PathEntry {
+    int sample;
+    int target;
+    int index;
+    int int_output_offset;
+  };
+  // The examples of the batch that go through a node, in order.
+  struct NodeBatch {
+    int w_offset;
+    int w_length;
+    std::vector<PathEntry> entries;
+  };
+
   std::unordered_map<int, PathProto> hierarchy_all_map_;
   Tensor<Context> scale_;
   Tensor<Context> sum_multiplier_;
   Tensor<Context> bias_multiplier_;
+  Workspace* ws_;
   static constexpr T kLOG_THRESHOLD() {
     return 1e-20f;
   }
-  static std::unordered_map<int, PathProto> getHierarchyForLabels(
+  // Groups the nodes in the paths of the labels by node, so that each node
+  // is evaluated for all its examples at once. The nodes of the path of
+  // example i are path_begins[i], ..., path_begins[i + 1] - 1. Returns the
+  // size of the intermediate output.
+  int getNodeBatches(
       int M,
       const int* labels,
-      const std::unordered_map<int, PathProto>& hierarchy_all_map) {
-    std::unordered_map<int, PathProto> hierarchy_map;
-    std::set<int> label_set = std::set<int>(labels, labels + M);
-    for (const auto& label : label_set) {
-      auto search = hierarchy_all_map.find(label);
-      CAFFE_ENFORCE(search != hierarchy_all_map.end(), "incorrect label.");
-      hierarchy_map.emplace(search->first, search->second);
-    }
-    return hierarchy_map;
-  }
-  int getIntermediateOutputSize(
-      const int* labels,
-      int M,
-      std::unordered_map<int, PathProto>& hierarchy) const {
+      std::vector<NodeBatch>* batches,
+      std::vector<int>* path_begins) const {
+    batches->clear();
+    path_begins->resize(M + 1);
+    std::unordered_map<int, int> batch_of_node;
+    int num_entries = 0;
     int size = 0;
-    for (int label = 0; label < M; ++label) {
-      int word_id = labels[label];
-      const auto& path = hierarchy[word_id];
-      size += std::accumulate(
-          path.path_nodes().begin(),
-          path.path_nodes().end(),
-          0,
-          // Output of FC + Output of Softmax
-          [](int sz, PathNodeProto node) {
-            return sz + 2 * node.length();
-          });
+    for (int sample = 0; sample < M; ++sample) {
+      (*path_begins)[sample] = num_entries;
+      auto search = hierarchy_all_map_.find(labels[sample]);
+      CAFFE_ENFORCE(search != hierarchy_all_map_.end(), "incorrect label.");
+      for (const auto& node : search->second.path_nodes()) {
+        CAFFE_ENFORCE(
+            0 <= node.target() && node.target() < node.length(),
+            "Target ",
+            node.target(),
+            " is out of the ",
+            node.length(),
+            " outputs of node ",
+            node.index());
+        auto it = batch_of_node.emplace(node.index(), batches->size());
+        if (it.second) {
+          batches->push_back(NodeBatch{node.index(), node.length(), {}});
+        }
+        auto& batch = (*batches)[it.first->second];
+        CAFFE_ENFORCE_EQ(
+            batch.w_length,
+            node.length(),
+            "Node ",
+            node.index(),
+            " has different lengths in the hierarchy");
+        batch.entries.push_back(
+            PathEntry{sample, node.target(), num_entries++, size});
+        // Output of FC + Output of Softmax
+        size += 2 * node.length();
+      }
     }
+    (*path_begins)[M] = num_entries;
     return size;
   }
+  // Returns the rows of X of the examples of batch, gathered into inputs
+  // unless they are already consecutive.
+  static const float* getBatchInputs(
+      const NodeBatch& batch,
+      const float* X,
+      int K,
+      std::vector<float>* inputs) {
+    const auto& entries = batch.entries;
+    const int m = entries.size();
+    const int first = entries[0].sample;
+    bool consecutive = true;
+    for (int i = 0; i < m && consecutive; ++i) {
+      consecutive = entries[i].sample == first + i;
+    }
+    if (consecutive) {
+      return X + first * K;
+    }
+    inputs->resize(m * K);
+    for (int i = 0; i < m; ++i) {
+      std::copy(
+          X + entries[i].sample * K,
+          X + (entries[i].sample + 1) * K,
+          inputs->data() + i * K);
+    }
+    return inputs->data();
+  }
 };
 
 template <typename T, class Context>
@@ -74,6 +132,8 @@ class HSoftmaxOp : public HSoftmaxOpBase<T, Context> {
   bool RunOnDevice() override;
 
  protected:
+  using typename HSoftmaxOpBase<T, Context>::NodeBatch;
+
   float RunForwardSingle(
       const float* X,
       const float* W,
@@ -84,6 +144,19 @@ class HSoftmaxOp : public HSoftmaxOpBase<T, Context> {
       int w_length,
       int K,
       int& output_offset);
+  // Computes the outputs of one node for all its examples with one GEMM, and
+  // the loss of each example at this node.
+  void RunForwardBatch(
+      const NodeBatch& batch,
+      const float* X,
+      const float* W,
+      const float* b,
+      int K,
+      float* int_output,
+      float* losses,
+      std::vector<float>* inputs,
+      std::vector<float>* fc_outputs,
+      Context* context);
 };
 
 template <typename T, class Context>
@@ -94,19 +167,22 @@ class HSoftmaxGradientOp final : public HSoftmaxOpBase<T, Context> {
   bool RunOnDevice() override;
 
  private:
-  void RunBackwardSingle(
+  using typename HSoftmaxOpBase<T, Context>::NodeBatch;
+
+  // Accumulates the gradients of the parameters of one node and writes the
+  // gradients of its softmax outputs to dOutput.
+  void RunBackwardBatch(
+      const NodeBatch& batch,
       const float* X,
       const float* dY,
-      const float* W,
-      int target,
       const float* int_output,
-      float* dX,
       float* dW,
       float* db,
       float* dOutput,
-      int dim_in,
-      int w_length,
-      int& output_offset);
+      int K,
+      std::vector<float>* inputs,
+      std::vector<float>* fc_gradients,
+      Context* context);
 };
 
 template <typename T, class Context>
@@ -1,6 +1,46 @@
 #include "caffe2/operators/half_float_ops.h"
+#include "caffe2/perfkernels/float16_convert.h"
 
 namespace caffe2 {
+
+template <>
+bool FloatToHalfOp<CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  ConvertFromFloat(X.size(), X.data<float>(), Y->mutable_data<float16>());
+  return true;
+}
+
+template <>
+bool HalfToFloatOp<CPUContext>::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  ConvertToFloat(X.size(), X.data<float16>(), Y->mutable_data<float>());
+  return true;
+}
+
+bool FloatToBFloat16Op::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  ConvertFromFloat(X.size(), X.data<float>(), Y->mutable_data<bfloat16>());
+  return true;
+}
+
+bool BFloat16ToFloatOp::RunOnDevice() {
+  auto& X = Input(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X);
+  ConvertToFloat(X.size(), X.data<bfloat16>(), Y->mutable_data<float>());
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(FloatToHalf, FloatToHalfOp<CPUContext>);
+REGISTER_CPU_OPERATOR(HalfToFloat, HalfToFloatOp<CPUContext>);
+REGISTER_CPU_OPERATOR(FloatToBFloat16, FloatToBFloat16Op);
+REGISTER_CPU_OPERATOR(BFloat16ToFloat, BFloat16ToFloatOp);
 OPERATOR_SCHEMA(FloatToHalf)
     .NumInputs(1)
     .NumOutputs(1)
@@ -26,6 +66,37 @@ OPERATOR_SCHEMA(HalfToFloat)
 
           return out;
         });
+OPERATOR_SCHEMA(FloatToBFloat16)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(
+        [](const OperatorDef& def, const vector<TensorShape>& in) {
+          vector<TensorShape> out;
+          const TensorShape& X = in[0];
+          out.push_back(X);
+          out[0].set_data_type(TensorProto_DataType_BFLOAT16);
+
+          return out;
+        })
+    .SetDoc(R"DOC(
+Converts a float tensor to bfloat16, rounding to nearest even. bfloat16 keeps
+the exponent range of float with an 8 bit mantissa, and is used to halve the
+memory footprint of CPU weights and activations; operators that accept it
+compute in float.
+)DOC");
+
+OPERATOR_SCHEMA(BFloat16ToFloat)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(
+        [](const OperatorDef& def, const vector<TensorShape>& in) {
+          vector<TensorShape> out;
+          const TensorShape& X = in[0];
+          out.push_back(X);
+          out[0].set_data_type(TensorProto_DataType_FLOAT);
+
+          return out;
+        });
 OPERATOR_SCHEMA(Float16ConstantFill)
     .NumInputs(0)
     .NumOutputs(1)
@@ -54,5 +125,23 @@ class GetHalfToFloatGradient : public GradientMakerBase {
   }
 };
 REGISTER_GRADIENT(HalfToFloat, GetHalfToFloatGradient);
+
+class GetFloatToBFloat16Gradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "BFloat16ToFloat", "", vector<string>{GO(0)}, vector<string>{GI(0)});
+  }
+};
+REGISTER_GRADIENT(FloatToBFloat16, GetFloatToBFloat16Gradient);
+
+class GetBFloat16ToFloatGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "FloatToBFloat16", "", vector<string>{GO(0)}, vector<string>{GI(0)});
+  }
+};
+REGISTER_GRADIENT(BFloat16ToFloat, GetBFloat16ToFloatGradient);
 NO_GRADIENT(Float16ConstantFill);
 } // namespace caffe2
@@ -24,6 +24,25 @@ class HalfToFloatOp : public Operator<Context> {
   bool RunOnDevice() override;
 };
 
+// bfloat16 is a CPU storage type only, so its conversions have no Context.
+class FloatToBFloat16Op : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  FloatToBFloat16Op(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override;
+};
+
+class BFloat16ToFloatOp : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  BFloat16ToFloatOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override;
+};
+
 class Float16ConstantFillOp : public Operator<CPUContext> {
  public:
   Float16ConstantFillOp(const OperatorDef& operator_def, Workspace* ws)
@@ -14,6 +14,14 @@ value. Accepts 'then_net' (required) and 'else_net' (optional) arguments for 'th
     )DOC")
     .Arg("then_net", "Net executed when condition is true")
     .Arg("else_net", "Net executed when condition is false (optional)")
+    .Arg(
+        "lazy_subnets",
+        "If true, subnets are created on their first execution instead of "
+        "in the constructor (default false)")
+    .Arg(
+        "evict_subnets_after",
+        "If positive, a subnet is destroyed after this many consecutive runs "
+        "in which it was not taken, and recreated when needed (default 0)")
     .Input(0, "condition", "Scalar boolean condition")
     .AllowInplace([](int in, int out) -> bool { return true; });
 
@@ -4,6 +4,7 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/lazy_net.h"
 
 namespace caffe2 {
 
@@ -15,16 +16,18 @@ class IfOp final : public Operator<Context> {
     CAFFE_ENFORCE(
         this->template HasSingleArgumentOfType<NetDef>("then_net"),
         "then_net must be specified in If operator");
+    const bool lazy =
+        this->template GetSingleArgument<bool>("lazy_subnets", false);
+    const int evict_after =
+        this->template GetSingleArgument<int>("evict_subnets_after", 0);
     auto then_net_def =
         this->template GetSingleArgument<NetDef>("then_net", NetDef());
-    then_net_ = CreateNet(then_net_def, ws);
-    CAFFE_ENFORCE(then_net_, "Failed to initialize then subnet");
+    then_net_.reset(new LazyNet(then_net_def, ws, lazy, evict_after));
 
     if (this->template HasSingleArgumentOfType<NetDef>("else_net")) {
       auto else_net_def =
           this->template GetSingleArgument<NetDef>("else_net", NetDef());
-      else_net_ = CreateNet(else_net_def, ws);
-      CAFFE_ENFORCE(else_net_, "Failed to initialize else subnet");
+      else_net_.reset(new LazyNet(else_net_def, ws, lazy, evict_after));
     }
   }
 
@@ -43,8 +46,13 @@ class IfOp final : public Operator<Context> {
 
     auto conditionValue = *condition.template data<bool>();
     if (conditionValue) {
+      if (else_net_) {
+        else_net_->Skip();
+      }
       return then_net_->Run();
-    } else if (else_net_) {
+    }
+    then_net_->Skip();
+    if (else_net_) {
       return else_net_->Run();
     }
 
@@ -52,8 +60,8 @@ class IfOp final : public Operator<Context> {
   }
 
  private:
-  std::unique_ptr<NetBase> then_net_;
-  std::unique_ptr<NetBase> else_net_;
+  std::unique_ptr<LazyNet> then_net_;
+  std::unique_ptr<LazyNet> else_net_;
 };
 
 } // namespace caffe2
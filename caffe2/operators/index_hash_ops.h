@@ -7,6 +7,21 @@
 
 namespace caffe2 {
 
+// Hash of the index id used by IndexHashOp, in [0, modulo) for modulo > 0.
+template <typename T>
+CAFFE2_NO_SANITIZE("signed-integer-overflow")
+T IndexHash(T id, int64_t seed, int64_t modulo) {
+  int8_t* bytes = (int8_t*)&id;
+  T hashed = seed * 0xDEADBEEF;
+  for (int i = 0; i < sizeof(T) / sizeof(int8_t); i++) {
+    hashed = hashed * 65537 + bytes[i];
+  }
+  // We want the result of the modulo to be positive. This works under the
+  // assumption that modulo > 0.
+  auto modHashed = hashed % modulo;
+  return modHashed >= 0 ? modHashed : modHashed + modulo;
+}
+
 template <class Context>
 class IndexHashOp : public Operator<Context> {
  public:
@@ -47,16 +62,8 @@ class IndexHashOp : public Operator<Context> {
 
  protected:
   template <typename T>
-  CAFFE2_NO_SANITIZE("signed-integer-overflow") T hash(T id) {
-    int8_t* bytes = (int8_t*)&id;
-    T hashed = seed_ * 0xDEADBEEF;
-    for (int i = 0; i < sizeof(T) / sizeof(int8_t); i++) {
-      hashed = hashed * 65537 + bytes[i];
-    }
-    // We want the result of the modulo to be positive. This works under the
-    // assumption that modulo_ > 0 which is enforced in the constructor.
-    auto modHashed = hashed % modulo_;
-    return modHashed >= 0 ? modHashed : modHashed + modulo_;
+  T hash(T id) {
+    return IndexHash(id, seed_, modulo_);
   }
 
  private:
@@ -1,17 +1,19 @@
 #include "caffe2/operators/instance_norm_op.h"
 
+#include "caffe2/perfkernels/moments.h"
+
 namespace caffe2 {
 
 // Here lives two separate implementations of the forward and backward passes of
 // instance normalization, one for NHWC order and the other for NCHW order.
-// Two implementations allow us to make use of Eigen vectorized operations
-// without an expensive tensor transpose operation.
+// Two implementations allow us to make use of vectorized operations without an
+// expensive tensor transpose operation. The statistics are computed in a
+// single pass, after which each image is normalized while it is in cache.
 
-template <typename T, typename Context>
-bool InstanceNormOp<T, Context>::RunOnDeviceWithOrderNHWC() {
+template <>
+bool InstanceNormOp<float, CPUContext>::RunOnDeviceWithOrderNHWC() {
   const auto& X = Input(INPUT);
   auto* Y = Output(OUTPUT);
-  CAFFE_ENFORCE(Y != &X, "Can't run InstanceNorm NHWC in-place");
   auto* mean = OutputSize() > 1 ? Output(MEAN) : &mean_;
   auto* inv_stdev = OutputSize() > 1 ? Output(INV_STDEV) : &inv_stdev_;
   const int N = X.dim32(0);
@@ -26,39 +28,36 @@ bool InstanceNormOp<T, Context>::RunOnDeviceWithOrderNHWC() {
   Y->ResizeLike(X);
   mean->Resize(N, C);
   inv_stdev->Resize(N, C);
-  ConstEigenVectorArrayMap<T> scale(Input(SCALE).template data<T>(), C);
-  ConstEigenVectorArrayMap<T> bias(Input(BIAS).template data<T>(), C);
-  for (int n = 0; n < N; ++n) {
-    ConstEigenArrayMap<T> Xmat(X.template data<T>() + offset * n, C, H * W);
-    EigenArrayMap<T> Ymat(Y->template mutable_data<T>() + offset * n, C, H * W);
-    EigenVectorArrayMap<T> mean_arr(
-        mean->template mutable_data<T>() + n * C, C);
-    EigenVectorArrayMap<T> inv_stdev_arr(
-        inv_stdev->template mutable_data<T>() + n * C, C);
-
-    // The following effectively does the row wise mean computation:
-    //   mean_arr = Xmat.rowwise().mean();
-    // but manually vectorizes over columns.
-    mean_arr = Xmat.col(0);
-    for (int i = 1; i < H * W; ++i) {
-      mean_arr += Xmat.col(i);
-    }
-    mean_arr *= 1. / (H * W);
-    Ymat = Xmat.colwise() - mean_arr;
-    // The following effectively does row wise squared norm computation,
-    // but manually vectorizes over columns similar to the mean case.
-    inv_stdev_arr = Ymat.col(0) * Ymat.col(0);
-    for (int i = 1; i < H * W; ++i) {
-      inv_stdev_arr += Ymat.col(i) * Ymat.col(i);
+  ConstEigenVectorArrayMap<float> scale(Input(SCALE).data<float>(), C);
+  ConstEigenVectorArrayMap<float> bias(Input(BIAS).data<float>(), C);
+  const float* Xdata = X.data<float>();
+  float* Ydata = Y->mutable_data<float>();
+  float* mean_data = mean->mutable_data<float>();
+  float* inv_stdev_data = inv_stdev->mutable_data<float>();
+  math::ParallelFor(N, offset, ws_->GetThreadPool(), [&](int begin, int end) {
+    Eigen::Array<float, Eigen::Dynamic, 1> channel_scale(C);
+    Eigen::Array<float, Eigen::Dynamic, 1> channel_shift(C);
+    for (int n = begin; n < end; ++n) {
+      EigenVectorArrayMap<float> mean_arr(mean_data + n * C, C);
+      EigenVectorArrayMap<float> inv_stdev_arr(inv_stdev_data + n * C, C);
+      // inv_stdev_arr holds the variance until it is inverted.
+      ColwiseMoments(
+          H * W, C, Xdata + offset * n, mean_arr.data(), inv_stdev_arr.data());
+      inv_stdev_arr = (inv_stdev_arr + epsilon_).sqrt().inverse();
+      channel_scale = inv_stdev_arr * scale;
+      channel_shift = bias - mean_arr * channel_scale;
+      EigenArrayMap<float>(Ydata + offset * n, C, H * W) =
+          (ConstEigenArrayMap<float>(Xdata + offset * n, C, H * W).colwise() *
+           channel_scale)
+              .colwise() +
+          channel_shift;
     }
-    inv_stdev_arr = (inv_stdev_arr / (H * W) + epsilon_).sqrt().inverse();
-    Ymat = (Ymat.colwise() * (inv_stdev_arr * scale)).colwise() + bias;
-  }
+  });
   return true;
 }
 
-template <typename T, typename Context>
-bool InstanceNormOp<T, Context>::RunOnDeviceWithOrderNCHW() {
+template <>
+bool InstanceNormOp<float, CPUContext>::RunOnDeviceWithOrderNCHW() {
   const auto& X = Input(INPUT);
   const auto& scale = Input(SCALE);
   const auto& bias = Input(BIAS);
@@ -77,26 +76,28 @@ bool InstanceNormOp<T, Context>::RunOnDeviceWithOrderNCHW() {
   mean->Resize(N, C);
   inv_stdev->Resize(N, C);
 
-  const auto* Xdata = X.template data<T>();
-  auto* Ydata = Y->template mutable_data<T>();
-  const auto* scale_data = scale.template data<T>();
-  const auto* bias_data = bias.template data<T>();
-  auto* mean_data = mean->template mutable_data<T>();
-  auto* inv_stdev_data = inv_stdev->template mutable_data<T>();
-
-  // TODO: benchmark parallelization strategies.
-  for (auto i = 0; i < N * C; ++i) {
-    ConstEigenVectorArrayMap<T> Xi(Xdata + H * W * i, H * W);
-    const T Xi_mean = Xi.mean();
-    const T squared_norm = (Xi - Xi_mean).matrix().squaredNorm();
-    const T inv_stdev = 1.0 / std::sqrt(squared_norm / (H * W) + epsilon_);
-    mean_data[i] = Xi_mean;
-    inv_stdev_data[i] = inv_stdev;
-    EigenVectorArrayMap<T> Yi(Ydata + H * W * i, H * W);
-    const T channel_scale = inv_stdev * scale_data[i % C];
-    const T channel_shift = bias_data[i % C] - Xi_mean * channel_scale;
-    Yi = Xi * channel_scale + channel_shift;
-  }
+  const auto* Xdata = X.data<float>();
+  auto* Ydata = Y->mutable_data<float>();
+  const auto* scale_data = scale.data<float>();
+  const auto* bias_data = bias.data<float>();
+  auto* mean_data = mean->mutable_data<float>();
+  auto* inv_stdev_data = inv_stdev->mutable_data<float>();
+
+  math::ParallelFor(
+      N * C, H * W, ws_->GetThreadPool(), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          const float* Xi = Xdata + H * W * i;
+          float var;
+          Moments(H * W, Xi, mean_data + i, &var);
+          inv_stdev_data[i] = 1.0f / std::sqrt(var + epsilon_);
+          const float channel_scale = inv_stdev_data[i] * scale_data[i % C];
+          const float channel_shift =
+              bias_data[i % C] - mean_data[i] * channel_scale;
+          EigenVectorArrayMap<float>(Ydata + H * W * i, H * W) =
+              ConstEigenVectorArrayMap<float>(Xi, H * W) * channel_scale +
+              channel_shift;
+        }
+      });
 
   return true;
 }
@@ -15,7 +15,8 @@ class InstanceNormOp : public Operator<Context> {
       : Operator<Context>(operator_def, ws),
         epsilon_(OperatorBase::GetSingleArgument<T>("epsilon", 1e-5f)),
         order_(StringToStorageOrder(
-            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
+        ws_(ws) {
     CAFFE_ENFORCE(epsilon_ >= 0, "Must pass a nonnegative epsilon.");
   }
   ~InstanceNormOp() {}
@@ -38,6 +39,7 @@ class InstanceNormOp : public Operator<Context> {
   // parameters
   T epsilon_;
   StorageOrder order_;
+  Workspace* ws_;
 
   // temp results that get passed to the gradient, but are otherwise stored here
   Tensor<Context> mean_;
@@ -0,0 +1,76 @@
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+class Int8AddOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8AddOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int32_t>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE(
+        OperatorBase::HasArgument("Y_scale"), "Y_scale must be specified");
+  }
+
+  bool RunOnDevice() override {
+    const auto& A = OperatorBase::Input<int8::Int8TensorCPU>(0);
+    const auto& B = OperatorBase::Input<int8::Int8TensorCPU>(1);
+    auto* Y = OperatorBase::Output<int8::Int8TensorCPU>(0);
+    CAFFE_ENFORCE(
+        A.t.IsType<std::uint8_t>() && B.t.IsType<std::uint8_t>(),
+        "Quantized activations must be uint8");
+    CAFFE_ENFORCE(
+        A.t.dims() == B.t.dims(), "Int8Add does not support broadcasting");
+    // Read the inputs before resizing the output, which may alias them.
+    const float a_scale = A.scale / Y_scale_;
+    const float b_scale = B.scale / Y_scale_;
+    const float offset =
+        Y_zero_point_ - a_scale * A.zero_point - b_scale * B.zero_point;
+    Y->t.ResizeLike(A.t);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+    Y->channel_scales.clear();
+    const std::uint8_t* a = A.t.data<std::uint8_t>();
+    const std::uint8_t* b = B.t.data<std::uint8_t>();
+    std::uint8_t* y = Y->t.mutable_data<std::uint8_t>();
+    for (int i = 0; i < A.t.size(); ++i) {
+      const float q = std::nearbyint(a_scale * a[i] + b_scale * b[i] + offset);
+      y[i] = static_cast<std::uint8_t>(std::min(255.f, std::max(0.f, q)));
+    }
+    return true;
+  }
+
+ private:
+  float Y_scale_;
+  int32_t Y_zero_point_;
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(Int8Add, Int8AddOp);
+
+OPERATOR_SCHEMA(Int8Add)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .SetDoc(R"DOC(
+Quantized elementwise addition of two uint8 tensors of the same shape, possibly
+with different quantization parameters. The sum is requantized with the given
+output scale and zero point.
+)DOC")
+    .Arg("Y_scale", "Output scale")
+    .Arg("Y_zero_point", "Output zero point (default 0)")
+    .Input(0, "A", "uint8 Int8TensorCPU")
+    .Input(1, "B", "uint8 Int8TensorCPU")
+    .Output(0, "Y", "uint8 Int8TensorCPU");
+
+NO_GRADIENT(Int8Add);
+
+} // namespace caffe2
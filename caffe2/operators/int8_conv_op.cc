@@ -0,0 +1,157 @@
+#include "caffe2/operators/int8_conv_op.h"
+
+#include <cstring>
+
+#include "caffe2/perfkernels/int8_gemm.h"
+
+namespace caffe2 {
+
+namespace {
+
+// im2col for a single NHWC uint8 image: row (oh, ow) of the result holds the
+// kernel_h x kernel_w x C patch feeding that output pixel. Padding is filled
+// with the zero point, i.e. the real value 0.
+void Im2ColNHWC(
+    const std::uint8_t* img,
+    int H,
+    int W,
+    int C,
+    int out_h,
+    int out_w,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int pad_t,
+    int pad_l,
+    int stride_h,
+    int stride_w,
+    std::uint8_t zero_point,
+    std::uint8_t* col) {
+  for (int oh = 0; oh < out_h; ++oh) {
+    for (int ow = 0; ow < out_w; ++ow) {
+      for (int kh = 0; kh < kernel_h; ++kh) {
+        const int ih = oh * stride_h - pad_t + kh * dilation_h;
+        for (int kw = 0; kw < kernel_w; ++kw) {
+          const int iw = ow * stride_w - pad_l + kw * dilation_w;
+          if (ih >= 0 && ih < H && iw >= 0 && iw < W) {
+            std::memcpy(col, img + (ih * W + iw) * C, C);
+          } else {
+            std::memset(col, zero_point, C);
+          }
+          col += C;
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+bool Int8ConvOp::RunOnDeviceWithOrderNHWC() {
+  const auto& X = OperatorBase::Input<int8::Int8TensorCPU>(INPUT);
+  const auto& W = OperatorBase::Input<int8::Int8TensorCPU>(FILTER);
+  auto* Y = OperatorBase::Output<int8::Int8TensorCPU>(0);
+  CAFFE_ENFORCE(
+      X.t.IsType<std::uint8_t>(), "Quantized activations must be uint8");
+  CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+  CAFFE_ENFORCE_EQ(W.t.ndim(), 4);
+  const int N = X.t.dim32(0), H = X.t.dim32(1), Wd = X.t.dim32(2),
+            C = X.t.dim32(3);
+  const int M = W.t.dim32(0);
+  int8::EnforceInt8Weights(W, M);
+  CAFFE_ENFORCE_EQ(W.t.dim32(1), kernel_h());
+  CAFFE_ENFORCE_EQ(W.t.dim32(2), kernel_w());
+  CAFFE_ENFORCE_EQ(W.t.dim32(3), C);
+  const float* bias = nullptr;
+  if (InputSize() == 3) {
+    const auto& b = Input(BIAS);
+    CAFFE_ENFORCE_EQ(b.size(), M, "Dimension mismatch between filter and b");
+    bias = b.data<float>();
+  }
+
+  ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), M);
+  Y->scale = Y_scale_;
+  Y->zero_point = Y_zero_point_;
+  Y->channel_scales.clear();
+  const int out_h = Y->t.dim32(1), out_w = Y->t.dim32(2);
+  const int output_image_size = out_h * out_w;
+  const int kernel_dim = kernel_h() * kernel_w() * C;
+
+  const bool is_1x1 = kernel_h() == 1 && kernel_w() == 1 && stride_h() == 1 &&
+      stride_w() == 1 && pad_t() == 0 && pad_l() == 0 && pad_b() == 0 &&
+      pad_r() == 0;
+
+  ScratchArena::Lease scratch(scratch_arena());
+  auto* acc = scratch.Get(&acc_);
+  acc->Resize(output_image_size, M);
+  auto* col_buffer = scratch.Get(&col_buffer_);
+  if (!is_1x1) {
+    col_buffer->Resize(output_image_size, kernel_dim);
+  }
+
+  requantizer_.Init(X, W, bias, Y_scale_, Y_zero_point_);
+  const std::uint8_t* Xdata = X.t.data<std::uint8_t>();
+  std::uint8_t* Ydata = Y->t.mutable_data<std::uint8_t>();
+  int32_t* acc_data = acc->mutable_data<int32_t>();
+  for (int image_id = 0; image_id < N; ++image_id) {
+    const std::uint8_t* A = Xdata;
+    if (!is_1x1) {
+      std::uint8_t* col_data = col_buffer->mutable_data<std::uint8_t>();
+      Im2ColNHWC(
+          Xdata,
+          H,
+          Wd,
+          C,
+          out_h,
+          out_w,
+          kernel_h(),
+          kernel_w(),
+          dilation_h(),
+          dilation_w(),
+          pad_t(),
+          pad_l(),
+          stride_h(),
+          stride_w(),
+          static_cast<std::uint8_t>(X.zero_point),
+          col_data);
+      A = col_data;
+    }
+    Int8GemmNT(
+        output_image_size,
+        M,
+        kernel_dim,
+        A,
+        W.t.data<std::int8_t>(),
+        acc_data);
+    requantizer_.Run(output_image_size, acc_data, Ydata);
+    Xdata += H * Wd * C;
+    Ydata += output_image_size * M;
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(Int8Conv, Int8ConvOp);
+
+OPERATOR_SCHEMA(Int8Conv)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of Conv for NHWC images (order="NHWC" is required). X holds
+uint8 activations and the filter, of shape M x kernel_h x kernel_w x C,
+symmetric int8 weights (see Int8Quantize), with a per-tensor or
+per-output-channel scale. The products are accumulated exactly in int32 and
+requantized to uint8 with the given output scale and zero point. Kernel,
+stride, dilation and padding arguments are the same as for Conv; groups are
+not supported.
+)DOC")
+    .Arg("Y_scale", "Output scale")
+    .Arg("Y_zero_point", "Output zero point (default 0)")
+    .Input(0, "X", "uint8 Int8TensorCPU of shape N x H x W x C")
+    .Input(1, "filter", "int8 Int8TensorCPU of shape M x kH x kW x C")
+    .Input(2, "bias", "Optional float bias of size M")
+    .Output(0, "Y", "uint8 Int8TensorCPU");
+
+NO_GRADIENT(Int8Conv);
+
+} // namespace caffe2
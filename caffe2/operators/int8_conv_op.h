@@ -0,0 +1,42 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONV_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONV_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+class Int8ConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8ConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int32_t>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE(
+        OperatorBase::HasArgument("Y_scale"), "Y_scale must be specified");
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NHWC, "Int8Conv only supports NHWC order");
+    CAFFE_ENFORCE_EQ(group_, 1, "Int8Conv does not support groups");
+    CAFFE_ENFORCE_EQ(kernel_.size(), 2, "Int8Conv only supports 2D kernels");
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override;
+
+ private:
+  float Y_scale_;
+  int32_t Y_zero_point_;
+  int8::Requantizer requantizer_;
+  TensorCPU col_buffer_;
+  TensorCPU acc_;
+
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONV_OP_H_
@@ -0,0 +1,72 @@
+#include "caffe2/operators/int8_fc_op.h"
+
+#include "caffe2/perfkernels/int8_gemm.h"
+
+namespace caffe2 {
+
+bool Int8FCOp::RunOnDevice() {
+  const auto& X = OperatorBase::Input<int8::Int8TensorCPU>(0);
+  const auto& W = OperatorBase::Input<int8::Int8TensorCPU>(1);
+  auto* Y = OperatorBase::Output<int8::Int8TensorCPU>(0);
+  CAFFE_ENFORCE(
+      X.t.IsType<std::uint8_t>(), "Quantized activations must be uint8");
+  const auto canonical_axis = X.t.canonical_axis_index(axis_);
+  const int M = X.t.size_to_dim(canonical_axis);
+  const int K = X.t.size_from_dim(canonical_axis);
+  CAFFE_ENFORCE_GE(W.t.ndim(), 1);
+  const int N = W.t.dim32(0);
+  int8::EnforceInt8Weights(W, N);
+  CAFFE_ENFORCE_EQ(K * N, W.t.size(), "Dimension mismatch between X and W");
+  const float* bias = nullptr;
+  if (InputSize() == 3) {
+    const auto& b = Input(2);
+    CAFFE_ENFORCE_EQ(b.size(), N, "Dimension mismatch between W and b");
+    bias = b.data<float>();
+  }
+
+  auto Y_dims = X.t.dims();
+  Y_dims.resize(canonical_axis + 1);
+  Y_dims[canonical_axis] = N;
+  Y->t.Resize(Y_dims);
+  Y->scale = Y_scale_;
+  Y->zero_point = Y_zero_point_;
+  Y->channel_scales.clear();
+
+  ScratchArena::Lease scratch(scratch_arena());
+  auto* acc = scratch.Get(&acc_);
+  acc->Resize(M, N);
+  Int8GemmNT(
+      M,
+      N,
+      K,
+      X.t.data<std::uint8_t>(),
+      W.t.data<std::int8_t>(),
+      acc->mutable_data<int32_t>());
+  requantizer_.Init(X, W, bias, Y_scale_, Y_zero_point_);
+  requantizer_.Run(
+      M, acc->data<int32_t>(), Y->t.mutable_data<std::uint8_t>());
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(Int8FC, Int8FCOp);
+
+OPERATOR_SCHEMA(Int8FC)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of FC: computes Y = X * W^T + b, where X holds uint8
+activations and W symmetric int8 weights (see Int8Quantize), with a per-tensor
+or per-output-channel scale. The products are accumulated exactly in int32 and
+requantized to uint8 with the given output scale and zero point.
+)DOC")
+    .Arg("axis", "Describes the axis of the inputs, as in FC (default 1)")
+    .Arg("Y_scale", "Output scale")
+    .Arg("Y_zero_point", "Output zero point (default 0)")
+    .Input(0, "X", "uint8 Int8TensorCPU")
+    .Input(1, "W", "int8 Int8TensorCPU of size N x K")
+    .Input(2, "b", "Optional float bias of size N")
+    .Output(0, "Y", "uint8 Int8TensorCPU");
+
+NO_GRADIENT(Int8FC);
+
+} // namespace caffe2
@@ -0,0 +1,36 @@
+#ifndef CAFFE2_OPERATORS_INT8_FC_OP_H_
+#define CAFFE2_OPERATORS_INT8_FC_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+class Int8FCOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8FCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int32_t>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE(
+        OperatorBase::HasArgument("Y_scale"), "Y_scale must be specified");
+  }
+
+  bool RunOnDevice() override;
+
+ private:
+  int axis_;
+  float Y_scale_;
+  int32_t Y_zero_point_;
+  int8::Requantizer requantizer_;
+  TensorCPU acc_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_FC_OP_H_
@@ -0,0 +1,81 @@
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+
+namespace caffe2 {
+
+namespace {
+
+class Int8MaxPoolOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8MaxPoolOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    CAFFE_ENFORCE(
+        order_ == StorageOrder::NHWC, "Int8MaxPool only supports NHWC order");
+    CAFFE_ENFORCE_EQ(
+        kernel_.size(), 2, "Int8MaxPool only supports 2D pooling");
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = OperatorBase::Input<int8::Int8TensorCPU>(0);
+    auto* Y = OperatorBase::Output<int8::Int8TensorCPU>(0);
+    CAFFE_ENFORCE(
+        X.t.IsType<std::uint8_t>(), "Quantized activations must be uint8");
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+    const int N = X.t.dim32(0), H = X.t.dim32(1), W = X.t.dim32(2),
+              C = X.t.dim32(3);
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), C);
+    // Max is monotonic, so the output keeps the quantization parameters.
+    Y->scale = X.scale;
+    Y->zero_point = X.zero_point;
+    Y->channel_scales.clear();
+    const int out_h = Y->t.dim32(1), out_w = Y->t.dim32(2);
+    const std::uint8_t* Xdata = X.t.data<std::uint8_t>();
+    std::uint8_t* Ydata = Y->t.mutable_data<std::uint8_t>();
+    for (int n = 0; n < N; ++n) {
+      for (int oh = 0; oh < out_h; ++oh) {
+        const int h_start = std::max(oh * stride_h() - pad_t(), 0);
+        const int h_end = std::min(oh * stride_h() - pad_t() + kernel_h(), H);
+        for (int ow = 0; ow < out_w; ++ow) {
+          const int w_start = std::max(ow * stride_w() - pad_l(), 0);
+          const int w_end =
+              std::min(ow * stride_w() - pad_l() + kernel_w(), W);
+          std::uint8_t* y = Ydata + (oh * out_w + ow) * C;
+          std::fill(y, y + C, 0);
+          for (int h = h_start; h < h_end; ++h) {
+            for (int w = w_start; w < w_end; ++w) {
+              const std::uint8_t* x = Xdata + (h * W + w) * C;
+              for (int c = 0; c < C; ++c) {
+                y[c] = std::max(y[c], x[c]);
+              }
+            }
+          }
+        }
+      }
+      Xdata += H * W * C;
+      Ydata += out_h * out_w * C;
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(Int8MaxPool, Int8MaxPoolOp);
+
+OPERATOR_SCHEMA(Int8MaxPool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantized version of MaxPool for NHWC uint8 images (order="NHWC" is required).
+Padded positions are ignored. The output keeps the scale and zero point of the
+input. Kernel, stride and padding arguments are the same as for MaxPool.
+)DOC")
+    .Input(0, "X", "uint8 Int8TensorCPU of shape N x H x W x C")
+    .Output(0, "Y", "uint8 Int8TensorCPU");
+
+NO_GRADIENT(Int8MaxPool);
+
+} // namespace caffe2
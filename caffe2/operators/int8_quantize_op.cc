@@ -0,0 +1,149 @@
+#include "caffe2/operators/int8_quantize_op.h"
+
+#include <cmath>
+
+namespace caffe2 {
+
+bool Int8QuantizeOp::RunOnDevice() {
+  const auto& X = Input(0);
+  auto* Y = OperatorBase::Output<int8::Int8TensorCPU>(0);
+  Y->t.ResizeLike(X);
+  Y->channel_scales.clear();
+  if (signed_) {
+    QuantizeSigned(X, Y);
+  } else {
+    QuantizeUnsigned(X, Y);
+  }
+  return true;
+}
+
+void Int8QuantizeOp::QuantizeUnsigned(
+    const TensorCPU& X,
+    int8::Int8TensorCPU* Y) {
+  const float* x = X.data<float>();
+  const int N = X.size();
+  if (has_scale_) {
+    Y->scale = scale_;
+    Y->zero_point = zero_point_;
+  } else {
+    // Without calibrated parameters, cover the range of this input.
+    float min = 0;
+    float max = 0;
+    if (N > 0) {
+      const auto minmax = std::minmax_element(x, x + N);
+      min = *minmax.first;
+      max = *minmax.second;
+    }
+    int8::ChooseUint8Params(min, max, &Y->scale, &Y->zero_point);
+  }
+  CAFFE_ENFORCE(
+      Y->zero_point >= 0 && Y->zero_point <= 255,
+      "Y_zero_point out of the uint8 range: ",
+      Y->zero_point);
+  const float inv_scale = 1.f / Y->scale;
+  auto* y = Y->t.mutable_data<std::uint8_t>();
+  for (int i = 0; i < N; ++i) {
+    y[i] = int8::QuantizeUint8(x[i], inv_scale, Y->zero_point);
+  }
+}
+
+void Int8QuantizeOp::QuantizeSigned(
+    const TensorCPU& X,
+    int8::Int8TensorCPU* Y) {
+  const float* x = X.data<float>();
+  auto* y = Y->t.mutable_data<std::int8_t>();
+  Y->zero_point = 0;
+  const int channels = per_channel_ ? X.dim32(0) : 1;
+  const int inner = channels ? X.size() / channels : 0;
+  for (int c = 0; c < channels; ++c) {
+    float scale = scale_;
+    if (!has_scale_) {
+      float abs_max = 0;
+      for (int i = c * inner; i < (c + 1) * inner; ++i) {
+        abs_max = std::max(abs_max, std::abs(x[i]));
+      }
+      scale = abs_max > 0 ? abs_max / 127.f : 1.f;
+    }
+    if (per_channel_) {
+      Y->channel_scales.push_back(scale);
+    } else {
+      Y->scale = scale;
+    }
+    const float inv_scale = 1.f / scale;
+    for (int i = c * inner; i < (c + 1) * inner; ++i) {
+      y[i] = int8::QuantizeInt8(x[i], inv_scale);
+    }
+  }
+  if (per_channel_) {
+    Y->scale = 1;
+  }
+}
+
+bool Int8DequantizeOp::RunOnDevice() {
+  const auto& X = OperatorBase::Input<int8::Int8TensorCPU>(0);
+  auto* Y = Output(0);
+  Y->ResizeLike(X.t);
+  float* y = Y->mutable_data<float>();
+  const int N = X.t.size();
+  if (X.t.IsType<std::uint8_t>()) {
+    const auto* x = X.t.data<std::uint8_t>();
+    for (int i = 0; i < N; ++i) {
+      y[i] = X.scale * (static_cast<int32_t>(x[i]) - X.zero_point);
+    }
+  } else {
+    CAFFE_ENFORCE(
+        X.t.IsType<std::int8_t>(), "Unexpected quantized type ", X.t.meta().name());
+    const auto* x = X.t.data<std::int8_t>();
+    const int channels = X.channel_scales.empty() ? 1 : X.t.dim32(0);
+    const int inner = channels ? N / channels : 0;
+    for (int c = 0; c < channels; ++c) {
+      const float scale = X.channel_scale(c);
+      for (int i = c * inner; i < (c + 1) * inner; ++i) {
+        y[i] = scale * (static_cast<int32_t>(x[i]) - X.zero_point);
+      }
+    }
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(Int8Quantize, Int8QuantizeOp);
+REGISTER_CPU_OPERATOR(Int8Dequantize, Int8DequantizeOp);
+
+OPERATOR_SCHEMA(Int8Quantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantizes a float tensor into an 8-bit quantized tensor (Int8TensorCPU), whose
+elements q stand for Y_scale * (q - Y_zero_point).
+
+By default the output is uint8, as expected for activations by the other Int8
+operators. If Y_scale is not given, the scale and zero point are chosen to
+cover the range of the input on every run; calibrated values should be
+preferred for inference.
+
+With signed=1 the output is symmetric int8 with a zero point of 0, as expected
+for the weights of Int8FC and Int8Conv. With per_channel=1, each slice along
+the first dimension gets its own scale.
+)DOC")
+    .Arg("Y_scale", "Output scale, computed from the input if not given")
+    .Arg("Y_zero_point", "Output zero point, for uint8 outputs (default 0)")
+    .Arg("signed", "Produce symmetric int8 instead of uint8 (default 0)")
+    .Arg(
+        "per_channel",
+        "Use one scale per output channel, for signed outputs (default 0)")
+    .Input(0, "X", "Float tensor")
+    .Output(0, "Y", "Int8TensorCPU");
+
+OPERATOR_SCHEMA(Int8Dequantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Converts an 8-bit quantized tensor (Int8TensorCPU) back into a float tensor.
+)DOC")
+    .Input(0, "X", "Int8TensorCPU")
+    .Output(0, "Y", "Float tensor");
+
+NO_GRADIENT(Int8Quantize);
+NO_GRADIENT(Int8Dequantize);
+
+} // namespace caffe2
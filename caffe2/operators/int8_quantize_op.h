@@ -0,0 +1,56 @@
+#ifndef CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+#define CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/int8_utils.h"
+
+namespace caffe2 {
+
+class Int8QuantizeOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8QuantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        has_scale_(OperatorBase::HasArgument("Y_scale")),
+        scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1)),
+        zero_point_(
+            OperatorBase::GetSingleArgument<int32_t>("Y_zero_point", 0)),
+        signed_(OperatorBase::GetSingleArgument<bool>("signed", false)),
+        per_channel_(
+            OperatorBase::GetSingleArgument<bool>("per_channel", false)) {
+    CAFFE_ENFORCE(
+        signed_ || !per_channel_,
+        "Per channel quantization is only supported for signed weights");
+    CAFFE_ENFORCE(
+        !(has_scale_ && per_channel_),
+        "Y_scale cannot be given with per channel quantization");
+    CAFFE_ENFORCE(scale_ > 0, "Y_scale must be positive");
+  }
+
+  bool RunOnDevice() override;
+
+ private:
+  void QuantizeUnsigned(const TensorCPU& X, int8::Int8TensorCPU* Y);
+  void QuantizeSigned(const TensorCPU& X, int8::Int8TensorCPU* Y);
+
+  bool has_scale_;
+  float scale_;
+  int32_t zero_point_;
+  bool signed_;
+  bool per_channel_;
+};
+
+class Int8DequantizeOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8DequantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
@@ -0,0 +1,53 @@
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+
+namespace {
+
+class Int8ReluOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  Int8ReluOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = OperatorBase::Input<int8::Int8TensorCPU>(0);
+    auto* Y = OperatorBase::Output<int8::Int8TensorCPU>(0);
+    CAFFE_ENFORCE(
+        X.t.IsType<std::uint8_t>(), "Quantized activations must be uint8");
+    Y->t.ResizeLike(X.t);
+    Y->scale = X.scale;
+    Y->zero_point = X.zero_point;
+    Y->channel_scales.clear();
+    // The real value 0 is represented by the zero point, so relu is a clamp
+    // in the quantized domain and keeps the quantization parameters.
+    const std::uint8_t zero = std::max(0, std::min(255, X.zero_point));
+    const std::uint8_t* x = X.t.data<std::uint8_t>();
+    std::uint8_t* y = Y->t.mutable_data<std::uint8_t>();
+    for (int i = 0; i < X.t.size(); ++i) {
+      y[i] = std::max(x[i], zero);
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+REGISTER_CPU_OPERATOR(Int8Relu, Int8ReluOp);
+
+OPERATOR_SCHEMA(Int8Relu)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .SetDoc(R"DOC(
+Quantized version of Relu on uint8 activations. The output keeps the scale and
+zero point of the input.
+)DOC")
+    .Input(0, "X", "uint8 Int8TensorCPU")
+    .Output(0, "Y", "uint8 Int8TensorCPU");
+
+NO_GRADIENT(Int8Relu);
+
+} // namespace caffe2
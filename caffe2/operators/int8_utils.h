@@ -0,0 +1,112 @@
+#ifndef CAFFE2_OPERATORS_INT8_UTILS_H_
+#define CAFFE2_OPERATORS_INT8_UTILS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/tensor_int8.h"
+
+namespace caffe2 {
+namespace int8 {
+
+inline std::uint8_t QuantizeUint8(float x, float inv_scale, int32_t zero_point) {
+  const float q = std::nearbyint(x * inv_scale) + zero_point;
+  return static_cast<std::uint8_t>(std::min(255.f, std::max(0.f, q)));
+}
+
+inline std::int8_t QuantizeInt8(float x, float inv_scale) {
+  const float q = std::nearbyint(x * inv_scale);
+  return static_cast<std::int8_t>(std::min(127.f, std::max(-127.f, q)));
+}
+
+// Chooses the uint8 quantization parameters covering [min, max]. The range is
+// extended to contain 0 so that zero (e.g. padding) is represented exactly.
+inline void ChooseUint8Params(
+    float min,
+    float max,
+    float* scale,
+    int32_t* zero_point) {
+  min = std::min(min, 0.f);
+  max = std::max(max, 0.f);
+  *scale = (max - min) / 255.f;
+  if (*scale == 0) {
+    *scale = 1;
+  }
+  *zero_point = static_cast<int32_t>(
+      std::min(255.f, std::max(0.f, std::nearbyint(-min / *scale))));
+}
+
+// Checks that the weights of a quantized FC or convolution are int8 with a
+// zero point of 0, and a scale per output channel if any.
+inline void EnforceInt8Weights(const Int8TensorCPU& W, int output_channels) {
+  CAFFE_ENFORCE(
+      W.t.IsType<std::int8_t>(), "Quantized weights must be stored as int8");
+  CAFFE_ENFORCE_EQ(W.zero_point, 0, "Quantized weights must be symmetric");
+  CAFFE_ENFORCE(
+      W.channel_scales.empty() || W.channel_scales.size() == output_channels,
+      "Expected one weight scale per output channel");
+}
+
+/**
+ * Turns int32 accumulators of uint8 activations times int8 weights into
+ * uint8 outputs. For output channel m, the real value of an accumulator is
+ *   X.scale * W.scale[m] * (acc - X.zero_point * sum_k W[m][k]) + bias[m]
+ * which is folded into a single multiply-add per element. The row sums of W
+ * are recomputed at every run, since the weights may be overwritten in place
+ * with new values; this is a small fraction of the cost of the GEMM.
+ */
+class Requantizer {
+ public:
+  void Init(
+      const Int8TensorCPU& X,
+      const Int8TensorCPU& W,
+      const float* bias,
+      float Y_scale,
+      int32_t Y_zero_point) {
+    const int M = W.t.dim32(0);
+    const int K = W.t.size() / M;
+    const std::int8_t* w = W.t.data<std::int8_t>();
+    w_sums_.resize(M);
+    for (int m = 0; m < M; ++m) {
+      int32_t w_sum = 0;
+      for (int k = 0; k < K; ++k) {
+        w_sum += w[m * K + k];
+      }
+      w_sums_[m] = w_sum;
+    }
+    multiplier_.resize(M);
+    offset_.resize(M);
+    for (int m = 0; m < M; ++m) {
+      multiplier_[m] = X.scale * W.channel_scale(m) / Y_scale;
+      offset_[m] = Y_zero_point -
+          multiplier_[m] * static_cast<float>(X.zero_point) * w_sums_[m] +
+          (bias ? bias[m] / Y_scale : 0.f);
+    }
+  }
+
+  // Requantizes rows x M accumulators, row-major.
+  void Run(int rows, const int32_t* acc, std::uint8_t* out) const {
+    const int M = multiplier_.size();
+    for (int i = 0; i < rows; ++i) {
+      for (int m = 0; m < M; ++m) {
+        const float q =
+            std::nearbyint(acc[i * M + m] * multiplier_[m] + offset_[m]);
+        out[i * M + m] =
+            static_cast<std::uint8_t>(std::min(255.f, std::max(0.f, q)));
+      }
+    }
+  }
+
+ private:
+  std::vector<int32_t> w_sums_;
+  std::vector<float> multiplier_;
+  std::vector<float> offset_;
+};
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_UTILS_H_
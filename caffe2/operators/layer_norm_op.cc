@@ -1,5 +1,7 @@
 #include "caffe2/operators/layer_norm_op.h"
 
+#include "caffe2/perfkernels/moments.h"
+
 namespace caffe2 {
 
 namespace {
@@ -33,26 +35,23 @@ bool LayerNormOp<CPUContext>::DoRunWithType<float>() {
   mean->Resize(stats_dims);
   stdev->Resize(stats_dims);
 
-  auto input_map = ConstEigenMatrixMapRowMajor<float>(
-      input.template data<float>(), left, right);
-  auto mean_map = EigenMatrixMapRowMajor<float>(
-      mean->template mutable_data<float>(), left, 1);
-  auto stdev_map = EigenMatrixMapRowMajor<float>(
-      stdev->template mutable_data<float>(), left, 1);
-  auto output_map = EigenMatrixMapRowMajor<float>(
-      output->template mutable_data<float>(), left, right);
-
-  auto sqr = [](float f) { return f * f; };
-  auto add_ep = [this](float f) { return f + epsilon_; };
-  auto fsqrt = [](float f) { return std::sqrt(f); };
-  // Calculate row-wise statistics
-  mean_map = input_map.rowwise().mean();
-  stdev_map =
-      (input_map.unaryExpr(sqr).rowwise().mean() - mean_map.unaryExpr(sqr))
-          .unaryExpr(add_ep)
-          .unaryExpr(fsqrt);
-  output_map = (input_map - mean_map.replicate(1, right))
-                   .cwiseQuotient(stdev_map.replicate(1, right));
+  const float* X = input.template data<float>();
+  float* Y = output->template mutable_data<float>();
+  float* mean_data = mean->template mutable_data<float>();
+  float* stdev_data = stdev->template mutable_data<float>();
+  // One pass over each row for its statistics, and one to normalize it while
+  // it is still in cache.
+  math::ParallelFor(left, right, ws_->GetThreadPool(), [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      float var;
+      Moments(right, X + i * right, mean_data + i, &var);
+      stdev_data[i] = std::sqrt(var + epsilon_);
+      EigenVectorArrayMap<float>(Y + i * right, right) =
+          (ConstEigenVectorArrayMap<float>(X + i * right, right) -
+           mean_data[i]) *
+          (1.0f / stdev_data[i]);
+    }
+  });
 
   return true;
 }
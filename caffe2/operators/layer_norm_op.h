@@ -14,7 +14,8 @@ class LayerNormOp : public Operator<Context> {
   LayerNormOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
         axis_(OperatorBase::GetSingleArgument<int>("axis", 1)),
-        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        ws_(ws) {}
   ~LayerNormOp() {}
 
   template <typename T>
@@ -27,6 +28,7 @@ class LayerNormOp : public Operator<Context> {
  protected:
   int axis_;
   float epsilon_;
+  Workspace* ws_;
 
   Tensor<Context> scratch_;
   Tensor<Context> seg_indices_;
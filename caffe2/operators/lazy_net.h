@@ -0,0 +1,72 @@
+#ifndef CAFFE2_OPERATORS_LAZY_NET_H_
+#define CAFFE2_OPERATORS_LAZY_NET_H_
+
+#include <memory>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * A subnet of a control flow operator.
+ *
+ * By default the net is created right away, as control flow operators always
+ * did. If lazy, it is only created the first time it runs, so branches that
+ * are never taken cost neither startup time nor memory; errors in the subnet
+ * then surface on its first run instead of at construction. If evict_after
+ * is positive, the net is also destroyed once it has been skipped
+ * evict_after times in a row, and recreated the next time it runs.
+ */
+class LazyNet {
+ public:
+  LazyNet(
+      const NetDef& net_def,
+      Workspace* ws,
+      bool lazy = false,
+      int evict_after = 0)
+      : net_def_(net_def), ws_(ws), evict_after_(evict_after) {
+    if (!lazy) {
+      CreateIfNeeded();
+    }
+  }
+
+  bool Run() {
+    CreateIfNeeded();
+    skipped_ = 0;
+    return net_->Run();
+  }
+
+  // Records that the owning operator ran without running this net.
+  void Skip() {
+    if (net_ && evict_after_ > 0 && ++skipped_ >= evict_after_) {
+      VLOG(1) << "Evicting unused subnet " << net_def_.name();
+      net_.reset();
+      skipped_ = 0;
+    }
+  }
+
+  bool created() const {
+    return net_ != nullptr;
+  }
+
+ private:
+  void CreateIfNeeded() {
+    if (!net_) {
+      net_ = CreateNet(net_def_, ws_);
+      CAFFE_ENFORCE(net_, "Failed to initialize subnet ", net_def_.name());
+    }
+  }
+
+  NetDef net_def_;
+  Workspace* ws_;
+  int evict_after_;
+  int skipped_ = 0;
+  std::unique_ptr<NetBase> net_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_LAZY_NET_H_
@@ -11,13 +11,13 @@ namespace caffe2 {
 
 REGISTER_CPU_OPERATOR_STR(
     "SparseLengthsSum",
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16>, 0, 0>);
+    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16, bfloat16>, 0, 0>);
 REGISTER_CPU_OPERATOR_STR(
     "SparseLengthsWeightedSum",
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16>, 1, 0>);
+    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16, bfloat16>, 1, 0>);
 REGISTER_CPU_OPERATOR_STR(
     "SparseLengthsMean",
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16>, 0, 1>);
+    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16, bfloat16>, 0, 1>);
 
 OPERATOR_SCHEMA(SparseLengthsPositionalWeightedSum)
     .NumInputs(4)
@@ -51,6 +51,6 @@ SparseWeightedSum
 
 REGISTER_CPU_OPERATOR_STR(
     "SparseLengthsPositionalWeightedSum",
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16>, 1, 0, 1>);
+    CPUSparseLengthsReductionOp<float, TensorTypes<float, float16, bfloat16>, 1, 0, 1>);
 
 } // namespace caffe2
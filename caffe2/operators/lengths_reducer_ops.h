@@ -26,8 +26,8 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
 
   ~CPUSparseLengthsReductionOp() {}
 
-  // Currently, we support float and float16 inputs for input data type, and
-  // int32_t and int64_t for the index type.
+  // Currently, we support float, float16 and bfloat16 inputs for input data
+  // type, and int32_t and int64_t for the index type.
 
   bool RunOnDevice() override {
     return DispatchHelper<InputTypes>::call(this, Input(DATA));
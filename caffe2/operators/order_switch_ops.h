@@ -12,21 +12,25 @@ namespace caffe2 {
 template <typename T, class Context>
 class NHWC2NCHWOp final : public Operator<Context> {
  public:
-  USE_SIMPLE_CTOR_DTOR(NHWC2NCHWOp);
   USE_OPERATOR_CONTEXT_FUNCTIONS;
+  NHWC2NCHWOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
   bool RunOnDevice() override;
 
  protected:
+  Workspace* ws_;
 };
 
 template <typename T, class Context>
 class NCHW2NHWCOp final : public Operator<Context> {
  public:
-  USE_SIMPLE_CTOR_DTOR(NCHW2NHWCOp);
   USE_OPERATOR_CONTEXT_FUNCTIONS;
+  NCHW2NHWCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
   bool RunOnDevice() override;
 
  protected:
+  Workspace* ws_;
 };
 
 } // namespace caffe2
@@ -2,6 +2,34 @@
 
 namespace caffe2 {
 
+namespace {
+
+// Copies the bytes of each segment, from srcs[i] to dsts[i], with the threads
+// of ws when the type is copied with memcpy.
+void CopySegments(
+    const TypeMeta& meta,
+    const vector<const char*>& srcs,
+    const vector<char*>& dsts,
+    const vector<size_t>& range_bytes,
+    CPUContext* context,
+    Workspace* ws) {
+  if (!meta.copy()) {
+    math::CopyRangesCPU(
+        srcs.size(),
+        srcs.data(),
+        dsts.data(),
+        range_bytes.data(),
+        ws->GetThreadPool());
+    return;
+  }
+  for (size_t i = 0; i < srcs.size(); ++i) {
+    context->CopyItems<CPUContext, CPUContext>(
+        meta, range_bytes[i] / meta.itemsize(), srcs[i], dsts[i]);
+  }
+}
+
+} // namespace
+
 template <>
 template <typename T>
 bool PackSegmentsOp<CPUContext>::DoRunWithType() {
@@ -29,6 +57,7 @@ bool PackSegmentsOp<CPUContext>::DoRunWithType2() {
   T max_length = 0;
   TIndex total_length = 0;
   for (T i = 0; i < lengths.dim(0); ++i) {
+    CAFFE_ENFORCE_GE(l[i], 0, "Lengths should be non-negative");
     max_length = std::max(max_length, l[i]);
     total_length += l[i];
   }
@@ -78,18 +107,21 @@ bool PackSegmentsOp<CPUContext>::DoRunWithType2() {
   auto block_size = data.size_from_dim(1);
   auto block_bytesize = data.itemsize() * block_size;
   const auto* d = static_cast<const char*>(data.raw_data());
+  const TIndex num_segments = lengths.dim(0);
+  srcs_.resize(num_segments);
+  dsts_.resize(num_segments);
+  range_bytes_.resize(num_segments);
   TIndex start = 0;
-  for (TIndex i = 0; i < lengths.dim(0); ++i) {
-    context_.template CopyItems<CPUContext, CPUContext>(
-        data.meta(),
-        l[i] * block_size,
-        d + block_bytesize * start,
-        out + block_bytesize * max_length * i);
+  for (TIndex i = 0; i < num_segments; ++i) {
+    srcs_[i] = d + block_bytesize * start;
+    dsts_[i] = out + block_bytesize * max_length * i;
+    range_bytes_[i] = block_bytesize * l[i];
     if (return_presence_mask_) {
       memset(presence_mask_data + max_length * i, (int)true, l[i]);
     }
     start += l[i];
   }
+  CopySegments(data.meta(), srcs_, dsts_, range_bytes_, &context_, ws_);
 
   return true;
 }
@@ -130,15 +162,24 @@ bool UnpackSegmentsOp<CPUContext>::DoRunWithType2() {
   auto block_size = data.size_from_dim(2);
   auto block_bytesize = data.itemsize() * block_size;
   const auto* d = static_cast<const char*>(data.raw_data());
+  const TIndex num_segments = lengths.dim(0);
+  srcs_.resize(num_segments);
+  dsts_.resize(num_segments);
+  range_bytes_.resize(num_segments);
   TIndex start = 0;
-  for (TIndex i = 0; i < lengths.dim(0); ++i) {
-    context_.template CopyItems<CPUContext, CPUContext>(
-        data.meta(),
-        l[i] * block_size,
-        d + block_bytesize * data.dim(1) * i,
-        out + block_bytesize * start);
+  for (TIndex i = 0; i < num_segments; ++i) {
+    CAFFE_ENFORCE(
+        0 <= l[i] && l[i] <= data.dim(1),
+        "Length ",
+        l[i],
+        " is out of the range of the packed dimension ",
+        data.dim(1));
+    srcs_[i] = d + block_bytesize * data.dim(1) * i;
+    dsts_[i] = out + block_bytesize * start;
+    range_bytes_[i] = block_bytesize * l[i];
     start += l[i];
   }
+  CopySegments(data.meta(), srcs_, dsts_, range_bytes_, &context_, ws_);
   return true;
 }
 
@@ -24,7 +24,8 @@ class PackSegmentsOp final : public Operator<Context> {
         pad_minf_(OperatorBase::GetSingleArgument<bool>("pad_minf", false)),
         return_presence_mask_(OperatorBase::GetSingleArgument<bool>(
             "return_presence_mask",
-            false)) {
+            false)),
+        ws_(ws) {
     if (pad_minf_) {
       padding_ = -1.0 * std::numeric_limits<float>::infinity();
     } else {
@@ -48,6 +49,12 @@ class PackSegmentsOp final : public Operator<Context> {
   bool pad_minf_;
   float padding_;
   bool return_presence_mask_;
+  Workspace* ws_;
+
+  // Ranges of bytes copied by the CPU version, one per segment
+  vector<const char*> srcs_;
+  vector<char*> dsts_;
+  vector<size_t> range_bytes_;
 
   // Scratch space required by the CUDA version
   Tensor<Context> dev_buffer_;
@@ -60,9 +67,11 @@ template <class Context>
 class UnpackSegmentsOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(UnpackSegmentsOp)
   USE_DISPATCH_HELPER;
 
+  UnpackSegmentsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
+
   bool RunOnDevice() override {
     return DispatchHelper<TensorTypes<int, long>>::call(this, Input(LENGTHS));
   }
@@ -76,6 +85,13 @@ class UnpackSegmentsOp final : public Operator<Context> {
   INPUT_TAGS(LENGTHS, DATA);
 
  private:
+  Workspace* ws_;
+
+  // Ranges of bytes copied by the CPU version, one per segment
+  vector<const char*> srcs_;
+  vector<char*> dsts_;
+  vector<size_t> range_bytes_;
+
   Tensor<Context> dev_buffer_;
   Tensor<Context> dev_lengths_prefix_sum_;
   Tensor<Context> dev_max_length_;
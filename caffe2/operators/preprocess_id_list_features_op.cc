@@ -0,0 +1,78 @@
+#include "caffe2/operators/preprocess_id_list_features_op.h"
+
+namespace caffe2 {
+namespace {
+
+OPERATOR_SCHEMA(PreprocessIdListFeatures)
+    .NumInputs(2)
+    .NumOutputs(2, INT_MAX)
+    .SetDoc(R"DOC(
+Turns the raw id lists of F features into the indices and lengths used by the
+sparse lookups, in a single operator instead of a chain of GatherRanges,
+IndexHash, Mod and dedup ops per feature. Features are processed in parallel.
+
+RANGES has dims (N, F, 2): for each of the N examples and each feature, the
+start and length of its id list in DATA. For each feature f, the op outputs
+INDICES_f, the processed ids of all the examples concatenated, and LENGTHS_f,
+the number of ids of each example.
+
+The ids of each list of feature f go through, in order:
+  1. hashing with IndexHash, with seeds[f] and modulos[f], if hash[f] is set.
+     Otherwise, when modulos[f] > 0, the ids are replaced by their
+     non-negative remainder modulo modulos[f];
+  2. the removal of repeated ids, keeping the first one, if dedup[f] is set;
+  3. truncation to the first max_lengths[f] ids, if max_lengths[f] > 0;
+  4. lists left empty get the single id default_ids[f], if it is not negative.
+
+Every argument is either omitted, which gives a feature that is only gathered,
+or has one value per feature.
+
+Example:
+  DATA = [1, 2, 2, 3, 7, 8, 9]
+  RANGES = [
+    [[0, 3], [3, 0]],
+    [[3, 1], [4, 3]],
+  ]
+  dedup = [1, 0]
+  max_lengths = [0, 2]
+  default_ids = [-1, 0]
+  INDICES_0 = [1, 2, 3]
+  LENGTHS_0 = [2, 1]
+  INDICES_1 = [0, 7, 8]
+  LENGTHS_1 = [1, 2]
+)DOC")
+    .Input(0, "DATA", "1-D tensor of int32 or int64 ids.")
+    .Input(
+        1,
+        "RANGES",
+        "Tensor of int32/int64 ranges of dims (N, F, 2), in the format "
+        "(start, length).")
+    .Output(0, "INDICES_0", "1-D tensor of the ids of feature 0, of DATA type.")
+    .Output(1, "LENGTHS_0", "1-D int32 tensor of size N.")
+    .Arg("hash", "Whether to hash the ids of each feature")
+    .Arg("seeds", "Seed of IndexHash for each feature")
+    .Arg("modulos", "Modulo of each feature, 0 for none")
+    .Arg("dedup", "Whether to remove repeated ids from each list")
+    .Arg("max_lengths", "Maximum length of each list, 0 for no limit")
+    .Arg("default_ids", "Id of the empty lists, negative for none")
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(def.output_size());
+      for (int i = 0; i + 1 < out.size(); i += 2) {
+        out[i].set_data_type(in[0].data_type());
+        out[i].set_unknown_shape(true);
+        out[i + 1].set_data_type(TensorProto::INT32);
+        if (in[1].dims_size() > 0) {
+          out[i + 1].add_dims(in[1].dims(0));
+        } else {
+          out[i + 1].set_unknown_shape(true);
+        }
+      }
+      return out;
+    });
+
+REGISTER_CPU_OPERATOR(PreprocessIdListFeatures, PreprocessIdListFeaturesOp);
+NO_GRADIENT(PreprocessIdListFeatures);
+
+} // namespace
+} // namespace caffe2
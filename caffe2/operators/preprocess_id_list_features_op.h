@@ -0,0 +1,233 @@
+#ifndef CAFFE2_OPERATORS_PREPROCESS_ID_LIST_FEATURES_OP_H_
+#define CAFFE2_OPERATORS_PREPROCESS_ID_LIST_FEATURES_OP_H_
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/index_hash_ops.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Runs GatherRanges, IndexHash or a modulo, deduplication, truncation and
+// the filling of empty lists for several id list features at once, one
+// feature per task of the thread pool.
+class PreprocessIdListFeaturesOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  PreprocessIdListFeaturesOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        hash_(OperatorBase::GetRepeatedArgument<int>("hash")),
+        seeds_(OperatorBase::GetRepeatedArgument<int64_t>("seeds")),
+        modulos_(OperatorBase::GetRepeatedArgument<int64_t>("modulos")),
+        dedup_(OperatorBase::GetRepeatedArgument<int>("dedup")),
+        max_lengths_(OperatorBase::GetRepeatedArgument<int>("max_lengths")),
+        default_ids_(
+            OperatorBase::GetRepeatedArgument<int64_t>("default_ids")),
+        ws_(ws) {
+    CAFFE_ENFORCE(
+        OutputSize() > 0 && OutputSize() % 2 == 0,
+        "There should be two outputs per feature");
+    num_features_ = OutputSize() / 2;
+    // The arguments default to a feature that is only gathered.
+    ResizeArgument(&hash_, "hash", 0);
+    ResizeArgument(&seeds_, "seeds", 0);
+    ResizeArgument(&modulos_, "modulos", 0);
+    ResizeArgument(&dedup_, "dedup", 0);
+    ResizeArgument(&max_lengths_, "max_lengths", 0);
+    ResizeArgument(&default_ids_, "default_ids", -1);
+    for (int f = 0; f < num_features_; ++f) {
+      CAFFE_ENFORCE_GE(modulos_[f], 0, "modulos should be non-negative");
+      CAFFE_ENFORCE(
+          !hash_[f] || modulos_[f] > 0,
+          "A positive modulo is needed to hash feature #",
+          f);
+      CAFFE_ENFORCE_GE(max_lengths_[f], 0, "max_lengths should be >= 0");
+      CAFFE_ENFORCE(
+          modulos_[f] == 0 || default_ids_[f] < modulos_[f],
+          "The default id of feature #",
+          f,
+          " should be less than its modulo");
+    }
+  }
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(RANGES));
+  }
+
+  template <typename Index>
+  bool DoRunWithType() {
+    return DispatchHelper<TensorTypes2<int32_t, int64_t>, Index>::call(
+        this, Input(DATA));
+  }
+
+  template <typename Index, typename T>
+  bool DoRunWithType2() {
+    auto& data = Input(DATA);
+    auto& ranges = Input(RANGES);
+    CAFFE_ENFORCE_EQ(data.ndim(), 1, "DATA has to be 1-D");
+    CAFFE_ENFORCE_EQ(ranges.ndim(), 3, "RANGES has to be 3-D");
+    CAFFE_ENFORCE_EQ(
+        ranges.dim(1),
+        num_features_,
+        "The number of features of RANGES should be half the outputs");
+    CAFFE_ENFORCE_EQ(ranges.dim(2), 2, "RANGES last dimension should be 2");
+
+    const int batch_size = ranges.dim(0);
+    const Index* ranges_data = ranges.template data<Index>();
+    const T* ids = data.template data<T>();
+
+    // Check all the ranges before any work is given to the threads, and
+    // bound the size of each output.
+    std::vector<TIndex> max_sizes(num_features_, 0);
+    for (int i = 0; i < batch_size; ++i) {
+      for (int f = 0; f < num_features_; ++f) {
+        const Index* range = ranges_data + (i * num_features_ + f) * 2;
+        CAFFE_ENFORCE(
+            0 <= range[0] && 0 <= range[1] &&
+                range[0] + range[1] <= data.size(),
+            "Range [",
+            range[0],
+            ", ",
+            range[0] + range[1],
+            ") is out of the data bounds ",
+            data.size());
+        TIndex length = range[1];
+        if (max_lengths_[f] > 0 && length > max_lengths_[f]) {
+          length = max_lengths_[f];
+        }
+        if (length == 0 && default_ids_[f] >= 0) {
+          length = 1;
+        }
+        max_sizes[f] += length;
+      }
+    }
+
+    std::vector<T*> indices(num_features_);
+    std::vector<int*> lengths(num_features_);
+    for (int f = 0; f < num_features_; ++f) {
+      auto* output_indices = Output(2 * f);
+      output_indices->Resize(max_sizes[f]);
+      indices[f] = output_indices->template mutable_data<T>();
+      auto* output_lengths = Output(2 * f + 1);
+      output_lengths->Resize(batch_size);
+      lengths[f] = output_lengths->template mutable_data<int>();
+    }
+
+    // Any cost above the grain size of ParallelFor gives a task per feature,
+    // so that even a few large features are processed in parallel.
+    const TIndex cost = std::min<TIndex>(
+        (batch_size + data.size()) / num_features_ + 1,
+        std::numeric_limits<int>::max());
+    std::vector<TIndex> sizes(num_features_);
+    math::ParallelFor(
+        num_features_,
+        cost,
+        ws_->GetThreadPool(),
+        [&](int begin, int end) {
+          std::unordered_set<T> seen;
+          for (int f = begin; f < end; ++f) {
+            sizes[f] = ProcessFeature(
+                f, batch_size, ranges_data, ids, indices[f], lengths[f], &seen);
+          }
+        });
+
+    for (int f = 0; f < num_features_; ++f) {
+      Output(2 * f)->Shrink(sizes[f]);
+    }
+    return true;
+  }
+
+ private:
+  // Lists at most this long are deduplicated by scanning the output.
+  static constexpr int kMaxLinearDedupLength = 16;
+
+  template <typename Arg>
+  void ResizeArgument(std::vector<Arg>* arg, const char* name, int value) {
+    if (arg->empty()) {
+      arg->resize(num_features_, value);
+    }
+    CAFFE_ENFORCE_EQ(
+        arg->size(),
+        num_features_,
+        "There should be one value of ",
+        name,
+        " per feature");
+  }
+
+  // Writes the ids of feature f for every example to indices and their
+  // number to lengths, and returns the total number of ids.
+  template <typename Index, typename T>
+  TIndex ProcessFeature(
+      int f,
+      int batch_size,
+      const Index* ranges_data,
+      const T* ids,
+      T* indices,
+      int* lengths,
+      std::unordered_set<T>* seen) {
+    const bool hash = hash_[f];
+    const int64_t seed = seeds_[f];
+    const int64_t modulo = modulos_[f];
+    const bool dedup = dedup_[f];
+    const TIndex max_length =
+        max_lengths_[f] > 0 ? max_lengths_[f] : TIndex(-1);
+    TIndex size = 0;
+    for (int i = 0; i < batch_size; ++i) {
+      const Index* range = ranges_data + (i * num_features_ + f) * 2;
+      const T* list = ids + range[0];
+      const bool linear_dedup = range[1] <= kMaxLinearDedupLength;
+      T* out = indices + size;
+      TIndex length = 0;
+      if (dedup && !linear_dedup) {
+        seen->clear();
+      }
+      for (Index j = 0; j < range[1] && length != max_length; ++j) {
+        T id = list[j];
+        if (hash) {
+          id = IndexHash(id, seed, modulo);
+        } else if (modulo > 0) {
+          id %= modulo;
+          id = id >= 0 ? id : id + modulo;
+        }
+        if (dedup) {
+          if (linear_dedup) {
+            if (std::find(out, out + length, id) != out + length) {
+              continue;
+            }
+          } else if (!seen->insert(id).second) {
+            continue;
+          }
+        }
+        out[length++] = id;
+      }
+      if (length == 0 && default_ids_[f] >= 0) {
+        out[length++] = default_ids_[f];
+      }
+      lengths[i] = length;
+      size += length;
+    }
+    return size;
+  }
+
+  int num_features_;
+  std::vector<int> hash_;
+  std::vector<int64_t> seeds_;
+  std::vector<int64_t> modulos_;
+  std::vector<int> dedup_;
+  std::vector<int> max_lengths_;
+  std::vector<int64_t> default_ids_;
+  Workspace* ws_;
+
+  INPUT_TAGS(DATA, RANGES);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_PREPROCESS_ID_LIST_FEATURES_OP_H_
@@ -322,6 +322,17 @@ struct MaxRangeReducerDef {
 // Incremental reducers: consume elements one by one
 ////////////////////////////////////////////////////////////////////////////////
 
+// Adds the block in to out. Inlined, so that the addition is vectorized
+// without the cost of a call per block.
+template <typename T, int FixedSize>
+inline void AddBlock(const TIndex block_size, const T* in, T* out) {
+  if (FixedSize == 1) { // static if
+    *out += *in;
+  } else {
+    EigenVectorMap<T>(out, block_size) += ConstEigenVectorMap<T>(in, block_size);
+  }
+}
+
 // Base implementation, everything can be overwritten
 class BaseReducer {
  public:
@@ -444,8 +455,7 @@ class SumReducer<T, CPUContext> : public BaseReducer {
       TIndex /*offset*/,
       CPUContext* context) {
     if (meta.first_dim) {
-      math::AxpyFixedSize<T, CPUContext, FixedSize>(
-          meta.block_size, 1, in, out_, context);
+      AddBlock<T, FixedSize>(meta.block_size, in, out_);
     } else {
       math::Sum<T, CPUContext>(
           meta.block_size, in, out_ + current_size_++, context);
@@ -675,8 +685,7 @@ class MeanReducer<T, CPUContext> : public BaseReducer {
       TIndex /*offset*/,
       CPUContext* context) {
     if (meta.first_dim) {
-      math::AxpyFixedSize<T, CPUContext, FixedSize>(
-          meta.block_size, 1, in, out_, context);
+      AddBlock<T, FixedSize>(meta.block_size, in, out_);
     } else {
       math::Sum<T, CPUContext>(
           meta.block_size, in, out_ + current_size_, context);
@@ -33,8 +33,13 @@ class SumElementsOp : public Operator<Context> {
     auto* sum = Output(0);
     sum->Resize(vector<TIndex>());
     T* data = sum->template mutable_data<T>();
+    ScratchArena::Lease scratch(OperatorBase::scratch_arena());
     math::Sum<T, Context>(
-      X.size(), X.template data<T>(), data, &context_, &scratch_);
+        X.size(),
+        X.template data<T>(),
+        data,
+        &context_,
+        scratch.Get(&scratch_));
     if (average_) {
       math::Scale<T, Context>(
           1,
@@ -65,8 +70,13 @@ class SumElementsIntOp : public Operator<Context> {
     auto* sum = Output(0);
     sum->Resize(vector<TIndex>());
     T* data = sum->template mutable_data<T>();
+    ScratchArena::Lease scratch(OperatorBase::scratch_arena());
     math::Sum<T, Context>(
-        X.size(), X.template data<T>(), data, &context_, &scratch_);
+        X.size(),
+        X.template data<T>(),
+        data,
+        &context_,
+        scratch.Get(&scratch_));
     return true;
   }
 
@@ -111,12 +121,13 @@ class SumSqrElementsOp : public Operator<Context> {
     auto& X = Input(0);
     auto* sum = Output(0);
     sum->Resize(vector<TIndex>());
+    ScratchArena::Lease scratch(OperatorBase::scratch_arena());
     math::SumSqr<T, Context>(
         X.size(),
         X.template data<T>(),
         sum->template mutable_data<T>(),
         &context_,
-        &scratch_);
+        scratch.Get(&scratch_));
     if (average) {
       math::Scale<T, Context>(
           1,
@@ -1,5 +1,7 @@
 #include "roi_align_gradient_op.h"
 
+#include <limits>
+
 #include "caffe2/utils/eigen_utils.h"
 #include "caffe2/utils/math.h"
 
@@ -74,6 +76,20 @@ inline void add(const T& val, T* address) {
   *address += val;
 }
 
+// Bilinear interpolation of a sampling point of a roi, as computed by
+// bilinear_interpolate_gradient.
+template <typename T>
+struct BilinearSample {
+  int x_low;
+  int x_high;
+  int y_low;
+  int y_high;
+  T w1;
+  T w2;
+  T w3;
+  T w4;
+};
+
 template <typename T>
 void ROIAlignBackwardFeature(
     const int nthreads,
@@ -88,16 +104,21 @@ void ROIAlignBackwardFeature(
     const int sampling_ratio,
     T* bottom_diff,
     const T* bottom_rois,
-    int rois_cols) {
+    int rois_cols,
+    StorageOrder order,
+    ThreadPool* pool) {
   DCHECK(rois_cols == 4 || rois_cols == 5);
 
-  for (int index = 0; index < nthreads; index++) {
-    // (n, c, ph, pw) is an element in the pooled output
-    int pw = index % pooled_width;
-    int ph = (index / pooled_width) % pooled_height;
-    int c = (index / pooled_width / pooled_height) % channels;
-    int n = index / pooled_width / pooled_height / channels;
-
+  const int n_rois = nthreads / channels / pooled_width / pooled_height;
+  std::vector<int> roi_batch_inds(n_rois);
+  std::vector<int> roi_bin_grids_h(n_rois);
+  std::vector<int> roi_bin_grids_w(n_rois);
+  // Offsets of the sampling points of each roi, counted from the first roi.
+  std::vector<size_t> sample_offsets(n_rois + 1, 0);
+  // The sampling points of the rois of the current chunk.
+  std::vector<BilinearSample<T>> samples;
+  int chunk_begin = 0;
+  auto compute_samples = [&](int n, bool sample) {
     const T* offset_bottom_rois = bottom_rois + n * rois_cols;
     int roi_batch_ind = 0;
     if (rois_cols == 5) {
@@ -110,10 +131,6 @@ void ROIAlignBackwardFeature(
     T roi_start_h = offset_bottom_rois[1] * spatial_scale;
     T roi_end_w = offset_bottom_rois[2] * spatial_scale;
     T roi_end_h = offset_bottom_rois[3] * spatial_scale;
-    // T roi_start_w = round(offset_bottom_rois[0] * spatial_scale);
-    // T roi_start_h = round(offset_bottom_rois[1] * spatial_scale);
-    // T roi_end_w = round(offset_bottom_rois[2] * spatial_scale);
-    // T roi_end_h = round(offset_bottom_rois[3] * spatial_scale);
 
     // Force malformed ROIs to be 1x1
     T roi_width = std::max(roi_end_w - roi_start_w, (T)1.);
@@ -121,13 +138,6 @@ void ROIAlignBackwardFeature(
     T bin_size_h = static_cast<T>(roi_height) / static_cast<T>(pooled_height);
     T bin_size_w = static_cast<T>(roi_width) / static_cast<T>(pooled_width);
 
-    T* offset_bottom_diff =
-        bottom_diff + (roi_batch_ind * channels + c) * height * width;
-
-    int top_offset = (n * channels + c) * pooled_height * pooled_width;
-    const T* offset_top_diff = top_diff + top_offset;
-    const T top_diff_this_bin = offset_top_diff[ph * pooled_width + pw];
-
     // We use roi_bin_grid to sample the grid and mimic integral
     int roi_bin_grid_h = (sampling_ratio > 0)
         ? sampling_ratio
@@ -135,51 +145,158 @@ void ROIAlignBackwardFeature(
     int roi_bin_grid_w =
         (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
 
-    // We do average (integral) pooling inside a bin
-    const T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
-
-    for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-      const T y = roi_start_h + ph * bin_size_h +
-          static_cast<T>(iy + .5f) * bin_size_h /
-              static_cast<T>(roi_bin_grid_h); // e.g., 0.5, 1.5
-      for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-        const T x = roi_start_w + pw * bin_size_w +
-            static_cast<T>(ix + .5f) * bin_size_w /
-                static_cast<T>(roi_bin_grid_w);
-
-        T w1, w2, w3, w4;
-        int x_low, x_high, y_low, y_high;
-
-        bilinear_interpolate_gradient(
-            height,
-            width,
-            y,
-            x,
-            w1,
-            w2,
-            w3,
-            w4,
-            x_low,
-            x_high,
-            y_low,
-            y_high,
-            index);
-
-        T g1 = top_diff_this_bin * w1 / count;
-        T g2 = top_diff_this_bin * w2 / count;
-        T g3 = top_diff_this_bin * w3 / count;
-        T g4 = top_diff_this_bin * w4 / count;
-
-        if (x_low >= 0 && x_high >= 0 && y_low >= 0 && y_high >= 0) {
-          // atomic add is not needed for now since it is single threaded
-          add(static_cast<T>(g1), offset_bottom_diff + y_low * width + x_low);
-          add(static_cast<T>(g2), offset_bottom_diff + y_low * width + x_high);
-          add(static_cast<T>(g3), offset_bottom_diff + y_high * width + x_low);
-          add(static_cast<T>(g4), offset_bottom_diff + y_high * width + x_high);
-        } // if
-      } // ix
-    } // iy
-  } // for
+    if (!sample) {
+      roi_batch_inds[n] = roi_batch_ind;
+      roi_bin_grids_h[n] = roi_bin_grid_h;
+      roi_bin_grids_w[n] = roi_bin_grid_w;
+      return;
+    }
+    BilinearSample<T>* s =
+        samples.data() + (sample_offsets[n] - sample_offsets[chunk_begin]);
+    for (int ph = 0; ph < pooled_height; ph++) {
+      for (int pw = 0; pw < pooled_width; pw++) {
+        for (int iy = 0; iy < roi_bin_grid_h; iy++) {
+          const T y = roi_start_h + ph * bin_size_h +
+              static_cast<T>(iy + .5f) * bin_size_h /
+                  static_cast<T>(roi_bin_grid_h); // e.g., 0.5, 1.5
+          for (int ix = 0; ix < roi_bin_grid_w; ix++) {
+            const T x = roi_start_w + pw * bin_size_w +
+                static_cast<T>(ix + .5f) * bin_size_w /
+                    static_cast<T>(roi_bin_grid_w);
+            bilinear_interpolate_gradient(
+                height,
+                width,
+                y,
+                x,
+                s->w1,
+                s->w2,
+                s->w3,
+                s->w4,
+                s->x_low,
+                s->x_high,
+                s->y_low,
+                s->y_high,
+                0);
+            s++;
+          }
+        }
+      }
+    }
+  };
+
+  // The interpolation of the sampling points is shared by all the channels,
+  // so it is computed once per roi. The points are tabulated for chunks of
+  // rois of about kMaxChunkSamples points at most, which bounds the memory
+  // of the table to a few MB however many rois there are.
+  constexpr size_t kMaxChunkSamples = 1 << 18;
+  for (int n = 0; n < n_rois; n++) {
+    compute_samples(n, false);
+    sample_offsets[n + 1] = sample_offsets[n] +
+        size_t(roi_bin_grids_h[n]) * roi_bin_grids_w[n] * pooled_height *
+            pooled_width;
+  }
+  const int pooled_size = pooled_height * pooled_width;
+  // The gradients of a channel only go to the same channel of bottom_diff,
+  // so the channels are divided between the threads. The rois are visited
+  // in order, so every gradient is summed in the same order. With NHWC, the
+  // channels are split in blocks of contiguous values.
+  const int channel_block = order == StorageOrder::NHWC ? 16 : 1;
+  const int num_channel_blocks = (channels + channel_block - 1) / channel_block;
+  for (int chunk_end; chunk_begin < n_rois; chunk_begin = chunk_end) {
+    chunk_end = chunk_begin + 1;
+    while (chunk_end < n_rois &&
+           sample_offsets[chunk_end + 1] - sample_offsets[chunk_begin] <=
+               kMaxChunkSamples) {
+      chunk_end++;
+    }
+    const size_t chunk_samples =
+        sample_offsets[chunk_end] - sample_offsets[chunk_begin];
+    samples.resize(chunk_samples);
+    math::ParallelFor(
+        chunk_end - chunk_begin,
+        pooled_size * 4,
+        pool,
+        [&](int begin, int end) {
+          for (int n = chunk_begin + begin; n < chunk_begin + end; n++) {
+            compute_samples(n, true);
+          }
+        });
+
+    math::ParallelFor(
+        num_channel_blocks,
+        std::min<size_t>(
+            chunk_samples * channel_block, std::numeric_limits<int>::max()),
+        pool,
+        [&](int block_begin, int block_end) {
+          const int c_begin = block_begin * channel_block;
+          const int c_end = std::min(block_end * channel_block, channels);
+          for (int n = chunk_begin; n < chunk_end; n++) {
+            // We do average (integral) pooling inside a bin
+            const int roi_bin_grid = roi_bin_grids_h[n] * roi_bin_grids_w[n];
+            const T count = roi_bin_grid; // e.g. = 4
+            const BilinearSample<T>* roi_samples = samples.data() +
+                (sample_offsets[n] - sample_offsets[chunk_begin]);
+
+            if (order == StorageOrder::NCHW) {
+              for (int c = c_begin; c < c_end; c++) {
+                T* offset_bottom_diff = bottom_diff +
+                    (roi_batch_inds[n] * channels + c) * height * width;
+                const T* offset_top_diff =
+                    top_diff + (n * channels + c) * pooled_size;
+                const BilinearSample<T>* s = roi_samples;
+                for (int bin = 0; bin < pooled_size; bin++) {
+                  const T top_diff_this_bin = offset_top_diff[bin];
+                  for (int i = 0; i < roi_bin_grid; i++, s++) {
+                    T g1 = top_diff_this_bin * s->w1 / count;
+                    T g2 = top_diff_this_bin * s->w2 / count;
+                    T g3 = top_diff_this_bin * s->w3 / count;
+                    T g4 = top_diff_this_bin * s->w4 / count;
+
+                    if (s->x_low >= 0 && s->x_high >= 0 && s->y_low >= 0 &&
+                        s->y_high >= 0) {
+                      add(g1, offset_bottom_diff + s->y_low * width + s->x_low);
+                      add(g2,
+                          offset_bottom_diff + s->y_low * width + s->x_high);
+                      add(g3,
+                          offset_bottom_diff + s->y_high * width + s->x_low);
+                      add(g4,
+                          offset_bottom_diff + s->y_high * width + s->x_high);
+                    } // if
+                  }
+                }
+              }
+            } else {
+              T* offset_bottom_diff =
+                  bottom_diff + roi_batch_inds[n] * height * width * channels;
+              const T* offset_top_diff = top_diff + n * pooled_size * channels;
+              const BilinearSample<T>* s = roi_samples;
+              for (int bin = 0; bin < pooled_size; bin++) {
+                const T* top_diff_this_bin = offset_top_diff + bin * channels;
+                for (int i = 0; i < roi_bin_grid; i++, s++) {
+                  if (s->x_low < 0 || s->x_high < 0 || s->y_low < 0 ||
+                      s->y_high < 0) {
+                    continue;
+                  }
+                  T* diff1 = offset_bottom_diff +
+                      (s->y_low * width + s->x_low) * channels;
+                  T* diff2 = offset_bottom_diff +
+                      (s->y_low * width + s->x_high) * channels;
+                  T* diff3 = offset_bottom_diff +
+                      (s->y_high * width + s->x_low) * channels;
+                  T* diff4 = offset_bottom_diff +
+                      (s->y_high * width + s->x_high) * channels;
+                  for (int c = c_begin; c < c_end; c++) {
+                    diff1[c] += top_diff_this_bin[c] * s->w1 / count;
+                    diff2[c] += top_diff_this_bin[c] * s->w2 / count;
+                    diff3[c] += top_diff_this_bin[c] * s->w3 / count;
+                    diff4[c] += top_diff_this_bin[c] * s->w4 / count;
+                  }
+                }
+              }
+            }
+          }
+        });
+  }
 } // ROIAlignBackward
 
 } // namespace
@@ -197,6 +314,20 @@ bool RoIAlignGradientOp<float, CPUContext>::RunOnDevice() {
   // if R has 5 columns, the first column is the index, otherwise 0
   CAFFE_ENFORCE(R.dim32(1) == 4 || R.dim32(1) == 5);
 
+  const int channels = order_ == StorageOrder::NCHW ? X.dim32(1) : X.dim32(3);
+  const int height = order_ == StorageOrder::NCHW ? X.dim32(2) : X.dim32(1);
+  const int width = order_ == StorageOrder::NCHW ? X.dim32(3) : X.dim32(2);
+  if (R.dim32(1) == 5) {
+    const float* rois = R.data<float>();
+    for (int n = 0; n < R.dim32(0); ++n) {
+      const int roi_batch_ind = rois[n * 5];
+      CAFFE_ENFORCE(
+          0 <= roi_batch_ind && roi_batch_ind < X.dim32(0),
+          "RoI batch index out of range: ",
+          roi_batch_ind);
+    }
+  }
+
   dX->ResizeLike(X);
 
   // Must zero-out dX before accumulating gradients
@@ -210,15 +341,17 @@ bool RoIAlignGradientOp<float, CPUContext>::RunOnDevice() {
         dY.data<float>(),
         R.dim32(0),
         spatial_scale_,
-        X.dim32(1),
-        X.dim32(2),
-        X.dim32(3),
+        channels,
+        height,
+        width,
         pooled_height_,
         pooled_width_,
         sampling_ratio_,
         dX->mutable_data<float>(),
         R.data<float>(),
-        R.dim32(1));
+        R.dim32(1),
+        order_,
+        ws_->GetThreadPool());
   }
   return true;
 }
@@ -230,6 +363,7 @@ REGISTER_CPU_OPERATOR(RoIAlignGradient, RoIAlignGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(RoIAlignGradient)
     .NumInputs(3)
     .NumOutputs(1)
+    .Arg("order", "A StorageOrder string (Default: \"NCHW\").")
     .Input(0, "X", "See RoIPoolF.")
     .Input(1, "RoIs", "See RoIPoolF.")
     .Input(2, "dY", "Gradient of forward output 0 (Y)")
@@ -195,6 +195,8 @@ bool RoIAlignGradientOp<float, CUDAContext>::RunOnDevice() {
                        // (aka "gradOutput")
   auto* dX = Output(0); // Gradient of net w.r.t. input to "forward" op
                         // (aka "gradInput")
+  CAFFE_ENFORCE_EQ(
+      order_, StorageOrder::NCHW, "Only NCHW order is supported on CUDA.");
 
   dX->ResizeLike(X);
 
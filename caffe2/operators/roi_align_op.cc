@@ -118,9 +118,10 @@ void pre_calc_for_bilinear_interpolate(
   }
 }
 
+// Pools the n-th roi, with pre_calc_buffer holding its interpolation table.
 template <typename T>
-void ROIAlignForward(
-    const int nthreads,
+void ROIAlignForwardRoI(
+    const int n,
     const T* bottom_data,
     const T& spatial_scale,
     const int channels,
@@ -132,138 +133,176 @@ void ROIAlignForward(
     const T* bottom_rois,
     int roi_cols,
     T* top_data,
-    StorageOrder order) {
-  DCHECK(roi_cols == 4 || roi_cols == 5);
-
-  int n_rois = nthreads / channels / pooled_width / pooled_height;
-  // (n, c, ph, pw) is an element in the pooled output
-  // can be parallelized using omp
-  // #pragma omp parallel for num_threads(32)
-  for (int n = 0; n < n_rois; n++) {
-    int index_n = n * channels * pooled_width * pooled_height;
-
-    // roi could have 4 or 5 columns
-    const T* offset_bottom_rois = bottom_rois + n * roi_cols;
-    int roi_batch_ind = 0;
-    if (roi_cols == 5) {
-      roi_batch_ind = offset_bottom_rois[0];
-      offset_bottom_rois++;
-    }
-
-    // Do not using rounding; this implementation detail is critical
-    T roi_start_w = offset_bottom_rois[0] * spatial_scale;
-    T roi_start_h = offset_bottom_rois[1] * spatial_scale;
-    T roi_end_w = offset_bottom_rois[2] * spatial_scale;
-    T roi_end_h = offset_bottom_rois[3] * spatial_scale;
-    // T roi_start_w = round(offset_bottom_rois[0] * spatial_scale);
-    // T roi_start_h = round(offset_bottom_rois[1] * spatial_scale);
-    // T roi_end_w = round(offset_bottom_rois[2] * spatial_scale);
-    // T roi_end_h = round(offset_bottom_rois[3] * spatial_scale);
-
-    // Force malformed ROIs to be 1x1
-    T roi_width = std::max(roi_end_w - roi_start_w, (T)1.);
-    T roi_height = std::max(roi_end_h - roi_start_h, (T)1.);
-    T bin_size_h = static_cast<T>(roi_height) / static_cast<T>(pooled_height);
-    T bin_size_w = static_cast<T>(roi_width) / static_cast<T>(pooled_width);
-
-    // We use roi_bin_grid to sample the grid and mimic integral
-    int roi_bin_grid_h = (sampling_ratio > 0)
-        ? sampling_ratio
-        : ceil(roi_height / pooled_height); // e.g., = 2
-    int roi_bin_grid_w =
-        (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
-
-    // We do average (integral) pooling inside a bin
-    const T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
-
-    // we want to precalculate indeces and weights shared by all chanels,
-    // this is the key point of optimiation
-    std::vector<PreCalc<T>> pre_calc(
-        roi_bin_grid_h * roi_bin_grid_w * pooled_width * pooled_height);
-    pre_calc_for_bilinear_interpolate(
-        height,
-        width,
-        pooled_height,
-        pooled_width,
-        roi_bin_grid_h,
-        roi_bin_grid_w,
-        roi_start_h,
-        roi_start_w,
-        bin_size_h,
-        bin_size_w,
-        roi_bin_grid_h,
-        roi_bin_grid_w,
-        pre_calc);
-
-    if (order == StorageOrder::NCHW) {
-      for (int c = 0; c < channels; c++) {
-        int index_n_c = index_n + c * pooled_width * pooled_height;
-        const T* offset_bottom_data =
-            bottom_data + (roi_batch_ind * channels + c) * height * width;
-        int pre_calc_index = 0;
-
-        for (int ph = 0; ph < pooled_height; ph++) {
-          for (int pw = 0; pw < pooled_width; pw++) {
-            int index = index_n_c + ph * pooled_width + pw;
-
-            T output_val = 0.;
-            for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-              for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-                PreCalc<T> pc = pre_calc[pre_calc_index];
-                output_val += pc.w1 * offset_bottom_data[pc.pos1] +
-                    pc.w2 * offset_bottom_data[pc.pos2] +
-                    pc.w3 * offset_bottom_data[pc.pos3] +
-                    pc.w4 * offset_bottom_data[pc.pos4];
-
-                pre_calc_index += 1;
-              }
-            }
-            output_val /= count;
-
-            top_data[index] = output_val;
-          } // for pw
-        } // for ph
-      } // for c
-    } // if nchw
+    StorageOrder order,
+    std::vector<PreCalc<T>>* pre_calc_buffer) {
+  int index_n = n * channels * pooled_width * pooled_height;
+
+  // roi could have 4 or 5 columns
+  const T* offset_bottom_rois = bottom_rois + n * roi_cols;
+  int roi_batch_ind = 0;
+  if (roi_cols == 5) {
+    roi_batch_ind = offset_bottom_rois[0];
+    offset_bottom_rois++;
+  }
 
-    if (order == StorageOrder::NHWC) {
+  // Do not using rounding; this implementation detail is critical
+  T roi_start_w = offset_bottom_rois[0] * spatial_scale;
+  T roi_start_h = offset_bottom_rois[1] * spatial_scale;
+  T roi_end_w = offset_bottom_rois[2] * spatial_scale;
+  T roi_end_h = offset_bottom_rois[3] * spatial_scale;
+  // T roi_start_w = round(offset_bottom_rois[0] * spatial_scale);
+  // T roi_start_h = round(offset_bottom_rois[1] * spatial_scale);
+  // T roi_end_w = round(offset_bottom_rois[2] * spatial_scale);
+  // T roi_end_h = round(offset_bottom_rois[3] * spatial_scale);
+
+  // Force malformed ROIs to be 1x1
+  T roi_width = std::max(roi_end_w - roi_start_w, (T)1.);
+  T roi_height = std::max(roi_end_h - roi_start_h, (T)1.);
+  T bin_size_h = static_cast<T>(roi_height) / static_cast<T>(pooled_height);
+  T bin_size_w = static_cast<T>(roi_width) / static_cast<T>(pooled_width);
+
+  // We use roi_bin_grid to sample the grid and mimic integral
+  int roi_bin_grid_h = (sampling_ratio > 0)
+      ? sampling_ratio
+      : ceil(roi_height / pooled_height); // e.g., = 2
+  int roi_bin_grid_w =
+      (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
+
+  // We do average (integral) pooling inside a bin
+  const T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
+
+  // we want to precalculate indeces and weights shared by all chanels,
+  // this is the key point of optimiation
+  std::vector<PreCalc<T>>& pre_calc = *pre_calc_buffer;
+  pre_calc.resize(
+      roi_bin_grid_h * roi_bin_grid_w * pooled_width * pooled_height);
+  pre_calc_for_bilinear_interpolate(
+      height,
+      width,
+      pooled_height,
+      pooled_width,
+      roi_bin_grid_h,
+      roi_bin_grid_w,
+      roi_start_h,
+      roi_start_w,
+      bin_size_h,
+      bin_size_w,
+      roi_bin_grid_h,
+      roi_bin_grid_w,
+      pre_calc);
+
+  if (order == StorageOrder::NCHW) {
+    for (int c = 0; c < channels; c++) {
+      int index_n_c = index_n + c * pooled_width * pooled_height;
       const T* offset_bottom_data =
-          bottom_data + roi_batch_ind * channels * height * width;
+          bottom_data + (roi_batch_ind * channels + c) * height * width;
       int pre_calc_index = 0;
 
       for (int ph = 0; ph < pooled_height; ph++) {
         for (int pw = 0; pw < pooled_width; pw++) {
-          EVecXf output_vals = EVecXf::Zero(channels);
+          int index = index_n_c + ph * pooled_width + pw;
 
+          T output_val = 0.;
           for (int iy = 0; iy < roi_bin_grid_h; iy++) {
             for (int ix = 0; ix < roi_bin_grid_w; ix++) {
               PreCalc<T> pc = pre_calc[pre_calc_index];
-
-              ConstEigenVectorMap<T> data_1(
-                  offset_bottom_data + channels * pc.pos1, channels);
-              ConstEigenVectorMap<T> data_2(
-                  offset_bottom_data + channels * pc.pos2, channels);
-              ConstEigenVectorMap<T> data_3(
-                  offset_bottom_data + channels * pc.pos3, channels);
-              ConstEigenVectorMap<T> data_4(
-                  offset_bottom_data + channels * pc.pos4, channels);
-
-              output_vals += pc.w1 * data_1 + pc.w2 * data_2 + pc.w3 * data_3 +
-                  pc.w4 * data_4;
+              output_val += pc.w1 * offset_bottom_data[pc.pos1] +
+                  pc.w2 * offset_bottom_data[pc.pos2] +
+                  pc.w3 * offset_bottom_data[pc.pos3] +
+                  pc.w4 * offset_bottom_data[pc.pos4];
 
               pre_calc_index += 1;
             }
           }
-          output_vals /= count;
+          output_val /= count;
 
-          int index_nhw = index_n + (ph * pooled_width + pw) * channels;
-          std::memcpy(
-              top_data + index_nhw, output_vals.data(), channels * sizeof(T));
+          top_data[index] = output_val;
         } // for pw
       } // for ph
-    } // if nhwc
+    } // for c
+  } // if nchw
+
+  if (order == StorageOrder::NHWC) {
+    const T* offset_bottom_data =
+        bottom_data + roi_batch_ind * channels * height * width;
+    int pre_calc_index = 0;
+
+    for (int ph = 0; ph < pooled_height; ph++) {
+      for (int pw = 0; pw < pooled_width; pw++) {
+        int index_nhw = index_n + (ph * pooled_width + pw) * channels;
+        EigenVectorMap<T> output_vals(top_data + index_nhw, channels);
+        output_vals.setZero();
+
+        for (int iy = 0; iy < roi_bin_grid_h; iy++) {
+          for (int ix = 0; ix < roi_bin_grid_w; ix++) {
+            PreCalc<T> pc = pre_calc[pre_calc_index];
+
+            ConstEigenVectorMap<T> data_1(
+                offset_bottom_data + channels * pc.pos1, channels);
+            ConstEigenVectorMap<T> data_2(
+                offset_bottom_data + channels * pc.pos2, channels);
+            ConstEigenVectorMap<T> data_3(
+                offset_bottom_data + channels * pc.pos3, channels);
+            ConstEigenVectorMap<T> data_4(
+                offset_bottom_data + channels * pc.pos4, channels);
+
+            output_vals += pc.w1 * data_1 + pc.w2 * data_2 + pc.w3 * data_3 +
+                pc.w4 * data_4;
 
-  } // for n
+            pre_calc_index += 1;
+          }
+        }
+        output_vals /= count;
+      } // for pw
+    } // for ph
+  } // if nhwc
+}
+
+template <typename T>
+void ROIAlignForward(
+    const int nthreads,
+    const T* bottom_data,
+    const T& spatial_scale,
+    const int channels,
+    const int height,
+    const int width,
+    const int pooled_height,
+    const int pooled_width,
+    const int sampling_ratio,
+    const T* bottom_rois,
+    int roi_cols,
+    T* top_data,
+    StorageOrder order,
+    ThreadPool* pool) {
+  DCHECK(roi_cols == 4 || roi_cols == 5);
+
+  int n_rois = nthreads / channels / pooled_width / pooled_height;
+  // (n, c, ph, pw) is an element in the pooled output
+  // The rois write disjoint outputs and are pooled in parallel.
+  math::ParallelFor(
+      n_rois,
+      channels * pooled_width * pooled_height,
+      pool,
+      [&](int begin, int end) {
+        std::vector<PreCalc<T>> pre_calc;
+        for (int n = begin; n < end; n++) {
+          ROIAlignForwardRoI(
+              n,
+              bottom_data,
+              spatial_scale,
+              channels,
+              height,
+              width,
+              pooled_height,
+              pooled_width,
+              sampling_ratio,
+              bottom_rois,
+              roi_cols,
+              top_data,
+              order,
+              &pre_calc);
+        }
+      });
 }
 
 } // namespace
@@ -292,6 +331,18 @@ bool RoIAlignOp<float, CPUContext>::RunOnDevice() {
 
   assert(sampling_ratio_ >= 0);
 
+  // The rois are pooled in parallel, their batch indices are checked first
+  if (R.dim32(1) == 5) {
+    const float* rois = R.data<float>();
+    for (int n = 0; n < R.dim32(0); ++n) {
+      const int roi_batch_ind = rois[n * 5];
+      CAFFE_ENFORCE(
+          0 <= roi_batch_ind && roi_batch_ind < X.dim32(0),
+          "RoI batch index out of range: ",
+          roi_batch_ind);
+    }
+  }
+
   if (order_ == StorageOrder::NCHW) {
     Y->Resize(R.dim32(0), X.dim32(1), pooled_height_, pooled_width_);
     int output_size = Y->size();
@@ -308,7 +359,8 @@ bool RoIAlignOp<float, CPUContext>::RunOnDevice() {
         R.data<float>(),
         R.dim32(1),
         Y->mutable_data<float>(),
-        order_);
+        order_,
+        ws_->GetThreadPool());
   } else if (order_ == StorageOrder::NHWC) {
     Y->Resize(R.dim32(0), pooled_height_, pooled_width_, X.dim32(3));
     int output_size = Y->size();
@@ -325,7 +377,8 @@ bool RoIAlignOp<float, CPUContext>::RunOnDevice() {
         R.data<float>(),
         R.dim32(1),
         Y->mutable_data<float>(),
-        order_);
+        order_,
+        ws_->GetThreadPool());
   }
 
   return true;
@@ -351,6 +404,9 @@ Region of Interest (RoI) align operation as used in Mask R-CNN.
         "(float) default 1.0; Spatial scale of the input feature map X "
         "relative to the input image. E.g., 0.0625 if X has a stride of 16 "
         "w.r.t. the input image.")
+    .Arg(
+        "order",
+        "(string) default \"NCHW\"; the order of X and Y, NCHW or NHWC.")
     .Arg("pooled_h", "(int) default 1; Pooled output Y's height.")
     .Arg("pooled_w", "(int) default 1; Pooled output Y's width.")
     .Arg(
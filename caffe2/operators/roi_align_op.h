@@ -21,7 +21,8 @@ class RoIAlignOp final : public Operator<Context> {
         pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
         pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
         sampling_ratio_(
-            OperatorBase::GetSingleArgument<int>("sampling_ratio", -1)) {
+            OperatorBase::GetSingleArgument<int>("sampling_ratio", -1)),
+        ws_(ws) {
     DCHECK_GT(spatial_scale_, 0);
     DCHECK_GT(pooled_height_, 0);
     DCHECK_GT(pooled_width_, 0);
@@ -40,6 +41,7 @@ class RoIAlignOp final : public Operator<Context> {
   int pooled_height_;
   int pooled_width_;
   int sampling_ratio_;
+  Workspace* ws_;
 };
 
 } // namespace caffe2
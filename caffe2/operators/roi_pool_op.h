@@ -19,7 +19,8 @@ class RoIPoolOp final : public Operator<Context> {
         pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
         pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
         spatial_scale_(
-            OperatorBase::GetSingleArgument<float>("spatial_scale", 1.)) {
+            OperatorBase::GetSingleArgument<float>("spatial_scale", 1.)),
+        ws_(ws) {
     CAFFE_ENFORCE(
         (is_test_ && OutputSize() == 1) || (!is_test_ && OutputSize() == 2),
         "Output size mismatch.");
@@ -34,11 +35,20 @@ class RoIPoolOp final : public Operator<Context> {
   bool RunOnDevice() override;
 
  protected:
+  // Max pools the roi [batch_index x1 y1 x2 y2] to the channels * pooled_h *
+  // pooled_w values of Ydata, and their indices in argmax_data when not null.
+  void PoolRoI(
+      const Tensor<Context>& X,
+      const T* rois,
+      T* Ydata,
+      int* argmax_data) const;
+
   bool is_test_;
   StorageOrder order_;
   int pooled_height_;
   int pooled_width_;
   float spatial_scale_;
+  Workspace* ws_;
 };
 
 template <typename T, class Context>
@@ -51,7 +61,8 @@ class RoIPoolGradientOp final : public Operator<Context> {
         pooled_height_(OperatorBase::GetSingleArgument<int>("pooled_h", 1)),
         pooled_width_(OperatorBase::GetSingleArgument<int>("pooled_w", 1)),
         order_(StringToStorageOrder(
-            OperatorBase::GetSingleArgument<string>("order", "NCHW"))) {
+            OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
+        ws_(ws) {
     CAFFE_ENFORCE_GT(spatial_scale_, 0);
     CAFFE_ENFORCE_GT(pooled_height_, 0);
     CAFFE_ENFORCE_GT(pooled_width_, 0);
@@ -60,15 +71,14 @@ class RoIPoolGradientOp final : public Operator<Context> {
   }
   USE_OPERATOR_CONTEXT_FUNCTIONS;
 
-  bool RunOnDevice() override {
-    CAFFE_NOT_IMPLEMENTED;
-  }
+  bool RunOnDevice() override;
 
  protected:
   float spatial_scale_;
   int pooled_height_;
   int pooled_width_;
   StorageOrder order_;
+  Workspace* ws_;
 };
 
 } // namespace caffe2
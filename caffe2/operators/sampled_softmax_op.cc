@@ -0,0 +1,511 @@
+#include "caffe2/operators/sampled_softmax_op.h"
+
+#include <limits>
+#include <unordered_set>
+
+namespace caffe2 {
+
+namespace {
+
+// The sampled classes are multiplied by blocks of this many classes, and the
+// examples by blocks of this many examples.
+constexpr int kBlockSize = 64;
+
+// Copies the rows of W of the sampled classes to sampled_weights.
+void GatherSampledWeights(
+    const TensorCPU& W,
+    const int* sampled,
+    int num_sampled,
+    TensorCPU* sampled_weights,
+    ThreadPool* pool) {
+  const int K = W.dim32(1);
+  sampled_weights->Resize(num_sampled, K);
+  math::GatherRowsCPU(
+      1,
+      num_sampled,
+      K * sizeof(float),
+      sampled,
+      reinterpret_cast<const char*>(W.data<float>()),
+      0,
+      reinterpret_cast<char*>(sampled_weights->mutable_data<float>()),
+      pool);
+}
+
+// Repeated classes are rejected while the classes to draw are at most this
+// share of all the classes. Beyond it, rejecting costs more draws than there
+// are classes, and more and more of them as num_sampled approaches N.
+constexpr int kMaxRejectionShare = 4;
+
+// The number of draws from the log-uniform distribution over N classes after
+// which num_sampled distinct classes are expected. The expected number of
+// distinct classes is concave in the number of draws and at most num_sampled
+// after num_sampled draws, so Newton's method converges from below.
+double ExpectedNumTries(int N, int num_sampled) {
+  LogUniformSampler sampler(N);
+  // log of the probability that a draw misses class k
+  std::vector<double> log_miss(N);
+  for (int k = 0; k < N; ++k) {
+    log_miss[k] = std::log1p(-sampler.Probability(k));
+  }
+  double num_tries = num_sampled;
+  for (int iter = 0; iter < 100; ++iter) {
+    double expected = 0;
+    double slope = 0;
+    for (int k = 0; k < N; ++k) {
+      const double q = std::exp(num_tries * log_miss[k]);
+      expected += 1 - q;
+      slope -= log_miss[k] * q;
+    }
+    const double step = (num_sampled - expected) / slope;
+    if (!(step > 1e-6 * num_tries)) {
+      break;
+    }
+    num_tries += step;
+  }
+  return num_tries;
+}
+
+} // namespace
+
+bool LogUniformSamplingOp::RunOnDevice() {
+  auto* indices = Output(0);
+  auto num_samples = num_samples_;
+  if (InputSize() == 1) {
+    CAFFE_ENFORCE(
+        !OperatorBase::HasArgument("num_samples"),
+        "New shape is specified by the input blob, do not pass in "
+        "the argument `num_samples`.");
+    num_samples = Input(0).size();
+    indices->ResizeLike(Input(0));
+  } else {
+    indices->Resize(num_samples);
+  }
+
+  int* indices_data = indices->mutable_data<int>();
+  std::vector<float> uniforms(num_samples);
+  math::RandUniform<float, CPUContext>(
+      num_samples, 0.0f, 1.0f, uniforms.data(), &context_);
+  for (int i = 0; i < num_samples; ++i) {
+    indices_data[i] = sampler_.Sample(uniforms[i]);
+  }
+  return true;
+}
+
+double SampledSoftmaxOp::SampleClasses(int N, int* sampled) {
+  LogUniformSampler sampler(N);
+  if (int64_t(num_sampled_) * kMaxRejectionShare > N) {
+    // The num_sampled_ classes with the largest log(u) / P(k), for u drawn
+    // uniformly for every class, are distributed as num_sampled_ distinct
+    // draws (Efraimidis and Spirakis).
+    std::vector<float> uniforms(N);
+    math::RandUniform<float, CPUContext>(
+        N, 0.0f, 1.0f, uniforms.data(), &context_);
+    std::vector<double> keys(N);
+    std::vector<int> classes(N);
+    for (int k = 0; k < N; ++k) {
+      keys[k] = std::log(uniforms[k]) / sampler.Probability(k);
+      classes[k] = k;
+    }
+    std::nth_element(
+        classes.begin(),
+        classes.begin() + num_sampled_,
+        classes.end(),
+        [&keys](int a, int b) { return keys[a] > keys[b]; });
+    std::copy(classes.begin(), classes.begin() + num_sampled_, sampled);
+    return subtract_log_q_ ? ExpectedNumTries(N, num_sampled_) : 0;
+  }
+
+  std::unordered_set<int> seen;
+  std::vector<float> uniforms;
+  int64_t num_tries = 0;
+  int num = 0;
+  // Every draw adds at most one class, so there are never too many.
+  while (num < num_sampled_) {
+    uniforms.resize(num_sampled_ - num);
+    math::RandUniform<float, CPUContext>(
+        uniforms.size(), 0.0f, 1.0f, uniforms.data(), &context_);
+    for (float u : uniforms) {
+      const int k = sampler.Sample(u);
+      if (seen.insert(k).second) {
+        sampled[num++] = k;
+      }
+    }
+    num_tries += uniforms.size();
+  }
+  return num_tries;
+}
+
+bool SampledSoftmaxOp::RunOnDevice() {
+  auto& X = Input(INPUT);
+  auto& W = Input(WEIGHTS);
+  auto& b = Input(BIAS);
+  auto& labels = Input(LABELS);
+  auto* Y = Output(LOSS);
+  auto* candidates = Output(CANDIDATES);
+  auto* probabilities = Output(PROBABILITIES);
+
+  // Batch size
+  const int M = X.ndim() > 1 ? X.dim32(0) : 1;
+  // Input feature dimension
+  const int K = X.ndim() > 1 ? X.size_from_dim(1) : X.size();
+  CAFFE_ENFORCE_EQ(W.ndim(), 2, "W should be a matrix");
+  CAFFE_ENFORCE_EQ(W.dim32(1), K, "feature dimension mismatch.");
+  const int N = W.dim32(0);
+  CAFFE_ENFORCE_EQ(b.ndim(), 1, "Bias must be a vector.");
+  CAFFE_ENFORCE_EQ(b.dim32(0), N, "mismatch between Weight and Bias.");
+  CAFFE_ENFORCE_EQ(labels.size(), M, "There should be one label per example");
+  CAFFE_ENFORCE_LT(
+      num_sampled_,
+      N,
+      "num_sampled should be less than the number of classes");
+  const int S = num_sampled_;
+
+  const int* labels_data = labels.data<int>();
+  for (int i = 0; i < M; ++i) {
+    CAFFE_ENFORCE(
+        0 <= labels_data[i] && labels_data[i] < N,
+        "Label ",
+        labels_data[i],
+        " is out of the ",
+        N,
+        " classes");
+  }
+
+  candidates->Resize(M + S);
+  int* candidates_data = candidates->mutable_data<int>();
+  std::copy(labels_data, labels_data + M, candidates_data);
+  const int* sampled = candidates_data + M;
+  const double num_tries = SampleClasses(N, candidates_data + M);
+
+  // The log of the expected number of times each candidate is drawn, the
+  // correction that makes the sampled softmax unbiased.
+  std::vector<float> log_q(M + S, 0.f);
+  if (subtract_log_q_) {
+    LogUniformSampler sampler(N);
+    for (int i = 0; i < M + S; ++i) {
+      const double p = sampler.Probability(candidates_data[i]);
+      log_q[i] = std::log(-std::expm1(num_tries * std::log1p(-p)));
+    }
+  }
+
+  auto* pool = ws_->GetThreadPool();
+  GatherSampledWeights(W, sampled, S, &sampled_weights_, pool);
+  const float* Xdata = X.data<float>();
+  const float* Wdata = W.data<float>();
+  const float* bdata = b.data<float>();
+  const float* sampled_weights_data = sampled_weights_.data<float>();
+
+  probabilities->Resize(M, S + 1);
+  float* P = probabilities->mutable_data<float>();
+  // The logits of the sampled classes, which follow the true class in each
+  // row of P.
+  const int num_blocks = (S + kBlockSize - 1) / kBlockSize;
+  math::ParallelFor(
+      num_blocks,
+      std::min<TIndex>(
+          TIndex(M) * K * kBlockSize, std::numeric_limits<int>::max()),
+      pool,
+      [&](int begin, int end) {
+        CPUContext context;
+        for (int block = begin; block < end; ++block) {
+          const int s = block * kBlockSize;
+          math::GemmEx<float, CPUContext>(
+              CblasNoTrans,
+              CblasTrans,
+              M,
+              std::min(kBlockSize, S - s),
+              K,
+              1,
+              Xdata,
+              K,
+              sampled_weights_data + s * K,
+              K,
+              0,
+              P + 1 + s,
+              S + 1,
+              &context);
+        }
+      });
+
+  Y->Resize(M);
+  float* Ydata = Y->mutable_data<float>();
+  math::ParallelFor(
+      M,
+      std::min<TIndex>(K + 4 * (S + 1), std::numeric_limits<int>::max()),
+      pool,
+      [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          float* row = P + i * (S + 1);
+          const int label = labels_data[i];
+          const float logit =
+              ConstEigenVectorMap<float>(Xdata + i * K, K)
+                  .dot(ConstEigenVectorMap<float>(Wdata + label * K, K)) +
+              bdata[label] - log_q[i];
+          row[0] = logit;
+          float max_logit = logit;
+          for (int j = 1; j <= S; ++j) {
+            const int c = sampled[j - 1];
+            if (remove_accidental_hits_ && c == label) {
+              row[j] = -std::numeric_limits<float>::infinity();
+            } else {
+              row[j] += bdata[c] - log_q[M + j - 1];
+              max_logit = std::max(max_logit, row[j]);
+            }
+          }
+          float sum = 0;
+          for (int j = 0; j <= S; ++j) {
+            row[j] = std::exp(row[j] - max_logit);
+            sum += row[j];
+          }
+          for (int j = 0; j <= S; ++j) {
+            row[j] /= sum;
+          }
+          Ydata[i] = std::log(sum) - (logit - max_logit);
+        }
+      });
+  return true;
+}
+
+bool SampledSoftmaxGradientOp::RunOnDevice() {
+  auto& X = Input(INPUT);
+  auto& W = Input(WEIGHTS);
+  auto& candidates = Input(CANDIDATES);
+  auto& probabilities = Input(PROBABILITIES);
+  auto& dY = Input(LOSS_GRAD);
+  auto* dX = Output(INPUT_GRAD);
+  auto* dW = Output(WEIGHTS_GRAD_VALUES);
+  auto* db = Output(BIAS_GRAD_VALUES);
+
+  CAFFE_ENFORCE_EQ(probabilities.ndim(), 2);
+  const int M = probabilities.dim32(0);
+  const int S = probabilities.dim32(1) - 1;
+  CAFFE_ENFORCE_EQ(W.ndim(), 2, "W should be a matrix");
+  const int N = W.dim32(0);
+  const int K = W.dim32(1);
+  CAFFE_ENFORCE_EQ(X.size(), TIndex(M) * K);
+  CAFFE_ENFORCE_EQ(dY.size(), M);
+  CAFFE_ENFORCE_EQ(candidates.size(), M + S);
+  const int* candidates_data = candidates.data<int>();
+  for (int i = 0; i < M + S; ++i) {
+    CAFFE_ENFORCE(
+        0 <= candidates_data[i] && candidates_data[i] < N,
+        "Candidate ",
+        candidates_data[i],
+        " is out of the ",
+        N,
+        " classes");
+  }
+  const int* sampled = candidates_data + M;
+
+  auto* pool = ws_->GetThreadPool();
+  GatherSampledWeights(W, sampled, S, &sampled_weights_, pool);
+  const float* Xdata = X.data<float>();
+  const float* Wdata = W.data<float>();
+  const float* P = probabilities.data<float>();
+  const float* dYdata = dY.data<float>();
+  const float* sampled_weights_data = sampled_weights_.data<float>();
+
+  dX->ResizeLike(X);
+  dW->Resize(M + S, K);
+  db->Resize(M + S);
+  float* dXdata = dX->mutable_data<float>();
+  float* dWdata = dW->mutable_data<float>();
+  float* dbdata = db->mutable_data<float>();
+  logits_grad_.Resize(M, S + 1);
+  float* G = logits_grad_.mutable_data<float>();
+
+  // The gradients of the logits, and the gradients of X and of the rows of the
+  // labels, by blocks of examples.
+  const int num_example_blocks = (M + kBlockSize - 1) / kBlockSize;
+  math::ParallelFor(
+      num_example_blocks,
+      std::min<TIndex>(
+          TIndex(S) * K * kBlockSize, std::numeric_limits<int>::max()),
+      pool,
+      [&](int begin, int end) {
+        CPUContext context;
+        for (int block = begin; block < end; ++block) {
+          const int first = block * kBlockSize;
+          const int last = std::min(first + kBlockSize, M);
+          for (int i = first; i < last; ++i) {
+            for (int j = 0; j <= S; ++j) {
+              G[i * (S + 1) + j] = dYdata[i] * P[i * (S + 1) + j];
+            }
+            G[i * (S + 1)] -= dYdata[i];
+          }
+          math::GemmEx<float, CPUContext>(
+              CblasNoTrans,
+              CblasNoTrans,
+              last - first,
+              K,
+              S,
+              1,
+              G + first * (S + 1) + 1,
+              S + 1,
+              sampled_weights_data,
+              K,
+              0,
+              dXdata + first * K,
+              K,
+              &context);
+          for (int i = first; i < last; ++i) {
+            const float g = G[i * (S + 1)];
+            const float* label_weights = Wdata + candidates_data[i] * K;
+            EigenVectorMap<float>(dXdata + i * K, K) +=
+                g * ConstEigenVectorMap<float>(label_weights, K);
+            EigenVectorMap<float>(dWdata + i * K, K) =
+                g * ConstEigenVectorMap<float>(Xdata + i * K, K);
+            dbdata[i] = g;
+          }
+        }
+      });
+
+  // The gradients of the rows of the sampled classes, by blocks of classes.
+  const int num_class_blocks = (S + kBlockSize - 1) / kBlockSize;
+  math::ParallelFor(
+      num_class_blocks,
+      std::min<TIndex>(
+          TIndex(M) * K * kBlockSize, std::numeric_limits<int>::max()),
+      pool,
+      [&](int begin, int end) {
+        CPUContext context;
+        for (int block = begin; block < end; ++block) {
+          const int s = block * kBlockSize;
+          const int n = std::min(kBlockSize, S - s);
+          math::GemmEx<float, CPUContext>(
+              CblasTrans,
+              CblasNoTrans,
+              n,
+              K,
+              M,
+              1,
+              G + 1 + s,
+              S + 1,
+              Xdata,
+              K,
+              0,
+              dWdata + (M + s) * K,
+              K,
+              &context);
+          for (int j = s; j < s + n; ++j) {
+            float sum = 0;
+            for (int i = 0; i < M; ++i) {
+              sum += G[i * (S + 1) + 1 + j];
+            }
+            dbdata[M + j] = sum;
+          }
+        }
+      });
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(LogUniformSampling, LogUniformSamplingOp);
+REGISTER_CPU_OPERATOR(SampledSoftmax, SampledSoftmaxOp);
+REGISTER_CPU_OPERATOR(SampledSoftmaxGradient, SampledSoftmaxGradientOp);
+
+OPERATOR_SCHEMA(LogUniformSampling)
+    .NumInputs(0, 1)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(1);
+      if (in.size() == 1) {
+        out[0] = CreateTensorShape(GetDimsVector(in[0]), TensorProto::INT32);
+      } else {
+        const ArgumentHelper args(def);
+        out[0] = CreateTensorShape(
+            vector<int64_t>{args.GetSingleArgument<int64_t>("num_samples", 0)},
+            TensorProto::INT32);
+      }
+      return out;
+    })
+    .SetDoc(R"DOC(
+Samples classes of [0, range) from the log-uniform (Zipfian) distribution
+P(k) = log((k + 2) / (k + 1)) / log(range + 1), which approximates the
+frequencies of words sorted by decreasing frequency. Each sample is drawn by
+inverting the CDF in closed form, so unlike WeightedMultiSampling the op does
+not need the CDF of the classes. If an input is given, its shape is the shape
+of the output. Otherwise, the argument `num_samples` gives the number of
+samples.
+)DOC")
+    .Arg("range", "The number of classes to sample from")
+    .Arg("num_samples", "number of samples to draw")
+    .Input(
+        0,
+        "shape_tensor (optional)",
+        "Tensor whose shape will be applied to output.")
+    .Output(0, "sampled_indexes", "Tensor<int> of the sampled classes");
+SHOULD_NOT_DO_GRADIENT(LogUniformSampling);
+
+OPERATOR_SCHEMA(SampledSoftmax)
+    .NumInputs(4)
+    .NumOutputs(3)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      const ArgumentHelper args(def);
+      const int64_t num_sampled = args.GetSingleArgument<int>("num_sampled", 0);
+      const int64_t M = in[0].dims_size() > 1 ? in[0].dims(0) : 1;
+      vector<TensorShape> out(3);
+      out[0] = CreateTensorShape(vector<int64_t>{M}, TensorProto::FLOAT);
+      out[1] = CreateTensorShape(
+          vector<int64_t>{M + num_sampled}, TensorProto::INT32);
+      out[2] = CreateTensorShape(
+          vector<int64_t>{M, num_sampled + 1}, TensorProto::FLOAT);
+      return out;
+    })
+    .SetDoc(R"DOC(
+Sampled softmax is a training approximation of the softmax cross entropy over a
+large number of classes, such as the words of a vocabulary. Instead of all the
+classes, the softmax of each example only covers its label and `num_sampled`
+distinct classes sampled from the log-uniform distribution, the same for the
+whole batch. The classes should hence be sorted by decreasing frequency.
+
+The log of the expected number of draws of each class is subtracted from its
+logit, which corrects for the sampling, and a sampled class equal to the label
+of an example does not count for that example. The gradients of W and b are
+slices over the rows of the candidates, so that only these rows are updated.
+)DOC")
+    .Arg("num_sampled", "The number of classes sampled for the batch")
+    .Arg(
+        "remove_accidental_hits",
+        "Whether a sampled class equal to the label of an example is ignored "
+        "for that example (default true)")
+    .Arg(
+        "subtract_log_q",
+        "Whether the logits are corrected by the log of the expected number of "
+        "draws of their class (default true)")
+    .Input(0, "X", "Input data from previous layer, of size M x K")
+    .Input(1, "W", "Weights of the classes, of size N x K")
+    .Input(2, "b", "1D blob with the N biases of the classes")
+    .Input(3, "labels", "int class of each example")
+    .Output(0, "Y", "1-D of cross entropy losses, one per example")
+    .Output(
+        1,
+        "candidates",
+        "The labels of the M examples followed by the sampled classes")
+    .Output(
+        2,
+        "probabilities",
+        "M x (num_sampled + 1) softmax of each example over its label, then "
+        "the sampled classes");
+
+OPERATOR_SCHEMA(SampledSoftmaxGradient).NumInputs(5).NumOutputs(3);
+
+class GetSampledSoftmaxGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    auto defs = SingleGradientDef(
+        "SampledSoftmaxGradient",
+        "",
+        // X, W, candidates, probabilities, dY
+        vector<string>{I(0), I(1), O(1), O(2), GO(0)},
+        // dX, dW and db for the rows of the candidates
+        vector<string>{GI(0), GI_V(1), GI_V(2)});
+    SetSparse(1, O(1), GI_V(1));
+    SetSparse(2, O(1), GI_V(2));
+    return defs;
+  }
+};
+REGISTER_GRADIENT(SampledSoftmax, GetSampledSoftmaxGradient);
+
+} // namespace caffe2
@@ -0,0 +1,122 @@
+#ifndef CAFFE2_OPERATORS_SAMPLED_SOFTMAX_OP_H_
+#define CAFFE2_OPERATORS_SAMPLED_SOFTMAX_OP_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// The log-uniform (Zipfian) distribution over [0, range), with
+// P(k) = log((k + 2) / (k + 1)) / log(range + 1). It approximates the
+// frequencies of words sorted by decreasing frequency, and its CDF is
+// inverted in closed form, so a sample costs one exponential where
+// WeightedMultiSampling searches a CDF of range values.
+class LogUniformSampler {
+ public:
+  explicit LogUniformSampler(int range)
+      : range_(range), log_range_(std::log1p(static_cast<double>(range))) {}
+
+  // Maps u, uniform in [0, 1), to a class.
+  int Sample(float u) const {
+    const int k = static_cast<int>(std::exp(u * log_range_)) - 1;
+    return std::min(std::max(k, 0), range_ - 1);
+  }
+
+  double Probability(int k) const {
+    return std::log1p(1.0 / (k + 1)) / log_range_;
+  }
+
+ private:
+  int range_;
+  double log_range_;
+};
+
+class LogUniformSamplingOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+
+  LogUniformSamplingOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        num_samples_(
+            OperatorBase::GetSingleArgument<int64_t>("num_samples", 0)),
+        sampler_(OperatorBase::GetSingleArgument<int>("range", 0)) {
+    CAFFE_ENFORCE_GT(
+        OperatorBase::GetSingleArgument<int>("range", 0),
+        0,
+        "The range to sample from should be positive");
+    CAFFE_ENFORCE_GE(num_samples_, 0);
+  }
+
+  bool RunOnDevice() override;
+
+ private:
+  const int64_t num_samples_;
+  LogUniformSampler sampler_;
+};
+
+// Softmax cross entropy over the true class and num_sampled classes drawn
+// from the log-uniform distribution, shared by the examples of the batch. The
+// logits of the sampled classes are computed with GEMMs on the threads of the
+// workspace pool, and the gradients of W and b are slices of the rows of the
+// candidates.
+class SampledSoftmaxOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+
+  SampledSoftmaxOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        num_sampled_(OperatorBase::GetSingleArgument<int>("num_sampled", 0)),
+        remove_accidental_hits_(OperatorBase::GetSingleArgument<bool>(
+            "remove_accidental_hits",
+            true)),
+        subtract_log_q_(
+            OperatorBase::GetSingleArgument<bool>("subtract_log_q", true)),
+        ws_(ws) {
+    CAFFE_ENFORCE_GT(num_sampled_, 0, "num_sampled should be positive");
+  }
+
+  bool RunOnDevice() override;
+
+ private:
+  // Draws num_sampled_ distinct classes of [0, N) into sampled, and returns
+  // the number of draws this took. When num_sampled_ is a large share of N,
+  // the classes are drawn without rejection, and the number of draws is the
+  // one expected to give num_sampled_ distinct classes.
+  double SampleClasses(int N, int* sampled);
+
+  int num_sampled_;
+  bool remove_accidental_hits_;
+  bool subtract_log_q_;
+  Workspace* ws_;
+  Tensor<CPUContext> sampled_weights_;
+
+  INPUT_TAGS(INPUT, WEIGHTS, BIAS, LABELS);
+  OUTPUT_TAGS(LOSS, CANDIDATES, PROBABILITIES);
+};
+
+class SampledSoftmaxGradientOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+
+  SampledSoftmaxGradientOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws), ws_(ws) {}
+
+  bool RunOnDevice() override;
+
+ private:
+  Workspace* ws_;
+  Tensor<CPUContext> sampled_weights_;
+  Tensor<CPUContext> logits_grad_;
+
+  INPUT_TAGS(INPUT, WEIGHTS, CANDIDATES, PROBABILITIES, LOSS_GRAD);
+  OUTPUT_TAGS(INPUT_GRAD, WEIGHTS_GRAD_VALUES, BIAS_GRAD_VALUES);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_SAMPLED_SOFTMAX_OP_H_
@@ -1,10 +1,16 @@
 #ifndef CAFFE2_OPERATORS_SEGMENT_REDUCTION_OP_H_
 #define CAFFE2_OPERATORS_SEGMENT_REDUCTION_OP_H_
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/operators/reducer_functors.h"
+#include "caffe2/utils/math.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
 
 namespace caffe2 {
 
@@ -27,6 +33,42 @@ class BaseInputAccessor {
   const void* data_ = nullptr;
 };
 
+// Calls f(begin, end) on consecutive ranges of the segments [0, K), where the
+// rows of segment i are [offsets[i], offsets[i + 1]). The ranges hold about the
+// same number of rows, and run on the threads of pool as math::ParallelFor
+// does when there are enough rows of the given block size. f must not throw.
+template <typename F>
+void ParallelForSegments(
+    const vector<TIndex>& offsets,
+    const TIndex block_size,
+    ThreadPool* pool,
+    F f) {
+  constexpr TIndex kGrainSize = 16384;
+  const TIndex K = offsets.size() - 1;
+  const TIndex rows = offsets.back();
+  const TIndex grain =
+      std::max<TIndex>(1, kGrainSize / std::max<TIndex>(block_size, 1));
+  const TIndex num_tasks = std::min(K, (rows + grain - 1) / grain);
+  if (pool == nullptr || num_tasks < 2) {
+    f(0, K);
+    return;
+  }
+  // Task t reduces the segments starting in its share of the rows.
+  auto first_segment = [&](TIndex t) -> TIndex {
+    if (t == num_tasks) {
+      return K;
+    }
+    return std::lower_bound(
+               offsets.begin(), offsets.end() - 1, t * rows / num_tasks) -
+        offsets.begin();
+  };
+  const int task_cost =
+      std::min<TIndex>(grain * block_size, std::numeric_limits<int>::max());
+  math::ParallelFor(num_tasks, task_cost, pool, [&](int begin, int end) {
+    f(first_segment(begin), first_segment(end));
+  });
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Range reducer ops: leverage that input segment is continuous and allow
 // reducer functors to do something special
@@ -593,7 +635,9 @@ template <
 class AbstractSortedSegmentOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(AbstractSortedSegmentOp);
+
+  AbstractSortedSegmentOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
 
   bool RunOnDevice() override {
     if (SparseFused) {
@@ -676,36 +720,49 @@ class AbstractSortedSegmentOp : public Operator<Context> {
 
     // Assume the segments are sorted and there are no gaps
     CAFFE_ENFORCE_EQ(0, s_ids[0], "Indices must be sorted and not have gaps");
-    for (TIndex i = 0; i < N;) {
-      TIndex start = i;
-
-      Reducer r(ctx, out + out_block_size * s_ids[start], &context_);
-      for (; i < N && s_ids[start] == s_ids[i]; ++i) {
-        IndexType idx;
-        if (SparseFused) { // static if
-          CAFFE_ENFORCE(
-              0 <= idxs[i] && idxs[i] < M,
-              "Index out of bounds: ",
-              idxs[i],
-              ", range 0 to ",
-              M);
-          idx = idxs[i];
-        } else {
-          idx = i;
-        }
-        r.template process<FixedSize>(
-            ctx, inputAccessor_.getBlockPtr(in_block_size, idx), i, &context_);
-      }
-
-      r.template finish<FixedSize>(ctx, &context_);
-      // check correctness of the next segment
-      if (i < N) {
+    // The inputs are checked upfront, so that the segments can be reduced in
+    // parallel.
+    offsets_.resize(K + 1);
+    offsets_[0] = 0;
+    for (TIndex i = 1; i < N; ++i) {
+      if (s_ids[i] != s_ids[i - 1]) {
         CAFFE_ENFORCE_EQ(
-            s_ids[start] + 1,
+            s_ids[i - 1] + 1,
             s_ids[i],
             "Indices must be sorted and not have gaps");
+        offsets_[s_ids[i]] = i;
+      }
+    }
+    offsets_[K] = N;
+    if (SparseFused) { // static if
+      for (TIndex i = 0; i < N; ++i) {
+        CAFFE_ENFORCE(
+            0 <= idxs[i] && idxs[i] < M,
+            "Index out of bounds: ",
+            idxs[i],
+            ", range 0 to ",
+            M);
       }
     }
+
+    ParallelForSegments(
+        offsets_,
+        in_block_size,
+        ws_->GetThreadPool(),
+        [&](TIndex begin, TIndex end) {
+          for (TIndex s = begin; s < end; ++s) {
+            Reducer r(ctx, out + out_block_size * s, &context_);
+            for (TIndex i = offsets_[s]; i < offsets_[s + 1]; ++i) {
+              const TIndex idx = SparseFused ? idxs[i] : i;
+              r.template process<FixedSize>(
+                  ctx,
+                  inputAccessor_.getBlockPtr(in_block_size, idx),
+                  i,
+                  &context_);
+            }
+            r.template finish<FixedSize>(ctx, &context_);
+          }
+        });
     return true;
   }
 
@@ -717,6 +774,9 @@ class AbstractSortedSegmentOp : public Operator<Context> {
   static constexpr int kNumInputs = Reducer::kInputCount + kSelfInputs;
 
  private:
+  Workspace* ws_;
+  // first row of each segment, and the number of rows
+  vector<TIndex> offsets_;
   InputAccessor inputAccessor_;
 };
 
@@ -997,7 +1057,8 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
 
   AbstractUnsortedSegmentOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        OP_SINGLE_ARG(int, "num_segments", num_segments_, -1) {}
+        OP_SINGLE_ARG(int, "num_segments", num_segments_, -1),
+        ws_(ws) {}
 
   bool RunOnDevice() override {
     if (SparseFused) {
@@ -1084,12 +1145,10 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
     TIndex out_block_size = output->size_from_dim(1);
     T* out = output->template mutable_data<T>();
 
-    reducers_.clear();
-    reducers_.reserve(K);
-    for (TIndex i = 0; i < K; ++i) {
-      reducers_.emplace_back(ctx, out + out_block_size * i, &context_);
-    }
-
+    // Group the rows by segment, keeping their order, so that each segment
+    // is reduced by a single thread in the same order as sequentially, and
+    // no two threads write to the same output.
+    offsets_.assign(K + 1, 0);
     for (TIndex i = 0; i < N; ++i) {
       auto s_id = s_ids[i];
       CAFFE_ENFORCE(
@@ -1098,7 +1157,6 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
           s_id,
           ", range 0 to ",
           K);
-      IndexType idx;
       if (SparseFused) { // static if
         CAFFE_ENFORCE(
             0 <= idxs[i] && idxs[i] < M,
@@ -1106,19 +1164,35 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
             idxs[i],
             ", range 0 to ",
             M);
-        idx = idxs[i];
-      } else {
-        idx = i;
       }
-      reducers_[s_id].template process<FixedSize>(
-          ctx, inputAccessor_.getBlockPtr(in_block_size, idx), i, &context_);
+      ++offsets_[s_id + 1];
     }
-
-    for (TIndex i = 0; i < K; ++i) {
-      reducers_[i].template finish<FixedSize>(ctx, &context_);
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+    rows_.resize(N);
+    vector<TIndex> next(offsets_.begin(), offsets_.end() - 1);
+    for (TIndex i = 0; i < N; ++i) {
+      rows_[next[s_ids[i]]++] = i;
     }
-    // call reducers destructors (if there is any)
-    reducers_.clear();
+
+    ParallelForSegments(
+        offsets_,
+        in_block_size,
+        ws_->GetThreadPool(),
+        [&](TIndex begin, TIndex end) {
+          for (TIndex s = begin; s < end; ++s) {
+            Reducer r(ctx, out + out_block_size * s, &context_);
+            for (TIndex j = offsets_[s]; j < offsets_[s + 1]; ++j) {
+              const TIndex i = rows_[j];
+              const TIndex idx = SparseFused ? idxs[i] : i;
+              r.template process<FixedSize>(
+                  ctx,
+                  inputAccessor_.getBlockPtr(in_block_size, idx),
+                  i,
+                  &context_);
+            }
+            r.template finish<FixedSize>(ctx, &context_);
+          }
+        });
     return true;
   }
 
@@ -1131,8 +1205,11 @@ class AbstractUnsortedSegmentOp : public Operator<Context> {
 
  private:
   TIndex num_segments_;
-  // member field to reuse memory
-  vector<Reducer> reducers_;
+  Workspace* ws_;
+  // member fields to reuse memory: the first row of each segment in rows_,
+  // and the rows sorted by segment
+  vector<TIndex> offsets_;
+  vector<TIndex> rows_;
   InputAccessor inputAccessor_;
 };
 
@@ -1391,7 +1468,9 @@ template <
 class AbstractLengthsOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(AbstractLengthsOp);
+
+  AbstractLengthsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
 
   bool RunOnDevice() override {
     if (SparseFused) {
@@ -1462,44 +1541,53 @@ class AbstractLengthsOp : public Operator<Context> {
     TIndex out_block_size = output->size_from_dim(1);
     TData* out = output->template mutable_data<TData>();
 
-    TIndex dataIndex = 0;
+    // The inputs are checked upfront, so that the ranges can be reduced in
+    // parallel.
+    offsets_.resize(outputSize + 1);
+    offsets_[0] = 0;
     for (TIndex rangeIndex = 0; rangeIndex < outputSize; ++rangeIndex) {
-      Reducer reducer(ctx, out + out_block_size * rangeIndex, &context_);
-      for (TIndex start = dataIndex; dataIndex < start + lengths[rangeIndex];
-           ++dataIndex) {
-        IndexType idx;
-        if (SparseFused) { // static if
-          idx = indices[dataIndex];
-          CAFFE_ENFORCE(
-              0 <= idx && idx < dataSize,
-              "The ",
-              dataIndex,
-              "th index from the input indices is out of bounds: ",
-              idx,
-              " vs. valid range 0 to ",
-              dataSize);
-        } else {
-          idx = dataIndex;
-          CAFFE_ENFORCE(
-              0 <= idx && idx < dataSize,
-              "When calculating the ",
-              rangeIndex,
-              "th output with length=",
-              lengths[rangeIndex],
-              ", the index is out of bounds: ",
-              idx,
-              " vs. valid range 0 to ",
-              dataSize);
-        }
-
-        const TData* input = inputAccessor_.getBlockPtr(in_block_size, idx);
-        reducer.template process<FixedSize>(ctx, input, dataIndex, &context_);
+      CAFFE_ENFORCE_GE(
+          lengths[rangeIndex],
+          0,
+          "The ",
+          rangeIndex,
+          "th length is negative");
+      offsets_[rangeIndex + 1] = offsets_[rangeIndex] + lengths[rangeIndex];
+    }
+    const TIndex dataIndex = offsets_[outputSize];
+    if (SparseFused) { // static if
+      for (TIndex i = 0; i < std::min(dataIndex, dataToReduceSize); ++i) {
+        CAFFE_ENFORCE(
+            0 <= indices[i] && indices[i] < dataSize,
+            "The ",
+            i,
+            "th index from the input indices is out of bounds: ",
+            indices[i],
+            " vs. valid range 0 to ",
+            dataSize);
       }
-      reducer.template finish<FixedSize>(ctx, &context_);
     }
     CAFFE_ENFORCE(
         dataIndex == dataToReduceSize, dataIndex, " != ", dataToReduceSize);
 
+    ParallelForSegments(
+        offsets_,
+        in_block_size,
+        ws_->GetThreadPool(),
+        [&](TIndex begin, TIndex end) {
+          for (TIndex rangeIndex = begin; rangeIndex < end; ++rangeIndex) {
+            Reducer reducer(
+                ctx, out + out_block_size * rangeIndex, &context_);
+            for (TIndex i = offsets_[rangeIndex]; i < offsets_[rangeIndex + 1];
+                 ++i) {
+              const TIndex idx = SparseFused ? indices[i] : i;
+              const TData* input =
+                  inputAccessor_.getBlockPtr(in_block_size, idx);
+              reducer.template process<FixedSize>(ctx, input, i, &context_);
+            }
+            reducer.template finish<FixedSize>(ctx, &context_);
+          }
+        });
     return true;
   }
 
@@ -1511,6 +1599,9 @@ class AbstractLengthsOp : public Operator<Context> {
   static constexpr int kNumInputs = Reducer::kInputCount + kSelfInputs;
 
  private:
+  Workspace* ws_;
+  // first row of each range, and the number of rows
+  vector<TIndex> offsets_;
   InputAccessor inputAccessor_;
 };
 
@@ -13,16 +13,21 @@ bool SoftmaxOp<float, CPUContext>::RunOnDevice() {
   const int D = X.size_from_dim(canonical_axis);
   Y->ResizeLike(X);
   float* Ydata = Y->mutable_data<float>();
+  ScratchArena::Lease scratch(scratch_arena());
+  auto* scale = scratch.Get(&scale_);
+  auto* rowmax = scratch.Get(&rowmax_);
+  auto* sum_multiplier = scratch.Get(&sum_multiplier_);
   // First, get scales
-  if (scale_.size() != N) {
-    scale_.Resize(N);
+  if (scale->size() != N) {
+    scale->Resize(N);
   }
-  if (rowmax_.size() != N) {
-    rowmax_.Resize(N);
+  if (rowmax->size() != N) {
+    rowmax->Resize(N);
   }
-  if (sum_multiplier_.size() != D) {
-    sum_multiplier_.Resize(D);
-    math::Set<float, CPUContext>(D, 1.f, sum_multiplier_.mutable_data<float>(),
+  // Scratch buffers do not keep their content from the previous run.
+  if (sum_multiplier->size() != D || sum_multiplier != &sum_multiplier_) {
+    sum_multiplier->Resize(D);
+    math::Set<float, CPUContext>(D, 1.f, sum_multiplier->mutable_data<float>(),
                                  &context_);
   }
 
@@ -32,10 +37,10 @@ bool SoftmaxOp<float, CPUContext>::RunOnDevice() {
       D,
       X.data<float>(),
       Ydata,
-      scale_.mutable_data<float>(),
-      sum_multiplier_.data<float>(),
+      scale->mutable_data<float>(),
+      sum_multiplier->data<float>(),
       false,
-      rowmax_.mutable_data<float>());
+      rowmax->mutable_data<float>());
   return true;
 }
 
@@ -48,13 +53,17 @@ bool SoftmaxGradientOp<float, CPUContext>::RunOnDevice() {
   const auto canonical_axis = Y.canonical_axis_index(axis_);
   const int N = Y.size_to_dim(canonical_axis);
   const int D = Y.size_from_dim(canonical_axis);
+  ScratchArena::Lease scratch(scratch_arena());
+  auto* scale = scratch.Get(&scale_);
+  auto* sum_multiplier = scratch.Get(&sum_multiplier_);
   // First, get scales
-  if (scale_.size() != N) {
-    scale_.Resize(N);
+  if (scale->size() != N) {
+    scale->Resize(N);
   }
-  if (sum_multiplier_.size() != D) {
-    sum_multiplier_.Resize(D);
-    math::Set<float, CPUContext>(D, 1.f, sum_multiplier_.mutable_data<float>(),
+  // Scratch buffers do not keep their content from the previous run.
+  if (sum_multiplier->size() != D || sum_multiplier != &sum_multiplier_) {
+    sum_multiplier->Resize(D);
+    math::Set<float, CPUContext>(D, 1.f, sum_multiplier->mutable_data<float>(),
                                  &context_);
   }
   dX->ResizeLike(Y);
@@ -62,13 +71,13 @@ bool SoftmaxGradientOp<float, CPUContext>::RunOnDevice() {
   const float* dYdata = dY.data<float>();
   float* dXdata = dX->mutable_data<float>();
   context_.Copy<float, CPUContext, CPUContext>(Y.size(), dYdata, dXdata);
-  float* scaledata = scale_.mutable_data<float>();
+  float* scaledata = scale->mutable_data<float>();
   for (int i = 0; i < N; ++i) {
     math::Dot<float, CPUContext>(D, Ydata + i * D, dYdata + i * D,
                                  scaledata + i, &context_);
   }
   math::Gemm<float, CPUContext>(CblasNoTrans, CblasNoTrans, N, D, 1, -1,
-                                scaledata, sum_multiplier_.data<float>(), 1,
+                                scaledata, sum_multiplier->data<float>(), 1,
                                 dXdata, &context_);
   math::Mul<float, CPUContext>(Y.size(), dXdata, Ydata, dXdata,
                                &context_);
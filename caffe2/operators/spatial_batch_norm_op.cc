@@ -1,5 +1,7 @@
 #include "caffe2/operators/spatial_batch_norm_op.h"
 
+#include "caffe2/perfkernels/moments.h"
+
 namespace caffe2 {
 
 template <>
@@ -53,32 +55,40 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
       mean = sums / multi_batch_size;
       var = (sumsq - (sums * sums) / multi_batch_size) / multi_batch_size;
     } else {
-      mean.setZero();
-      var.setZero();
       switch (order_) {
         case StorageOrder::NCHW: {
-          ConstEigenArrayMap<float> X_arr(X.data<float>(), sample_size, N * C);
-          for (int nc = 0; nc < N * C; ++nc) {
-            mean(nc % C) += X_arr.col(nc).sum();
-          }
-          mean /= N * sample_size;
-          for (int nc = 0; nc < N * C; ++nc) {
-            var(nc % C) +=
-                (X_arr.col(nc) - mean(nc % C)).matrix().squaredNorm();
-          }
-          var /= N * sample_size;
+          // Merge the moments of the N planes of each channel, which all have
+          // sample_size values.
+          const float* Xdata = X.data<float>();
+          math::ParallelFor(
+              C,
+              N * sample_size,
+              ws_->GetThreadPool(),
+              [&](int begin, int end) {
+                for (int c = begin; c < end; ++c) {
+                  double channel_mean = 0;
+                  double channel_var = 0;
+                  for (int n = 0; n < N; ++n) {
+                    float plane_mean, plane_var;
+                    Moments(
+                        sample_size,
+                        Xdata + (n * C + c) * sample_size,
+                        &plane_mean,
+                        &plane_var);
+                    const double delta = plane_mean - channel_mean;
+                    channel_mean += delta / (n + 1);
+                    channel_var += (plane_var - channel_var) / (n + 1) +
+                        delta * delta * n / ((n + 1) * (n + 1));
+                  }
+                  mean(c) = channel_mean;
+                  var(c) = channel_var;
+                }
+              });
           break;
         }
         case StorageOrder::NHWC: {
-          ConstEigenArrayMap<float> X_arr(X.data<float>(), C, N * sample_size);
-          for (int i = 0; i < N * sample_size; ++i) {
-            mean += X_arr.col(i);
-          }
-          mean /= N * sample_size;
-          for (int i = 0; i < N * sample_size; ++i) {
-            var += (X_arr.col(i) - mean) * (X_arr.col(i) - mean);
-          }
-          var /= N * sample_size;
+          ColwiseMoments(
+              N * sample_size, C, X.data<float>(), mean.data(), var.data());
           break;
         }
         default:
@@ -135,22 +145,33 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
   Eigen::Array<float, Eigen::Dynamic, 1> new_scale = inv_std * scale_arr;
   Eigen::Array<float, Eigen::Dynamic, 1> new_bias =
       bias_arr - mean_arr * inv_std * scale_arr;
+  const float* Xdata = X.data<float>();
+  float* Ydata = Y->mutable_data<float>();
   switch (order_) {
     case StorageOrder::NHWC: {
-      EigenArrayMap<float>(Y->mutable_data<float>(), C, N * sample_size) =
-          (ConstEigenArrayMap<float>(X.data<float>(), C, N * sample_size)
-               .colwise() *
-           new_scale)
-              .colwise() +
-          new_bias;
+      math::ParallelFor(
+          N * sample_size, C, ws_->GetThreadPool(), [&](int begin, int end) {
+            EigenArrayMap<float>(Ydata + begin * C, C, end - begin) =
+                (ConstEigenArrayMap<float>(Xdata + begin * C, C, end - begin)
+                     .colwise() *
+                 new_scale)
+                    .colwise() +
+                new_bias;
+          });
       break;
     }
     case StorageOrder::NCHW: {
-      EigenArrayMap<float> Y_arr(Y->mutable_data<float>(), sample_size, N * C);
-      ConstEigenArrayMap<float> X_arr(X.data<float>(), sample_size, N * C);
-      for (int nc = 0; nc < N * C; ++nc) {
-        Y_arr.col(nc) = X_arr.col(nc) * new_scale(nc % C) + new_bias(nc % C);
-      }
+      math::ParallelFor(
+          N * C, sample_size, ws_->GetThreadPool(), [&](int begin, int end) {
+            for (int nc = begin; nc < end; ++nc) {
+              EigenVectorArrayMap<float>(
+                  Ydata + nc * sample_size, sample_size) =
+                  ConstEigenVectorArrayMap<float>(
+                      Xdata + nc * sample_size, sample_size) *
+                      new_scale(nc % C) +
+                  new_bias(nc % C);
+            }
+          });
       break;
     }
     default:
@@ -18,7 +18,8 @@ class SpatialBNOp : public Operator<Context> {
         momentum_(OperatorBase::GetSingleArgument<float>("momentum", 0.9f)),
         order_(StringToStorageOrder(
             OperatorBase::GetSingleArgument<string>("order", "NCHW"))),
-        num_batches_(OperatorBase::GetSingleArgument<int>("num_batches", 1)) {
+        num_batches_(OperatorBase::GetSingleArgument<int>("num_batches", 1)),
+        ws_(ws) {
     // TODO(jiayq): update the input and output size checks.
     CAFFE_ENFORCE(
         (is_test_ && OutputSize() == 1) || (!is_test_ && OutputSize() == 5));
@@ -38,6 +39,7 @@ class SpatialBNOp : public Operator<Context> {
   double momentum_;
   StorageOrder order_;
   int num_batches_;
+  Workspace* ws_;
   INPUT_TAGS(INPUT, SCALE, BIAS, EST_MEAN, EST_VAR, SUMS, SUMSQ);
   OUTPUT_TAGS(OUTPUT, RUNNING_MEAN, RUNNING_VAR, SAVED_MEAN, SAVED_INV_VAR);
 };
@@ -15,6 +15,7 @@ class TransposeOp final : public Operator<Context> {
   USE_DISPATCH_HELPER;
   TransposeOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
+        ws_(ws),
         axes_(OperatorBase::GetRepeatedArgument<int>("axes")) {
     // We will check the legality of axes_: it should be from 0 to axes_.size().
     std::vector<int> axes_sorted(axes_);
@@ -31,7 +32,7 @@ class TransposeOp final : public Operator<Context> {
     const auto& X = Input(0);
     auto* Y = Output(0);
     const int num_axes = X.ndim();
-    const std::vector<int> x_dims(X.dims().cbegin(), X.dims().cend());
+    x_dims_.assign(X.dims().cbegin(), X.dims().cend());
     std::vector<int> y_dims(num_axes);
     if (axes_.empty()) {
       axes_.resize(num_axes);
@@ -46,7 +47,7 @@ class TransposeOp final : public Operator<Context> {
       }
     }
     Y->Resize(y_dims);
-    SetDeviceTensor(x_dims, &x_dims_device_);
+    SetDeviceTensor(x_dims_, &x_dims_device_);
     SetDeviceTensor(y_dims, &y_dims_device_);
     SetDeviceTensor(axes_, &axes_device_);
 
@@ -64,21 +65,41 @@ class TransposeOp final : public Operator<Context> {
 
   template <typename T>
   bool DoRunWithType() {
-    const auto& X = Input(0);
-    auto* Y = Output(0);
+    Transpose<T>(Input(0).template data<T>(),
+                 Output(0)->template mutable_data<T>(),
+                 &context_);
+    return true;
+  }
+
+  // On CPU the transpose is split across the threads of the workspace.
+  template <typename T>
+  void Transpose(const T* X, T* Y, CPUContext* /* context */) {
+    math::TransposeCPU(
+        axes_.size(),
+        x_dims_.data(),
+        axes_.data(),
+        Input(0).size(),
+        X,
+        Y,
+        ws_->GetThreadPool());
+  }
+
+  template <typename T, class OtherContext>
+  void Transpose(const T* X, T* Y, OtherContext* context) {
     math::Transpose<T, Context>(
         axes_.size(),
         x_dims_device_.template data<int>(),
         y_dims_device_.template data<int>(),
         axes_device_.template data<int>(),
-        X.size(),
-        X.template data<T>(),
-        Y->template mutable_data<T>(),
-        &context_);
-    return true;
+        Input(0).size(),
+        X,
+        Y,
+        context);
   }
 
+  Workspace* ws_;
   std::vector<int> axes_;
+  std::vector<int> x_dims_;
 
   Tensor<Context> x_dims_device_;
   Tensor<Context> y_dims_device_;
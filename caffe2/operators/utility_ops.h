@@ -1009,7 +1009,8 @@ template <class Context>
 class GatherOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(GatherOp);
+  GatherOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws), ws_(ws) {}
 
   bool RunOnDevice() override {
     return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
@@ -1018,8 +1019,6 @@ class GatherOp : public Operator<Context> {
 
   template <typename Index>
   bool DoRunWithType() {
-    // If we endup using it on GPU doing O(N) memcpy is probably not best :)
-    // TODO: implement prefetching if it starts mattering (TF does it)
     auto& data = Input(DATA);
     auto& indices = Input(INDICES);
     auto* output = Output(0);
@@ -1045,14 +1044,62 @@ class GatherOp : public Operator<Context> {
           idx,
           " data_dim=",
           data.dim(0));
-      auto src = src_base + idx * block_bytesize;
-      context_.template CopyItems<Context, Context>(
-          data.meta(), block_size, src, out + block_bytesize * i);
     }
+    GatherRows(
+        N,
+        block_size,
+        block_bytesize,
+        idxs,
+        src_base,
+        out,
+        data.meta(),
+        &context_);
     return true;
   }
 
   INPUT_TAGS(DATA, INDICES);
+
+ private:
+  template <typename Index>
+  void GatherRows(
+      int N,
+      int block_size,
+      size_t block_bytesize,
+      const Index* idxs,
+      const char* src_base,
+      char* out,
+      const TypeMeta& meta,
+      CPUContext* context) {
+    if (meta.copy()) {
+      GatherRows<Index, CPUContext>(
+          N, block_size, block_bytesize, idxs, src_base, out, meta, context);
+      return;
+    }
+    math::GatherRowsCPU(
+        1, N, block_bytesize, idxs, src_base, 0, out, ws_->GetThreadPool());
+  }
+
+  template <typename Index, class OtherContext>
+  void GatherRows(
+      int N,
+      int block_size,
+      size_t block_bytesize,
+      const Index* idxs,
+      const char* src_base,
+      char* out,
+      const TypeMeta& meta,
+      OtherContext* context) {
+    // If we endup using it on GPU doing O(N) memcpy is probably not best :)
+    for (int i = 0; i < N; ++i) {
+      context->template CopyItems<Context, Context>(
+          meta,
+          block_size,
+          src_base + idxs[i] * block_bytesize,
+          out + block_bytesize * i);
+    }
+  }
+
+  Workspace* ws_;
 };
 
 template <class Context>
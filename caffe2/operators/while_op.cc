@@ -16,6 +16,14 @@ the same workspace as 'While'.
     )DOC")
     .Arg("loop_net", "Net executed on each iteration")
     .Arg("cond_net", "Net to (re)compute condition value")
+    .Arg(
+        "lazy_subnets",
+        "If true, subnets are created on their first execution instead of "
+        "in the constructor (default false)")
+    .Arg(
+        "evict_subnets_after",
+        "If positive, the loop subnet is destroyed after this many consecutive "
+        "runs without iterations, and recreated when needed (default 0)")
     .Input(0, "condition", "Scalar boolean condition")
     .AllowInplace([](int in, int out) -> bool { return true; });
 
@@ -4,6 +4,7 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/lazy_net.h"
 
 namespace caffe2 {
 
@@ -15,19 +16,22 @@ class WhileOp final : public Operator<Context> {
     CAFFE_ENFORCE(
         this->template HasSingleArgumentOfType<NetDef>("loop_net"),
         "loop_net must be specified in While operator");
-    loop_net_def_ =
+    const bool lazy =
+        this->template GetSingleArgument<bool>("lazy_subnets", false);
+    const int evict_after =
+        this->template GetSingleArgument<int>("evict_subnets_after", 0);
+    auto loop_net_def =
         this->template GetSingleArgument<NetDef>("loop_net", NetDef());
-    loop_net_ = CreateNet(loop_net_def_, ws);
-    CAFFE_ENFORCE(loop_net_, "Failed to initialize loop subnet");
+    loop_net_.reset(new LazyNet(loop_net_def, ws, lazy, evict_after));
 
     cond_net_ = nullptr;
     bool has_cond_net =
         this->template HasSingleArgumentOfType<NetDef>("cond_net");
     if (has_cond_net) {
-      cond_net_def_ =
+      auto cond_net_def =
           this->template GetSingleArgument<NetDef>("cond_net", NetDef());
-      cond_net_ = CreateNet(cond_net_def_, ws);
-      CAFFE_ENFORCE(cond_net_, "Failed to initialize condition subnet");
+      // The condition net runs every time, so there is nothing to evict.
+      cond_net_.reset(new LazyNet(cond_net_def, ws, lazy));
     }
   }
 
@@ -44,13 +48,18 @@ class WhileOp final : public Operator<Context> {
         1,
         "Invalid condition tensor in While operator: single value expected");
 
+    bool looped = false;
     while (true) {
       if (cond_net_ && !cond_net_->Run()) {
         return false;
       }
       if (!*condition.template data<bool>()) {
+        if (!looped) {
+          loop_net_->Skip();
+        }
         return true;
       }
+      looped = true;
       if (!loop_net_->Run()) {
         return false;
       }
@@ -60,11 +69,8 @@ class WhileOp final : public Operator<Context> {
   }
 
  private:
-  NetDef loop_net_def_;
-  std::unique_ptr<NetBase> loop_net_;
-
-  NetDef cond_net_def_;
-  std::unique_ptr<NetBase> cond_net_;
+  std::unique_ptr<LazyNet> loop_net_;
+  std::unique_ptr<LazyNet> cond_net_;
 };
 
 } // namespace caffe2
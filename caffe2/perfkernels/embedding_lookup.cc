@@ -170,4 +170,46 @@ EMBEDDING_SPECIALIZATION(int64_t, uint8_t, float, true);
 
 #undef EMBEDDING_SPECIALIZATION
 
+// bfloat16 has no generated kernels; the generic implementation still
+// vectorizes the accumulation of each row through TypedAxpy.
+#define EMBEDDING_GENERIC_SPECIALIZATION(                                 \
+    IndexType, InType, OutType, IS_WEIGHT_POSITIONAL)                     \
+  template <>                                                             \
+  void EmbeddingLookup<IndexType, InType, OutType, IS_WEIGHT_POSITIONAL>( \
+      const TIndex block_size,                                            \
+      const TIndex output_size,                                           \
+      const TIndex index_size,                                            \
+      const TIndex data_size,                                             \
+      const InType* input,                                                \
+      const IndexType* indices,                                           \
+      const int* lengths,                                                 \
+      const float* weights,                                               \
+      const float* scale_bias,                                            \
+      bool normalize_by_lengths,                                          \
+      OutType* out) {                                                     \
+    EmbeddingLookupGenericSlow<                                           \
+        IndexType,                                                        \
+        InType,                                                           \
+        OutType,                                                          \
+        IS_WEIGHT_POSITIONAL>(                                            \
+        block_size,                                                       \
+        output_size,                                                      \
+        index_size,                                                       \
+        data_size,                                                        \
+        input,                                                            \
+        indices,                                                          \
+        lengths,                                                          \
+        weights,                                                          \
+        scale_bias,                                                       \
+        normalize_by_lengths,                                             \
+        out);                                                             \
+  }
+
+EMBEDDING_GENERIC_SPECIALIZATION(int32_t, bfloat16, float, false);
+EMBEDDING_GENERIC_SPECIALIZATION(int64_t, bfloat16, float, false);
+EMBEDDING_GENERIC_SPECIALIZATION(int32_t, bfloat16, float, true);
+EMBEDDING_GENERIC_SPECIALIZATION(int64_t, bfloat16, float, true);
+
+#undef EMBEDDING_GENERIC_SPECIALIZATION
+
 } // namespace caffe2
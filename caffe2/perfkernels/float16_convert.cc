@@ -0,0 +1,53 @@
+#include "caffe2/perfkernels/float16_convert.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void Float16ToFloat__base(int N, const float16* x, float* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = convert::cpu_half2float(x[i]);
+  }
+}
+
+void ConvertToFloat(int N, const float16* x, float* y) {
+  AVX_F16C_DO(Float16ToFloat, N, x, y);
+  BASE_DO(Float16ToFloat, N, x, y);
+}
+
+void FloatToFloat16__base(int N, const float* x, float16* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = convert::cpu_float2half_rn(x[i]);
+  }
+}
+
+void ConvertFromFloat(int N, const float* x, float16* y) {
+  AVX_F16C_DO(FloatToFloat16, N, x, y);
+  BASE_DO(FloatToFloat16, N, x, y);
+}
+
+void BFloat16ToFloat__base(int N, const bfloat16* x, float* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = BFloat16ToFloat(x[i]);
+  }
+}
+
+void ConvertToFloat(int N, const bfloat16* x, float* y) {
+  AVX2_DO(BFloat16ToFloat, N, x, y);
+  BASE_DO(BFloat16ToFloat, N, x, y);
+}
+
+void FloatToBFloat16__base(int N, const float* x, bfloat16* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] = FloatToBFloat16(x[i]);
+  }
+}
+
+void ConvertFromFloat(int N, const float* x, bfloat16* y) {
+  AVX2_DO(FloatToBFloat16, N, x, y);
+  BASE_DO(FloatToBFloat16, N, x, y);
+}
+
+} // namespace caffe2
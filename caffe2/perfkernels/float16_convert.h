@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstring>
+
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+// Conversions between float and the 16 bit storage types float16 and
+// bfloat16, used by CPU operators that store their data in 16 bits and
+// compute in float. Conversions to 16 bits round to nearest even.
+void ConvertToFloat(int N, const float16* x, float* y);
+void ConvertToFloat(int N, const bfloat16* x, float* y);
+void ConvertFromFloat(int N, const float* x, float16* y);
+void ConvertFromFloat(int N, const float* x, bfloat16* y);
+
+// Scalar bfloat16 conversions.
+inline float BFloat16ToFloat(bfloat16 x) {
+  const uint32_t bits = static_cast<uint32_t>(x.x) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+inline bfloat16 FloatToBFloat16(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  bfloat16 r;
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    // Keep NaNs quiet instead of letting the rounding turn them into Inf.
+    r.x = (bits >> 16) | 0x40;
+  } else {
+    r.x = (bits + 0x7fff + ((bits >> 16) & 1)) >> 16;
+  }
+  return r;
+}
+
+} // namespace caffe2
@@ -0,0 +1,33 @@
+#include "caffe2/perfkernels/float16_convert.h"
+#include "caffe2/utils/conversions.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void Float16ToFloat__avx_f16c(int N, const float16* x, float* y) {
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    _mm256_storeu_ps(
+        y + i,
+        _mm256_cvtph_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i))));
+  }
+  for (; i < N; ++i) {
+    y[i] = convert::cpu_half2float(x[i]);
+  }
+}
+
+void FloatToFloat16__avx_f16c(int N, const float* x, float16* y) {
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(y + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i < N; ++i) {
+    y[i] = convert::cpu_float2half_rn(x[i]);
+  }
+}
+
+} // namespace caffe2
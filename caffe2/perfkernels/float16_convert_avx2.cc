@@ -0,0 +1,48 @@
+#include "caffe2/perfkernels/float16_convert.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void BFloat16ToFloat__avx2(int N, const bfloat16* x, float* y) {
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    const __m256i bits = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    _mm256_storeu_ps(y + i, _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16)));
+  }
+  for (; i < N; ++i) {
+    y[i] = BFloat16ToFloat(x[i]);
+  }
+}
+
+void FloatToBFloat16__avx2(int N, const float* x, bfloat16* y) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i rounding_bias = _mm256_set1_epi32(0x7fff);
+  const __m256i quiet_bit = _mm256_set1_epi32(0x40);
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    const __m256 v = _mm256_loadu_ps(x + i);
+    const __m256i bits = _mm256_castps_si256(v);
+    // Round to nearest even, as in FloatToBFloat16.
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+    const __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(bits, rounding_bias), lsb), 16);
+    const __m256i nan =
+        _mm256_or_si256(_mm256_srli_epi32(bits, 16), quiet_bit);
+    const __m256i is_nan =
+        _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    const __m256i r = _mm256_blendv_epi8(rounded, nan, is_nan);
+    // Pack the 32 bit lanes to 16 bits; packus works within 128 bit lanes,
+    // so gather the two halves afterwards.
+    const __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(y + i), _mm256_castsi256_si128(packed));
+  }
+  for (; i < N; ++i) {
+    y[i] = FloatToBFloat16(x[i]);
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,47 @@
+#include "caffe2/perfkernels/gather.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+// The dispatch macros need a name per index type.
+void GatherRowsInt32__base(
+    int n,
+    size_t row_bytes,
+    const int32_t* idxs,
+    const char* src,
+    char* dst) {
+  GatherRowsGeneric(n, row_bytes, idxs, src, dst);
+}
+
+void GatherRowsInt64__base(
+    int n,
+    size_t row_bytes,
+    const int64_t* idxs,
+    const char* src,
+    char* dst) {
+  GatherRowsGeneric(n, row_bytes, idxs, src, dst);
+}
+
+void GatherRows(
+    int n,
+    size_t row_bytes,
+    const int32_t* idxs,
+    const char* src,
+    char* dst) {
+  AVX2_DO(GatherRowsInt32, n, row_bytes, idxs, src, dst);
+  BASE_DO(GatherRowsInt32, n, row_bytes, idxs, src, dst);
+}
+
+void GatherRows(
+    int n,
+    size_t row_bytes,
+    const int64_t* idxs,
+    const char* src,
+    char* dst) {
+  AVX2_DO(GatherRowsInt64, n, row_bytes, idxs, src, dst);
+  BASE_DO(GatherRowsInt64, n, row_bytes, idxs, src, dst);
+}
+
+} // namespace caffe2
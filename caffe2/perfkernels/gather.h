@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace caffe2 {
+
+// Copies the rows idxs[0], ..., idxs[n - 1] of src into the n consecutive rows
+// of dst, all of row_bytes bytes. The rows of up to 64 bytes, such as those of
+// 1 to 16 floats, are moved with fixed size copies, and the rows of 4 or 8
+// bytes with AVX2 gathers when the CPU supports them. The indices must be
+// valid.
+void GatherRows(
+    int n,
+    size_t row_bytes,
+    const int32_t* idxs,
+    const char* src,
+    char* dst);
+void GatherRows(
+    int n,
+    size_t row_bytes,
+    const int64_t* idxs,
+    const char* src,
+    char* dst);
+
+// Portable version of GatherRows, also used by the vectorized versions for the
+// sizes they do not gather. Each source row is prefetched kPrefetchDistance
+// rows ahead, as the indices are usually random.
+template <size_t kRowBytes, typename Index>
+void GatherFixedRows(int n, const Index* idxs, const char* src, char* dst) {
+  constexpr int kPrefetchDistance = 16;
+  for (int i = 0; i < n; ++i) {
+#ifdef __GNUC__
+    if (i + kPrefetchDistance < n) {
+      __builtin_prefetch(src + idxs[i + kPrefetchDistance] * kRowBytes, 0, 1);
+    }
+#endif
+    std::memcpy(dst + i * kRowBytes, src + idxs[i] * kRowBytes, kRowBytes);
+  }
+}
+
+template <typename Index>
+void GatherRowsGeneric(
+    int n,
+    size_t row_bytes,
+    const Index* idxs,
+    const char* src,
+    char* dst) {
+  switch (row_bytes) {
+    case 1:
+      return GatherFixedRows<1>(n, idxs, src, dst);
+    case 2:
+      return GatherFixedRows<2>(n, idxs, src, dst);
+    case 4:
+      return GatherFixedRows<4>(n, idxs, src, dst);
+    case 8:
+      return GatherFixedRows<8>(n, idxs, src, dst);
+    case 12:
+      return GatherFixedRows<12>(n, idxs, src, dst);
+    case 16:
+      return GatherFixedRows<16>(n, idxs, src, dst);
+    case 24:
+      return GatherFixedRows<24>(n, idxs, src, dst);
+    case 32:
+      return GatherFixedRows<32>(n, idxs, src, dst);
+    case 48:
+      return GatherFixedRows<48>(n, idxs, src, dst);
+    case 64:
+      return GatherFixedRows<64>(n, idxs, src, dst);
+  }
+  for (int i = 0; i < n; ++i) {
+    std::memcpy(dst + i * row_bytes, src + idxs[i] * row_bytes, row_bytes);
+  }
+}
+
+} // namespace caffe2
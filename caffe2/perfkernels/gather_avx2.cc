@@ -0,0 +1,102 @@
+#include "caffe2/perfkernels/gather.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+// The gathers of 4 or 8 rows at once, then the remaining rows one by one.
+inline void
+Gather4Bytes(int n, const int32_t* idxs, const char* src, char* dst) {
+  const int* x = reinterpret_cast<const int*>(src);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i idx =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idxs + i));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i * 4),
+        _mm256_i32gather_epi32(x, idx, 4));
+  }
+  GatherFixedRows<4>(n - i, idxs + i, src, dst + i * 4);
+}
+
+inline void
+Gather4Bytes(int n, const int64_t* idxs, const char* src, char* dst) {
+  const int* x = reinterpret_cast<const int*>(src);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256i idx =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idxs + i));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i * 4),
+        _mm256_i64gather_epi32(x, idx, 4));
+  }
+  GatherFixedRows<4>(n - i, idxs + i, src, dst + i * 4);
+}
+
+inline void
+Gather8Bytes(int n, const int32_t* idxs, const char* src, char* dst) {
+  const long long* x = reinterpret_cast<const long long*>(src);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128i idx =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(idxs + i));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i * 8),
+        _mm256_i32gather_epi64(x, idx, 8));
+  }
+  GatherFixedRows<8>(n - i, idxs + i, src, dst + i * 8);
+}
+
+inline void
+Gather8Bytes(int n, const int64_t* idxs, const char* src, char* dst) {
+  const long long* x = reinterpret_cast<const long long*>(src);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256i idx =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idxs + i));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i * 8),
+        _mm256_i64gather_epi64(x, idx, 8));
+  }
+  GatherFixedRows<8>(n - i, idxs + i, src, dst + i * 8);
+}
+
+template <typename Index>
+void GatherRowsAVX2(
+    int n,
+    size_t row_bytes,
+    const Index* idxs,
+    const char* src,
+    char* dst) {
+  if (row_bytes == 4) {
+    return Gather4Bytes(n, idxs, src, dst);
+  }
+  if (row_bytes == 8) {
+    return Gather8Bytes(n, idxs, src, dst);
+  }
+  GatherRowsGeneric(n, row_bytes, idxs, src, dst);
+}
+
+} // namespace
+
+void GatherRowsInt32__avx2(
+    int n,
+    size_t row_bytes,
+    const int32_t* idxs,
+    const char* src,
+    char* dst) {
+  GatherRowsAVX2(n, row_bytes, idxs, src, dst);
+}
+
+void GatherRowsInt64__avx2(
+    int n,
+    size_t row_bytes,
+    const int64_t* idxs,
+    const char* src,
+    char* dst) {
+  GatherRowsAVX2(n, row_bytes, idxs, src, dst);
+}
+
+} // namespace caffe2
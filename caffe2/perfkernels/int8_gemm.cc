@@ -0,0 +1,40 @@
+#include "caffe2/perfkernels/int8_gemm.h"
+
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void Int8GemmNT__base(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* A,
+    const std::int8_t* B,
+    std::int32_t* C) {
+  for (int i = 0; i < M; ++i) {
+    const std::uint8_t* a = A + i * K;
+    for (int j = 0; j < N; ++j) {
+      const std::int8_t* b = B + j * K;
+      std::int32_t sum = 0;
+      for (int k = 0; k < K; ++k) {
+        sum += static_cast<std::int32_t>(a[k]) * static_cast<std::int32_t>(b[k]);
+      }
+      C[i * N + j] = sum;
+    }
+  }
+}
+
+void Int8GemmNT(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* A,
+    const std::int8_t* B,
+    std::int32_t* C) {
+  AVX2_DO(Int8GemmNT, M, N, K, A, B, C);
+  BASE_DO(Int8GemmNT, M, N, K, A, B, C);
+}
+
+} // namespace caffe2
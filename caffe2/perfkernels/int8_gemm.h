@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace caffe2 {
+
+// Computes C = A * B^T with exact int32 accumulation, where A is an M x K
+// row-major matrix of uint8 values and B an N x K row-major matrix of int8
+// values. C is M x N, row-major:
+//   C[i * N + j] = sum_k A[i * K + k] * B[j * K + k]
+// Keeping both operands contiguous along K is the natural layout for
+// quantized FC and NHWC convolution, where B holds the weights.
+void Int8GemmNT(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* A,
+    const std::int8_t* B,
+    std::int32_t* C);
+
+} // namespace caffe2
@@ -0,0 +1,100 @@
+#include "caffe2/perfkernels/int8_gemm.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+inline std::int32_t HorizontalSum(__m256i v) {
+  __m128i sum = _mm_add_epi32(
+      _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  return _mm_cvtsi128_si32(sum);
+}
+
+// Sign- or zero-extends 16 bytes to 16 int16 lanes.
+inline __m256i LoadUint8AsInt16(const std::uint8_t* p) {
+  return _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+inline __m256i LoadInt8AsInt16(const std::int8_t* p) {
+  return _mm256_cvtepi8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+} // namespace
+
+// The operands are widened to int16 and multiplied with vpmaddwd, which adds
+// adjacent products into int32 lanes. Unlike vpmaddubsw, which multiplies the
+// bytes directly, this never saturates: the sum of two uint8 * int8 products
+// can exceed the int16 range. Each row of A is reused across four rows of B.
+void Int8GemmNT__avx2(
+    int M,
+    int N,
+    int K,
+    const std::uint8_t* A,
+    const std::int8_t* B,
+    std::int32_t* C) {
+  for (int i = 0; i < M; ++i) {
+    const std::uint8_t* a = A + i * K;
+    std::int32_t* c = C + i * N;
+    int j = 0;
+    for (; j + 4 <= N; j += 4) {
+      const std::int8_t* b0 = B + j * K;
+      const std::int8_t* b1 = b0 + K;
+      const std::int8_t* b2 = b1 + K;
+      const std::int8_t* b3 = b2 + K;
+      __m256i acc0 = _mm256_setzero_si256();
+      __m256i acc1 = _mm256_setzero_si256();
+      __m256i acc2 = _mm256_setzero_si256();
+      __m256i acc3 = _mm256_setzero_si256();
+      int k = 0;
+      for (; k + 16 <= K; k += 16) {
+        const __m256i va = LoadUint8AsInt16(a + k);
+        acc0 = _mm256_add_epi32(
+            acc0, _mm256_madd_epi16(va, LoadInt8AsInt16(b0 + k)));
+        acc1 = _mm256_add_epi32(
+            acc1, _mm256_madd_epi16(va, LoadInt8AsInt16(b1 + k)));
+        acc2 = _mm256_add_epi32(
+            acc2, _mm256_madd_epi16(va, LoadInt8AsInt16(b2 + k)));
+        acc3 = _mm256_add_epi32(
+            acc3, _mm256_madd_epi16(va, LoadInt8AsInt16(b3 + k)));
+      }
+      std::int32_t c0 = HorizontalSum(acc0);
+      std::int32_t c1 = HorizontalSum(acc1);
+      std::int32_t c2 = HorizontalSum(acc2);
+      std::int32_t c3 = HorizontalSum(acc3);
+      for (; k < K; ++k) {
+        const std::int32_t ak = a[k];
+        c0 += ak * b0[k];
+        c1 += ak * b1[k];
+        c2 += ak * b2[k];
+        c3 += ak * b3[k];
+      }
+      c[j] = c0;
+      c[j + 1] = c1;
+      c[j + 2] = c2;
+      c[j + 3] = c3;
+    }
+    for (; j < N; ++j) {
+      const std::int8_t* b = B + j * K;
+      __m256i acc = _mm256_setzero_si256();
+      int k = 0;
+      for (; k + 16 <= K; k += 16) {
+        acc = _mm256_add_epi32(
+            acc,
+            _mm256_madd_epi16(LoadUint8AsInt16(a + k), LoadInt8AsInt16(b + k)));
+      }
+      std::int32_t sum = HorizontalSum(acc);
+      for (; k < K; ++k) {
+        sum += static_cast<std::int32_t>(a[k]) * b[k];
+      }
+      c[j] = sum;
+    }
+  }
+}
+
+} // namespace caffe2
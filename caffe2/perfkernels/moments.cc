@@ -0,0 +1,76 @@
+#include "caffe2/perfkernels/moments.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void Moments__base(int n, const float* x, float* mean, float* var) {
+  // Independent interleaved states, which the compiler can vectorize.
+  constexpr int kLanes = 16;
+  float lane_mean[kLanes] = {0};
+  float lane_m2[kLanes] = {0};
+  const int blocks = n / kLanes;
+  for (int i = 0; i < blocks; ++i) {
+    const float inv_count = 1.0f / (i + 1);
+    const float* block = x + i * kLanes;
+    for (int j = 0; j < kLanes; ++j) {
+      const float delta = block[j] - lane_mean[j];
+      lane_mean[j] += delta * inv_count;
+      lane_m2[j] += delta * (block[j] - lane_mean[j]);
+    }
+  }
+  MergeMoments(
+      kLanes,
+      blocks,
+      lane_mean,
+      lane_m2,
+      n - blocks * kLanes,
+      x + blocks * kLanes,
+      mean,
+      var);
+}
+
+void Moments(int n, const float* x, float* mean, float* var) {
+  AVX2_FMA_DO(Moments, n, x, mean, var);
+  BASE_DO(Moments, n, x, mean, var);
+}
+
+void ColwiseMoments__base(
+    int rows,
+    int cols,
+    const float* x,
+    float* mean,
+    float* var) {
+  // var holds the sums of squared deviations until the end.
+  for (int j = 0; j < cols; ++j) {
+    mean[j] = 0;
+    var[j] = 0;
+  }
+  for (int i = 0; i < rows; ++i) {
+    const float inv_count = 1.0f / (i + 1);
+    const float* row = x + i * cols;
+    for (int j = 0; j < cols; ++j) {
+      const float delta = row[j] - mean[j];
+      mean[j] += delta * inv_count;
+      var[j] += delta * (row[j] - mean[j]);
+    }
+  }
+  if (rows > 0) {
+    for (int j = 0; j < cols; ++j) {
+      var[j] /= rows;
+    }
+  }
+}
+
+void ColwiseMoments(
+    int rows,
+    int cols,
+    const float* x,
+    float* mean,
+    float* var) {
+  AVX2_FMA_DO(ColwiseMoments, rows, cols, x, mean, var);
+  BASE_DO(ColwiseMoments, rows, cols, x, mean, var);
+}
+
+} // namespace caffe2
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace caffe2 {
+
+// Computes the mean and the biased variance of the n values of x in a single
+// pass, with Welford's algorithm. Unlike E[x^2] - E[x]^2, it does not lose
+// the variance when the values are far from 0 compared to their spread.
+void Moments(int n, const float* x, float* mean, float* var);
+
+// Computes the mean and the biased variance of each of the cols columns of the
+// row-major rows x cols matrix x, such as the per channel statistics of an
+// NHWC tensor, in a single pass over x.
+void ColwiseMoments(
+    int rows,
+    int cols,
+    const float* x,
+    float* mean,
+    float* var);
+
+// Merges the Welford states of lanes interleaved partitions of a sequence,
+// each of count values with the given means and sums of squared deviations
+// m2, then adds the n values of x. Shared by the implementations of Moments.
+inline void MergeMoments(
+    int lanes,
+    int count,
+    const float* lane_mean,
+    const float* lane_m2,
+    int n,
+    const float* x,
+    float* mean,
+    float* var) {
+  double total_mean = 0;
+  double total_m2 = 0;
+  int total_count = 0;
+  if (count > 0) {
+    for (int i = 0; i < lanes; ++i) {
+      total_mean += lane_mean[i];
+    }
+    total_mean /= lanes;
+    for (int i = 0; i < lanes; ++i) {
+      const double delta = lane_mean[i] - total_mean;
+      total_m2 += lane_m2[i] + count * delta * delta;
+    }
+    total_count = lanes * count;
+  }
+  for (int i = 0; i < n; ++i) {
+    ++total_count;
+    const double delta = x[i] - total_mean;
+    total_mean += delta / total_count;
+    total_m2 += delta * (x[i] - total_mean);
+  }
+  *mean = total_mean;
+  *var = total_count > 0 ? total_m2 / total_count : 0;
+}
+
+} // namespace caffe2
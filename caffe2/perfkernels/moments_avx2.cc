@@ -0,0 +1,84 @@
+#include "caffe2/perfkernels/moments.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void Moments__avx2_fma(int n, const float* x, float* mean, float* var) {
+  // Two registers of states, so that consecutive updates do not wait on each
+  // other.
+  constexpr int kLanes = 16;
+  __m256 mean0 = _mm256_setzero_ps();
+  __m256 mean1 = _mm256_setzero_ps();
+  __m256 m20 = _mm256_setzero_ps();
+  __m256 m21 = _mm256_setzero_ps();
+  const int blocks = n / kLanes;
+  for (int i = 0; i < blocks; ++i) {
+    const __m256 inv_count = _mm256_set1_ps(1.0f / (i + 1));
+    const __m256 x0 = _mm256_loadu_ps(x + i * kLanes);
+    const __m256 x1 = _mm256_loadu_ps(x + i * kLanes + 8);
+    const __m256 delta0 = _mm256_sub_ps(x0, mean0);
+    const __m256 delta1 = _mm256_sub_ps(x1, mean1);
+    mean0 = _mm256_fmadd_ps(delta0, inv_count, mean0);
+    mean1 = _mm256_fmadd_ps(delta1, inv_count, mean1);
+    m20 = _mm256_fmadd_ps(delta0, _mm256_sub_ps(x0, mean0), m20);
+    m21 = _mm256_fmadd_ps(delta1, _mm256_sub_ps(x1, mean1), m21);
+  }
+  float lane_mean[kLanes];
+  float lane_m2[kLanes];
+  _mm256_storeu_ps(lane_mean, mean0);
+  _mm256_storeu_ps(lane_mean + 8, mean1);
+  _mm256_storeu_ps(lane_m2, m20);
+  _mm256_storeu_ps(lane_m2 + 8, m21);
+  MergeMoments(
+      kLanes,
+      blocks,
+      lane_mean,
+      lane_m2,
+      n - blocks * kLanes,
+      x + blocks * kLanes,
+      mean,
+      var);
+}
+
+void ColwiseMoments__avx2_fma(
+    int rows,
+    int cols,
+    const float* x,
+    float* mean,
+    float* var) {
+  // var holds the sums of squared deviations until the end.
+  for (int j = 0; j < cols; ++j) {
+    mean[j] = 0;
+    var[j] = 0;
+  }
+  const int vec_cols = cols / 8 * 8;
+  for (int i = 0; i < rows; ++i) {
+    const float inv_count = 1.0f / (i + 1);
+    const __m256 inv_count_v = _mm256_set1_ps(inv_count);
+    const float* row = x + i * cols;
+    int j = 0;
+    for (; j < vec_cols; j += 8) {
+      const __m256 xj = _mm256_loadu_ps(row + j);
+      __m256 mean_j = _mm256_loadu_ps(mean + j);
+      const __m256 delta = _mm256_sub_ps(xj, mean_j);
+      mean_j = _mm256_fmadd_ps(delta, inv_count_v, mean_j);
+      const __m256 m2_j = _mm256_fmadd_ps(
+          delta, _mm256_sub_ps(xj, mean_j), _mm256_loadu_ps(var + j));
+      _mm256_storeu_ps(mean + j, mean_j);
+      _mm256_storeu_ps(var + j, m2_j);
+    }
+    for (; j < cols; ++j) {
+      const float delta = row[j] - mean[j];
+      mean[j] += delta * inv_count;
+      var[j] += delta * (row[j] - mean[j]);
+    }
+  }
+  if (rows > 0) {
+    for (int j = 0; j < cols; ++j) {
+      var[j] /= rows;
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,26 @@
+#include "caffe2/perfkernels/nontemporal_copy.h"
+
+#include <cstring>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void NonTemporalCopy__base(void* dst, const void* src, size_t n) {
+  std::memcpy(dst, src, n);
+}
+
+void NonTemporalCopy(void* dst, const void* src, size_t n) {
+  AVX_DO(NonTemporalCopy, dst, src, n);
+  BASE_DO(NonTemporalCopy, dst, src, n);
+}
+
+void NonTemporalFence__base() {}
+
+void NonTemporalFence() {
+  AVX_DO(NonTemporalFence);
+  BASE_DO(NonTemporalFence);
+}
+
+} // namespace caffe2
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace caffe2 {
+
+// Copies n bytes from src to dst like memcpy, but with non-temporal stores
+// when the CPU supports AVX: dst is written to memory without going through
+// the cache, so copying a buffer much larger than the cache does not evict
+// the data the following ops work on. The stores are not fenced: call
+// NonTemporalFence once after the copies, before dst is read by other threads.
+void NonTemporalCopy(void* dst, const void* src, size_t n);
+
+// Orders the non-temporal stores of the previous NonTemporalCopy calls of the
+// thread before its following stores.
+void NonTemporalFence();
+
+} // namespace caffe2
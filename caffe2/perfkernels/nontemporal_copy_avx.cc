@@ -0,0 +1,49 @@
+#include "caffe2/perfkernels/nontemporal_copy.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void NonTemporalCopy__avx(void* dst, const void* src, size_t n) {
+  char* y = static_cast<char*>(dst);
+  const char* x = static_cast<const char*>(src);
+  // Streaming stores must be aligned, so the unaligned head of dst is copied
+  // normally.
+  size_t head = (32 - reinterpret_cast<std::uintptr_t>(y) % 32) % 32;
+  if (head >= n) {
+    std::memcpy(y, x, n);
+    return;
+  }
+  std::memcpy(y, x, head);
+  size_t i = head;
+  for (; i + 128 <= n; i += 128) {
+    const __m256i v0 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    const __m256i v1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 32));
+    const __m256i v2 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 64));
+    const __m256i v3 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 96));
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(y + i), v0);
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(y + i + 32), v1);
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(y + i + 64), v2);
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(y + i + 96), v3);
+  }
+  for (; i + 32 <= n; i += 32) {
+    _mm256_stream_si256(
+        reinterpret_cast<__m256i*>(y + i),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+  }
+  std::memcpy(y + i, x + i, n - i);
+}
+
+void NonTemporalFence__avx() {
+  // Make the streaming stores visible to the threads that read dst next.
+  _mm_sfence();
+}
+
+} // namespace caffe2
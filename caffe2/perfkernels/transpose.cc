@@ -0,0 +1,29 @@
+#include "caffe2/perfkernels/transpose.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void Transpose2D__base(
+    int rows,
+    int cols,
+    const float* x,
+    int ldx,
+    float* y,
+    int ldy) {
+  Transpose2DTiled(rows, cols, x, ldx, y, ldy);
+}
+
+void Transpose2D(
+    int rows,
+    int cols,
+    const float* x,
+    int ldx,
+    float* y,
+    int ldy) {
+  AVX_DO(Transpose2D, rows, cols, x, ldx, y, ldy);
+  BASE_DO(Transpose2D, rows, cols, x, ldx, y, ldy);
+}
+
+} // namespace caffe2
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+
+namespace caffe2 {
+
+// Transposes the rows x cols matrix x with leading dimension ldx into y with
+// leading dimension ldy: y[j * ldy + i] = x[i * ldx + j]. The float version
+// moves 8x8 blocks through AVX registers when the CPU supports it.
+void Transpose2D(
+    int rows,
+    int cols,
+    const float* x,
+    int ldx,
+    float* y,
+    int ldy);
+
+// Portable version of Transpose2D, walking the matrix in square tiles so that
+// both x and y stay in cache.
+template <typename T>
+void Transpose2DTiled(int rows, int cols, const T* x, int ldx, T* y, int ldy) {
+  constexpr int kTileSize = 32;
+  for (int i0 = 0; i0 < rows; i0 += kTileSize) {
+    const int i1 = std::min(rows, i0 + kTileSize);
+    for (int j0 = 0; j0 < cols; j0 += kTileSize) {
+      const int j1 = std::min(cols, j0 + kTileSize);
+      for (int j = j0; j < j1; ++j) {
+        for (int i = i0; i < i1; ++i) {
+          y[j * ldy + i] = x[i * ldx + j];
+        }
+      }
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,74 @@
+#include "caffe2/perfkernels/transpose.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+inline void Transpose8x8(const float* x, int ldx, float* y, int ldy) {
+  const __m256 r0 = _mm256_loadu_ps(x);
+  const __m256 r1 = _mm256_loadu_ps(x + ldx);
+  const __m256 r2 = _mm256_loadu_ps(x + 2 * ldx);
+  const __m256 r3 = _mm256_loadu_ps(x + 3 * ldx);
+  const __m256 r4 = _mm256_loadu_ps(x + 4 * ldx);
+  const __m256 r5 = _mm256_loadu_ps(x + 5 * ldx);
+  const __m256 r6 = _mm256_loadu_ps(x + 6 * ldx);
+  const __m256 r7 = _mm256_loadu_ps(x + 7 * ldx);
+  // Interleave pairs of rows, then pairs of pairs, within 128 bit lanes.
+  const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  const __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  const __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  const __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  const __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+  const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  // Swap the 128 bit lanes between the top and bottom halves.
+  _mm256_storeu_ps(y, _mm256_permute2f128_ps(s0, s4, 0x20));
+  _mm256_storeu_ps(y + ldy, _mm256_permute2f128_ps(s1, s5, 0x20));
+  _mm256_storeu_ps(y + 2 * ldy, _mm256_permute2f128_ps(s2, s6, 0x20));
+  _mm256_storeu_ps(y + 3 * ldy, _mm256_permute2f128_ps(s3, s7, 0x20));
+  _mm256_storeu_ps(y + 4 * ldy, _mm256_permute2f128_ps(s0, s4, 0x31));
+  _mm256_storeu_ps(y + 5 * ldy, _mm256_permute2f128_ps(s1, s5, 0x31));
+  _mm256_storeu_ps(y + 6 * ldy, _mm256_permute2f128_ps(s2, s6, 0x31));
+  _mm256_storeu_ps(y + 7 * ldy, _mm256_permute2f128_ps(s3, s7, 0x31));
+}
+
+} // namespace
+
+void Transpose2D__avx(
+    int rows,
+    int cols,
+    const float* x,
+    int ldx,
+    float* y,
+    int ldy) {
+  constexpr int kTileSize = 32;
+  for (int i0 = 0; i0 < rows; i0 += kTileSize) {
+    const int i1 = std::min(rows, i0 + kTileSize);
+    for (int j0 = 0; j0 < cols; j0 += kTileSize) {
+      const int j1 = std::min(cols, j0 + kTileSize);
+      int i = i0;
+      for (; i + 8 <= i1; i += 8) {
+        int j = j0;
+        for (; j + 8 <= j1; j += 8) {
+          Transpose8x8(x + i * ldx + j, ldx, y + j * ldy + i, ldy);
+        }
+        Transpose2DTiled(8, j1 - j, x + i * ldx + j, ldx, y + j * ldy + i, ldy);
+      }
+      Transpose2DTiled(
+          i1 - i, j1 - j0, x + i * ldx + j0, ldx, y + j0 * ldy + i, ldy);
+    }
+  }
+}
+
+} // namespace caffe2
@@ -1,6 +1,7 @@
 #include "caffe2/perfkernels/typed_axpy.h"
 #include "caffe2/core/types.h"
 #include "caffe2/perfkernels/common.h"
+#include "caffe2/perfkernels/float16_convert.h"
 #include "caffe2/utils/cpuid.h"
 #include "caffe2/utils/math.h"
 
@@ -47,6 +48,26 @@ void TypedAxpy<float16, float>(
   BASE_DO(TypedAxpy_float16_float, N, a, x, y);
 }
 
+void TypedAxpy_bfloat16_float__base(
+    int N,
+    const float a,
+    const bfloat16* x,
+    float* y) {
+  for (int i = 0; i < N; ++i) {
+    y[i] += BFloat16ToFloat(x[i]) * a;
+  }
+}
+
+template <>
+void TypedAxpy<bfloat16, float>(
+    int N,
+    const float a,
+    const bfloat16* x,
+    float* y) {
+  AVX2_FMA_DO(TypedAxpy_bfloat16_float, N, a, x, y);
+  BASE_DO(TypedAxpy_bfloat16_float, N, a, x, y);
+}
+
 void TypedAxpy_uint8_float__base(
     int N,
     const float a,
@@ -1,5 +1,6 @@
 #include "caffe2/core/types.h"
 #include "caffe2/perfkernels/cvtsh_ss_bugfix.h"
+#include "caffe2/perfkernels/float16_convert.h"
 #include "caffe2/perfkernels/typed_axpy.h"
 #include "caffe2/utils/math.h"
 
@@ -43,6 +44,29 @@ void TypedAxpy_float16_float__avx2_fma(
   }
 }
 
+void TypedAxpy_bfloat16_float__avx2_fma(
+    int N,
+    const float a,
+    const bfloat16* x,
+    float* y) {
+  // bfloat16 is the upper half of a float, so widening to 32 bits and
+  // shifting left by 16 gives the float.
+  __m256 mma = _mm256_set1_ps(a);
+  int current = 0;
+  for (; current + 8 <= N; current += 8) {
+    __m256i mmx_int32 = _mm256_slli_epi32(
+        _mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + current))),
+        16);
+    __m256 mmy = _mm256_loadu_ps(y + current);
+    mmy = _mm256_fmadd_ps(_mm256_castsi256_ps(mmx_int32), mma, mmy);
+    _mm256_storeu_ps(y + current, mmy);
+  }
+  for (; current < N; ++current) {
+    y[current] += BFloat16ToFloat(x[current]) * a;
+  }
+}
+
 void TypedAxpy_uint8_float__avx2_fma(
     int N,
     const float a,
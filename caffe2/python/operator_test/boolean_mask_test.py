@@ -45,6 +45,23 @@ class TestBooleanMaskOp(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [x, mask], ref)
         self.assertDeviceChecks(dc, op, [x, mask], [0])
 
+    @given(rows_num=st.integers(0, 5000),
+           block_size=st.integers(1, 17),
+           dtype=st.sampled_from([np.float32, np.float64, np.uint8]),
+           **hu.gcs_cpu_only)
+    def test_boolean_mask_small_rows(self, rows_num, block_size, dtype, gc, dc):
+        # Rows of 1 to 136 bytes, copied by the vectorized kernels.
+        x = (np.random.random((rows_num, block_size)) * 100).astype(dtype)
+        mask = np.random.choice(a=[True, False], size=rows_num)
+        op = core.CreateOperator("BooleanMask",
+                                 ["data", "mask"],
+                                 ["masked_data", "masked_indices"])
+
+        def ref(x, mask):
+            return (x[mask], np.where(mask)[0])
+
+        self.assertReferenceChecks(gc, op, [x, mask], ref)
+
     @staticmethod
     def _dtype_conversion(x, dtype, gc, dc):
         """SequenceMask only supports fp16 with CUDA."""
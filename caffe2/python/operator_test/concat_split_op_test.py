@@ -126,6 +126,74 @@ class TestConcatSplitOps(hu.HypothesisTestCase):
         self.assertDeviceChecks(dc, op, input_tensors, outputs_with_grad)
         self.assertGradientChecks(gc, op, input_tensors, 0, outputs_with_grad)
 
+    @given(num_inputs=st.integers(100, 300),
+           rows=st.integers(1, 256),
+           **hu.gcs_cpu_only)
+    def test_concat_split_many_inputs(self, num_inputs, rows, gc, dc):
+        # Up to megabytes of small slices, some of them empty, which are
+        # copied in chunks straddling the slices and the rows.
+        splits = [
+            np.random.rand(rows, np.random.randint(0, 20)).astype(np.float32)
+            for _ in range(num_inputs)
+        ]
+        split_info = np.array([a.shape[1] for a in splits], dtype=np.int32)
+        concat_op = core.CreateOperator(
+            "Concat",
+            ['X_{}'.format(i) for i in range(num_inputs)],
+            ['concat_result', 'split_info'],
+            axis=1
+        )
+        self.assertReferenceChecks(
+            gc, concat_op, splits, lambda *splits: (
+                np.concatenate(splits, axis=1),
+                split_info,
+            )
+        )
+        split_op = core.CreateOperator(
+            "Split",
+            ['input'],
+            ['X_{}'.format(i) for i in range(num_inputs)],
+            axis=1,
+            split=split_info
+        )
+        self.assertReferenceChecks(
+            gc, split_op, [np.concatenate(splits, axis=1)],
+            lambda input: splits
+        )
+
+    @given(**hu.gcs_cpu_only)
+    def test_concat_split_large(self, gc, dc):
+        # Over 16 MB, rows of large slices are copied with non-temporal
+        # stores, and the narrow slice between them normally.
+        splits = [
+            np.random.rand(1024, n).astype(np.float32)
+            for n in [2500, 3, 2501]
+        ]
+        split_info = np.array([a.shape[1] for a in splits], dtype=np.int32)
+        concat_op = core.CreateOperator(
+            "Concat",
+            ['X_{}'.format(i) for i in range(len(splits))],
+            ['concat_result', 'split_info'],
+            axis=1
+        )
+        self.assertReferenceChecks(
+            gc, concat_op, splits, lambda *splits: (
+                np.concatenate(splits, axis=1),
+                split_info,
+            )
+        )
+        split_op = core.CreateOperator(
+            "Split",
+            ['input'],
+            ['X_{}'.format(i) for i in range(len(splits))],
+            axis=1,
+            split=split_info
+        )
+        self.assertReferenceChecks(
+            gc, split_op, [np.concatenate(splits, axis=1)],
+            lambda input: splits
+        )
+
 
 if __name__ == "__main__":
     unittest.main()
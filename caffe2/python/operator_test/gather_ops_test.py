@@ -32,6 +32,28 @@ class TestGatherOps(hu.HypothesisTestCase):
 
         self.assertReferenceChecks(gc, op, [data, ind], ref_gather)
 
+    @given(rows_num=st.integers(1, 1000),
+           index_num=st.integers(0, 20000),
+           block_size=st.integers(1, 17),
+           dtype=st.sampled_from([np.float32, np.float64, np.uint8]),
+           index_type=st.sampled_from([np.int32, np.int64]),
+           **hu.gcs_cpu_only)
+    def test_gather_small_rows(
+        self, rows_num, index_num, block_size, dtype, index_type, gc, dc
+    ):
+        # Rows of 1 to 136 bytes, copied by the vectorized kernels.
+        data = (np.random.random((rows_num, block_size)) * 100).astype(dtype)
+        ind = np.random.randint(rows_num, size=(index_num, )).astype(index_type)
+        op = core.CreateOperator(
+            'Gather',
+            ['data', 'ind'],
+            ['output'])
+
+        def ref_gather(data, ind):
+            return [data[ind]]
+
+        self.assertReferenceChecks(gc, op, [data, ind], ref_gather)
+
 
 @st.composite
 def _inputs(draw):
@@ -71,6 +93,32 @@ class TestBatchGatherOps(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [data, ind], ref_batch_gather)
         self.assertGradientChecks(gc, op, [data, ind], 0, [0])
 
+    @given(batch_size=st.integers(2, 8),
+           rows_num=st.integers(1, 100),
+           index_num=st.integers(0, 2000),
+           block_size=st.integers(1, 17),
+           dtype=st.sampled_from([np.float32, np.float64, np.uint8]),
+           index_type=st.sampled_from([np.int32, np.int64]),
+           **hu.gcs_cpu_only)
+    def test_batch_gather_small_rows(
+        self, batch_size, rows_num, index_num, block_size, dtype, index_type,
+        gc, dc
+    ):
+        # Batches of rows of 1 to 136 bytes, copied by the vectorized kernels
+        # in chunks that may straddle the batches.
+        shape = (batch_size, rows_num, block_size)
+        data = (np.random.random(shape) * 100).astype(dtype)
+        ind = np.random.randint(rows_num, size=(index_num, )).astype(index_type)
+        op = core.CreateOperator(
+            'BatchGather',
+            ['data', 'ind'],
+            ['output'])
+
+        def ref_batch_gather(data, ind):
+            return [data[:, ind]]
+
+        self.assertReferenceChecks(gc, op, [data, ind], ref_batch_gather)
+
 
 class TestGatherFused8BitRowwise(hu.HypothesisTestCase):
     @given(rows_num=st.integers(1, 10000),
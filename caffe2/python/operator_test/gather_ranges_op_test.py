@@ -174,6 +174,50 @@ class TestGatherRanges(hu.HypothesisTestCase):
             reference=gather_ranges_to_dense_with_key
         )
 
+    @given(batch_size=st.integers(1, 200),
+           lengths=st.lists(st.integers(1, 20), min_size=1, max_size=5),
+           dtype=st.sampled_from([np.float32, np.float64, np.uint8]),
+           **hu.gcs_cpu_only)
+    def test_gather_ranges_to_dense_many_ranges(
+        self, batch_size, lengths, dtype, gc, dc
+    ):
+        # Up to a thousand ranges, a quarter of them empty, which are copied
+        # on the threads of the workspace.
+        data = (np.random.random(1000) * 100).astype(dtype)
+        ranges = np.zeros((batch_size, len(lengths), 2), dtype=np.int32)
+        for i in range(batch_size):
+            for j, length in enumerate(lengths):
+                if np.random.randint(4):
+                    start = np.random.randint(len(data) - length + 1)
+                    ranges[i, j] = (start, length)
+        lengths = np.array(lengths)
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=core.CreateOperator(
+                "GatherRangesToDense",
+                ['data', 'ranges'],
+                ['X_{}'.format(i) for i in range(len(lengths))],
+                lengths=lengths
+            ),
+            inputs=[data, ranges, lengths],
+            reference=gather_ranges_to_dense
+        )
+
+    @given(**hu.gcs_cpu_only)
+    def test_gather_ranges_to_dense_out_of_bounds(self, gc, dc):
+        data = np.arange(10, dtype=np.float32)
+        op = core.CreateOperator(
+            "GatherRangesToDense", ['data', 'ranges'], ['X'], lengths=[3])
+        # Ranges starting before the data or ending after it.
+        for ranges in ([[[8, 3]]], [[[-1, 3]]]):
+            self.assertRunOpRaises(
+                device_option=gc,
+                op=op,
+                inputs=[data, np.array(ranges, dtype=np.int32)],
+                exception=RuntimeError
+            )
+
     def test_shape_and_type_inference(self):
         with hu.temp_workspace("shape_type_inf_int32"):
             net = core.Net('test_net')
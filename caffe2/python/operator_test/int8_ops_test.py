@@ -0,0 +1,110 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+import unittest
+
+from caffe2.python import core, workspace
+
+
+def _run(op_type, inputs, outputs, **kwargs):
+    workspace.RunOperatorOnce(
+        core.CreateOperator(op_type, inputs, outputs, **kwargs))
+
+
+def _quantize(name, value, **kwargs):
+    workspace.FeedBlob(name + "_fp32", value)
+    _run("Int8Quantize", [name + "_fp32"], [name], **kwargs)
+
+
+def _dequantize(name):
+    _run("Int8Dequantize", [name], [name + "_fp32"])
+    return workspace.FetchBlob(name + "_fp32")
+
+
+class TestInt8Ops(unittest.TestCase):
+    def setUp(self):
+        workspace.ResetWorkspace()
+        np.random.seed(0)
+
+    def test_quantize_dequantize(self):
+        X = np.random.randn(4, 5).astype(np.float32)
+        _quantize("X", X)
+        scale = (X.max() - min(X.min(), 0)) / 255
+        np.testing.assert_allclose(_dequantize("X"), X, atol=scale)
+
+        _quantize("W", X, signed=True, per_channel=True)
+        scales = np.abs(X).max(axis=1, keepdims=True) / 127
+        np.testing.assert_allclose(
+            _dequantize("W"), X, atol=np.max(scales) / 2 + 1e-6)
+
+    def test_int8_fc(self):
+        X = np.random.rand(3, 40).astype(np.float32)
+        W = np.random.randn(6, 40).astype(np.float32) * 0.1
+        b = np.random.randn(6).astype(np.float32)
+        _quantize("X", X)
+        _quantize("W", W, signed=True, per_channel=True)
+        workspace.FeedBlob("b", b)
+        _run("Int8FC", ["X", "W", "b"], ["Y"], Y_scale=0.05, Y_zero_point=128)
+        np.testing.assert_allclose(
+            _dequantize("Y"), X.dot(W.T) + b, atol=0.1)
+
+    def test_int8_fc_new_inputs(self):
+        # The same op is run with new activations, with new weights of the
+        # same shape, which are quantized in place, and of another shape. The
+        # activations are signed so that their zero point, which multiplies
+        # the row sums of the weights, is not 0.
+        net = core.Net("int8_fc")
+        net.Int8FC(["X", "W", "b"], ["Y"], Y_scale=0.05, Y_zero_point=128)
+        for i, (m, n) in enumerate([(3, 6), (5, 6), (5, 6), (5, 4)]):
+            X = np.random.rand(m, 40).astype(np.float32) - 0.5
+            _quantize("X", X)
+            if i != 1:
+                W = np.random.randn(n, 40).astype(np.float32) * 0.1
+                b = np.random.randn(n).astype(np.float32)
+                _quantize("W", W, signed=True, per_channel=True)
+                workspace.FeedBlob("b", b)
+            if i == 0:
+                workspace.CreateNet(net)
+            workspace.RunNet(net.Name())
+            np.testing.assert_allclose(
+                _dequantize("Y"), X.dot(W.T) + b, atol=0.1)
+
+    def test_int8_conv_relu_pool(self):
+        X = np.random.rand(2, 7, 6, 5).astype(np.float32)
+        W = np.random.randn(4, 3, 3, 5).astype(np.float32) * 0.1
+        b = np.random.randn(4).astype(np.float32)
+        workspace.FeedBlob("X_ref", X)
+        workspace.FeedBlob("W_ref", W)
+        workspace.FeedBlob("b", b)
+        conv_args = dict(kernel=3, pad=1, stride=2, order="NHWC")
+        pool_args = dict(kernel=2, stride=2, order="NHWC")
+        _run("Conv", ["X_ref", "W_ref", "b"], ["Y_ref"], **conv_args)
+        _run("Relu", ["Y_ref"], ["Y_ref"])
+        _run("MaxPool", ["Y_ref"], ["P_ref"], **pool_args)
+
+        _quantize("X", X)
+        _quantize("W", W, signed=True)
+        _run(
+            "Int8Conv", ["X", "W", "b"], ["Y"],
+            Y_scale=0.05, Y_zero_point=128, **conv_args)
+        _run("Int8Relu", ["Y"], ["Y"])
+        _run("Int8MaxPool", ["Y"], ["P"], **pool_args)
+        np.testing.assert_allclose(
+            _dequantize("Y"), workspace.FetchBlob("Y_ref"), atol=0.15)
+        np.testing.assert_allclose(
+            _dequantize("P"), workspace.FetchBlob("P_ref"), atol=0.15)
+
+    def test_int8_add(self):
+        A = np.random.rand(3, 4).astype(np.float32)
+        B = np.random.randn(3, 4).astype(np.float32)
+        _quantize("A", A)
+        _quantize("B", B)
+        _run("Int8Add", ["A", "B"], ["Y"], Y_scale=0.05, Y_zero_point=128)
+        np.testing.assert_allclose(_dequantize("Y"), A + B, atol=0.06)
+
+
+if __name__ == "__main__":
+    unittest.main()
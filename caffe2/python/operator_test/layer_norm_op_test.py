@@ -124,6 +124,33 @@ class TestLayerNormOp(hu.HypothesisTestCase):
             outputs_to_check=[0, 1, 2],
         )
 
+    @given(**hu.gcs_cpu_only)
+    def test_layer_norm_op_large_mean(self, gc, dc):
+        # E[x^2] - E[x]^2 would lose the variance of these rows in float.
+        X = (1000 + np.random.rand(8, 300)).astype(np.float32)
+        epsilon = 1e-5
+        op = core.CreateOperator(
+            "LayerNorm",
+            ["input"],
+            ["output", "mean", "stdev"],
+            axis=1,
+            epsilon=epsilon,
+        )
+
+        def layer_norm_ref(X):
+            X = X.astype(np.float64)
+            mean = np.mean(X, axis=1, keepdims=True)
+            stdev = np.sqrt(np.var(X, axis=1, keepdims=True) + epsilon)
+            return [(X - mean) / stdev, mean, stdev]
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X],
+            reference=layer_norm_ref,
+            threshold=1e-3,
+        )
+
     @given(X=hu.tensors(n=1), **hu.gcs)
     def test_layer_norm_brew_wrapper(self, X, gc, dc):
         X = X[0]
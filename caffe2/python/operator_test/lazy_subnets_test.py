@@ -0,0 +1,83 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+import unittest
+
+from caffe2.python import core, workspace
+
+
+def _const_net(name, blob, value):
+    net = core.Net(name)
+    net.ConstantFill([], blob, shape=[1], value=value)
+    return net.Proto()
+
+
+class TestLazySubnets(unittest.TestCase):
+    def setUp(self):
+        workspace.ResetWorkspace()
+
+    def _run_if(self, condition, **kwargs):
+        workspace.FeedBlob("cond", np.array(condition))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "If",
+            ["cond"],
+            [],
+            then_net=_const_net("then", "then_out", 1.0),
+            else_net=_const_net("else", "else_out", 2.0),
+            **kwargs
+        ))
+
+    def test_if_eager(self):
+        self._run_if(True)
+        # Both branches have been created, so both outputs exist.
+        self.assertTrue(workspace.HasBlob("then_out"))
+        self.assertTrue(workspace.HasBlob("else_out"))
+        np.testing.assert_array_equal(workspace.FetchBlob("then_out"), [1.0])
+
+    def test_if_lazy(self):
+        self._run_if(True, lazy_subnets=True)
+        np.testing.assert_array_equal(workspace.FetchBlob("then_out"), [1.0])
+        self.assertFalse(workspace.HasBlob("else_out"))
+
+        self._run_if(False, lazy_subnets=True)
+        np.testing.assert_array_equal(workspace.FetchBlob("else_out"), [2.0])
+
+    def test_if_evict(self):
+        workspace.FeedBlob("cond", np.array(True))
+        op = core.CreateOperator(
+            "If",
+            ["cond"],
+            [],
+            then_net=_const_net("then", "then_out", 1.0),
+            else_net=_const_net("else", "else_out", 2.0),
+            lazy_subnets=True,
+            evict_subnets_after=1,
+        )
+        net = core.Net("if_net")
+        net.Proto().op.extend([op])
+        workspace.CreateNet(net)
+        for condition in [True, False, True, False]:
+            workspace.FeedBlob("cond", np.array(condition))
+            workspace.RunNet(net)
+            expected = [1.0] if condition else [2.0]
+            out = "then_out" if condition else "else_out"
+            np.testing.assert_array_equal(workspace.FetchBlob(out), expected)
+
+    def test_while_lazy(self):
+        workspace.FeedBlob("cond", np.array(False))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "While",
+            ["cond"],
+            [],
+            loop_net=_const_net("loop", "loop_out", 1.0),
+            lazy_subnets=True,
+        ))
+        # The loop never ran, so its net was never created.
+        self.assertFalse(workspace.HasBlob("loop_out"))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -242,6 +242,37 @@ class TestBatchMatMul(hu.HypothesisTestCase):
 
         self._test_batch_matmul_with_broadcast_common(X, Y, dtype, gc, dc, trans_a, trans_b)
 
+    @given(
+        C=st.integers(min_value=1, max_value=3),  # number of batch dims
+        M=st.integers(min_value=1, max_value=10),
+        K=st.integers(min_value=1, max_value=10),
+        N=st.integers(min_value=1, max_value=10),
+        trans_a=st.booleans(),
+        trans_b=st.booleans(),
+        **hu.gcs
+    )
+    def test_numpy_batch_matmul_broadcast_ones(
+        self, C, M, K, N, trans_a, trans_b, gc, dc
+    ):
+        dtype = np.float32
+        batch_dims = np.random.randint(
+            low=1,
+            high=4,
+            size=C,
+            dtype=np.int64).tolist()
+        # Each batch dimension is 1 in X, in Y, or in neither of them.
+        ones = np.random.randint(low=0, high=3, size=C).tolist()
+        X_dims = [1 if o == 0 else d for d, o in zip(batch_dims, ones)]
+        Y_dims = [1 if o == 1 else d for d, o in zip(batch_dims, ones)]
+        X = np.random.rand(*(X_dims + [M, K])).astype(dtype) - 0.5
+        if trans_a:
+            X = X.swapaxes(-1, -2)
+        Y = np.random.rand(*(Y_dims + [K, N])).astype(dtype) - 0.5
+        if trans_b:
+            Y = Y.swapaxes(-1, -2)
+
+        self._test_batch_matmul_with_broadcast_common(X, Y, dtype, gc, dc, trans_a, trans_b)
+
     @settings(max_examples=30)
     @given(
         K=st.integers(min_value=1, max_value=10),
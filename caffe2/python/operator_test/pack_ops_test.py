@@ -99,6 +99,36 @@ class TestTensorPackOps(hu.HypothesisTestCase):
             device_option=gc))
         assert((workspace.FetchBlob('newd') == workspace.FetchBlob('d')).all())
 
+    @given(
+        num_seq=st.integers(1, 200),
+        block_size=st.integers(1, 17),
+        **hu.gcs_cpu_only
+    )
+    def test_pack_ops_small_rows(self, num_seq, block_size, gc, dc):
+        # Segments of short rows, some of them empty, which are copied on the
+        # threads of the workspace.
+        lengths = np.random.randint(0, 20, size=num_seq).astype(np.int32)
+        lengths[0] = 20
+        data = np.random.rand(np.sum(lengths), block_size).astype(np.float32)
+        pack_op = core.CreateOperator(
+            'PackSegments', ['l', 'd'], ['t'])
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=pack_op,
+            inputs=[lengths, data],
+            reference=self.pack_segments_ref(),
+        )
+
+        packed = np.array(self.pack_segments_ref()(lengths, data)[0])
+        unpack_op = core.CreateOperator(
+            'UnpackSegments', ['l', 't'], ['d'])
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=unpack_op,
+            inputs=[lengths, packed],
+            reference=lambda lengths, packed: [data],
+        )
+
     @given(
         **hu.gcs_cpu_only
     )
@@ -251,6 +281,36 @@ class TestTensorPackOps(hu.HypothesisTestCase):
             exception=RuntimeError
         )
 
+    @given(**hu.gcs_cpu_only)
+    def test_negative_lengths(self, gc, dc):
+        # The lengths add up to the number of rows, but one is negative.
+        lengths = np.array([2, -1, 3], dtype=np.int32)
+        data = np.ones((4, 2), dtype=np.float32)
+        op = core.CreateOperator(
+            'PackSegments', ['l', 'd'], ['t'])
+
+        self.assertRunOpRaises(
+            device_option=gc,
+            op=op,
+            inputs=[lengths, data],
+            exception=RuntimeError
+        )
+
+    @given(**hu.gcs_cpu_only)
+    def test_unpack_out_of_bounds(self, gc, dc):
+        # The segments are packed into 2 rows, which a length of 3 overruns.
+        lengths = np.array([1, 3, 2], dtype=np.int32)
+        packed = np.ones((3, 2, 2), dtype=np.float32)
+        op = core.CreateOperator(
+            'UnpackSegments', ['l', 't'], ['d'])
+
+        self.assertRunOpRaises(
+            device_option=gc,
+            op=op,
+            inputs=[lengths, packed],
+            exception=RuntimeError
+        )
+
 
 if __name__ == "__main__":
     import unittest
@@ -0,0 +1,137 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+def index_hash(index, seed, modulo, dtype):
+    hashed = dtype.type(0xDEADBEEF * seed)
+    for b in np.array([index], dtype).view(np.int8):
+        hashed = dtype.type(hashed * 65537 + b)
+    return (modulo + hashed % modulo) % modulo
+
+
+def random_config(num_features):
+    hash = np.random.randint(0, 2, size=num_features).tolist()
+    seeds = np.random.randint(0, 10, size=num_features).tolist()
+    modulos = [
+        np.random.randint(1, 50) if h else np.random.randint(0, 10)
+        for h in hash
+    ]
+    dedup = np.random.randint(0, 2, size=num_features).tolist()
+    max_lengths = np.random.randint(0, 5, size=num_features).tolist()
+    default_ids = [
+        np.random.randint(-1, m) if m else np.random.randint(-1, 5)
+        for m in modulos
+    ]
+    return dict(
+        hash=hash,
+        seeds=seeds,
+        modulos=modulos,
+        dedup=dedup,
+        max_lengths=max_lengths,
+        default_ids=default_ids,
+    )
+
+
+def preprocess_ref(data, ranges, config):
+    batch_size, num_features = ranges.shape[:2]
+    results = []
+    for f in range(num_features):
+        indices = []
+        out_lengths = []
+        for i in range(batch_size):
+            start, length = ranges[i, f]
+            ids = []
+            for index in data[start:start + length]:
+                if config["hash"][f]:
+                    index = index_hash(
+                        index,
+                        config["seeds"][f],
+                        config["modulos"][f],
+                        data.dtype)
+                elif config["modulos"][f]:
+                    index = index % config["modulos"][f]
+                if config["dedup"][f] and index in ids:
+                    continue
+                ids.append(index)
+            if config["max_lengths"][f]:
+                ids = ids[:config["max_lengths"][f]]
+            if not ids and config["default_ids"][f] >= 0:
+                ids = [config["default_ids"][f]]
+            indices += ids
+            out_lengths.append(len(ids))
+        results.append(np.array(indices, dtype=data.dtype))
+        results.append(np.array(out_lengths, dtype=np.int32))
+    return results
+
+
+def random_inputs(batch_size, num_features, max_length, dtype):
+    lengths = np.random.randint(
+        0, max_length, size=(batch_size, num_features)).astype(np.int32)
+    data = np.random.randint(
+        -20, 20, size=lengths.sum()).astype(dtype)
+    ranges = np.zeros((batch_size, num_features, 2), dtype=np.int32)
+    ranges[:, :, 0] = np.cumsum(lengths).reshape(lengths.shape) - lengths
+    ranges[:, :, 1] = lengths
+    return data, ranges
+
+
+def create_op(num_features, config):
+    outputs = []
+    for f in range(num_features):
+        outputs += ["indices_%d" % f, "lengths_%d" % f]
+    return core.CreateOperator(
+        "PreprocessIdListFeatures", ["data", "ranges"], outputs, **config)
+
+
+class TestPreprocessIdListFeatures(hu.HypothesisTestCase):
+    @given(
+        dtype=st.sampled_from([np.int32, np.int64]),
+        num_features=st.integers(min_value=1, max_value=4),
+        batch_size=st.integers(min_value=0, max_value=6),
+        seed=st.integers(min_value=0, max_value=10),
+        **hu.gcs_cpu_only
+    )
+    def test_preprocess_id_list_features(
+            self, dtype, num_features, batch_size, seed, gc, dc):
+        np.random.seed(seed)
+        data, ranges = random_inputs(batch_size, num_features, 30, dtype)
+        config = random_config(num_features)
+        op = create_op(num_features, config)
+        self.assertReferenceChecks(
+            gc, op, [data, ranges],
+            lambda data, ranges: preprocess_ref(data, ranges, config))
+
+    def test_preprocess_id_list_features_threaded(self):
+        # Enough features and ids for the features to be processed on the
+        # threads of the workspace.
+        np.random.seed(0)
+        num_features = 16
+        data, ranges = random_inputs(256, num_features, 20, np.int64)
+        config = random_config(num_features)
+        workspace.FeedBlob("data", data)
+        workspace.FeedBlob("ranges", ranges)
+        workspace.RunOperatorOnce(create_op(num_features, config))
+        expected = preprocess_ref(data, ranges, config)
+        for f in range(num_features):
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("indices_%d" % f), expected[2 * f])
+            np.testing.assert_array_equal(
+                workspace.FetchBlob("lengths_%d" % f), expected[2 * f + 1])
+
+    def test_invalid_range(self):
+        op = core.CreateOperator(
+            "PreprocessIdListFeatures",
+            ["data", "ranges"],
+            ["indices", "lengths"],
+        )
+        workspace.FeedBlob("data", np.array([1, 2, 3], dtype=np.int64))
+        workspace.FeedBlob("ranges", np.array([[[1, 3]]], dtype=np.int32))
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(op)
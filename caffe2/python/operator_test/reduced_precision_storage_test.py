@@ -0,0 +1,91 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+import unittest
+
+from caffe2.python import core, workspace
+
+
+_TO = {"fp16": "FloatToHalf", "bf16": "FloatToBFloat16"}
+_FROM = {"fp16": "HalfToFloat", "bf16": "BFloat16ToFloat"}
+# Relative error of a single rounding to each storage type.
+_EPS = {"fp16": 2.0 ** -11, "bf16": 2.0 ** -8}
+
+
+def _run(op_type, inputs, outputs, **kwargs):
+    workspace.RunOperatorOnce(
+        core.CreateOperator(op_type, inputs, outputs, **kwargs))
+
+
+def _to(name, storage):
+    _run(_TO[storage], [name], [name + "_" + storage])
+    return name + "_" + storage
+
+
+def _fetch(name, storage):
+    _run(_FROM[storage], [name], [name + "_fp32"])
+    return workspace.FetchBlob(name + "_fp32")
+
+
+class TestReducedPrecisionStorage(unittest.TestCase):
+    def setUp(self):
+        workspace.ResetWorkspace()
+        np.random.seed(0)
+
+    def test_round_trip(self):
+        X = np.random.randn(7, 33).astype(np.float32)
+        workspace.FeedBlob("X", X)
+        for storage in ["fp16", "bf16"]:
+            np.testing.assert_allclose(
+                _fetch(_to("X", storage), storage), X, rtol=_EPS[storage])
+
+    def _check_fc(self, op_type, x_storage, w_storage):
+        X = np.random.randn(5, 300).astype(np.float32)
+        W = np.random.randn(40, 300).astype(np.float32)
+        b = np.random.randn(40).astype(np.float32)
+        if op_type == "FCTransposed":
+            W = np.ascontiguousarray(W.T)
+        workspace.FeedBlob("X", X)
+        workspace.FeedBlob("W", W)
+        workspace.FeedBlob("b", b)
+        _run(op_type, ["X", "W", "b"], ["Y_ref"])
+        X_name = _to("X", x_storage) if x_storage else "X"
+        W_name = _to("W", w_storage) if w_storage else "W"
+        _run(op_type, [X_name, W_name, "b"], ["Y"])
+        Y = _fetch("Y", x_storage) if x_storage else workspace.FetchBlob("Y")
+        eps = max(_EPS.get(x_storage, 0), _EPS.get(w_storage, 0))
+        # Each product is rounded at most twice, then summed in fp32.
+        atol = 3 * eps * np.abs(X).dot(np.abs(W.T if op_type == "FC" else W))
+        np.testing.assert_array_less(
+            np.abs(Y - workspace.FetchBlob("Y_ref")),
+            atol + 2 * eps * np.abs(workspace.FetchBlob("Y_ref")) + 1e-4)
+
+    def test_fc(self):
+        for op_type in ["FC", "FCTransposed"]:
+            for storage in ["fp16", "bf16"]:
+                self._check_fc(op_type, None, storage)
+                self._check_fc(op_type, storage, storage)
+
+    def test_sparse_lengths_sum(self):
+        D = np.random.randn(20, 37).astype(np.float32)
+        I = np.random.randint(0, 20, size=9).astype(np.int64)
+        L = np.array([2, 0, 4, 3], dtype=np.int32)
+        workspace.FeedBlob("D", D)
+        workspace.FeedBlob("I", I)
+        workspace.FeedBlob("L", L)
+        for storage in ["fp16", "bf16"]:
+            D_rounded = _fetch(_to("D", storage), storage)
+            _run("SparseLengthsSum", ["D_" + storage, "I", "L"], ["Y"])
+            offsets = np.cumsum(np.concatenate([[0], L]))
+            expected = np.stack([
+                D_rounded[I[offsets[i]:offsets[i + 1]]].sum(axis=0)
+                for i in range(len(L))])
+            np.testing.assert_allclose(
+                workspace.FetchBlob("Y"), expected, rtol=1e-5, atol=1e-5)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,88 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+
+
+def _rois(num_rois, batch_size, height, width):
+    rois = np.zeros((num_rois, 5), dtype=np.float32)
+    rois[:, 0] = np.random.randint(0, batch_size, size=num_rois)
+    xy = np.random.rand(num_rois, 2) * [width - 2, height - 2]
+    wh = np.random.rand(num_rois, 2) * [width / 2, height / 2] + 1
+    rois[:, 1:3] = xy
+    rois[:, 3:5] = xy + wh
+    return rois
+
+
+class TestRoIOps(hu.HypothesisTestCase):
+    @given(
+        batch_size=st.integers(1, 3),
+        channels=st.integers(1, 20),
+        num_rois=st.integers(1, 10),
+        pooled=st.integers(1, 4),
+        sampling_ratio=st.integers(0, 2),
+        **hu.gcs_cpu_only
+    )
+    def test_roi_align_nhwc(
+            self, batch_size, channels, num_rois, pooled, sampling_ratio,
+            gc, dc):
+        X = np.random.randn(batch_size, channels, 10, 12).astype(np.float32)
+        R = _rois(num_rois, batch_size, 10, 12)
+
+        def op(order):
+            return core.CreateOperator(
+                "RoIAlign",
+                ["X", "R"],
+                ["Y"],
+                pooled_h=pooled,
+                pooled_w=pooled,
+                sampling_ratio=sampling_ratio,
+                order=order,
+            )
+
+        workspace.FeedBlob("X", X)
+        workspace.FeedBlob("R", R)
+        workspace.RunOperatorOnce(op("NCHW"))
+        Y = workspace.FetchBlob("Y")
+
+        X_nhwc = X.transpose(0, 2, 3, 1).copy()
+        self.assertReferenceChecks(
+            gc,
+            op("NHWC"),
+            [X_nhwc, R],
+            lambda X_nhwc, R: [Y.transpose(0, 2, 3, 1)],
+        )
+        self.assertGradientChecks(gc, op("NCHW"), [X, R], 0, [0])
+        self.assertGradientChecks(gc, op("NHWC"), [X_nhwc, R], 0, [0])
+
+    @given(
+        batch_size=st.integers(1, 3),
+        channels=st.integers(1, 10),
+        num_rois=st.integers(1, 10),
+        pooled=st.integers(1, 4),
+        **hu.gcs_cpu_only
+    )
+    def test_roi_pool_gradient(
+            self, batch_size, channels, num_rois, pooled, gc, dc):
+        # Distinct values, so the max of each bin is unique
+        X = np.random.permutation(batch_size * channels * 10 * 12).astype(
+            np.float32).reshape(batch_size, channels, 10, 12) / 10.
+        R = _rois(num_rois, batch_size, 10, 12)
+        op = core.CreateOperator(
+            "RoIPool",
+            ["X", "R"],
+            ["Y", "argmaxes"],
+            pooled_h=pooled,
+            pooled_w=pooled,
+        )
+        self.assertGradientChecks(gc, op, [X, R], 0, [0], stepsize=1e-3)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -0,0 +1,185 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
+from hypothesis import given
+import caffe2.python.hypothesis_test_util as hu
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+def log_uniform_probability(k, num_classes):
+    return np.log1p(1.0 / (k + 1)) / np.log1p(num_classes)
+
+
+class TestSampledSoftmax(hu.HypothesisTestCase):
+    def test_log_uniform_sampling(self):
+        num_classes = 20
+        num_samples = 100000
+        op = core.CreateOperator(
+            "LogUniformSampling",
+            [],
+            ["samples"],
+            range=num_classes,
+            num_samples=num_samples,
+        )
+        workspace.RunOperatorOnce(op)
+        samples = workspace.FetchBlob("samples")
+        self.assertEqual(samples.shape, (num_samples,))
+        self.assertTrue(np.all((samples >= 0) & (samples < num_classes)))
+        frequencies = np.bincount(samples, minlength=num_classes) / num_samples
+        np.testing.assert_allclose(
+            frequencies,
+            log_uniform_probability(np.arange(num_classes), num_classes),
+            atol=0.01)
+
+        # test shape input
+        workspace.FeedBlob("shape", np.zeros((3, 4), dtype=np.float32))
+        op = core.CreateOperator(
+            "LogUniformSampling", ["shape"], ["samples_2"], range=num_classes)
+        workspace.RunOperatorOnce(op)
+        self.assertEqual(workspace.FetchBlob("samples_2").shape, (3, 4))
+
+    @given(
+        batch_size=st.integers(min_value=1, max_value=10),
+        dim_in=st.integers(min_value=1, max_value=8),
+        num_classes=st.integers(min_value=2, max_value=50),
+        num_sampled=st.integers(min_value=1, max_value=20),
+        remove_accidental_hits=st.booleans(),
+        **hu.gcs_cpu_only
+    )
+    def test_sampled_softmax(
+            self, batch_size, dim_in, num_classes, num_sampled,
+            remove_accidental_hits, gc, dc):
+        num_sampled = min(num_sampled, num_classes - 1)
+        X = np.random.randn(batch_size, dim_in).astype(np.float32)
+        W = np.random.randn(num_classes, dim_in).astype(np.float32)
+        b = np.random.randn(num_classes).astype(np.float32)
+        labels = np.random.randint(
+            0, num_classes, size=batch_size).astype(np.int32)
+
+        op = core.CreateOperator(
+            "SampledSoftmax",
+            ["X", "W", "b", "labels"],
+            ["Y", "candidates", "probabilities"],
+            num_sampled=num_sampled,
+            remove_accidental_hits=remove_accidental_hits,
+            subtract_log_q=False,
+        )
+        workspace.FeedBlob("X", X)
+        workspace.FeedBlob("W", W)
+        workspace.FeedBlob("b", b)
+        workspace.FeedBlob("labels", labels)
+        workspace.RunOperatorOnce(op)
+        Y = workspace.FetchBlob("Y")
+        candidates = workspace.FetchBlob("candidates")
+        probabilities = workspace.FetchBlob("probabilities")
+
+        np.testing.assert_array_equal(candidates[:batch_size], labels)
+        sampled = candidates[batch_size:]
+        self.assertEqual(len(np.unique(sampled)), num_sampled)
+        self.assertTrue(np.all((sampled >= 0) & (sampled < num_classes)))
+
+        classes = np.concatenate(
+            [labels[:, np.newaxis], np.tile(sampled, (batch_size, 1))], axis=1)
+        logits = np.einsum("ik,ijk->ij", X, W[classes]) + b[classes]
+        if remove_accidental_hits:
+            hits = classes[:, 1:] == labels[:, np.newaxis]
+            logits[:, 1:][hits] = -np.inf
+        logits -= logits.max(axis=1, keepdims=True)
+        expected = np.exp(logits)
+        expected /= expected.sum(axis=1, keepdims=True)
+        np.testing.assert_allclose(
+            probabilities, expected, rtol=1e-4, atol=1e-5)
+        np.testing.assert_allclose(
+            Y, -np.log(expected[:, 0]), rtol=1e-4, atol=1e-4)
+
+    def test_sampled_softmax_most_classes(self):
+        # Rejecting repeated classes would take many times more draws than
+        # there are classes.
+        num_classes = 100000
+        num_sampled = num_classes - 1
+        workspace.FeedBlob("X", np.random.randn(2, 4).astype(np.float32))
+        workspace.FeedBlob(
+            "W", np.random.randn(num_classes, 4).astype(np.float32))
+        workspace.FeedBlob(
+            "b", np.random.randn(num_classes).astype(np.float32))
+        workspace.FeedBlob(
+            "labels", np.array([0, num_classes - 1], dtype=np.int32))
+        op = core.CreateOperator(
+            "SampledSoftmax",
+            ["X", "W", "b", "labels"],
+            ["Y", "candidates", "probabilities"],
+            num_sampled=num_sampled,
+        )
+        workspace.RunOperatorOnce(op)
+        sampled = workspace.FetchBlob("candidates")[2:]
+        self.assertEqual(len(np.unique(sampled)), num_sampled)
+        self.assertTrue(np.all((sampled >= 0) & (sampled < num_classes)))
+        probabilities = workspace.FetchBlob("probabilities")
+        self.assertTrue(np.all(np.isfinite(probabilities)))
+        np.testing.assert_allclose(probabilities.sum(axis=1), 1, rtol=1e-4)
+
+    def test_sampled_classes_distribution(self):
+        # Without rejection, the classes are still distributed as distinct
+        # draws from the log-uniform distribution.
+        num_classes = 8
+        num_sampled = 4
+        num_runs = 5000
+        workspace.FeedBlob("X", np.random.randn(1, 2).astype(np.float32))
+        workspace.FeedBlob(
+            "W", np.random.randn(num_classes, 2).astype(np.float32))
+        workspace.FeedBlob(
+            "b", np.random.randn(num_classes).astype(np.float32))
+        workspace.FeedBlob("labels", np.array([0], dtype=np.int32))
+        op = core.CreateOperator(
+            "SampledSoftmax",
+            ["X", "W", "b", "labels"],
+            ["Y", "candidates", "probabilities"],
+            num_sampled=num_sampled,
+        )
+        counts = np.zeros(num_classes)
+        expected = np.zeros(num_classes)
+        probability = log_uniform_probability(
+            np.arange(num_classes), num_classes)
+        for _ in range(num_runs):
+            workspace.RunOperatorOnce(op)
+            counts[workspace.FetchBlob("candidates")[1:]] += 1
+            expected[np.random.choice(
+                num_classes, num_sampled, replace=False, p=probability)] += 1
+        np.testing.assert_allclose(
+            counts / num_runs, expected / num_runs, atol=0.05)
+
+    @given(
+        batch_size=st.integers(min_value=1, max_value=5),
+        dim_in=st.integers(min_value=1, max_value=5),
+        **hu.gcs_cpu_only
+    )
+    def test_sampled_softmax_gradient(self, batch_size, dim_in, gc, dc):
+        num_classes = 30
+        X = np.random.rand(batch_size, dim_in).astype(np.float32) - 0.5
+        W = np.random.rand(num_classes, dim_in).astype(np.float32) - 0.5
+        b = np.random.rand(num_classes).astype(np.float32) - 0.5
+        labels = np.random.randint(
+            0, num_classes, size=batch_size).astype(np.int32)
+
+        op = core.CreateOperator(
+            "SampledSoftmax",
+            ["X", "W", "b", "labels"],
+            ["Y", "candidates", "probabilities"],
+            num_sampled=8,
+        )
+        # The same classes have to be sampled for every run of the op.
+        device_option = caffe2_pb2.DeviceOption()
+        device_option.CopyFrom(gc)
+        device_option.random_seed = 1
+        for i in range(3):
+            self.assertGradientChecks(
+                device_option, op, [X, W, b, labels], i, [0])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -418,6 +418,49 @@ class TestSegmentOps(hu.HypothesisTestCase):
         op = core.CreateOperator("UnsortedSegmentMean", ["X", "segments"], "out")
         self.assertDeviceChecks(dc, op, [X, segments], [0])
 
+    @given(**hu.gcs_cpu_only)
+    def test_segment_ops_parallel(self, gc, dc):
+        # Large enough for the segments to be split across threads.
+        X = np.random.rand(20000, 128).astype(np.float32)
+        segments = np.random.randint(0, 1000, size=20000).astype(np.int32)
+        sorted_segments = np.sort(segments)
+        sorted_segments = np.unique(
+            sorted_segments, return_inverse=True)[1].astype(np.int32)
+        lengths = np.bincount(sorted_segments).astype(np.int32)
+
+        def sum_ref(X, segments):
+            out = np.zeros((segments.max() + 1, X.shape[1]), dtype=np.float32)
+            np.add.at(out, segments, X)
+            return (out,)
+
+        def mean_ref(X, segments):
+            counts = np.bincount(segments, minlength=segments.max() + 1)
+            out = sum_ref(X, segments)[0]
+            return (out / np.maximum(counts, 1)[:, np.newaxis],)
+
+        def lengths_max_ref(X, lengths):
+            offsets = np.cumsum(np.concatenate(([0], lengths)))
+            return (np.array([X[offsets[i]:offsets[i + 1]].max(axis=0)
+                              for i in range(len(lengths))]),)
+
+        self.assertReferenceChecks(
+            gc,
+            core.CreateOperator(
+                "SortedSegmentSum", ["X", "segments"], "out"),
+            [X, sorted_segments],
+            sum_ref)
+        self.assertReferenceChecks(
+            gc,
+            core.CreateOperator(
+                "UnsortedSegmentMean", ["X", "segments"], "out"),
+            [X, segments],
+            mean_ref)
+        self.assertReferenceChecks(
+            gc,
+            core.CreateOperator("LengthsMax", ["X", "lengths"], "out"),
+            [X, lengths],
+            lengths_max_ref)
+
     @given(
         inputs=hu.lengths_tensor(
             dtype=np.float32,
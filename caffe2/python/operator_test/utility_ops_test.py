@@ -91,6 +91,23 @@ class TestUtilityOps(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [X, axes],
                                    transpose_ref)
 
+    def test_transpose_empty(self):
+        for shape in [(0, 5), (5, 0)]:
+            X = np.zeros(shape, dtype=np.float32)
+            workspace.FeedBlob("X", X)
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "Transpose", ["X"], ["Y"], axes=[1, 0]))
+            np.testing.assert_array_equal(workspace.FetchBlob("Y"), X.T)
+
+        X = np.zeros((0, 3, 4, 5), dtype=np.float32)
+        workspace.FeedBlob("X", X)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "NCHW2NHWC", ["X"], ["Y"]))
+        self.assertEqual(workspace.FetchBlob("Y").shape, (0, 4, 5, 3))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "NHWC2NCHW", ["Y"], ["Z"]))
+        self.assertEqual(workspace.FetchBlob("Z").shape, (0, 3, 4, 5))
+
 
     @given(m=st.integers(5, 10), n=st.integers(5, 10),
            o=st.integers(5, 10), nans=st.booleans(), **hu.gcs)
@@ -71,3 +71,23 @@ class TestPredictor(unittest.TestCase):
         })
         self.assertEqual(len(outputs), 1)
         np.testing.assert_almost_equal(np.dot(A, B), outputs[0])
+
+    def test_run_outputs(self):
+        A = np.zeros((2, 3), np.float32)
+        B = np.ones((3, 4), np.float32)
+        net = caffe2_pb2.NetDef()
+        net.ParseFromString(self.predict_net)
+        net.external_output.append('D')
+        net.op.extend([core.CreateOperator('Relu', ['C'], ['D'])])
+        predictor = workspace.Predictor(
+            self.init_net, net.SerializeToString())
+        outputs = predictor.run({
+            'B': B,
+        }, ['C'])
+        self.assertEqual(len(outputs), 1)
+        np.testing.assert_almost_equal(np.dot(A, B), outputs[0])
+        outputs = predictor.run({
+            'B': B,
+        }, ['D', 'C'])
+        self.assertEqual(len(outputs), 2)
+        np.testing.assert_almost_equal(np.dot(A, B), outputs[1])
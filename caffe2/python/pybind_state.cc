@@ -155,12 +155,13 @@ const Func& getGradientFunc(const std::string& token) {
   return getOpFunc(token + "_gradient");
 }
 
-py::object fetchBlob(Workspace* ws, const std::string& name) {
+py::object
+fetchBlob(Workspace* ws, const std::string& name, bool copy = true) {
   CAFFE_ENFORCE(ws->HasBlob(name), "Can't find blob: ", name);
   const caffe2::Blob& blob = *(ws->GetBlob(name));
   auto fetcher = CreateFetcher(blob.meta().id());
   if (fetcher) {
-    return fetcher->Fetch(blob);
+    return copy ? fetcher->Fetch(blob) : fetcher->FetchShared(blob);
   } else {
     // If there is no fetcher registered, return a metainfo string.
     // If all branches failed, we will return a metainfo string.
@@ -274,14 +275,18 @@ void addObjectMethods(py::module& m) {
           })
       .def(
           "fetch",
-          [](const Blob& blob) {
+          [](const Blob& blob, bool copy) {
             auto fetcher = CreateFetcher(blob.meta().id());
             CAFFE_ENFORCE(
                 fetcher,
                 "Could not fetch for blob of type: ",
                 blob.meta().name());
-            return fetcher->Fetch(blob);
-          })
+            return copy ? fetcher->Fetch(blob) : fetcher->FetchShared(blob);
+          },
+          "Fetch the blob's content. With copy=False, tensors are returned "
+          "as read-only numpy arrays sharing memory with the blob when "
+          "possible.",
+          py::arg("copy") = true)
       .def(
           "tensor",
           [](Blob* blob) { return py::cast(blob->GetMutable<TensorCPU>()); },
@@ -290,7 +295,8 @@ void addObjectMethods(py::module& m) {
           "_feed",
           [](Blob* blob,
              const py::object& arg,
-             const py::object device_option) {
+             const py::object device_option,
+             bool zero_copy) {
             DeviceOption option;
             if (!device_option.is(py::none())) {
               // If we have a device option passed in, read it.
@@ -303,7 +309,11 @@ void addObjectMethods(py::module& m) {
               auto feeder = CreateFeeder(option.device_type());
               CAFFE_ENFORCE(
                   feeder, "Unknown device type encountered in FeedBlob.");
-              feeder->Feed(option, array, blob);
+              if (zero_copy) {
+                feeder->FeedShared(option, array, blob);
+              } else {
+                feeder->Feed(option, array, blob);
+              }
               return true;
             }
 
@@ -315,9 +325,12 @@ void addObjectMethods(py::module& m) {
                 "Unexpected type of argument - only numpy array or string are "
                 "supported for feeding");
           },
-          "Feed an input array or string, with the (optional) DeviceOption",
+          "Feed an input array or string, with the (optional) DeviceOption. "
+          "With zero_copy=True, the blob borrows the memory of the array "
+          "when possible instead of copying it.",
           py::arg("arg"),
-          py::arg("device_option") = py::none());
+          py::arg("device_option") = py::none(),
+          py::arg("zero_copy") = false);
 
   py::class_<DLPackWrapper<CPUContext>>(m, "DLPackTensorCPU")
       .def_property_readonly(
@@ -339,7 +352,7 @@ void addObjectMethods(py::module& m) {
                 "Expected CPU device option for CPU tensor");
             t->feed(obj);
           },
-          "Copy data from given DLPack tensor into this tensor.")
+          "Share data of given DLPack tensor with this tensor.")
       .def_property_readonly(
           "_shape",
           [](const DLPackWrapper<CPUContext>& t) {
@@ -448,7 +461,11 @@ void addObjectMethods(py::module& m) {
             return py::cast(self->CreateBlob(name));
           },
           py::return_value_policy::reference_internal)
-      .def("fetch_blob", &python_detail::fetchBlob)
+      .def(
+          "fetch_blob",
+          &python_detail::fetchBlob,
+          py::arg("name"),
+          py::arg("copy") = true)
       .def(
           "has_blob",
           [](Workspace* self, const std::string& name) {
@@ -815,10 +832,39 @@ void addObjectMethods(py::module& m) {
                   TensorFetcher<CPUContext>().FetchTensor(*t, true).obj);
             }
             return pyout;
+          })
+      .def(
+          "run",
+          [](Predictor& instance,
+             std::map<std::string, py::object> inputs,
+             std::vector<std::string> output_names)
+              -> std::vector<py::object> {
+            Predictor::TensorMap tensors;
+            std::map<std::string, TensorCPU> tensors_data{};
+            for (const auto pair : inputs) {
+              const auto& name = pair.first;
+              const auto& input = pair.second;
+              CAFFE_ENFORCE(
+                  PyArray_Check(input.ptr()),
+                  "Input must be of type numpy array.");
+              PyArrayObject* array =
+                  reinterpret_cast<PyArrayObject*>(input.ptr());
+              TensorFeeder<CPUContext>().FeedTensor(
+                  DeviceOption(), array, &tensors_data[name]);
+              tensors.insert(std::make_pair(name, &tensors_data[name]));
+            }
+            std::vector<TensorCPU*> out;
+            instance.run_map_outputs(tensors, output_names, &out);
+            std::vector<py::object> pyout;
+            for (auto t : out) {
+              pyout.push_back(
+                  TensorFetcher<CPUContext>().FetchTensor(*t, true).obj);
+            }
+            return pyout;
           });
 
   py::class_<script::CompilationUnit>(m, "CompilationUnit")
-      .def(py::init<>())
+      .def(py::init<bool>(), py::arg("optimize") = false)
       .def("define", &script::CompilationUnit::define)
       .def("get_proto", &script::CompilationUnit::getProto)
       .def(
@@ -1253,12 +1299,20 @@ void addGlobalMethods(py::module& m) {
     CAFFE_ENFORCE(gWorkspace->CreateBlob(name));
     return true;
   });
-  m.def("fetch_blob", [](const std::string& name) -> py::object {
-    return python_detail::fetchBlob(gWorkspace, name);
-  });
+  m.def(
+      "fetch_blob",
+      [](const std::string& name, bool copy) -> py::object {
+        return python_detail::fetchBlob(gWorkspace, name, copy);
+      },
+      "",
+      py::arg("name"),
+      py::arg("copy") = true);
   m.def(
       "feed_blob",
-      [](const std::string& name, py::object arg, py::object device_option) {
+      [](const std::string& name,
+         py::object arg,
+         py::object device_option,
+         bool zero_copy) {
         DeviceOption option;
         if (!device_option.is(py::none())) {
           // If we have a device option passed in, read it.
@@ -1270,7 +1324,11 @@ void addGlobalMethods(py::module& m) {
           PyArrayObject* array = reinterpret_cast<PyArrayObject*>(arg.ptr());
           auto feeder = CreateFeeder(option.device_type());
           CAFFE_ENFORCE(feeder, "Unknown device type encountered in FeedBlob.");
-          feeder->Feed(option, array, blob);
+          if (zero_copy) {
+            feeder->FeedShared(option, array, blob);
+          } else {
+            feeder->Feed(option, array, blob);
+          }
           return true;
         }
         if (PyBytes_Check(arg.ptr()) || PyUnicode_Check(arg.ptr())) { // string
@@ -1285,7 +1343,8 @@ void addGlobalMethods(py::module& m) {
       "",
       py::arg("name"),
       py::arg("arg"),
-      py::arg("device_option") = py::none());
+      py::arg("device_option") = py::none(),
+      py::arg("zero_copy") = false);
   m.def("serialize_blob", [](const std::string& name) {
     CAFFE_ENFORCE(gWorkspace);
     auto* blob = gWorkspace->GetBlob(name);
@@ -48,6 +48,12 @@ class BlobFetcherBase {
   };
   virtual ~BlobFetcherBase();
   virtual pybind11::object Fetch(const Blob& blob) = 0;
+  // Like Fetch, but may return a read-only view of the blob's memory instead
+  // of a copy. The view keeps the memory alive on its own, so it remains
+  // valid (though it may go stale) after the blob is changed or freed.
+  virtual pybind11::object FetchShared(const Blob& blob) {
+    return Fetch(blob);
+  }
 };
 
 class BlobFeederBase {
@@ -55,6 +61,13 @@ class BlobFeederBase {
   virtual ~BlobFeederBase();
   virtual void
   Feed(const DeviceOption& option, PyArrayObject* array, Blob* blob) = 0;
+  // Like Feed, but may make the blob borrow the array's memory instead of
+  // copying it. The blob then holds a reference to the array, and in-place
+  // writes to the blob are visible from python.
+  virtual void
+  FeedShared(const DeviceOption& option, PyArrayObject* array, Blob* blob) {
+    Feed(option, array, blob);
+  }
 };
 
 CAFFE_DECLARE_TYPED_REGISTRY(
@@ -94,6 +107,10 @@ class TensorFetcher : public BlobFetcherBase {
     return FetchTensor(blob.Get<Tensor<Context>>(), true).obj;
   }
 
+  pybind11::object FetchShared(const Blob& blob) override {
+    return FetchTensorShared(blob.Get<Tensor<Context>>());
+  }
+
   bool NeedsCopy(const TypeMeta& meta) const {
     return !std::is_same<Context, CPUContext>::value ||
         CaffeToNumpyType(meta) == NPY_OBJECT;
@@ -150,15 +167,60 @@ class TensorFetcher : public BlobFetcherBase {
     }
     return result;
   }
+
+  // Returns a read-only numpy array backed by the tensor's memory. Unlike
+  // FetchTensor(tensor, false), the array owns a reference to the memory
+  // through a tensor sharing it, so it does not dangle if the original
+  // tensor is resized or destroyed. Falls back to a copy if the memory cannot
+  // be exposed to numpy.
+  pybind11::object FetchTensorShared(const Tensor<Context>& tensor) {
+    if (NeedsCopy(tensor.meta())) {
+      return FetchTensor(tensor, true).obj;
+    }
+    CAFFE_ENFORCE_GE(tensor.size(), 0, "Trying to fetch unitilized tensor");
+    const int numpy_type = CaffeToNumpyType(tensor.meta());
+    CAFFE_ENFORCE(
+        numpy_type != -1,
+        "This tensor's data type is not supported: ",
+        tensor.meta().name(),
+        ".");
+    std::vector<npy_intp> npy_dims(tensor.dims().begin(), tensor.dims().end());
+    auto* holder = new Tensor<Context>();
+    holder->ResizeLike(tensor);
+    holder->ShareData(tensor);
+    auto capsule = py::reinterpret_steal<py::object>(
+        PyCapsule_New(holder, nullptr, [](PyObject* capsule) {
+          delete static_cast<Tensor<Context>*>(
+              PyCapsule_GetPointer(capsule, nullptr));
+        }));
+    if (!capsule) {
+      delete holder;
+      throw py::error_already_set();
+    }
+    auto obj = py::reinterpret_steal<py::object>(PyArray_SimpleNewFromData(
+        tensor.ndim(),
+        npy_dims.data(),
+        numpy_type,
+        const_cast<void*>(holder->raw_data())));
+    auto* array = reinterpret_cast<PyArrayObject*>(obj.ptr());
+    // PyArray_SetBaseObject steals the reference to the capsule.
+    CAFFE_ENFORCE_EQ(PyArray_SetBaseObject(array, capsule.release().ptr()), 0);
+    PyArray_CLEARFLAGS(array, NPY_ARRAY_WRITEABLE);
+    return obj;
+  }
 };
 
 template <class Context>
 class TensorFeeder : public BlobFeederBase {
  public:
+  // If share_memory is set, the tensor borrows the memory of the (contiguous
+  // version of the) array when possible, instead of copying it. The tensor
+  // keeps a reference to the array until it releases the memory.
   void FeedTensor(
       const DeviceOption& option,
       PyArrayObject* original_array,
-      Tensor<Context>* tensor) {
+      Tensor<Context>* tensor,
+      bool share_memory = false) {
     PyArrayObject* array = PyArray_GETCONTIGUOUS(original_array);
     auto g = MakeGuard([&]() { Py_XDECREF(array); });
 
@@ -180,6 +242,23 @@ class TensorFeeder : public BlobFeederBase {
     }
     tensor->Resize(dims);
 
+    if (share_memory && std::is_same<Context, CPUContext>::value &&
+        npy_type != NPY_OBJECT && npy_type != NPY_UNICODE &&
+        PyArray_ISALIGNED(array) && PyArray_ISWRITEABLE(array)) {
+      Py_INCREF(array);
+      tensor->ShareExternalPointer(
+          PyArray_DATA(array),
+          meta,
+          PyArray_NBYTES(array),
+          [array](void*) {
+            // The tensor may be released from a thread that does not hold
+            // the GIL, e.g. while running a net.
+            py::gil_scoped_acquire g;
+            Py_DECREF(array);
+          });
+      return;
+    }
+
     // Now, copy the data to the tensor.
     switch (npy_type) {
       case NPY_OBJECT: {
@@ -229,6 +308,14 @@ class TensorFeeder : public BlobFeederBase {
   Feed(const DeviceOption& option, PyArrayObject* original_array, Blob* blob) {
     FeedTensor(option, original_array, blob->GetMutable<Tensor<Context>>());
   }
+
+  void FeedShared(
+      const DeviceOption& option,
+      PyArrayObject* original_array,
+      Blob* blob) override {
+    FeedTensor(
+        option, original_array, blob->GetMutable<Tensor<Context>>(), true);
+  }
 };
 
 namespace python_detail {
@@ -20,6 +20,19 @@ const DLDataType* CaffeToDLType(const TypeMeta& meta);
 
 const TypeMeta& DLTypeToCaffe(const DLDataType& dl_type);
 
+// Backing storage of a DLPack tensor exported from Caffe2. It holds a tensor
+// sharing the exported memory, so that the DLPack tensor stays valid for as
+// long as the consumer needs it, independently of the source tensor.
+template <class Context>
+struct DLPackSharedTensor {
+  DLManagedTensor managed_tensor;
+  Tensor<Context> tensor;
+
+  static void Deleter(DLManagedTensor* self) {
+    delete static_cast<DLPackSharedTensor<Context>*>(self->ctx);
+  }
+};
+
 template <class Context>
 class DLPackWrapper {
  public:
@@ -52,26 +65,46 @@ class DLPackWrapper {
         tensor->meta().name());
     DLDataType tensor_type = *type_ptr;
 
+    auto* shared = new DLPackSharedTensor<Context>();
+    shared->tensor.ResizeLike(*tensor);
+    shared->tensor.ShareData(*tensor);
+
     DLTensor dlTensor;
-    dlTensor.data = const_cast<void*>(tensor->raw_data());
+    dlTensor.data = const_cast<void*>(shared->tensor.raw_data());
     dlTensor.ctx = tensor_context;
-    dlTensor.ndim = tensor->ndim();
+    dlTensor.ndim = shared->tensor.ndim();
     dlTensor.dtype = tensor_type;
-    dlTensor.shape = const_cast<int64_t*>(&(tensor->dims()[0]));
+    dlTensor.shape = const_cast<int64_t*>(&(shared->tensor.dims()[0]));
     dlTensor.strides = nullptr;
     dlTensor.byte_offset = 0;
 
-    managed_tensor.dlTensor = dlTensor;
-    // C2 Tensor memory is managed by C2
-    managed_tensor.ctx = nullptr;
-    managed_tensor.destructor = [](DLManagedTensor*) {};
-
-    return py::reinterpret_steal<py::object>(
-        PyCapsule_New(&managed_tensor, "dltensor", nullptr));
+    shared->managed_tensor.dlTensor = dlTensor;
+    shared->managed_tensor.ctx = shared;
+    shared->managed_tensor.destructor = &DLPackSharedTensor<Context>::Deleter;
+
+    // Following the DLPack convention, a consumer renames the capsule to
+    // "used_dltensor" and becomes responsible for calling the destructor.
+    // Otherwise the capsule calls it when it is garbage collected.
+    auto* capsule = PyCapsule_New(
+        &shared->managed_tensor, "dltensor", [](PyObject* capsule) {
+          if (PyCapsule_IsValid(capsule, "dltensor")) {
+            auto* managed = static_cast<DLManagedTensor*>(
+                PyCapsule_GetPointer(capsule, "dltensor"));
+            managed->destructor(managed);
+          }
+        });
+    if (!capsule) {
+      delete shared;
+      throw py::error_already_set();
+    }
+    return py::reinterpret_steal<py::object>(capsule);
   }
 
   void feed(py::object obj) {
     CAFFE_ENFORCE(PyCapsule_CheckExact(obj.ptr()), "Expected DLPack capsule");
+    CAFFE_ENFORCE(
+        PyCapsule_IsValid(obj.ptr(), "dltensor"),
+        "DLPack capsule has already been consumed");
     DLManagedTensor* dlMTensor =
         (DLManagedTensor*)PyCapsule_GetPointer(obj.ptr(), "dltensor");
     CAFFE_ENFORCE(dlMTensor, "Invalid DLPack capsule");
@@ -118,11 +151,13 @@ class DLPackWrapper {
             dlMTensor->destructor(dlMTensor);
           }
         });
+    // The tensor now owns the DLPack tensor; mark the capsule as consumed so
+    // that it is neither freed twice nor fed again.
+    PyCapsule_SetName(obj.ptr(), "used_dltensor");
   }
 
   Tensor<Context>* tensor;
   DeviceOption device_option;
-  DLManagedTensor managed_tensor;
 };
 
 } // namespace python
@@ -279,7 +279,7 @@ def GetNetName(net):
     raise Exception("Not a Net object: {}".format(str(net)))
 
 
-def FeedBlob(name, arr, device_option=None):
+def FeedBlob(name, arr, device_option=None, zero_copy=False):
     """Feeds a blob into the workspace.
 
     Inputs:
@@ -287,6 +287,9 @@ def FeedBlob(name, arr, device_option=None):
       arr: either a TensorProto object or a numpy array object to be fed into
           the workspace.
       device_option (optional): the device option to feed the data with.
+      zero_copy (optional): if True, the blob borrows the memory of a CPU
+          numpy array instead of copying it. The array is kept alive by the
+          blob, and operators writing the blob in place modify the array.
     Returns:
       True or False, stating whether the feed is successful.
     """
@@ -310,9 +313,10 @@ def FeedBlob(name, arr, device_option=None):
 
     name = StringifyBlobName(name)
     if device_option is not None:
-        return C.feed_blob(name, arr, StringifyProto(device_option))
+        return C.feed_blob(
+            name, arr, StringifyProto(device_option), zero_copy=zero_copy)
     else:
-        return C.feed_blob(name, arr)
+        return C.feed_blob(name, arr, zero_copy=zero_copy)
 
 
 def FetchBlobs(names):
@@ -326,15 +330,18 @@ def FetchBlobs(names):
     return [FetchBlob(name) for name in names]
 
 
-def FetchBlob(name):
+def FetchBlob(name, copy=True):
     """Fetches a blob from the workspace.
 
     Inputs:
       name: the name of the blob - a string or a BlobReference
+      copy (optional): if False, CPU tensors are returned as read-only numpy
+          arrays sharing memory with the blob. The array stays valid after
+          the blob changes, but may then no longer reflect its content.
     Returns:
       Fetched blob (numpy array or string) if successful
     """
-    return C.fetch_blob(StringifyBlobName(name))
+    return C.fetch_blob(StringifyBlobName(name), copy=copy)
 
 
 def ApplyTransform(transform_key, net):
@@ -583,10 +590,10 @@ def _Workspace_run(ws, obj):
 C.Workspace.run = _Workspace_run
 
 
-def _Blob_feed(blob, arg, device_option=None):
+def _Blob_feed(blob, arg, device_option=None, zero_copy=False):
     if device_option is not None:
         device_option = StringifyProto(device_option)
-    return blob._feed(arg, device_option)
+    return blob._feed(arg, device_option, zero_copy=zero_copy)
 
 
 C.Blob.feed = _Blob_feed
@@ -234,6 +234,21 @@ class TestWorkspace(unittest.TestCase):
         self.assertEquals(s1, fetch1)
         self.assertEquals(s2, fetch2)
 
+    def testFetchFeedBlobZeroCopy(self):
+        data = np.random.rand(16, 8).astype(np.float32)
+        self.assertEqual(
+            workspace.FeedBlob("zero_copy", data, zero_copy=True), True)
+        # The blob borrows the memory of the array.
+        data[0, 0] = 42.0
+        fetched = workspace.FetchBlob("zero_copy", copy=False)
+        np.testing.assert_array_equal(fetched, data)
+        self.assertFalse(fetched.flags.writeable)
+        # The fetched view keeps the memory alive after the blob is dropped.
+        del data
+        expected = fetched.copy()
+        workspace.ResetWorkspace()
+        np.testing.assert_array_equal(fetched, expected)
+
     def testFetchFeedViaBlobDict(self):
         self.assertEqual(
             workspace.RunNetOnce(self.net.Proto().SerializeToString()), True)
@@ -0,0 +1,222 @@
+#include "caffe2/transforms/constant_folding_transform.h"
+
+#include <unordered_map>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Ops without inputs that always produce the same value.
+const std::unordered_set<std::string>& ConstantFillOps() {
+  static const std::unordered_set<std::string> ops{
+      "ConstantFill",
+      "GivenTensorFill",
+      "GivenTensorDoubleFill",
+      "GivenTensorBoolFill",
+      "GivenTensorIntFill",
+      "GivenTensorInt64Fill",
+      "GivenTensorStringFill",
+      "RangeFill",
+  };
+  return ops;
+}
+
+// Ops with inputs that are known to compute the same outputs from the same
+// inputs, without other effects. Any other op, such as a random sampling or
+// stateful op, is never folded.
+const std::unordered_set<std::string>& FoldableOps() {
+  static const std::unordered_set<std::string> ops{
+      "Abs",
+      "Add",
+      "And",
+      "BatchMatMul",
+      "Cast",
+      "Clip",
+      "Concat",
+      "Copy",
+      "Div",
+      "EQ",
+      "Exp",
+      "ExpandDims",
+      "FC",
+      "FCTransposed",
+      "Flatten",
+      "FlattenToVec",
+      "GE",
+      "GT",
+      "Gather",
+      "LE",
+      "LT",
+      "LengthsToRanges",
+      "LengthsToSegmentIds",
+      "Log",
+      "MatMul",
+      "Max",
+      "Mean",
+      "Min",
+      "Mul",
+      "NE",
+      "Negative",
+      "Not",
+      "Or",
+      "Pow",
+      "ReduceMean",
+      "ReduceSum",
+      "Relu",
+      "Reshape",
+      "Scale",
+      "Shape",
+      "Sigmoid",
+      "Sign",
+      "Size",
+      "Slice",
+      "Softmax",
+      "Split",
+      "Sqr",
+      "Sqrt",
+      "Squeeze",
+      "Sub",
+      "Sum",
+      "SumElements",
+      "Tanh",
+      "Tile",
+      "Transpose",
+  };
+  return ops;
+}
+
+// Sets op to a GivenTensor*Fill op of the type T with the values of tensor.
+template <typename T, typename V = T>
+void SetFillValues(const TensorCPU& tensor, const char* type, OperatorDef* op) {
+  op->set_type(type);
+  const T* data = tensor.data<T>();
+  op->add_arg()->CopyFrom(MakeArgument<std::vector<V>>(
+      "values", std::vector<V>(data, data + tensor.size())));
+}
+
+// Appends to net an op filling the blob name with tensor, or returns false
+// when there is no fill op for its type.
+bool AddFillOp(const Blob& blob, const std::string& name, NetDef* net) {
+  if (!blob.IsType<TensorCPU>()) {
+    return false;
+  }
+  const auto& tensor = blob.Get<TensorCPU>();
+  OperatorDef op;
+  if (tensor.IsType<float>()) {
+    SetFillValues<float>(tensor, "GivenTensorFill", &op);
+  } else if (tensor.IsType<int>()) {
+    SetFillValues<int>(tensor, "GivenTensorIntFill", &op);
+  } else if (tensor.IsType<int64_t>()) {
+    SetFillValues<int64_t>(tensor, "GivenTensorInt64Fill", &op);
+  } else if (tensor.IsType<bool>()) {
+    SetFillValues<bool, int>(tensor, "GivenTensorBoolFill", &op);
+  } else if (tensor.IsType<std::string>()) {
+    SetFillValues<std::string>(tensor, "GivenTensorStringFill", &op);
+  } else {
+    return false;
+  }
+  op.add_output(name);
+  const std::vector<int64_t> shape(tensor.dims().begin(), tensor.dims().end());
+  op.add_arg()->CopyFrom(MakeArgument<std::vector<int64_t>>("shape", shape));
+  net->add_op()->Swap(&op);
+  return true;
+}
+
+} // namespace
+
+NetDef FoldConstants(
+    const NetDef& net,
+    const std::unordered_set<std::string>& constants,
+    Workspace* ws) {
+  // A blob written by the net changes between runs unless it is written
+  // exactly once, by a folded op.
+  std::unordered_map<std::string, int> writes;
+  for (const auto& op : net.op()) {
+    for (const auto& output : op.output()) {
+      ++writes[output];
+    }
+  }
+  std::unordered_set<std::string> constant;
+  for (const auto& name : constants) {
+    if (!writes.count(name)) {
+      constant.insert(name);
+    }
+  }
+  const std::unordered_set<std::string> external_inputs(
+      net.external_input().begin(), net.external_input().end());
+
+  NetDef folded_net = net;
+  folded_net.clear_op();
+  std::vector<std::string> folded;
+  for (const auto& op : net.op()) {
+    bool foldable = ConstantFillOps().count(op.type()) ||
+        (op.input_size() > 0 && FoldableOps().count(op.type()));
+    for (const auto& input : op.input()) {
+      foldable &= constant.count(input) > 0;
+    }
+    for (const auto& output : op.output()) {
+      foldable &= writes[output] == 1 && !external_inputs.count(output);
+    }
+    if (foldable) {
+      try {
+        foldable = ws->RunOperatorOnce(op);
+      } catch (const std::exception& e) {
+        VLOG(1) << "Not folding " << ProtoDebugString(op) << ": " << e.what();
+        foldable = false;
+      }
+    }
+    if (!foldable) {
+      folded_net.add_op()->CopyFrom(op);
+      continue;
+    }
+    for (const auto& output : op.output()) {
+      constant.insert(output);
+      folded.push_back(output);
+    }
+  }
+  if (folded.empty()) {
+    return folded_net;
+  }
+
+  // Keep the folded blobs that are still needed, as inputs of the net.
+  std::unordered_set<std::string> used(
+      net.external_output().begin(), net.external_output().end());
+  for (const auto& op : folded_net.op()) {
+    used.insert(op.input().begin(), op.input().end());
+  }
+  for (const auto& name : folded) {
+    if (!used.count(name)) {
+      ws->RemoveBlob(name);
+    } else if (!external_inputs.count(name)) {
+      folded_net.add_external_input(name);
+    }
+  }
+  VLOG(1) << "Folded " << net.op_size() - folded_net.op_size()
+          << " constant ops of net " << net.name();
+  return folded_net;
+}
+
+NetDef FoldConstantsIntoInitNet(const NetDef& net, NetDef* init_net) {
+  Workspace ws;
+  auto folded = FoldConstants(net, {}, &ws);
+  if (folded.op_size() == net.op_size()) {
+    return net;
+  }
+  const std::unordered_set<std::string> external_inputs(
+      net.external_input().begin(), net.external_input().end());
+  NetDef fills;
+  for (const auto& name : folded.external_input()) {
+    if (!external_inputs.count(name) &&
+        !AddFillOp(*ws.GetBlob(name), name, &fills)) {
+      VLOG(1) << "Cannot move the folded blob " << name << " to an init net";
+      return net;
+    }
+  }
+  init_net->mutable_op()->MergeFrom(fills.op());
+  return folded;
+}
+
+} // namespace caffe2
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * Folds the ops of net that only depend on constants into blobs of ws.
+ *
+ * constants names the blobs of ws that hold the same value at every run of
+ * net, typically the parameters created by its init net. An op is folded
+ * when all its inputs are constants, or when it is a constant fill without
+ * inputs: it is run once in ws and removed from the returned net, and its
+ * outputs become constants in turn. Only constant fills and a list of
+ * deterministic ops without side effects, such as Transpose, Reshape or the
+ * elementwise arithmetic ops, are folded; other ops, including random and
+ * stateful ones, and ops whose outputs are also written by other ops are
+ * never folded.
+ *
+ * Folded blobs that the remaining ops read are appended to the external
+ * inputs of the returned net; the other intermediate blobs are removed
+ * from ws.
+ */
+NetDef FoldConstants(
+    const NetDef& net,
+    const std::unordered_set<std::string>& constants,
+    Workspace* ws);
+
+/**
+ * Folds the ops of net that only depend on the constant fills of net
+ * itself, such as the Constant nodes of an imported ONNX graph and the
+ * Shape or Reshape ops reading them, and moves the fills of the folded blobs
+ * that net still reads to init_net.
+ *
+ * Unlike FoldConstants, this does not run init_net. The net is returned
+ * unchanged if a folded blob has a type without a GivenTensor*Fill op.
+ */
+NetDef FoldConstantsIntoInitNet(const NetDef& net, NetDef* init_net);
+
+} // namespace caffe2
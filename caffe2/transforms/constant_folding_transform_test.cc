@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/constant_folding_transform.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+OperatorDef* AddOp(
+    NetDef* net,
+    const string& type,
+    const vector<string>& inputs,
+    const vector<string>& outputs) {
+  auto* op = net->add_op();
+  *op = CreateOperatorDef(type, "", inputs, outputs);
+  return op;
+}
+
+void FillTensor(Workspace* ws, const string& name, vector<TIndex> dims) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<float>()[i] = (i % 7) - 3;
+  }
+}
+
+} // namespace
+
+TEST(ConstantFoldingTest, FoldsWeightPreprocessing) {
+  NetDef net;
+  AddOp(&net, "Transpose", {"W"}, {"W_t"});
+  AddOp(&net, "Scale", {"W_t"}, {"W_scaled"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<float>("scale", 0.5));
+  AddOp(&net, "ConstantFill", {}, {"b"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<vector<int>>("shape", {3}));
+  AddOp(&net, "FC", {"X", "W_scaled", "b"}, {"Y"});
+  AddOp(&net, "UniformFill", {}, {"noise"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<vector<int>>("shape", {3}));
+  for (const auto& input : {"X", "W"}) {
+    net.add_external_input(input);
+  }
+  net.add_external_output("Y");
+
+  Workspace ws;
+  FillTensor(&ws, "X", {2, 4});
+  FillTensor(&ws, "W", {4, 3});
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  TensorCPU expected(ws.GetBlob("Y")->Get<TensorCPU>());
+
+  Workspace folding_ws;
+  FillTensor(&folding_ws, "X", {2, 4});
+  FillTensor(&folding_ws, "W", {4, 3});
+  auto folded = FoldConstants(net, {"W"}, &folding_ws);
+  ASSERT_EQ(folded.op_size(), 2);
+  EXPECT_EQ(folded.op(0).type(), "FC");
+  EXPECT_EQ(folded.op(1).type(), "UniformFill");
+  EXPECT_EQ(
+      vector<string>(
+          folded.external_input().begin(), folded.external_input().end()),
+      vector<string>({"X", "W", "W_scaled", "b"}));
+  // Intermediate results are not kept.
+  EXPECT_FALSE(folding_ws.HasBlob("W_t"));
+
+  ASSERT_TRUE(folding_ws.RunNetOnce(folded));
+  const auto& Y = folding_ws.GetBlob("Y")->Get<TensorCPU>();
+  ASSERT_EQ(Y.dims(), expected.dims());
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_FLOAT_EQ(Y.data<float>()[i], expected.data<float>()[i]);
+  }
+}
+
+TEST(ConstantFoldingTest, KeepsBlobsWrittenByTheNet) {
+  NetDef net;
+  // W is updated at every run, so it is not a constant.
+  AddOp(&net, "Scale", {"W"}, {"W"});
+  AddOp(&net, "Transpose", {"W"}, {"W_t"});
+  // V is written twice.
+  AddOp(&net, "Transpose", {"U"}, {"V"});
+  AddOp(&net, "Relu", {"X"}, {"V"});
+  for (const auto& input : {"X", "W", "U"}) {
+    net.add_external_input(input);
+  }
+
+  Workspace ws;
+  FillTensor(&ws, "W", {4, 3});
+  FillTensor(&ws, "U", {4, 3});
+  auto folded = FoldConstants(net, {"W", "U"}, &ws);
+  EXPECT_EQ(folded.op_size(), 4);
+  EXPECT_EQ(folded.external_input_size(), 3);
+}
+
+TEST(ConstantFoldingTest, KeepsUnknownOps) {
+  // Only ops known to be deterministic are folded, so the sampling ops
+  // stay even though their inputs are constants.
+  NetDef net;
+  AddOp(&net, "Transpose", {"W"}, {"W_t"});
+  AddOp(&net, "LogUniformSampling", {"W_t"}, {"samples"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<int>("range", 10));
+  AddOp(&net, "WeightedSampling", {"W"}, {"index"});
+  net.add_external_input("W");
+
+  Workspace ws;
+  FillTensor(&ws, "W", {4, 3});
+  auto folded = FoldConstants(net, {"W"}, &ws);
+  ASSERT_EQ(folded.op_size(), 2);
+  EXPECT_EQ(folded.op(0).type(), "LogUniformSampling");
+  EXPECT_EQ(folded.op(1).type(), "WeightedSampling");
+  EXPECT_EQ(folded.external_input_size(), 2);
+}
+
+TEST(ConstantFoldingTest, FoldsIntoInitNet) {
+  NetDef net;
+  AddOp(&net, "GivenTensorInt64Fill", {}, {"shape"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<vector<int64_t>>("values", {2, 6}));
+  net.mutable_op(0)->add_arg()->CopyFrom(
+      MakeArgument<vector<int>>("shape", {2}));
+  AddOp(&net, "Reshape", {"X", "shape"}, {"Y", "old_shape"});
+  AddOp(&net, "GivenTensorFill", {}, {"W"})
+      ->add_arg()
+      ->CopyFrom(MakeArgument<vector<float>>("values", {1, 2, 3, 4, 5, 6}));
+  net.mutable_op(2)->add_arg()->CopyFrom(
+      MakeArgument<vector<int>>("shape", {3, 2}));
+  AddOp(&net, "Transpose", {"W"}, {"W_t"});
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  net.add_external_output("W_t");
+
+  Workspace ws;
+  FillTensor(&ws, "X", {3, 4});
+  ASSERT_TRUE(ws.RunNetOnce(net));
+
+  NetDef init;
+  auto folded = FoldConstantsIntoInitNet(net, &init);
+  ASSERT_EQ(folded.op_size(), 1);
+  EXPECT_EQ(folded.op(0).type(), "Reshape");
+  ASSERT_EQ(init.op_size(), 2);
+  EXPECT_EQ(init.op(0).type(), "GivenTensorInt64Fill");
+  EXPECT_EQ(init.op(1).type(), "GivenTensorFill");
+
+  Workspace folded_ws;
+  FillTensor(&folded_ws, "X", {3, 4});
+  ASSERT_TRUE(folded_ws.RunNetOnce(init));
+  ASSERT_TRUE(folded_ws.RunNetOnce(folded));
+  for (const auto& name : {"Y", "W_t"}) {
+    const auto& expected = ws.GetBlob(name)->Get<TensorCPU>();
+    const auto& actual = folded_ws.GetBlob(name)->Get<TensorCPU>();
+    ASSERT_EQ(actual.dims(), expected.dims());
+    for (int i = 0; i < actual.size(); ++i) {
+      EXPECT_EQ(actual.data<float>()[i], expected.data<float>()[i]);
+    }
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,193 @@
+#include "caffe2/transforms/dead_op_elimination_transform.h"
+
+#include <unordered_set>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+namespace {
+
+using BlobSet = std::unordered_set<std::string>;
+
+bool HasSubnets(const OperatorDef& op) {
+  for (const auto& arg : op.arg()) {
+    if (arg.has_n() || arg.nets_size()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+NetDef* MutableSubnet(OperatorDef* op, const std::string& name) {
+  for (auto& arg : *op->mutable_arg()) {
+    if (arg.name() == name && arg.has_n()) {
+      return arg.mutable_n();
+    }
+  }
+  return nullptr;
+}
+
+// Whether op is run for its effects rather than for its outputs: it writes
+// no blob, or it saves, prints or checks its inputs.
+bool HasSideEffects(const OperatorDef& op) {
+  static const std::unordered_set<std::string> kSideEffectOps{
+      "Assert",
+      "Checkpoint",
+      "EnforceFinite",
+      "NanCheck",
+      "Print",
+      "Save",
+      "Snapshot",
+  };
+  return op.output_size() == 0 || kSideEffectOps.count(op.type());
+}
+
+// Adds every blob read by net, including by its subnets, to blobs.
+void AddReads(const NetDef& net, BlobSet* blobs);
+
+void AddReads(const OperatorDef& op, BlobSet* blobs) {
+  blobs->insert(op.input().begin(), op.input().end());
+  for (const auto& arg : op.arg()) {
+    if (arg.has_n()) {
+      AddReads(arg.n(), blobs);
+    }
+    for (const auto& net : arg.nets()) {
+      AddReads(net, blobs);
+    }
+  }
+}
+
+void AddReads(const NetDef& net, BlobSet* blobs) {
+  for (const auto& op : net.op()) {
+    AddReads(op, blobs);
+  }
+}
+
+bool AddAll(const BlobSet& from, BlobSet* to) {
+  bool changed = false;
+  for (const auto& name : from) {
+    changed |= to->insert(name).second;
+  }
+  return changed;
+}
+
+// Removes the ops of net whose outputs are not in live, going backwards.
+// On return, live holds the blobs needed before net runs.
+void PruneOps(NetDef* net, BlobSet* live);
+
+// Prunes net as a subnet that may or may not run: the blobs needed before
+// it are the ones it reads plus the ones in live it may not write.
+bool PruneConditionalSubnet(NetDef* net, BlobSet* live) {
+  if (!net) {
+    return false;
+  }
+  BlobSet subnet_live = *live;
+  PruneOps(net, &subnet_live);
+  AddAll(subnet_live, live);
+  return net->op_size() > 0;
+}
+
+// Returns whether op is still needed, after pruning its subnets.
+bool PruneOp(OperatorDef* op, BlobSet* live) {
+  bool needed = HasSideEffects(*op);
+  for (const auto& output : op->output()) {
+    needed |= live->count(output) > 0;
+  }
+  if (op->type() == "If") {
+    BlobSet then_live = *live;
+    needed |= PruneConditionalSubnet(MutableSubnet(op, "then_net"), &then_live);
+    BlobSet else_live = *live;
+    needed |= PruneConditionalSubnet(MutableSubnet(op, "else_net"), &else_live);
+    if (needed) {
+      AddAll(then_live, live);
+      AddAll(else_live, live);
+      live->insert(op->input().begin(), op->input().end());
+    }
+    return needed;
+  }
+  if (op->type() == "While") {
+    auto* loop_net = MutableSubnet(op, "loop_net");
+    CAFFE_ENFORCE(loop_net, "While op without loop_net");
+    auto* cond_net = MutableSubnet(op, "cond_net");
+    // An iteration needs what the next one and the loop condition read, so
+    // grow the set of blobs live across iterations to a fixpoint.
+    BlobSet loop_live = *live;
+    loop_live.insert(op->input().begin(), op->input().end());
+    if (cond_net) {
+      AddReads(*cond_net, &loop_live);
+    }
+    NetDef pruned_loop_net;
+    bool changed = true;
+    while (changed) {
+      pruned_loop_net = *loop_net;
+      BlobSet iteration_live = loop_live;
+      PruneConditionalSubnet(&pruned_loop_net, &iteration_live);
+      changed = AddAll(iteration_live, &loop_live);
+    }
+    needed |= pruned_loop_net.op_size() > 0;
+    if (needed) {
+      *loop_net = pruned_loop_net;
+      AddAll(loop_live, live);
+    }
+    return needed;
+  }
+  if (needed) {
+    if (HasSubnets(*op)) {
+      // The outputs of other control ops may be written conditionally.
+      AddReads(*op, live);
+      return true;
+    }
+    for (const auto& output : op->output()) {
+      live->erase(output);
+    }
+    live->insert(op->input().begin(), op->input().end());
+  }
+  return needed;
+}
+
+void PruneOps(NetDef* net, BlobSet* live) {
+  std::vector<bool> keep(net->op_size());
+  for (int i = net->op_size() - 1; i >= 0; --i) {
+    keep[i] = PruneOp(net->mutable_op(i), live);
+  }
+  NetDef pruned;
+  pruned.mutable_op()->Swap(net->mutable_op());
+  for (int i = 0; i < pruned.op_size(); ++i) {
+    if (keep[i]) {
+      net->add_op()->Swap(pruned.mutable_op(i));
+    }
+  }
+}
+
+} // namespace
+
+NetDef PruneUnusedOps(
+    const NetDef& net,
+    const std::vector<std::string>& outputs) {
+  BlobSet available(net.external_input().begin(), net.external_input().end());
+  for (const auto& op : net.op()) {
+    available.insert(op.output().begin(), op.output().end());
+  }
+  for (const auto& output : outputs) {
+    CAFFE_ENFORCE(
+        available.count(output),
+        "Output ",
+        output,
+        " is not produced by net ",
+        net.name());
+  }
+
+  NetDef pruned = net;
+  BlobSet live(outputs.begin(), outputs.end());
+  PruneOps(&pruned, &live);
+  pruned.clear_external_output();
+  for (const auto& output : outputs) {
+    pruned.add_external_output(output);
+  }
+  VLOG(1) << "Pruned " << net.op_size() - pruned.op_size()
+          << " unused ops of net " << net.name();
+  return pruned;
+}
+
+} // namespace caffe2
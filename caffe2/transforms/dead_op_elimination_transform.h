@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+/**
+ * Removes the ops of net that do not contribute to outputs.
+ *
+ * An op is kept when one of its outputs is read by a kept op or is in
+ * outputs, or when it has side effects: ops without outputs and ops such as
+ * Save, Print or Assert are always kept. The subnets of If and While ops
+ * are pruned in the same way, and the op itself is dropped when nothing it
+ * writes is needed. Ops with other kinds of subnets are kept or dropped as
+ * a whole.
+ *
+ * The external outputs of the returned net are outputs; its external inputs
+ * are those of net, so that inputs can still be fed by position. Every
+ * name in outputs must be written by net or be one of its external inputs.
+ */
+NetDef PruneUnusedOps(
+    const NetDef& net,
+    const std::vector<std::string>& outputs);
+
+} // namespace caffe2
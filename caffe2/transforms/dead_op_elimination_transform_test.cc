@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/transforms/dead_op_elimination_transform.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+OperatorDef* AddOp(
+    NetDef* net,
+    const string& type,
+    const vector<string>& inputs,
+    const vector<string>& outputs) {
+  auto* op = net->add_op();
+  *op = CreateOperatorDef(type, "", inputs, outputs);
+  return op;
+}
+
+vector<string> OpTypes(const NetDef& net) {
+  vector<string> types;
+  for (const auto& op : net.op()) {
+    types.push_back(op.type());
+  }
+  return types;
+}
+
+void AddSubnet(OperatorDef* op, const string& name, const NetDef& net) {
+  auto* arg = op->add_arg();
+  arg->set_name(name);
+  arg->mutable_n()->CopyFrom(net);
+}
+
+const NetDef& Subnet(const OperatorDef& op, const string& name) {
+  for (const auto& arg : op.arg()) {
+    if (arg.name() == name) {
+      return arg.n();
+    }
+  }
+  CAFFE_THROW("No subnet ", name);
+}
+
+} // namespace
+
+TEST(DeadOpEliminationTest, PrunesUnusedHeads) {
+  NetDef net;
+  AddOp(&net, "FC", {"X", "W", "b"}, {"hidden"});
+  AddOp(&net, "Relu", {"hidden"}, {"hidden"});
+  AddOp(&net, "FC", {"hidden", "W2", "b2"}, {"logits"});
+  AddOp(&net, "Softmax", {"logits"}, {"prob"});
+  AddOp(&net, "LabelCrossEntropy", {"prob", "label"}, {"xent"});
+  AddOp(&net, "AveragedLoss", {"xent"}, {"loss"});
+  AddOp(&net, "Accuracy", {"prob", "label"}, {"accuracy"});
+  AddOp(&net, "Sigmoid", {"hidden"}, {"aux"});
+  for (const auto& input : {"X", "W", "b", "W2", "b2", "label"}) {
+    net.add_external_input(input);
+  }
+  for (const auto& output : {"prob", "loss", "accuracy", "aux"}) {
+    net.add_external_output(output);
+  }
+
+  auto pruned = PruneUnusedOps(net, {"prob"});
+  EXPECT_EQ(OpTypes(pruned), vector<string>({"FC", "Relu", "FC", "Softmax"}));
+  ASSERT_EQ(pruned.external_output_size(), 1);
+  EXPECT_EQ(pruned.external_output(0), "prob");
+  EXPECT_EQ(pruned.external_input_size(), net.external_input_size());
+
+  pruned = PruneUnusedOps(net, {"aux"});
+  EXPECT_EQ(OpTypes(pruned), vector<string>({"FC", "Relu", "Sigmoid"}));
+
+  // An external input is its own output.
+  EXPECT_EQ(PruneUnusedOps(net, {"X"}).op_size(), 0);
+  EXPECT_THROW(PruneUnusedOps(net, {"missing"}), EnforceNotMet);
+}
+
+TEST(DeadOpEliminationTest, KeepsOverwrittenInputs) {
+  // The second write of A does not make the first one dead, since B reads
+  // it in between.
+  NetDef net;
+  AddOp(&net, "Relu", {"X"}, {"A"});
+  AddOp(&net, "Sigmoid", {"A"}, {"B"});
+  AddOp(&net, "Tanh", {"X"}, {"A"});
+  AddOp(&net, "Sum", {"A", "B"}, {"Y"});
+  AddOp(&net, "Tanh", {"Y"}, {"A"});
+  net.add_external_input("X");
+  EXPECT_EQ(
+      OpTypes(PruneUnusedOps(net, {"Y"})),
+      vector<string>({"Relu", "Sigmoid", "Tanh", "Sum"}));
+  // The last write of A reads Y, which needs every other op.
+  EXPECT_EQ(
+      OpTypes(PruneUnusedOps(net, {"A"})),
+      vector<string>({"Relu", "Sigmoid", "Tanh", "Sum", "Tanh"}));
+  NetDef tail;
+  AddOp(&tail, "Relu", {"X"}, {"A"});
+  AddOp(&tail, "Tanh", {"X"}, {"A"});
+  EXPECT_EQ(OpTypes(PruneUnusedOps(tail, {"A"})), vector<string>({"Tanh"}));
+}
+
+TEST(DeadOpEliminationTest, KeepsSideEffects) {
+  NetDef net;
+  AddOp(&net, "Relu", {"X"}, {"A"});
+  AddOp(&net, "Sigmoid", {"A"}, {"B"});
+  AddOp(&net, "Print", {"B"}, {});
+  AddOp(&net, "Tanh", {"X"}, {"C"});
+  AddOp(&net, "Save", {"C"}, {});
+  AddOp(&net, "Abs", {"X"}, {"D"});
+  AddOp(&net, "Exp", {"X"}, {"Y"});
+  net.add_external_input("X");
+  // The unused Abs goes, but Print and Save and what they read stay.
+  EXPECT_EQ(
+      OpTypes(PruneUnusedOps(net, {"Y"})),
+      vector<string>({"Relu", "Sigmoid", "Print", "Tanh", "Save", "Exp"}));
+}
+
+TEST(DeadOpEliminationTest, PrunesIfSubnets) {
+  NetDef then_net;
+  AddOp(&then_net, "Relu", {"X"}, {"Y"});
+  AddOp(&then_net, "Sigmoid", {"X"}, {"metric"});
+  NetDef else_net;
+  AddOp(&else_net, "Tanh", {"X"}, {"metric"});
+
+  NetDef net;
+  AddOp(&net, "Copy", {"X0"}, {"X"});
+  auto* if_op = AddOp(&net, "If", {"cond"}, {"Y", "metric"});
+  AddSubnet(if_op, "then_net", then_net);
+  AddSubnet(if_op, "else_net", else_net);
+  net.add_external_input("X0");
+  net.add_external_input("cond");
+
+  auto pruned = PruneUnusedOps(net, {"Y"});
+  ASSERT_EQ(OpTypes(pruned), vector<string>({"Copy", "If"}));
+  EXPECT_EQ(
+      OpTypes(Subnet(pruned.op(1), "then_net")), vector<string>({"Relu"}));
+  EXPECT_EQ(Subnet(pruned.op(1), "else_net").op_size(), 0);
+
+  // Nothing the If writes is needed.
+  NetDef other = net;
+  AddOp(&other, "Relu", {"X0"}, {"Z"});
+  EXPECT_EQ(OpTypes(PruneUnusedOps(other, {"Z"})), vector<string>({"Relu"}));
+}
+
+TEST(DeadOpEliminationTest, PrunesWhileSubnets) {
+  // Each iteration computes Y from A and then A from B, so the op writing
+  // A is live through the next iteration even though Y is the only output.
+  NetDef loop_net;
+  AddOp(&loop_net, "Relu", {"A"}, {"Y"});
+  AddOp(&loop_net, "Sigmoid", {"B"}, {"A"});
+  AddOp(&loop_net, "Tanh", {"C"}, {"B"});
+  AddOp(&loop_net, "Softsign", {"Y"}, {"metric"});
+  AddOp(&loop_net, "LT", {"Y", "limit"}, {"cond"});
+  NetDef cond_net;
+  AddOp(&cond_net, "Not", {"done"}, {"cond"});
+
+  NetDef net;
+  auto* while_op = AddOp(&net, "While", {"cond"}, {"Y", "A", "B", "metric"});
+  AddSubnet(while_op, "loop_net", loop_net);
+  for (const auto& input : {"A", "B", "C", "cond", "limit"}) {
+    net.add_external_input(input);
+  }
+
+  auto pruned = PruneUnusedOps(net, {"Y"});
+  ASSERT_EQ(pruned.op_size(), 1);
+  EXPECT_EQ(
+      OpTypes(Subnet(pruned.op(0), "loop_net")),
+      vector<string>({"Relu", "Sigmoid", "Tanh", "LT"}));
+
+  // With a condition net, the condition blob is computed by it instead.
+  AddSubnet(while_op, "cond_net", cond_net);
+  net.mutable_op(0)->mutable_arg(0)->mutable_n()->mutable_op()->RemoveLast();
+  pruned = PruneUnusedOps(net, {"Y"});
+  EXPECT_EQ(
+      OpTypes(Subnet(pruned.op(0), "loop_net")),
+      vector<string>({"Relu", "Sigmoid", "Tanh"}));
+}
+
+} // namespace caffe2
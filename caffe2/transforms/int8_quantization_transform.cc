@@ -0,0 +1,421 @@
+#include "caffe2/transforms/int8_quantization_transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/operators/int8_utils.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+namespace int8 {
+
+void Histogram::Add(const float* data, int n) {
+  if (n <= 0) {
+    return;
+  }
+  const auto minmax = std::minmax_element(data, data + n);
+  float new_min = *minmax.first;
+  float new_max = *minmax.second;
+  if (total_ > 0) {
+    new_min = std::min(new_min, min_);
+    new_max = std::max(new_max, max_);
+  }
+  if (total_ == 0 || new_min < min_ || new_max > max_) {
+    // Move the existing counts to the bins of the new range.
+    const float old_min = min_;
+    const float old_width = bin_width();
+    std::vector<uint64_t> old_bins(bins_.size(), 0);
+    old_bins.swap(bins_);
+    min_ = new_min;
+    max_ = new_max;
+    for (int i = 0; i < old_bins.size(); ++i) {
+      if (old_bins[i]) {
+        bins_[BinIndex(old_min + (i + 0.5f) * old_width)] += old_bins[i];
+      }
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    ++bins_[BinIndex(data[i])];
+  }
+  total_ += n;
+}
+
+int Histogram::BinIndex(float value) const {
+  const float width = bin_width();
+  if (!(width > 0)) {
+    return 0;
+  }
+  const int index = static_cast<int>((value - min_) / width);
+  return std::min(std::max(index, 0), static_cast<int>(bins_.size()) - 1);
+}
+
+CalibrationMethod StringToCalibrationMethod(const std::string& method) {
+  if (method == "min_max") {
+    return CalibrationMethod::MIN_MAX;
+  } else if (method == "kl") {
+    return CalibrationMethod::KL_DIVERGENCE;
+  } else if (method == "percentile") {
+    return CalibrationMethod::PERCENTILE;
+  }
+  CAFFE_THROW("Unknown calibration method: ", method);
+}
+
+namespace {
+
+QuantizationParams ParamsForRange(float min, float max) {
+  QuantizationParams params;
+  ChooseUint8Params(min, max, &params.scale, &params.zero_point);
+  return params;
+}
+
+// Returns the threshold on the magnitude of values that minimizes the KL
+// divergence between the distribution clipped at the threshold and its
+// quantization into the available number of levels. This is the entropy
+// calibration used by TensorRT.
+float ChooseKLThreshold(const Histogram& histogram) {
+  const auto& bins = histogram.bins();
+  const int nbins = bins.size();
+  const float abs_max =
+      std::max(std::abs(histogram.min()), std::abs(histogram.max()));
+  // Fold the histogram into a histogram of magnitudes.
+  std::vector<double> magnitude(nbins, 0);
+  for (int i = 0; i < nbins; ++i) {
+    const float center =
+        histogram.min() + (i + 0.5f) * histogram.bin_width();
+    const int j =
+        std::min(nbins - 1, static_cast<int>(std::abs(center) / abs_max * nbins));
+    magnitude[j] += bins[i];
+  }
+  // Signed values share the 256 levels between both signs.
+  const int levels = histogram.min() < 0 ? 128 : 256;
+  if (nbins <= levels) {
+    return abs_max;
+  }
+
+  std::vector<double> suffix_sum(nbins + 1, 0);
+  for (int i = nbins - 1; i >= 0; --i) {
+    suffix_sum[i] = suffix_sum[i + 1] + magnitude[i];
+  }
+  double best_divergence = std::numeric_limits<double>::max();
+  int best_i = nbins;
+  std::vector<double> p, q;
+  for (int i = levels; i <= nbins; ++i) {
+    // The reference distribution, with the clipped outliers in its last bin.
+    p.assign(magnitude.begin(), magnitude.begin() + i);
+    p[i - 1] += suffix_sum[i];
+    // The candidate distribution: the unclipped part quantized into levels
+    // chunks, each spread evenly over its non-empty bins.
+    q.assign(i, 0);
+    for (int level = 0; level < levels; ++level) {
+      const int start = static_cast<int64_t>(level) * i / levels;
+      const int end = static_cast<int64_t>(level + 1) * i / levels;
+      double sum = 0;
+      int nonzero = 0;
+      for (int k = start; k < end; ++k) {
+        sum += magnitude[k];
+        nonzero += magnitude[k] > 0;
+      }
+      for (int k = start; k < end; ++k) {
+        q[k] = magnitude[k] > 0 ? sum / nonzero : 0;
+      }
+    }
+    double p_sum = 0, q_sum = 0;
+    for (int k = 0; k < i; ++k) {
+      p_sum += p[k];
+      q_sum += q[k];
+    }
+    if (p_sum == 0 || q_sum == 0) {
+      continue;
+    }
+    double divergence = 0;
+    for (int k = 0; k < i; ++k) {
+      if (p[k] > 0) {
+        const double pk = p[k] / p_sum;
+        const double qk = std::max(q[k] / q_sum, 1e-12);
+        divergence += pk * std::log(pk / qk);
+      }
+    }
+    if (divergence < best_divergence) {
+      best_divergence = divergence;
+      best_i = i;
+    }
+  }
+  return static_cast<float>(best_i) / nbins * abs_max;
+}
+
+} // namespace
+
+QuantizationParams ChooseQuantizationParams(
+    const Histogram& histogram,
+    CalibrationMethod method,
+    float percentile) {
+  if (histogram.total() == 0 || histogram.min() == histogram.max()) {
+    return ParamsForRange(histogram.min(), histogram.max());
+  }
+  switch (method) {
+    case CalibrationMethod::MIN_MAX:
+      return ParamsForRange(histogram.min(), histogram.max());
+    case CalibrationMethod::KL_DIVERGENCE: {
+      const float threshold = ChooseKLThreshold(histogram);
+      return ParamsForRange(
+          std::max(histogram.min(), -threshold),
+          std::min(histogram.max(), threshold));
+    }
+    case CalibrationMethod::PERCENTILE: {
+      CAFFE_ENFORCE(
+          percentile > 0 && percentile <= 100,
+          "Percentile must be in (0, 100]");
+      const auto& bins = histogram.bins();
+      const int nbins = bins.size();
+      const double tail = histogram.total() * (100.0 - percentile) / 100.0;
+      int lower = 0;
+      for (double count = 0; lower < nbins - 1; ++lower) {
+        count += bins[lower];
+        if (count > tail) {
+          break;
+        }
+      }
+      int upper = nbins - 1;
+      for (double count = 0; upper > lower; --upper) {
+        count += bins[upper];
+        if (count > tail) {
+          break;
+        }
+      }
+      return ParamsForRange(
+          histogram.min() + lower * histogram.bin_width(),
+          histogram.min() + (upper + 1) * histogram.bin_width());
+    }
+  }
+  CAFFE_THROW("Unknown calibration method");
+}
+
+namespace {
+
+std::string Int8Name(const std::string& name) {
+  return name + "_int8";
+}
+
+template <typename T>
+T GetArg(const OperatorDef& op, const std::string& name, const T& default_value) {
+  return ArgumentHelper::GetSingleArgument<OperatorDef, T>(
+      op, name, default_value);
+}
+
+bool IsNHWC2D(const OperatorDef& op) {
+  if (GetArg<std::string>(op, "order", "NCHW") != "NHWC") {
+    return false;
+  }
+  return !ArgumentHelper::HasArgument(op, "kernels") ||
+      ArgumentHelper::GetRepeatedArgument<OperatorDef, int>(op, "kernels")
+              .size() == 2;
+}
+
+// Tracks, while walking the predict net, in which representations each blob
+// is currently available, and emits the conversions between them.
+class NetQuantizer {
+ public:
+  NetQuantizer(
+      const NetDef& predict_net,
+      const NetDef& init_net,
+      const std::unordered_map<std::string, QuantizationParams>& params,
+      NetDef* quantized_predict_net,
+      NetDef* quantized_init_net)
+      : params_(params),
+        net_(quantized_predict_net),
+        init_net_(quantized_init_net) {
+    for (const auto& op : init_net.op()) {
+      for (const auto& output : op.output()) {
+        weights_.insert(output);
+      }
+    }
+    for (const auto& input : predict_net.external_input()) {
+      float_.insert(input);
+    }
+  }
+
+  void Run(const NetDef& predict_net) {
+    net_->CopyFrom(predict_net);
+    net_->clear_op();
+    for (const auto& op : predict_net.op()) {
+      if (!QuantizeOp(op)) {
+        AddFloatOp(op);
+      }
+    }
+    for (const auto& output : predict_net.external_output()) {
+      EnsureFloat(output);
+    }
+    for (const auto& weight : quantized_weights_) {
+      net_->add_external_input(Int8Name(weight));
+      if (!float_weights_used_.count(weight)) {
+        init_net_->add_op()->CopyFrom(
+            CreateOperatorDef("Free", "", {weight}, {weight}));
+      }
+    }
+  }
+
+ private:
+  bool HasParams(const std::string& name) const {
+    return int8_.count(name) || (float_.count(name) && params_.count(name));
+  }
+
+  bool QuantizeOp(const OperatorDef& op) {
+    if (op.device_option().device_type() != CPU) {
+      return false;
+    }
+    const auto& type = op.type();
+    if (type == "FC" || type == "Conv") {
+      if (op.input_size() < 2 || op.output_size() != 1 ||
+          !HasParams(op.input(0)) || !params_.count(op.output(0)) ||
+          !weights_.count(op.input(1))) {
+        return false;
+      }
+      if (type == "FC" &&
+          (GetArg<int>(op, "axis_w", 1) != 1 ||
+           GetArg<bool>(op, "float16_compute", false))) {
+        return false;
+      }
+      if (type == "Conv" && (!IsNHWC2D(op) || GetArg<int>(op, "group", 1) != 1)) {
+        return false;
+      }
+      auto qop = MakeInt8Op(op, "Int8" + type);
+      qop.set_input(0, EnsureInt8(op.input(0)));
+      qop.set_input(1, QuantizeWeight(op.input(1)));
+      SetOutputParams(&qop, params_.at(op.output(0)));
+      AddInt8Op(qop, op.output(0), params_.at(op.output(0)));
+      return true;
+    }
+    if (type == "Relu" || type == "MaxPool") {
+      if (op.input_size() != 1 || op.output_size() != 1 ||
+          !int8_.count(op.input(0)) || float_.count(op.input(0)) ||
+          (type == "MaxPool" && !IsNHWC2D(op))) {
+        return false;
+      }
+      const auto input_params = int8_.at(op.input(0));
+      auto qop = MakeInt8Op(op, "Int8" + type);
+      qop.set_input(0, Int8Name(op.input(0)));
+      AddInt8Op(qop, op.output(0), input_params);
+      return true;
+    }
+    if (type == "Add") {
+      if (op.input_size() != 2 || op.output_size() != 1 ||
+          GetArg<int>(op, "broadcast", 0) != 0 || !int8_.count(op.input(0)) ||
+          !int8_.count(op.input(1)) || !params_.count(op.output(0))) {
+        return false;
+      }
+      auto qop = MakeInt8Op(op, "Int8Add");
+      qop.set_input(0, Int8Name(op.input(0)));
+      qop.set_input(1, Int8Name(op.input(1)));
+      SetOutputParams(&qop, params_.at(op.output(0)));
+      AddInt8Op(qop, op.output(0), params_.at(op.output(0)));
+      return true;
+    }
+    return false;
+  }
+
+  OperatorDef MakeInt8Op(const OperatorDef& op, const std::string& type) {
+    OperatorDef qop(op);
+    qop.set_type(type);
+    qop.clear_engine();
+    for (int i = 0; i < qop.output_size(); ++i) {
+      qop.set_output(i, Int8Name(op.output(i)));
+    }
+    return qop;
+  }
+
+  void SetOutputParams(OperatorDef* op, const QuantizationParams& params) {
+    op->add_arg()->CopyFrom(MakeArgument<float>("Y_scale", params.scale));
+    op->add_arg()->CopyFrom(
+        MakeArgument<int>("Y_zero_point", params.zero_point));
+  }
+
+  void AddInt8Op(
+      const OperatorDef& op,
+      const std::string& output,
+      const QuantizationParams& params) {
+    net_->add_op()->CopyFrom(op);
+    float_.erase(output);
+    int8_[output] = params;
+  }
+
+  void AddFloatOp(const OperatorDef& op) {
+    for (const auto& input : op.input()) {
+      EnsureFloat(input);
+      if (weights_.count(input)) {
+        float_weights_used_.insert(input);
+      }
+    }
+    net_->add_op()->CopyFrom(op);
+    for (const auto& output : op.output()) {
+      float_.insert(output);
+      int8_.erase(output);
+    }
+  }
+
+  std::string EnsureInt8(const std::string& name) {
+    if (!int8_.count(name)) {
+      const auto& params = params_.at(name);
+      auto op = CreateOperatorDef("Int8Quantize", "", {name}, {Int8Name(name)});
+      SetOutputParams(&op, params);
+      net_->add_op()->CopyFrom(op);
+      int8_[name] = params;
+    }
+    return Int8Name(name);
+  }
+
+  void EnsureFloat(const std::string& name) {
+    if (float_.count(name) || !int8_.count(name)) {
+      return;
+    }
+    net_->add_op()->CopyFrom(
+        CreateOperatorDef("Int8Dequantize", "", {Int8Name(name)}, {name}));
+    float_.insert(name);
+  }
+
+  std::string QuantizeWeight(const std::string& name) {
+    if (quantized_weights_.insert(name).second) {
+      auto op =
+          CreateOperatorDef("Int8Quantize", "", {name}, {Int8Name(name)});
+      op.add_arg()->CopyFrom(MakeArgument<bool>("signed", true));
+      op.add_arg()->CopyFrom(MakeArgument<bool>("per_channel", true));
+      init_net_->add_op()->CopyFrom(op);
+    }
+    return Int8Name(name);
+  }
+
+  const std::unordered_map<std::string, QuantizationParams>& params_;
+  NetDef* net_;
+  NetDef* init_net_;
+  // Blobs produced by the init net.
+  std::unordered_set<std::string> weights_;
+  std::unordered_set<std::string> quantized_weights_;
+  std::unordered_set<std::string> float_weights_used_;
+  // Blobs whose current value is available in fp32, and in int8.
+  std::unordered_set<std::string> float_;
+  std::unordered_map<std::string, QuantizationParams> int8_;
+};
+
+} // namespace
+
+void QuantizeNet(
+    const NetDef& predict_net,
+    const NetDef& init_net,
+    const std::unordered_map<std::string, QuantizationParams>& params,
+    NetDef* quantized_predict_net,
+    NetDef* quantized_init_net) {
+  CAFFE_ENFORCE(quantized_predict_net && quantized_init_net);
+  quantized_init_net->CopyFrom(init_net);
+  NetQuantizer quantizer(
+      predict_net,
+      init_net,
+      params,
+      quantized_predict_net,
+      quantized_init_net);
+  quantizer.Run(predict_net);
+}
+
+} // namespace int8
+} // namespace caffe2
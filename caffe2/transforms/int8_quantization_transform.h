@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+namespace int8 {
+
+/**
+ * A running histogram of the values of a float blob, used to calibrate the
+ * quantization parameters of activations. The range of the histogram grows
+ * to cover every value added; when it does, existing counts are moved to the
+ * bins of the new range.
+ */
+class Histogram {
+ public:
+  explicit Histogram(int nbins = 2048) : bins_(nbins, 0) {}
+
+  void Add(const float* data, int n);
+
+  float min() const {
+    return min_;
+  }
+  float max() const {
+    return max_;
+  }
+  uint64_t total() const {
+    return total_;
+  }
+  const std::vector<uint64_t>& bins() const {
+    return bins_;
+  }
+  float bin_width() const {
+    return (max_ - min_) / bins_.size();
+  }
+
+ private:
+  int BinIndex(float value) const;
+
+  float min_ = 0;
+  float max_ = 0;
+  uint64_t total_ = 0;
+  std::vector<uint64_t> bins_;
+};
+
+/**
+ * How to choose the quantized range of an activation from its histogram.
+ *   MIN_MAX covers every value seen.
+ *   KL_DIVERGENCE clips outliers at the threshold whose quantized
+ *     distribution is closest to the original one, in the KL sense.
+ *   PERCENTILE clips the given percentile of values at each end.
+ */
+enum class CalibrationMethod { MIN_MAX, KL_DIVERGENCE, PERCENTILE };
+
+CalibrationMethod StringToCalibrationMethod(const std::string& method);
+
+struct QuantizationParams {
+  float scale = 1;
+  int32_t zero_point = 0;
+};
+
+// Chooses uint8 quantization parameters for the values in the histogram.
+QuantizationParams ChooseQuantizationParams(
+    const Histogram& histogram,
+    CalibrationMethod method,
+    float percentile = 99.99);
+
+/**
+ * Rewrites an fp32 predict net and its init net to run on the Int8 operators.
+ *
+ * FC, NHWC Conv, Relu, Add and NHWC MaxPool are replaced with their Int8
+ * counterparts when the quantization parameters of their activations are
+ * known from params, which maps blob names to calibrated parameters (e.g.
+ * from a CalibrationNetObserver). Relu and MaxPool keep the parameters of
+ * their input, so they are only quantized when their input already is.
+ * Weights of FC and Conv must be produced by the init net, which gets
+ * Int8Quantize ops appended to quantize them per output channel; float
+ * weights that are no longer used are freed.
+ *
+ * Quantized blobs are named after their float counterpart with an "_int8"
+ * suffix. Other operators keep running in fp32: Int8Quantize and
+ * Int8Dequantize ops are inserted wherever a blob crosses between the two,
+ * and external outputs are always produced in fp32.
+ */
+void QuantizeNet(
+    const NetDef& predict_net,
+    const NetDef& init_net,
+    const std::unordered_map<std::string, QuantizationParams>& params,
+    NetDef* quantized_predict_net,
+    NetDef* quantized_init_net);
+
+} // namespace int8
+} // namespace caffe2
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "caffe2/core/graph.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/observers/calibration_observer.h"
+#include "caffe2/transforms/int8_quantization_transform.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+using int8::CalibrationMethod;
+using int8::ChooseQuantizationParams;
+using int8::Histogram;
+using int8::QuantizationParams;
+
+TEST(Int8QuantizationTest, HistogramGrows) {
+  Histogram histogram(4);
+  const float a[] = {0, 1};
+  histogram.Add(a, 2);
+  EXPECT_EQ(histogram.min(), 0);
+  EXPECT_EQ(histogram.max(), 1);
+  // The old counts move to the bins containing the centers of their bins.
+  const float b[] = {-1, 3};
+  histogram.Add(b, 2);
+  EXPECT_EQ(histogram.min(), -1);
+  EXPECT_EQ(histogram.max(), 3);
+  EXPECT_EQ(histogram.total(), 4);
+  EXPECT_EQ(histogram.bins(), std::vector<uint64_t>({1, 2, 0, 1}));
+}
+
+TEST(Int8QuantizationTest, ChooseParams) {
+  std::vector<float> values(10000);
+  for (int i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<float>(i) / values.size();
+  }
+  // A single large outlier.
+  values[0] = 100;
+  Histogram histogram;
+  histogram.Add(values.data(), values.size());
+
+  auto min_max = ChooseQuantizationParams(histogram, CalibrationMethod::MIN_MAX);
+  EXPECT_NEAR(min_max.scale, 100.f / 255, 1e-5);
+  EXPECT_EQ(min_max.zero_point, 0);
+
+  auto percentile = ChooseQuantizationParams(
+      histogram, CalibrationMethod::PERCENTILE, 99.9);
+  EXPECT_LT(percentile.scale, 2.f / 255);
+
+  auto kl =
+      ChooseQuantizationParams(histogram, CalibrationMethod::KL_DIVERGENCE);
+  EXPECT_LT(kl.scale, min_max.scale);
+  EXPECT_EQ(kl.zero_point, 0);
+}
+
+TEST(Int8QuantizationTest, QuantizeNetStructure) {
+  NetDef init_net;
+  AddOp(&init_net, "ConstantFill", {}, {"W"});
+  AddOp(&init_net, "ConstantFill", {}, {"b"});
+  NetDef predict_net;
+  AddOp(&predict_net, "FC", {"X", "W", "b"}, {"Y"});
+  AddOp(&predict_net, "Relu", {"Y"}, {"Y"});
+  AddOp(&predict_net, "Sigmoid", {"Y"}, {"Z"});
+  AddOp(&predict_net, "FC", {"Z", "W", "b"}, {"out"});
+  predict_net.add_external_input("X");
+  predict_net.add_external_output("out");
+  std::unordered_map<std::string, QuantizationParams> params;
+  for (const auto& name : {"X", "Y", "Z", "out"}) {
+    params[name] = QuantizationParams();
+  }
+
+  NetDef quantized_init_net, quantized_predict_net;
+  int8::QuantizeNet(
+      predict_net,
+      init_net,
+      params,
+      &quantized_predict_net,
+      &quantized_init_net);
+
+  std::vector<std::string> types;
+  for (const auto& op : quantized_predict_net.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      std::vector<std::string>({"Int8Quantize",
+                                "Int8FC",
+                                "Int8Relu",
+                                "Int8Dequantize",
+                                "Sigmoid",
+                                "Int8Quantize",
+                                "Int8FC",
+                                "Int8Dequantize"}));
+  EXPECT_EQ(quantized_predict_net.op(1).input(0), "X_int8");
+  EXPECT_EQ(quantized_predict_net.op(1).input(1), "W_int8");
+  EXPECT_EQ(quantized_predict_net.op(1).input(2), "b");
+  EXPECT_EQ(quantized_predict_net.op(7).output(0), "out");
+
+  // W is quantized once and then freed; b stays in fp32.
+  ASSERT_EQ(quantized_init_net.op_size(), 4);
+  EXPECT_EQ(quantized_init_net.op(2).type(), "Int8Quantize");
+  EXPECT_EQ(quantized_init_net.op(2).output(0), "W_int8");
+  EXPECT_EQ(quantized_init_net.op(3).type(), "Free");
+  EXPECT_EQ(quantized_init_net.op(3).input(0), "W");
+}
+
+TEST(Int8QuantizationTest, CalibrateAndQuantize) {
+  NetDef init_net;
+  auto* op = AddOp(&init_net, "GaussianFill", {}, {"W"});
+  op->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", {8, 16}));
+  op->add_arg()->CopyFrom(MakeArgument<float>("std", 0.2));
+  // The init net runs once per workspace and must produce the same weights.
+  op->mutable_device_option()->set_random_seed(1701);
+  op = AddOp(&init_net, "ConstantFill", {}, {"b"});
+  op->add_arg()->CopyFrom(MakeArgument<vector<int>>("shape", {8}));
+  op->add_arg()->CopyFrom(MakeArgument<float>("value", 0.1));
+  NetDef predict_net;
+  predict_net.set_name("predict");
+  AddOp(&predict_net, "FC", {"X", "W", "b"}, {"Y"});
+  AddOp(&predict_net, "Relu", {"Y"}, {"out"});
+  predict_net.add_external_input("X");
+  predict_net.add_external_input("W");
+  predict_net.add_external_input("b");
+  predict_net.add_external_output("out");
+
+  Workspace ws;
+  auto* X = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(4, 16);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = static_cast<float>(i % 7) / 7;
+  }
+  ASSERT_TRUE(ws.RunNetOnce(init_net));
+  auto* net = ws.CreateNet(predict_net);
+  ASSERT_NE(net, nullptr);
+  const auto* calibration = static_cast<const CalibrationNetObserver*>(
+      net->AttachObserver(caffe2::make_unique<CalibrationNetObserver>(net)));
+  ASSERT_TRUE(net->Run());
+  TensorCPU expected(ws.GetBlob("out")->Get<TensorCPU>());
+  auto params =
+      calibration->GetQuantizationParams(CalibrationMethod::MIN_MAX);
+  EXPECT_EQ(params.size(), 5);
+
+  NetDef quantized_init_net, quantized_predict_net;
+  int8::QuantizeNet(
+      predict_net,
+      init_net,
+      params,
+      &quantized_predict_net,
+      &quantized_init_net);
+  Workspace qws;
+  qws.CreateBlob("X")->GetMutable<TensorCPU>()->CopyFrom(*X);
+  ASSERT_TRUE(qws.RunNetOnce(quantized_init_net));
+  ASSERT_TRUE(qws.RunNetOnce(quantized_predict_net));
+  const auto& out = qws.GetBlob("out")->Get<TensorCPU>();
+  ASSERT_EQ(out.dims(), expected.dims());
+  for (int i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(
+        out.data<float>()[i],
+        expected.data<float>()[i],
+        0.05);
+  }
+}
+
+} // namespace
+
+} // namespace caffe2
@@ -13,6 +13,8 @@ extern "C" {
 #include <Accelerate/Accelerate.h>
 #endif // CAFFE2_USE_ACCELERATE
 
+#include <functional>
+
 #include "caffe2/core/common.h"
 #include "caffe2/core/types.h"
 
@@ -25,6 +27,7 @@ namespace caffe2 {
 
 template <class Context>
 class Tensor;
+class ThreadPool;
 
 // An empty class as a placeholder for a math function that has no specific
 // engine specified.
@@ -195,6 +198,56 @@ void Transpose(
     T* Y,
     Context* context);
 
+// Calls f(begin, end) on consecutive ranges covering [0, n), in parallel on
+// the threads of pool (optional) when --caffe2_intra_op_parallelism is set and
+// the n items of the given cost, the number of elements each item touches,
+// touch at least --caffe2_intra_op_min_work_size elements. f must not throw.
+// Runs on the calling thread when pool is busy, e.g. when nested in another
+// ParallelFor on the same pool.
+void ParallelFor(
+    const int n,
+    const int cost,
+    ThreadPool* pool,
+    const std::function<void(int, int)>& f);
+
+// Transpose on the CPU as Transpose<T, CPUContext> does, dividing the work
+// between the threads of pool (optional) when there is enough of it.
+template <typename T>
+void TransposeCPU(
+    const int num_axes,
+    const int* x_dims,
+    const int* axes,
+    const int data_size,
+    const T* X,
+    T* Y,
+    ThreadPool* pool = nullptr);
+
+// Copies the rows idxs[0], ..., idxs[n - 1] of src into the n consecutive rows
+// of dst, all of row_bytes bytes, for each of the batch_size batches b of
+// rows starting at src + b * src_batch_bytes and dst + b * n * row_bytes. Uses
+// the vectorized kernels of GatherRows, on the threads of pool (optional) when
+// there are enough rows. The indices must be valid. Index is int32_t or
+// int64_t.
+template <typename Index>
+void GatherRowsCPU(
+    const int batch_size,
+    const int n,
+    const size_t row_bytes,
+    const Index* idxs,
+    const char* src,
+    const size_t src_batch_bytes,
+    char* dst,
+    ThreadPool* pool = nullptr);
+
+// Copies n ranges of bytes, lengths[i] bytes from srcs[i] to dsts[i], on the
+// threads of pool (optional) when there is enough to copy.
+void CopyRangesCPU(
+    const int n,
+    const char* const* srcs,
+    char* const* dsts,
+    const size_t* lengths,
+    ThreadPool* pool = nullptr);
+
 // Decaf gemm provides a simpler interface to the gemm functions, with the
 // limitation that the data has to be contiguous in memory.
 template <typename T, class Context, class Engine = DefaultEngine>
@@ -249,6 +302,26 @@ void GemmBatched(
     Tensor<Context>* scratch = nullptr,
     TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
 
+// Computes C[i] = alpha * op(A[i]) * op(B[i]) + beta * C[i] for the
+// batch_size matrices of the arrays A, B and C. Unlike with GemmBatched, the
+// matrices need not be evenly spaced, so that a matrix can be used for several
+// products of the batch without being copied. Calls MKL's batched GEMM when
+// Caffe2 is built with MKL, and otherwise single threaded GEMMs on the threads
+// of pool (optional).
+void GemmBatchedCPU(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float** A,
+    const float** B,
+    const float beta,
+    float** C,
+    ThreadPool* pool = nullptr);
+
 // Gemv always takes in a M*N matrix A, and depending on whether we set TransA
 // to Trans, the output is:
 // CblasNoTrans: x is an N dim vector and y is an M dim vector.
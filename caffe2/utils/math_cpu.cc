@@ -15,6 +15,8 @@
 #include <atomic>
 #include <chrono>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <numeric>
 #include <random>
 #include <unordered_set>
@@ -23,6 +25,9 @@
 #include "caffe2/utils/math.h"
 #include "caffe2/utils/cpu_neon.h"
 #include "caffe2/core/context.h"
+#include "caffe2/perfkernels/gather.h"
+#include "caffe2/perfkernels/transpose.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
 #include "Eigen/Core"
 #include "Eigen/Dense"
 
@@ -38,6 +43,19 @@
 #include <process.h>
 #endif
 
+CAFFE2_DEFINE_bool(
+    caffe2_intra_op_parallelism,
+    false,
+    "Divide the work of the CPU operators that support it, such as Transpose "
+    "or the segment reductions, between the threads of the threadpool of "
+    "their workspace.");
+CAFFE2_DEFINE_int(
+    caffe2_intra_op_min_work_size,
+    65536,
+    "With --caffe2_intra_op_parallelism, the number of elements an operator "
+    "must touch for its work to be divided between threads. Waking up the "
+    "threadpool costs more than running smaller work on the calling thread.");
+
 namespace caffe2 {
 namespace math {
 
@@ -475,6 +493,55 @@ void GemmBatched<float, CPUContext>(
 #endif
 }
 
+void GemmBatchedCPU(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float** A,
+    const float** B,
+    const float beta,
+    float** C,
+    ThreadPool* pool) {
+#ifdef CAFFE2_USE_MKL
+  (void)pool;
+
+  const int lda = (TransA == CblasNoTrans) ? K : M;
+  const int ldb = (TransB == CblasNoTrans) ? N : K;
+  cblas_sgemm_batch(
+      CblasRowMajor,
+      &TransA,
+      &TransB,
+      &M,
+      &N,
+      &K,
+      &alpha,
+      A,
+      &lda,
+      B,
+      &ldb,
+      &beta,
+      C,
+      &N, // ldc_array
+      1,
+      &batch_size);
+#else // CAFFE2_USE_MKL
+  // Each product is a task, unless they are small enough to be grouped.
+  const int cost = std::min<long long>(
+      static_cast<long long>(M) * N * K, std::numeric_limits<int>::max());
+  ParallelFor(batch_size, cost, pool, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      // The CPU Gemm does not use its context.
+      Gemm<float, CPUContext>(
+          TransA, TransB, M, N, K, alpha, A[i], B[i], beta, C[i], nullptr);
+    }
+  });
+#endif // CAFFE2_USE_MKL
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // MKL VML alternatives.
 // Depending on whether we are using MKL, we will delegate the Caffe math
@@ -1541,108 +1608,393 @@ bool TryTransposeWithHPTT(
   return true;
 }
 
+// HPTT only transposes floats.
+template <typename T>
+bool TryTransposeWithHPTT(
+    const int /* num_axes */,
+    const int* /* dims */,
+    const int* /* axes */,
+    const T* /* X */,
+    T* /* Y */) {
+  return false;
+}
+
 #endif // CAFFE2_USE_HPTT
 
-std::vector<int>
-ComputeXStrides(const int num_axes, const int* dims, const int* axes) {
-  std::vector<int> x_strides(num_axes);
-  std::vector<int> buff(num_axes);
-  int cur_stride = 1;
-  for (int i = num_axes - 1; i >= 0; --i) {
-    buff[i] = cur_stride;
-    cur_stride *= dims[i];
+// Removes the axes of size 1 and merges the axes of X that stay adjacent and
+// in order in Y, which leaves the transpose unchanged. NCHW <-> NHWC for
+// instance becomes a batch of 2-D transposes of C x HW matrices.
+void SimplifyTranspose(
+    const int num_axes,
+    const int* x_dims,
+    const int* axes,
+    std::vector<int>* dims,
+    std::vector<int>* perm) {
+  std::vector<int> compact_axis(num_axes, -1);
+  for (int i = 0, j = 0; i < num_axes; ++i) {
+    if (x_dims[i] != 1) {
+      compact_axis[i] = j++;
+    }
   }
+  // Runs of consecutive axes of X, in the order of Y.
+  std::vector<int> first_axis;
+  std::vector<int> last_axis;
+  std::vector<int> run_dims;
   for (int i = 0; i < num_axes; ++i) {
-    x_strides[i] = buff[axes[i]];
+    const int axis = compact_axis[axes[i]];
+    if (axis < 0) {
+      continue;
+    }
+    if (!last_axis.empty() && axis == last_axis.back() + 1) {
+      last_axis.back() = axis;
+      run_dims.back() *= x_dims[axes[i]];
+    } else {
+      first_axis.push_back(axis);
+      last_axis.push_back(axis);
+      run_dims.push_back(x_dims[axes[i]]);
+    }
+  }
+  const int num_runs = first_axis.size();
+  std::vector<int> x_order(num_runs);
+  std::iota(x_order.begin(), x_order.end(), 0);
+  std::sort(x_order.begin(), x_order.end(), [&first_axis](int i, int j) {
+    return first_axis[i] < first_axis[j];
+  });
+  dims->resize(num_runs);
+  perm->resize(num_runs);
+  for (int i = 0; i < num_runs; ++i) {
+    (*dims)[i] = run_dims[x_order[i]];
+    (*perm)[x_order[i]] = i;
   }
-  return x_strides;
 }
 
-void IncreaseIndex(const int* dims, std::vector<int>* index) {
-  for (int i = index->size() - 1; i >= 0; --i) {
-    ++index->at(i);
-    if (index->at(i) >= dims[i]) {
-      index->at(i) -= dims[i];
-    } else {
-      break;
+// Iterates over the indices of dims in row-major order, tracking the
+// matching offsets in two tensors with the given strides.
+class StridedIndex {
+ public:
+  StridedIndex(
+      const std::vector<int>& dims,
+      const std::vector<int>& x_strides,
+      const std::vector<int>& y_strides,
+      int linear_index)
+      : dims_(dims),
+        x_strides_(x_strides),
+        y_strides_(y_strides),
+        index_(dims.size()) {
+    for (int i = dims_.size() - 1; i >= 0; --i) {
+      index_[i] = linear_index % dims_[i];
+      linear_index /= dims_[i];
+      x_offset_ += index_[i] * x_strides_[i];
+      y_offset_ += index_[i] * y_strides_[i];
+    }
+  }
+
+  void Next() {
+    for (int i = dims_.size() - 1; i >= 0; --i) {
+      x_offset_ += x_strides_[i];
+      y_offset_ += y_strides_[i];
+      if (++index_[i] < dims_[i]) {
+        return;
+      }
+      x_offset_ -= dims_[i] * x_strides_[i];
+      y_offset_ -= dims_[i] * y_strides_[i];
+      index_[i] = 0;
     }
   }
-}
+
+  int x_offset() const {
+    return x_offset_;
+  }
+
+  int y_offset() const {
+    return y_offset_;
+  }
+
+ private:
+  const std::vector<int>& dims_;
+  const std::vector<int>& x_strides_;
+  const std::vector<int>& y_strides_;
+  std::vector<int> index_;
+  int x_offset_ = 0;
+  int y_offset_ = 0;
+};
 
 template <typename T>
-void TransposeCPU(
-    const int num_axes,
-    const int* x_dims,
-    const int* y_dims,
-    const int* axes,
-    const int data_size,
+void Transpose2DBlock(
+    const int rows,
+    const int cols,
     const T* X,
-    T* Y) {
-  // Measure amount of contiguous data we can copy at once
-  int block_size = 1;
-  int num_shared_idxs = 0;
-  for (int i = num_axes - 1; i >= 0 && axes[i] == i; --i) {
-    block_size *= y_dims[i];
-    ++num_shared_idxs;
-  }
+    const int ldx,
+    T* Y,
+    const int ldy) {
+  Transpose2DTiled(rows, cols, X, ldx, Y, ldy);
+}
 
-  if (num_axes < 2 || num_shared_idxs == num_axes) {
-    memcpy(Y, X, data_size * sizeof(T));
+template <>
+void Transpose2DBlock<float>(
+    const int rows,
+    const int cols,
+    const float* X,
+    const int ldx,
+    float* Y,
+    const int ldy) {
+  Transpose2D(rows, cols, X, ldx, Y, ldy);
+}
+
+} // namespace
+
+void ParallelFor(
+    const int n,
+    const int cost,
+    ThreadPool* pool,
+    const std::function<void(int, int)>& f) {
+  constexpr int kGrainSize = 4096;
+  const int grain = std::max(1, kGrainSize / std::max(cost, 1));
+  const int num_tasks = (n + grain - 1) / grain;
+  if (pool == nullptr || !FLAGS_caffe2_intra_op_parallelism ||
+      static_cast<int64_t>(n) * std::max(cost, 1) <
+          FLAGS_caffe2_intra_op_min_work_size ||
+      num_tasks < 2) {
+    f(0, n);
     return;
   }
+  // The tasks are sized to the work already, so that the minimum work size
+  // of the pool, a number of tasks, does not apply.
+  pool->run(
+      [&](int /* thread_id */, size_t task) {
+        const int begin = task * grain;
+        f(begin, std::min(n, begin + grain));
+      },
+      num_tasks,
+      2);
+}
 
-  const int itr_axes = num_axes - num_shared_idxs;
-  const std::vector<int> x_strides = ComputeXStrides(itr_axes, x_dims, axes);
-  std::vector<int> index_digits(itr_axes, 0);
-  const int num_blocks = data_size / block_size;
-  for (int y_index = 0; y_index < num_blocks; ++y_index) {
-    const int x_index = std::inner_product(
-        x_strides.cbegin(), x_strides.cend(), index_digits.cbegin(), 0);
-    if (block_size == 1) {
-      Y[y_index] = X[x_index];
-    } else {
-      memcpy(
-          Y + block_size * y_index,
-          X + block_size * x_index,
-          block_size * sizeof(T));
-    }
-    IncreaseIndex(y_dims, &index_digits);
+template <typename Index>
+void GatherRowsCPU(
+    const int batch_size,
+    const int n,
+    const size_t row_bytes,
+    const Index* idxs,
+    const char* src,
+    const size_t src_batch_bytes,
+    char* dst,
+    ThreadPool* pool) {
+  const TIndex total = TIndex(batch_size) * n;
+  if (total == 0) {
+    return;
   }
+  // ParallelFor counts its items with an int, so when there are more rows
+  // than that, each item is a block of rows.
+  const TIndex block = (total - 1) / std::numeric_limits<int>::max() + 1;
+  ParallelFor(
+      (total - 1) / block + 1,
+      std::min<size_t>(row_bytes * block, std::numeric_limits<int>::max()),
+      pool,
+      [&](int begin, int end) {
+        // The rows of the items [begin, end) that are in the same batch at
+        // once.
+        const TIndex last = std::min(end * block, total);
+        for (TIndex i = begin * block; i < last;) {
+          const TIndex b = i / n;
+          const int j = i % n;
+          const int count = std::min(last - i, TIndex(n - j));
+          GatherRows(
+              count,
+              row_bytes,
+              idxs + j,
+              src + b * src_batch_bytes,
+              dst + i * row_bytes);
+          i += count;
+        }
+      });
 }
 
-} // namespace
+template void GatherRowsCPU<int32_t>(
+    const int batch_size,
+    const int n,
+    const size_t row_bytes,
+    const int32_t* idxs,
+    const char* src,
+    const size_t src_batch_bytes,
+    char* dst,
+    ThreadPool* pool);
+template void GatherRowsCPU<int64_t>(
+    const int batch_size,
+    const int n,
+    const size_t row_bytes,
+    const int64_t* idxs,
+    const char* src,
+    const size_t src_batch_bytes,
+    char* dst,
+    ThreadPool* pool);
+
+void CopyRangesCPU(
+    const int n,
+    const char* const* srcs,
+    char* const* dsts,
+    const size_t* lengths,
+    ThreadPool* pool) {
+  if (n == 0) {
+    return;
+  }
+  const size_t total = std::accumulate(lengths, lengths + n, size_t(0));
+  ParallelFor(
+      n,
+      std::min<size_t>(total / n, std::numeric_limits<int>::max()),
+      pool,
+      [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          if (lengths[i] > 0) {
+            memcpy(dsts[i], srcs[i], lengths[i]);
+          }
+        }
+      });
+}
 
-template <>
-void Transpose<float, CPUContext>(
+template <typename T>
+void TransposeCPU(
     const int num_axes,
     const int* x_dims,
-    const int* y_dims,
     const int* axes,
     const int data_size,
-    const float* X,
-    float* Y,
-    CPUContext* /* context */) {
+    const T* X,
+    T* Y,
+    ThreadPool* pool) {
+  if (data_size == 0) {
+    return;
+  }
 #ifdef CAFFE2_USE_HPTT
   if (TryTransposeWithHPTT(num_axes, x_dims, axes, X, Y)) {
     return;
   }
 #endif // CAFFE2_USE_HPTT
-  TransposeCPU(num_axes, x_dims, y_dims, axes, data_size, X, Y);
-}
+  std::vector<int> dims;
+  std::vector<int> perm;
+  SimplifyTranspose(num_axes, x_dims, axes, &dims, &perm);
+  const int ndim = dims.size();
+  if (ndim <= 1) {
+    memcpy(Y, X, data_size * sizeof(T));
+    return;
+  }
+  std::vector<int> y_dims(ndim);
+  std::vector<int> x_strides(ndim);
+  std::vector<int> y_strides(ndim);
+  // Strides in X of the axes of Y.
+  std::vector<int> x_strides_in_y(ndim);
+  for (int i = 0; i < ndim; ++i) {
+    y_dims[i] = dims[perm[i]];
+  }
+  for (int i = ndim - 1, x_stride = 1, y_stride = 1; i >= 0; --i) {
+    x_strides[i] = x_stride;
+    y_strides[i] = y_stride;
+    x_stride *= dims[i];
+    y_stride *= y_dims[i];
+  }
+  for (int i = 0; i < ndim; ++i) {
+    x_strides_in_y[i] = x_strides[perm[i]];
+  }
+
+  if (perm[ndim - 1] == ndim - 1) {
+    // The innermost axis does not move: copy whole rows of X.
+    const int row_size = dims[ndim - 1];
+    const std::vector<int> outer_dims(y_dims.begin(), y_dims.end() - 1);
+    const std::vector<int> outer_x_strides(
+        x_strides_in_y.begin(), x_strides_in_y.end() - 1);
+    const std::vector<int> outer_y_strides(
+        y_strides.begin(), y_strides.end() - 1);
+    ParallelFor(
+        data_size / row_size, row_size, pool, [&](int begin, int end) {
+          StridedIndex index(
+              outer_dims, outer_x_strides, outer_y_strides, begin);
+          for (int i = begin; i < end; ++i) {
+            memcpy(
+                Y + index.y_offset(),
+                X + index.x_offset(),
+                row_size * sizeof(T));
+            index.Next();
+          }
+        });
+    return;
+  }
 
-#define CAFFE2_SPECIALIZED_TRANSPOSE(T)                            \
-  template <>                                                      \
-  void Transpose<T, CPUContext>(                                   \
-      const int num_axes,                                          \
-      const int* x_dims,                                           \
-      const int* y_dims,                                           \
-      const int* axes,                                             \
-      const int data_size,                                         \
-      const T* X,                                                  \
-      T* Y,                                                        \
-      CPUContext* /* context */) {                                 \
-    TransposeCPU(num_axes, x_dims, y_dims, axes, data_size, X, Y); \
+  // Otherwise Y is a batch of 2-D transposes, between the innermost axis of
+  // X and the axis of X that becomes the innermost one of Y. They are split
+  // into tiles, the unit of parallel work.
+  constexpr int kTileSize = 64;
+  const int x_axis = perm[ndim - 1];
+  const int y_axis =
+      std::find(perm.begin(), perm.end(), ndim - 1) - perm.begin();
+  const int rows = dims[x_axis];
+  const int cols = dims[ndim - 1];
+  const int ldx = x_strides[x_axis];
+  const int ldy = y_strides[y_axis];
+  std::vector<int> outer_dims;
+  std::vector<int> outer_x_strides;
+  std::vector<int> outer_y_strides;
+  for (int i = 0; i < ndim - 1; ++i) {
+    if (i != y_axis) {
+      outer_dims.push_back(y_dims[i]);
+      outer_x_strides.push_back(x_strides_in_y[i]);
+      outer_y_strides.push_back(y_strides[i]);
+    }
   }
+  const int row_tiles = (rows + kTileSize - 1) / kTileSize;
+  const int col_tiles = (cols + kTileSize - 1) / kTileSize;
+  const int num_tiles = row_tiles * col_tiles;
+  ParallelFor(
+      data_size / (rows * cols) * num_tiles,
+      std::min(rows, kTileSize) * std::min(cols, kTileSize),
+      pool,
+      [&](int begin, int end) {
+        StridedIndex index(
+            outer_dims, outer_x_strides, outer_y_strides, begin / num_tiles);
+        for (int i = begin, tile = begin % num_tiles; i < end; ++i) {
+          const int r = tile / col_tiles * kTileSize;
+          const int c = tile % col_tiles * kTileSize;
+          Transpose2DBlock(
+              std::min(kTileSize, rows - r),
+              std::min(kTileSize, cols - c),
+              X + index.x_offset() + r * ldx + c,
+              ldx,
+              Y + index.y_offset() + c * ldy + r,
+              ldy);
+          if (++tile == num_tiles) {
+            tile = 0;
+            index.Next();
+          }
+        }
+      });
+}
+
+#define CAFFE2_INSTANTIATE_TRANSPOSE_CPU(T) \
+  template void TransposeCPU<T>(             \
+      const int num_axes,                    \
+      const int* x_dims,                     \
+      const int* axes,                       \
+      const int data_size,                   \
+      const T* X,                            \
+      T* Y,                                  \
+      ThreadPool* pool);
+CAFFE2_INSTANTIATE_TRANSPOSE_CPU(float)
+CAFFE2_INSTANTIATE_TRANSPOSE_CPU(double)
+CAFFE2_INSTANTIATE_TRANSPOSE_CPU(int)
+CAFFE2_INSTANTIATE_TRANSPOSE_CPU(long)
+#undef CAFFE2_INSTANTIATE_TRANSPOSE_CPU
+
+#define CAFFE2_SPECIALIZED_TRANSPOSE(T)                    \
+  template <>                                              \
+  void Transpose<T, CPUContext>(                           \
+      const int num_axes,                                  \
+      const int* x_dims,                                   \
+      const int* /* y_dims */,                             \
+      const int* axes,                                     \
+      const int data_size,                                 \
+      const T* X,                                          \
+      T* Y,                                                \
+      CPUContext* /* context */) {                         \
+    TransposeCPU(num_axes, x_dims, axes, data_size, X, Y); \
+  }
+CAFFE2_SPECIALIZED_TRANSPOSE(float)
 CAFFE2_SPECIALIZED_TRANSPOSE(double)
 CAFFE2_SPECIALIZED_TRANSPOSE(int)
 CAFFE2_SPECIALIZED_TRANSPOSE(long)
@@ -1,14 +1,23 @@
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
 
 #include "caffe2/core/blob.h"
 #include "caffe2/core/context.h"
+#include "caffe2/core/flags.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+CAFFE2_DECLARE_bool(caffe2_intra_op_parallelism);
+CAFFE2_DECLARE_int(caffe2_intra_op_min_work_size);
 
 namespace caffe2 {
 
@@ -366,4 +375,208 @@ TEST(MathTest, TranposeTest) {
   }
 }
 
+namespace {
+
+// Transposes X one element at a time, for comparison.
+std::vector<float> ReferenceTranspose(
+    const std::vector<int>& x_dims,
+    const std::vector<int>& axes,
+    const std::vector<float>& X) {
+  const int ndim = x_dims.size();
+  std::vector<int> x_strides(ndim, 1);
+  for (int i = ndim - 2; i >= 0; --i) {
+    x_strides[i] = x_strides[i + 1] * x_dims[i + 1];
+  }
+  std::vector<int> index(ndim, 0);
+  std::vector<float> Y(X.size());
+  for (int i = 0; i < Y.size(); ++i) {
+    int x_offset = 0;
+    for (int j = 0; j < ndim; ++j) {
+      x_offset += index[j] * x_strides[axes[j]];
+    }
+    Y[i] = X[x_offset];
+    for (int j = ndim - 1; j >= 0; --j) {
+      if (++index[j] < x_dims[axes[j]]) {
+        break;
+      }
+      index[j] = 0;
+    }
+  }
+  return Y;
+}
+
+// Lets ParallelFor use the pool for any amount of work while in scope.
+class IntraOpParallelismGuard {
+ public:
+  IntraOpParallelismGuard()
+      : enabled_(FLAGS_caffe2_intra_op_parallelism),
+        min_work_size_(FLAGS_caffe2_intra_op_min_work_size) {
+    FLAGS_caffe2_intra_op_parallelism = true;
+    FLAGS_caffe2_intra_op_min_work_size = 0;
+  }
+
+  ~IntraOpParallelismGuard() {
+    FLAGS_caffe2_intra_op_parallelism = enabled_;
+    FLAGS_caffe2_intra_op_min_work_size = min_work_size_;
+  }
+
+ private:
+  const bool enabled_;
+  const int min_work_size_;
+};
+
+} // namespace
+
+TEST(MathTest, TransposeCPUTest) {
+  // Sizes that are not multiples of the tiles, size 1 axes, and the layout
+  // switches of convolutions.
+  const std::vector<std::pair<std::vector<int>, std::vector<int>>> cases = {
+      {{67, 129}, {1, 0}},
+      {{8, 8}, {1, 0}},
+      {{3, 1, 5}, {2, 1, 0}},
+      {{2, 17, 9, 33}, {0, 2, 3, 1}},
+      {{2, 9, 33, 17}, {0, 3, 1, 2}},
+      {{4, 5, 6, 7}, {0, 1, 3, 2}},
+      {{4, 5, 6, 7}, {2, 0, 1, 3}},
+      {{3, 4, 5, 6, 7}, {4, 2, 0, 3, 1}},
+      {{1, 300, 1, 200}, {3, 2, 1, 0}},
+      // Empty tensors.
+      {{0, 5}, {1, 0}},
+      {{5, 0}, {1, 0}},
+      {{0, 3, 4, 5}, {0, 2, 3, 1}},
+      // Enough tiles and rows to be split across the threads.
+      {{2, 512, 48, 48}, {0, 2, 3, 1}},
+      {{256, 64, 128}, {1, 0, 2}},
+  };
+  ThreadPool pool(4);
+  IntraOpParallelismGuard guard;
+  for (const auto& c : cases) {
+    const auto& x_dims = c.first;
+    const auto& axes = c.second;
+    int size = 1;
+    for (const int d : x_dims) {
+      size *= d;
+    }
+    std::vector<float> X(size);
+    for (int i = 0; i < size; ++i) {
+      X[i] = static_cast<float>(i);
+    }
+    const auto expected = ReferenceTranspose(x_dims, axes, X);
+    for (ThreadPool* p : {static_cast<ThreadPool*>(nullptr), &pool}) {
+      std::vector<float> Y(size, -1.0f);
+      math::TransposeCPU(
+          x_dims.size(), x_dims.data(), axes.data(), size, X.data(), Y.data(), p);
+      for (int i = 0; i < size; ++i) {
+        ASSERT_EQ(expected[i], Y[i]) << "at " << i;
+      }
+    }
+  }
+}
+
+TEST(MathTest, GatherRowsCPUTest) {
+  // Rows of the sizes copied by each of the kernels, in batches whose rows
+  // are split across the threads at any row.
+  ThreadPool pool(4);
+  IntraOpParallelismGuard guard;
+  const int num_rows = 50;
+  for (const int batch_size : {1, 3, 7}) {
+    for (const int n : {0, 1, 37, 5000}) {
+      for (const size_t row_bytes : {1, 4, 8, 12, 20, 100}) {
+        const size_t src_batch_bytes = num_rows * row_bytes;
+        std::vector<char> src(batch_size * src_batch_bytes);
+        for (size_t i = 0; i < src.size(); ++i) {
+          src[i] = static_cast<char>(i * 7 + i / 251);
+        }
+        std::vector<int64_t> idxs(n);
+        for (int i = 0; i < n; ++i) {
+          idxs[i] = (i * 13 + i / 3) % num_rows;
+        }
+        const std::vector<int32_t> idxs32(idxs.begin(), idxs.end());
+        std::vector<char> expected(batch_size * n * row_bytes);
+        for (int b = 0; b < batch_size; ++b) {
+          for (int i = 0; i < n; ++i) {
+            std::copy_n(
+                src.data() + b * src_batch_bytes + idxs[i] * row_bytes,
+                row_bytes,
+                expected.data() + (b * n + i) * row_bytes);
+          }
+        }
+        for (ThreadPool* p : {static_cast<ThreadPool*>(nullptr), &pool}) {
+          std::vector<char> dst(expected.size(), 0);
+          math::GatherRowsCPU(
+              batch_size,
+              n,
+              row_bytes,
+              idxs.data(),
+              src.data(),
+              src_batch_bytes,
+              dst.data(),
+              p);
+          EXPECT_EQ(expected, dst);
+          std::fill(dst.begin(), dst.end(), 0);
+          math::GatherRowsCPU(
+              batch_size,
+              n,
+              row_bytes,
+              idxs32.data(),
+              src.data(),
+              src_batch_bytes,
+              dst.data(),
+              p);
+          EXPECT_EQ(expected, dst);
+        }
+      }
+    }
+  }
+}
+
+TEST(MathTest, ParallelForTest) {
+  ThreadPool pool(4);
+  // Runs f on pool and returns the number of threads it ran on.
+  auto num_threads = [&](const int n, const int cost) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    math::ParallelFor(n, cost, &pool, [&](int /* begin */, int /* end */) {
+      std::lock_guard<std::mutex> guard(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+    return threads.size();
+  };
+  // Intra-op parallelism is off by default, and small work stays on the
+  // calling thread even when it is on.
+  EXPECT_EQ(1, num_threads(1000, 1024));
+  {
+    IntraOpParallelismGuard guard;
+    FLAGS_caffe2_intra_op_min_work_size = 1 << 20;
+    EXPECT_EQ(1, num_threads(1000, 1024));
+    EXPECT_GT(num_threads(1024, 1024), 1);
+  }
+
+  IntraOpParallelismGuard guard;
+  for (const int n : {0, 1, 5, 1000}) {
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::vector<int> counts(n, 0);
+    // A few tasks are enough to use the threads of the pool, and the nested
+    // ParallelFor runs on the calling thread.
+    math::ParallelFor(n, 1024, &pool, [&](int begin, int end) {
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        threads.insert(std::this_thread::get_id());
+      }
+      math::ParallelFor(end - begin, 4096, &pool, [&](int b, int e) {
+        for (int i = begin + b; i < begin + e; ++i) {
+          ++counts[i];
+        }
+      });
+    });
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(1, counts[i]) << "at " << i;
+    }
+    if (n > 4) {
+      EXPECT_GT(threads.size(), 1);
+    }
+  }
+}
+
 } // namespace caffe2
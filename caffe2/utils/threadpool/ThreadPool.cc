@@ -95,26 +95,58 @@ int ThreadPool::getNumThreads() const {
 // threadpool; work sizes smaller than this will just be run on the
 // main (calling) thread
 void ThreadPool::setMinWorkSize(size_t size) {
-  std::lock_guard<std::mutex> guard(executionMutex_);
   minWorkSize_ = size;
 }
 
+// If there are no worker threads, or if the range is too small (too
+// little work), just run locally
+bool ThreadPool::runsLocally(size_t range, size_t minWorkSize) const {
+  return range < minWorkSize || FLAGS_caffe2_threadpool_force_inline ||
+      (numThreads_ == 0);
+}
+
+void ThreadPool::runLocally(
+    const std::function<void(int, size_t)>& fn,
+    size_t range) {
+  // Work is small enough to just run locally; multithread overhead
+  // is too high
+  for (size_t i = 0; i < range; ++i) {
+    fn(0, i);
+  }
+}
+
 void ThreadPool::run(const std::function<void(int, size_t)>& fn, size_t range) {
+  // Small work runs on the calling thread without taking the lock.
+  if (runsLocally(range, minWorkSize_)) {
+    runLocally(fn, range);
+    return;
+  }
   std::lock_guard<std::mutex> guard(executionMutex_);
-  // If there are no worker threads, or if the range is too small (too
-  // little work), just run locally
-  const bool runLocally = range < minWorkSize_ ||
-                          FLAGS_caffe2_threadpool_force_inline ||
-                          (numThreads_ == 0);
-  if (runLocally) {
-    // Work is small enough to just run locally; multithread overhead
-    // is too high
-    for (size_t i = 0; i < range; ++i) {
-      fn(0, i);
-    }
+  executingThread_ = std::this_thread::get_id();
+  execute(fn, range);
+  executingThread_ = std::thread::id();
+}
+
+void ThreadPool::run(
+    const std::function<void(int, size_t)>& fn,
+    size_t range,
+    size_t minWorkSize) {
+  // The thread executing the pool runs one of the tasks itself, and must not
+  // try to lock executionMutex_ again from there.
+  std::unique_lock<std::mutex> guard(executionMutex_, std::defer_lock);
+  if (runsLocally(range, minWorkSize) ||
+      executingThread_ == std::this_thread::get_id() || !guard.try_lock()) {
+    runLocally(fn, range);
     return;
   }
+  executingThread_ = std::this_thread::get_id();
+  execute(fn, range);
+  executingThread_ = std::thread::id();
+}
 
+void ThreadPool::execute(
+    const std::function<void(int, size_t)>& fn,
+    size_t range) {
   struct FnTask : public Task {
     FnTask(){};
     virtual ~FnTask(){};
@@ -3,9 +3,11 @@
 
 #include "ThreadPoolCommon.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 //
@@ -39,14 +41,31 @@ class alignas(kCacheLineSize) ThreadPool {
   void setMinWorkSize(size_t size);
   size_t getMinWorkSize() const { return minWorkSize_; }
   void run(const std::function<void(int, size_t)>& fn, size_t range);
+  // As above, with the given minimum work size instead of the one of the
+  // pool, for callers that already sized the range to the work. Runs on the
+  // calling thread when the pool is busy, for instance when called from
+  // within one of its own tasks.
+  void run(
+      const std::function<void(int, size_t)>& fn,
+      size_t range,
+      size_t minWorkSize);
 
   // Run an arbitrary function in a thread-safe manner accessing the Workers
   // Pool
   void withPool(const std::function<void(WorkersPool*)>& fn);
 
  private:
+  bool runsLocally(size_t range, size_t minWorkSize) const;
+  static void runLocally(
+      const std::function<void(int, size_t)>& fn,
+      size_t range);
+  // Splits the range between the workers; executionMutex_ must be held.
+  void execute(const std::function<void(int, size_t)>& fn, size_t range);
+
   mutable std::mutex executionMutex_;
-  size_t minWorkSize_;
+  // The thread holding executionMutex_ while the workers run.
+  std::atomic<std::thread::id> executingThread_;
+  std::atomic<size_t> minWorkSize_;
   size_t numThreads_;
   std::shared_ptr<WorkersPool> workersPool_;
   std::vector<std::shared_ptr<Task>> tasks_;